@@ -9,42 +9,84 @@
 \*************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <limits.h>
 #include <math.h>
 
+#include <string>
+#include <vector>
+
 #include "cadef.h"
 #include "dbDefs.h"
+#include "epicsAtomic.h"
 #include "epicsTime.h"
 #include "errlog.h"
 
 /*
  * event_handler()
+ *
+ * with preemptive callbacks enabled this runs in the
+ * threads of several circuits
  */
 extern "C" void eventCallBack ( struct event_handler_args args )
 {
-    unsigned *pCount = static_cast < unsigned * > ( args.usr );
-    (*pCount)++;
+    size_t *pCount = static_cast < size_t * > ( args.usr );
+    epicsAtomicIncrSizeT ( pCount );
 }
 
 /*
  * caEventRate ()
+ *
+ * pNames is a PV name, or several separated by commas, each of them
+ * is subscribed count times
  */
-void caEventRate ( const char *pName, unsigned count )
+void caEventRate ( const char *pNames, unsigned count, bool preemptive )
 {
     static const double initialSamplePeriod = 1.0;
     static const double maxSamplePeriod = 60.0 * 5.0;
-    unsigned eventCount = 0u;
+    size_t eventCount = 0u;
+
+    if ( preemptive ) {
+        int status = ca_context_create ( ca_enable_preemptive_callback );
+        SEVCHK ( status, NULL );
+    }
+
+    std::vector < std::string > names;
+    for ( const char * pName = pNames; *pName; ) {
+        const char * pEnd = strchr ( pName, ',' );
+        size_t len = pEnd ? size_t ( pEnd - pName ) : strlen ( pName );
+        if ( len ) {
+            names.push_back ( std::string ( pName, len ) );
+        }
+        pName += len;
+        if ( *pName ) {
+            pName++;
+        }
+    }
+    if ( names.empty () ) {
+        fprintf ( stderr, "No PV name.\n" );
+        return;
+    }
 
-    chid * pChidTable = new chid [ count ];
+    unsigned nNames = static_cast < unsigned > ( names.size () );
+    unsigned total = count * nNames;
+    chid * pChidTable = new chid [ total ];
 
     {
-        printf ( "Connecting to CA Channel \"%s\" %u times.", 
-                    pName, count );
+        if ( nNames == 1u ) {
+            printf ( "Connecting to CA Channel \"%s\" %u times.", 
+                        names[0].c_str (), count );
+        }
+        else {
+            printf ( "Connecting to %u CA Channels %u times.", 
+                        nNames, count );
+        }
         fflush ( stdout );
     
         epicsTime begin = epicsTime::getCurrent ();
-        for ( unsigned i = 0u; i < count; i++ ) {
-            int status = ca_search ( pName,  & pChidTable[i] );
+        for ( unsigned i = 0u; i < total; i++ ) {
+            int status = ca_search ( names[i % nNames].c_str (),
+                & pChidTable[i] );
             SEVCHK ( status, NULL );
         }
     
@@ -59,11 +101,11 @@ void caEventRate ( const char *pName, unsigned count )
     }
 
     {
-        printf ( "Subscribing %u times.", count );
+        printf ( "Subscribing %u times.", total );
         fflush ( stdout );
         
         epicsTime begin = epicsTime::getCurrent ();
-        for ( unsigned i = 0u; i < count; i++ ) {
+        for ( unsigned i = 0u; i < total; i++ ) {
             int addEventStatus = ca_add_event ( DBR_FLOAT, 
                 pChidTable[i], eventCallBack, &eventCount, NULL);
             SEVCHK ( addEventStatus, __FILE__ );
@@ -83,7 +125,7 @@ void caEventRate ( const char *pName, unsigned count )
     
         // let the first one go by 
         epicsTime begin = epicsTime::getCurrent ();
-        while ( eventCount < count ) {
+        while ( epicsAtomicGetSizeT ( & eventCount ) < total ) {
             int status = ca_pend_event ( 0.01 );
             if ( status != ECA_TIMEOUT ) {
                 SEVCHK ( status, NULL );
@@ -99,23 +141,19 @@ void caEventRate ( const char *pName, unsigned count )
     double XX = 0.0;
     unsigned N = 0u;
     while ( true ) {
-        unsigned nEvents, lastEventCount, curEventCount;
+        size_t nEvents, lastEventCount, curEventCount;
 
         epicsTime beginPend = epicsTime::getCurrent ();
-        lastEventCount = eventCount;
+        lastEventCount = epicsAtomicGetSizeT ( & eventCount );
         int status = ca_pend_event ( samplePeriod );
-        curEventCount = eventCount;
+        curEventCount = epicsAtomicGetSizeT ( & eventCount );
         epicsTime endPend = epicsTime::getCurrent ();
         if ( status != ECA_TIMEOUT ) {
             SEVCHK ( status, NULL );
         }
 
-        if ( curEventCount >= lastEventCount ) {
-            nEvents = curEventCount - lastEventCount;
-        }
-        else {
-            nEvents = ( UINT_MAX - lastEventCount ) + curEventCount + 1u;
-        }
+        // unsigned arithmetic takes care of the counter wrapping
+        nEvents = curEventCount - lastEventCount;
 
         N++;
 
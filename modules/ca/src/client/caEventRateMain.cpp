@@ -10,13 +10,23 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-void caEventRate ( const char *pName, unsigned count );
+void caEventRate ( const char *pNames, unsigned count, bool preemptive );
 
 int main ( int argc, char **argv )
 {
+    const char * pProgName = argv[0];
+    bool preemptive = false;
+    if ( argc > 1 && strcmp ( argv[1], "-p" ) == 0 ) {
+        preemptive = true;
+        argc--;
+        argv++;
+    }
+
     if ( argc < 2 || argc > 3 ) {
-        fprintf ( stderr, "usage: %s < PV name > [subscription count]\n", argv[0] );
+        fprintf ( stderr, "usage: %s [-p] < PV name[,PV name...] > [subscription count]\n", pProgName );
+        fprintf ( stderr, "\t-p enable preemptive callbacks\n" );
         return 0;
     }
 
@@ -32,7 +42,7 @@ int main ( int argc, char **argv )
         count = 1;
     }
 
-    caEventRate ( argv[1], count );
+    caEventRate ( argv[1], count, preemptive );
 
     return 0;
 }
@@ -0,0 +1,300 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Memory mapped channel name to server map, see caNameCache.h
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   define CA_NAME_CACHE_MMAP
+#endif
+
+#include "epicsAtomic.h"
+#include "epicsString.h"
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "inetAddrID.h"
+#include "caNameCache.h"
+
+static const char caNameCacheMagic[8] = { 'C', 'A', 'N', 'A', 'M', 'E', 'S', '2' };
+
+struct caNameCacheServer {
+    epicsUInt32 addr;               // network byte order
+    epicsUInt16 port;               // network byte order
+    epicsUInt16 pad;
+    epicsUInt32 epoch;              // when forgotten, zero if unused
+};
+
+struct caNameCacheHeader {
+    char magic[8];
+    epicsUInt32 nSlots;
+    epicsUInt32 slotSize;
+    epicsUInt32 epoch;
+    epicsUInt32 floor;              // older slots are all stale
+    caNameCacheServer servers[caNameCacheServers];
+};
+
+caNameCache::caNameCache ( const char * pFileNameIn, void * pMapIn,
+        size_t mapSizeIn, unsigned nSlotsIn ) :
+    pHdr ( static_cast < caNameCacheHeader * > ( pMapIn ) ),
+    pSlots ( reinterpret_cast < slot * > (
+        static_cast < char * > ( pMapIn ) + sizeof ( caNameCacheHeader ) ) ),
+    pMap ( pMapIn ), mapSize ( mapSizeIn ),
+    pFileName ( epicsStrDup ( pFileNameIn ) ), nSlots ( nSlotsIn ),
+    nLookups ( 0ul ), nFound ( 0ul ), nUpdates ( 0ul ), nRemoved ( 0ul ),
+    nServersRemoved ( 0ul )
+{
+}
+
+caNameCache * caNameCache::create ( const char * pFileName )
+{
+#ifdef CA_NAME_CACHE_MMAP
+    size_t mapSize = sizeof ( caNameCacheHeader ) +
+        caNameCacheSlots * sizeof ( slot );
+    int fd = open ( pFileName, O_RDWR | O_CREAT, 0644 );
+    if ( fd < 0 ) {
+        errlogPrintf ( "CAC: unable to open name cache \"%s\" because \"%s\"\n",
+            pFileName, strerror ( errno ) );
+        return 0;
+    }
+    struct stat st;
+    if ( fstat ( fd, & st ) ||
+            ( static_cast < size_t > ( st.st_size ) != mapSize &&
+                ftruncate ( fd, static_cast < off_t > ( mapSize ) ) ) ) {
+        errlogPrintf ( "CAC: unable to size name cache \"%s\" because \"%s\"\n",
+            pFileName, strerror ( errno ) );
+        close ( fd );
+        return 0;
+    }
+    void * pMap = mmap ( 0, mapSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0 );
+    close ( fd );
+    if ( pMap == MAP_FAILED ) {
+        errlogPrintf ( "CAC: unable to map name cache \"%s\" because \"%s\"\n",
+            pFileName, strerror ( errno ) );
+        return 0;
+    }
+
+    // start over with a file written by an incompatible version
+    caNameCacheHeader * pHdr = static_cast < caNameCacheHeader * > ( pMap );
+    if ( memcmp ( pHdr->magic, caNameCacheMagic, sizeof ( pHdr->magic ) ) ||
+            pHdr->nSlots != caNameCacheSlots ||
+            pHdr->slotSize != sizeof ( slot ) ) {
+        memset ( pMap, 0, mapSize );
+        pHdr->nSlots = caNameCacheSlots;
+        pHdr->slotSize = sizeof ( slot );
+        memcpy ( pHdr->magic, caNameCacheMagic, sizeof ( pHdr->magic ) );
+    }
+
+    try {
+        return new caNameCache ( pFileName, pMap, mapSize, caNameCacheSlots );
+    }
+    catch ( ... ) {
+        munmap ( pMap, mapSize );
+        return 0;
+    }
+#else
+    errlogPrintf ( "CAC: the name cache \"%s\" isn't available on this system\n",
+        pFileName );
+    return 0;
+#endif
+}
+
+caNameCache::~caNameCache ()
+{
+#ifdef CA_NAME_CACHE_MMAP
+    munmap ( this->pMap, this->mapSize );
+#endif
+    free ( this->pFileName );
+}
+
+// 64 bit FNV-1a, zero marks an empty slot
+epicsUInt64 caNameCache::hash ( const char * pName )
+{
+    epicsUInt64 h = 14695981039346656037ull;
+    while ( *pName ) {
+        h ^= static_cast < unsigned char > ( *pName++ );
+        h *= 1099511628211ull;
+    }
+    return h ? h : 1u;
+}
+
+// a copy of the slot holding the key, checked against a
+// concurrent writer in another process
+caNameCache::slot * caNameCache::find ( epicsUInt64 key, slot & copy ) const
+{
+    unsigned mask = this->nSlots - 1u;
+    unsigned index = static_cast < unsigned > ( key ) & mask;
+    for ( unsigned i = 0u; i < caNameCacheProbes; i++ ) {
+        slot & s = this->pSlots[ ( index + i ) & mask ];
+        if ( s.key == key ) {
+            epicsAtomicReadMemoryBarrier ();
+            copy = s;
+            epicsAtomicReadMemoryBarrier ();
+            if ( copy.key == key && s.key == key ) {
+                return & s;
+            }
+        }
+    }
+    return 0;
+}
+
+bool caNameCache::stale ( const slot & copy ) const
+{
+    if ( copy.epoch < this->pHdr->floor ) {
+        return true;
+    }
+    for ( unsigned i = 0u; i < caNameCacheServers; i++ ) {
+        const caNameCacheServer & server = this->pHdr->servers[i];
+        if ( server.epoch && server.addr == copy.addr &&
+                server.port == copy.port ) {
+            return copy.epoch < server.epoch;
+        }
+    }
+    return false;
+}
+
+void caNameCache::write ( slot & s, epicsUInt64 key,
+    const osiSockAddr & addr, unsigned minorVersion, epicsUInt32 epoch )
+{
+    s.key = 0u;
+    epicsAtomicWriteMemoryBarrier ();
+    s.addr = addr.ia.sin_addr.s_addr;
+    s.port = addr.ia.sin_port;
+    s.minorVersion = static_cast < epicsUInt16 > ( minorVersion );
+    s.epoch = epoch;
+    epicsAtomicWriteMemoryBarrier ();
+    s.key = key;
+}
+
+bool caNameCache::lookup ( const char * pName,
+    osiSockAddr & addr, unsigned & minorVersion )
+{
+    this->nLookups++;
+    slot copy;
+    if ( ! this->find ( hash ( pName ), copy ) || this->stale ( copy ) ) {
+        return false;
+    }
+    memset ( & addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = copy.addr;
+    addr.ia.sin_port = copy.port;
+    minorVersion = copy.minorVersion;
+    this->nFound++;
+    return true;
+}
+
+void caNameCache::update ( const char * pName,
+    const osiSockAddr & addr, unsigned minorVersion )
+{
+    if ( addr.sa.sa_family != AF_INET ) {
+        return;
+    }
+    epicsUInt64 key = hash ( pName );
+    slot copy;
+    slot * pSlot = this->find ( key, copy );
+    if ( pSlot ) {
+        if ( copy.addr == addr.ia.sin_addr.s_addr &&
+                copy.port == addr.ia.sin_port &&
+                copy.minorVersion == minorVersion &&
+                ! this->stale ( copy ) ) {
+            return;
+        }
+    }
+    else {
+        // the first free or stale slot, or else evict the first one probed
+        unsigned mask = this->nSlots - 1u;
+        unsigned index = static_cast < unsigned > ( key ) & mask;
+        pSlot = & this->pSlots[index];
+        for ( unsigned i = 0u; i < caNameCacheProbes; i++ ) {
+            slot & s = this->pSlots[ ( index + i ) & mask ];
+            if ( s.key == 0u || this->stale ( s ) ) {
+                pSlot = & s;
+                break;
+            }
+        }
+    }
+    write ( *pSlot, key, addr, minorVersion, this->pHdr->epoch );
+    this->nUpdates++;
+}
+
+void caNameCache::remove ( const char * pName, const osiSockAddr & addr )
+{
+    slot copy;
+    slot * pSlot = this->find ( hash ( pName ), copy );
+    if ( pSlot && addr.sa.sa_family == AF_INET &&
+            copy.addr == addr.ia.sin_addr.s_addr &&
+            copy.port == addr.ia.sin_port ) {
+        pSlot->key = 0u;
+        this->nRemoved++;
+    }
+}
+
+void caNameCache::removeServer ( const inetAddrID & addr )
+{
+    const struct sockaddr_in & ina = addr.sockAddr ();
+    caNameCacheHeader & hdr = * this->pHdr;
+
+    // this server's entry, or else an unused or the oldest one
+    caNameCacheServer * pServer = & hdr.servers[0];
+    for ( unsigned i = 0u; i < caNameCacheServers; i++ ) {
+        caNameCacheServer & server = hdr.servers[i];
+        if ( server.epoch && server.addr == ina.sin_addr.s_addr &&
+                server.port == ina.sin_port ) {
+            pServer = & server;
+            break;
+        }
+        if ( server.epoch < pServer->epoch ) {
+            pServer = & server;
+        }
+    }
+    if ( pServer->addr != ina.sin_addr.s_addr ||
+            pServer->port != ina.sin_port ) {
+        if ( pServer->epoch > hdr.floor ) {
+            hdr.floor = pServer->epoch;
+        }
+        pServer->epoch = 0u;
+        epicsAtomicWriteMemoryBarrier ();
+        pServer->addr = ina.sin_addr.s_addr;
+        pServer->port = ina.sin_port;
+    }
+    // slots written from now on are newer than the server's epoch
+    hdr.epoch++;
+    epicsAtomicWriteMemoryBarrier ();
+    pServer->epoch = hdr.epoch;
+    this->nServersRemoved++;
+}
+
+void caNameCache::show ( unsigned level ) const
+{
+    ::printf ( "\tname cache \"%s\": %lu lookups, %lu found, "
+        "%lu updates, %lu removed, %lu servers removed\n", this->pFileName,
+        this->nLookups, this->nFound, this->nUpdates, this->nRemoved,
+        this->nServersRemoved );
+    if ( level > 0u ) {
+        unsigned nUsed = 0u;
+        unsigned nStale = 0u;
+        for ( unsigned i = 0u; i < this->nSlots; i++ ) {
+            if ( this->pSlots[i].key ) {
+                nUsed++;
+                if ( this->stale ( this->pSlots[i] ) ) {
+                    nStale++;
+                }
+            }
+        }
+        ::printf ( "\t%u of %u slots in use, %u stale, epoch %u\n",
+            nUsed, this->nSlots, nStale, this->pHdr->epoch );
+    }
+}
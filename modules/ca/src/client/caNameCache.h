@@ -0,0 +1,90 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * A persistent map from channel names to the server that last
+ * connected them, see EPICS_CA_NAME_CACHE.
+ *
+ * The file is a fixed size hash table memory mapped into the
+ * client. Each slot holds a 64 bit hash of a channel name and
+ * the server's address and minor protocol version. The names
+ * themselves are not stored, since an entry is only a hint which
+ * the server must confirm before the channel connects, so an
+ * occasional hash collision just costs one unanswered request.
+ *
+ * Forgetting a server doesn't visit the slots. The header holds
+ * a small table of the servers forgotten most recently, with the
+ * epoch at which each was, and a slot written before its server's
+ * epoch is stale. A server pushed out of the table raises a floor
+ * epoch below which every slot is stale.
+ *
+ * Several processes may share the file. A slot's key is written
+ * last, after a write barrier, and a reader checks that the key
+ * is unchanged after copying the slot, so it never uses a half
+ * written entry. Two writers racing on one slot may still mix
+ * their entries, which only costs one unanswered request.
+ *
+ * The map is only available where mmap is (Unix). The caller
+ * provides the mutual exclusion within a process.
+ */
+
+#ifndef caNameCacheh
+#define caNameCacheh
+
+#include "epicsTypes.h"
+#include "osiSock.h"
+
+class inetAddrID;
+struct caNameCacheHeader;
+
+static const unsigned caNameCacheSlots = 1u << 19u; // 12M bytes
+static const unsigned caNameCacheProbes = 8u;
+static const unsigned caNameCacheServers = 32u;
+
+class caNameCache {
+public:
+    // returns NULL if the file can't be used
+    static caNameCache * create ( const char * pFileName );
+    ~caNameCache ();
+    bool lookup ( const char * pName,
+        osiSockAddr & addr, unsigned & minorVersion );
+    void update ( const char * pName,
+        const osiSockAddr & addr, unsigned minorVersion );
+    // removes the entry only if it still names this server
+    void remove ( const char * pName, const osiSockAddr & addr );
+    // the server's entries become stale, in constant time
+    void removeServer ( const inetAddrID & addr );
+    void show ( unsigned level ) const;
+    static epicsUInt64 hash ( const char * pName );
+private:
+    struct slot {
+        epicsUInt64 key;            // written last, zero when free
+        epicsUInt32 addr;           // network byte order
+        epicsUInt16 port;           // network byte order
+        epicsUInt16 minorVersion;
+        epicsUInt32 epoch;          // when written
+    };
+    caNameCacheHeader * pHdr;
+    slot * pSlots;
+    void * pMap;
+    size_t mapSize;
+    char * pFileName;
+    unsigned nSlots;
+    unsigned long nLookups;
+    unsigned long nFound;
+    unsigned long nUpdates;
+    unsigned long nRemoved;
+    unsigned long nServersRemoved;
+    caNameCache ( const char * pFileName, void * pMap,
+        size_t mapSize, unsigned nSlots );
+    slot * find ( epicsUInt64 key, slot & copy ) const;
+    bool stale ( const slot & copy ) const;
+    static void write ( slot & s, epicsUInt64 key, const osiSockAddr & addr,
+        unsigned minorVersion, epicsUInt32 epoch );
+    caNameCache ( const caNameCache & );
+    caNameCache & operator = ( const caNameCache & );
+};
+
+#endif // ifndef caNameCacheh
@@ -0,0 +1,89 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * caNameServer
+ *
+ * Resolves channel names over TCP on behalf of the IOCs that register
+ * with it. An IOC that lists this server in EPICS_CAS_NAME_SERVERS
+ * connects to it when it starts and sends the names of all of its
+ * records (CA_PROTO_NAME_REGISTER). Clients that list this server in
+ * EPICS_CA_NAME_SERVERS send it their search requests, and those for
+ * registered names are answered with the address of the IOC, so the
+ * client connects to the IOC directly. The names of an IOC are
+ * forgotten when its connection to this server closes.
+ *
+ * The server listens on EPICS_CAS_SERVER_PORT, or EPICS_CA_SERVER_PORT
+ * if that isn't set, at the first address in EPICS_CAS_INTF_ADDR_LIST,
+ * or at all of the host's addresses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osiSock.h"
+#include "envDefs.h"
+#include "addrList.h"
+#include "epicsSignal.h"
+#include "errlog.h"
+#include "caProto.h"
+#include "udpiiu.h"
+
+int main ()
+{
+    osiSockAttach ();
+    epicsSignalInstallSigPipeIgnore ();
+
+    unsigned short port;
+    if ( envGetConfigParamPtr ( & EPICS_CAS_SERVER_PORT ) ) {
+        port = envGetInetPortConfigParam ( & EPICS_CAS_SERVER_PORT,
+            static_cast < unsigned short > ( CA_SERVER_PORT ) );
+    }
+    else {
+        port = envGetInetPortConfigParam ( & EPICS_CA_SERVER_PORT,
+            static_cast < unsigned short > ( CA_SERVER_PORT ) );
+    }
+
+    osiSockAddr addr;
+    memset ( & addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl ( INADDR_ANY );
+    {
+        ELLLIST intfList = ELLLIST_INIT;
+        addAddrToChannelAccessAddressList ( & intfList,
+            & EPICS_CAS_INTF_ADDR_LIST, port, false );
+        osiSockAddrNode * pNode =
+            reinterpret_cast < osiSockAddrNode * > ( ellFirst ( & intfList ) );
+        if ( pNode ) {
+            addr.ia.sin_addr = pNode->addr.ia.sin_addr;
+        }
+        ellFree ( & intfList );
+    }
+    addr.ia.sin_port = htons ( port );
+
+    SOCKET sock = epicsSocketCreate ( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+    if ( sock == INVALID_SOCKET ) {
+        errlogPrintf ( "caNameServer: unable to create a socket\n" );
+        return 1;
+    }
+    epicsSocketEnableAddressReuseDuringTimeWaitState ( sock );
+    char buf[64];
+    ipAddrToDottedIP ( & addr.ia, buf, sizeof ( buf ) );
+    if ( bind ( sock, & addr.sa, sizeof ( addr.ia ) ) < 0 ||
+            listen ( sock, 20 ) < 0 ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "caNameServer: unable to listen at %s because \"%s\"\n",
+            buf, sockErrBuf );
+        epicsSocketDestroy ( sock );
+        return 1;
+    }
+    errlogPrintf ( "caNameServer: listening at %s\n", buf );
+
+    caNameServerThread ( & sock );
+    return 0;
+}
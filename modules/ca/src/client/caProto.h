@@ -109,8 +109,9 @@ typedef ca_uint32_t     caResId;
 #define CA_PROTO_SIGNAL         25u /* knock the server out of select */
 #define CA_PROTO_CREATE_CH_FAIL 26u /* unable to create chan resource in server */
 #define CA_PROTO_SERVER_DISCONN 27u /* server deletes PV (or channel) */
+#define CA_PROTO_NAME_REGISTER  28u /* server registers its PV names with a name server */
 
-#define CA_PROTO_LAST_CMMD CA_PROTO_SERVER_DISCONN
+#define CA_PROTO_LAST_CMMD CA_PROTO_NAME_REGISTER
 
 /*
  * for use with search and not_found (if search fails and
@@ -124,6 +125,14 @@ typedef ca_uint32_t     caResId;
  */
 #define sequenceNoIsValid 1
 
+/*
+ * CA_PROTO_NAME_REGISTER carries m_count nil terminated PV names. The
+ * m_dataType field is the server's TCP port, m_cid its IP address (zero
+ * for the address that the message came from), and m_available is
+ * nonzero in the last message of a registration. A name server forgets
+ * the names when the circuit that registered them closes.
+ */
+
 /* size of object in bytes rounded up to nearest oct word */
 #define OCT_ROUND(A)    (((A)+7)/8)
 #define OCT_SIZEOF(A)   (OCT_ROUND(sizeof(A)))
@@ -83,7 +83,8 @@ ca_client_context::ca_client_context ( bool enablePreemptiveCallback ) :
                     this->mutex, this->cbMutex, *this ) );
         }
         else {
-            this->pServiceContext.reset ( new cac ( this->mutex, this->cbMutex, *this ) );
+            this->pServiceContext.reset ( new cac ( this->mutex, this->cbMutex,
+                *this, enablePreemptiveCallback ) );
         }
     }
 
@@ -721,7 +722,8 @@ epicsMutex & ca_client_context::mutexRef () const
 cacContext & ca_client_context::createNetworkContext (
     epicsMutex & mutexIn, epicsMutex & cbMutexIn )
 {
-    return * new cac ( mutexIn, cbMutexIn, *this );
+    return * new cac ( mutexIn, cbMutexIn, *this,
+        ! this->pCallbackGuard.get () );
 }
 
 void ca_client_context::installDefaultService ( cacService & service )
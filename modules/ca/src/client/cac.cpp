@@ -50,6 +50,7 @@
 #include "net_convert.h"
 #include "autoPtrFreeList.h"
 #include "noopiiu.h"
+#include "caNameCache.h"
 
 static const char pVersionCAC[] =
     "@(#) " EPICS_VERSION_STRING
@@ -73,7 +74,7 @@ const cac::pProtoStubTCP cac::tcpJumpTableCAC [] =
     &cac::exceptionRespAction,
     &cac::clearChannelRespAction,
     &cac::badTCPRespAction,
-    &cac::badTCPRespAction,
+    &cac::notHereRespAction,
     &cac::readNotifyRespAction,
     &cac::badTCPRespAction,
     &cac::badTCPRespAction,
@@ -128,7 +129,8 @@ const cac::pExcepProtoStubTCP cac::tcpExcepJumpTableCAC [] =
 cac::cac (
     epicsMutex & mutualExclusionIn,
     epicsMutex & callbackControlIn,
-    cacContextNotify & notifyIn ) :
+    cacContextNotify & notifyIn,
+    bool preemptiveCallback ) :
     _refLocalHostName ( localHostNameCache.getReference () ),
     programBeginTime ( epicsTime::getMonotonic() ),
     connTMO ( CA_CONN_VERIFY_PERIOD ),
@@ -139,6 +141,8 @@ cac::cac (
         lowestPriorityLevelAbove(epicsThreadGetPrioritySelf()) ) ),
     pUserName ( 0 ),
     pudpiiu ( 0 ),
+    pIOPool ( 0 ),
+    pNameCache ( 0 ),
     tcpSmallRecvBufFreeList ( 0 ),
     tcpLargeRecvBufFreeList ( 0 ),
     notify ( notifyIn ),
@@ -148,6 +152,11 @@ cac::cac (
     maxContigFrames ( contiguousMsgCountWhichTriggersFlowControl ),
     beaconAnomalyCount ( 0u ),
     iiuExistenceCount ( 0u ),
+    ioThreads ( 0u ),
+    nNameCacheHints ( 0ul ),
+    nNameCacheConfirmed ( 0ul ),
+    nNameCacheRefused ( 0ul ),
+    zeroCopySend ( false ),
     cacShutdownInProgress ( false )
 {
     if ( ! osiSockAttach () ) {
@@ -234,6 +243,30 @@ cac::cac (
             maxContigFrames = bufsPerArray *
                 contiguousMsgCountWhichTriggersFlowControl;
         }
+
+        // the circuits of a context with preemptive callbacks can
+        // be serviced by a pool of I/O threads, the callbacks of the
+        // others must wait for the application to poll
+        long ioThreadsAsALong;
+        status = envGetLongConfigParam ( &EPICS_CA_IO_THREADS, &ioThreadsAsALong );
+        if ( status || ioThreadsAsALong < 0 ) {
+            errlogPrintf ( "cac: EPICS_CA_IO_THREADS was not a positive integer\n" );
+        }
+        else if ( preemptiveCallback ) {
+            this->ioThreads = static_cast < unsigned > ( ioThreadsAsALong );
+        }
+
+        int zeroCopySendAsInt;
+        if ( envGetBoolConfigParam ( &EPICS_CA_ZERO_COPY_SEND, &zeroCopySendAsInt ) ) {
+            zeroCopySendAsInt = 0;
+        }
+        this->zeroCopySend = zeroCopySendAsInt != 0;
+
+        const char * pNameCacheFile =
+            envGetConfigParamPtr ( &EPICS_CA_NAME_CACHE );
+        if ( pNameCacheFile && *pNameCacheFile ) {
+            this->pNameCache = caNameCache::create ( pNameCacheFile );
+        }
     }
     catch ( ... ) {
         osiSockRelease ();
@@ -327,6 +360,9 @@ cac::~cac ()
         delete this->pudpiiu;
     }
 
+    delete this->pIOPool;
+    delete this->pNameCache;
+
     freeListCleanup ( this->tcpSmallRecvBufFreeList );
     if ( this->tcpLargeRecvBufFreeList ) {
         freeListCleanup ( this->tcpLargeRecvBufFreeList );
@@ -418,6 +454,21 @@ void cac::show (
     if ( level > 0u ) {
         this->serverTable.show ( level - 1u );
         ::printf ( "\tconnection time out watchdog period %f\n", this->connTMO );
+        tsDLIterConst < tcpiiu > iter = this->circuitList.firstIter ();
+        while ( iter.valid () ) {
+            iter->showSendStatistics ( guard );
+            iter++;
+        }
+        if ( this->pNameCache ) {
+            this->pNameCache->show ( level - 1u );
+            ::printf ( "\tname cache hints %lu, confirmed %lu, refused %lu\n",
+                this->nNameCacheHints, this->nNameCacheConfirmed,
+                this->nNameCacheRefused );
+        }
+    }
+
+    if ( level > 0u && this->pIOPool ) {
+        this->pIOPool->show ( level - 1u );
     }
 
     if ( level > 1u ) {
@@ -497,6 +548,11 @@ void cac::beaconNotify ( const inetAddrID & addr, const epicsTime & currentTime,
 
     this->pudpiiu->beaconAnomalyNotify ( guard );
 
+    // a restarted server may no longer have the same channels
+    if ( this->pNameCache ) {
+        this->pNameCache->removeServer ( addr );
+    }
+
 #   ifdef DEBUG
     {
         char buf[128];
@@ -548,12 +604,27 @@ bool cac::findOrCreateVirtCircuit (
     }
     else {
         try {
+            // name server circuits keep their own threads
+            tcpIOThread * pIOThread = 0;
+            if ( this->ioThreads && ! pSearchDest ) {
+                if ( ! this->pIOPool ) {
+                    this->pIOPool = tcpIOPool::create ( *this, this->ioThreads,
+                        highestPriorityLevelBelow ( this->initializingThreadsPriority ) );
+                    if ( ! this->pIOPool ) {
+                        this->ioThreads = 0u;
+                    }
+                }
+                if ( this->pIOPool ) {
+                    pIOThread = & this->pIOPool->assign ();
+                }
+            }
+
             autoPtrFreeList < tcpiiu, 32, epicsMutexNOOP > pnewiiu (
                     this->freeListVirtualCircuit,
                     new ( this->freeListVirtualCircuit ) tcpiiu (
                         *this, this->mutex, this->cbMutex, this->notify, this->connTMO,
                         this->timerQueue, addr, this->comBufMemMgr, minorVersionNumber,
-                        this->ipToAEngine, priority, pSearchDest ) );
+                        this->ipToAEngine, priority, pSearchDest, pIOThread ) );
 
             bhe * pBHE = this->beaconTable.lookup ( addr.ia );
             if ( ! pBHE ) {
@@ -1148,6 +1219,11 @@ bool cac::createChannelRespAction (
         }
         bool wasExpected = iiu.connectNotify ( guard, *pChan );
         if ( wasExpected ) {
+            if ( this->pNameCache ) {
+                this->pNameCache->update ( pChan->pName ( guard ),
+                    iiu.getNetworkAddress ( guard ),
+                    iiu.minorVersionNumber ( guard ) );
+            }
             pChan->connect ( hdr.m_dataType, hdr.m_count, sidTmp,
                 mgr.cbGuard, guard );
         }
@@ -1166,6 +1242,16 @@ bool cac::createChannelRespAction (
     return true;
 }
 
+// only sent in reply to a name cache hint
+bool cac::notHereRespAction (
+    callbackManager &, tcpiiu & iiu,
+    const epicsTime &, const caHdrLargeArray & hdr, void * /* pMsgBody */ )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->nameCacheReplyNotify ( guard, iiu, hdr.m_available, false );
+    return true;
+}
+
 bool cac::verifyAndDisconnectChan (
     callbackManager & mgr, tcpiiu &,
     const epicsTime &, const caHdrLargeArray & hdr, void * /* pMsgBody */ )
@@ -1243,6 +1329,10 @@ void cac::destroyIIU ( tcpiiu & iiu )
             if ( pBHE ) {
                 pBHE->unregisterIIU ( guard, iiu );
             }
+            // the server never answered the name cache hints
+            if ( this->pNameCache && iiu.nameCacheHintCount ( guard ) ) {
+                this->pNameCache->removeServer ( tmp );
+            }
         }
 
         assert ( this->pudpiiu );
@@ -1296,6 +1386,66 @@ void cac::initiateConnect (
     guard.assertIdenticalMutex ( this->mutex );
     assert ( this->pudpiiu );
     this->pudpiiu->installNewChannel ( guard, chan, piiu );
+    if ( this->pNameCache ) {
+        this->nameCacheSearch ( guard, chan );
+    }
+}
+
+//
+// Ask the server that last connected this channel, over TCP, if it
+// still has it. The UDP search continues, and whichever reply arrives
+// first connects the channel.
+//
+void cac::nameCacheSearch (
+    epicsGuard < epicsMutex > & guard, nciu & chan )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    osiSockAddr addr;
+    unsigned minorVersion;
+    if ( ! this->pNameCache->lookup ( chan.pName ( guard ),
+            addr, minorVersion ) ) {
+        return;
+    }
+    // older servers dont resolve names over TCP
+    if ( ! CA_V412 ( minorVersion ) ) {
+        return;
+    }
+
+    caServerID servID ( addr.ia, chan.getPriority ( guard ) );
+    tcpiiu * piiu = this->serverTable.lookup ( servID );
+    bool newIIU = this->findOrCreateVirtCircuit ( guard, addr,
+        chan.getPriority ( guard ), piiu, minorVersion );
+    if ( ! piiu ) {
+        return;
+    }
+    if ( newIIU ) {
+        piiu->start ( guard );
+    }
+    if ( piiu->alive ( guard ) ) {
+        piiu->nameCacheSearchRequest ( guard, chan );
+        this->nNameCacheHints++;
+    }
+}
+
+void cac::nameCacheReplyNotify (
+    epicsGuard < epicsMutex > & guard, tcpiiu & iiu,
+    unsigned cid, bool found )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    if ( found ) {
+        this->nNameCacheConfirmed++;
+    }
+    else {
+        this->nNameCacheRefused++;
+        nciu * pChan = this->chanTable.lookup ( cid );
+        if ( pChan && this->pNameCache ) {
+            this->pNameCache->remove ( pChan->pName ( guard ),
+                iiu.getNetworkAddress ( guard ) );
+        }
+    }
+    iiu.nameCacheHintDone ( guard );
 }
 
 void *cacComBufMemoryManager::allocate ( size_t size )
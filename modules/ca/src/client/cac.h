@@ -112,7 +112,8 @@ public:
     cac (
         epicsMutex & mutualExclusion,
         epicsMutex & callbackControl,
-        cacContextNotify & );
+        cacContextNotify &,
+        bool preemptiveCallback = false );
     virtual ~cac ();
 
     // beacon management
@@ -199,6 +200,7 @@ public:
     // misc
     const char * userNamePointer () const;
     unsigned getInitializingThreadsPriority () const;
+    bool zeroCopySendEnabled () const;
     epicsMutex & mutexRef ();
     void attachToClientCtx ();
     void selfTest (
@@ -265,6 +267,8 @@ private:
     epicsTimerQueueActive & timerQueue;
     char * pUserName;
     class udpiiu * pudpiiu;
+    class tcpIOPool * pIOPool;
+    class caNameCache * pNameCache;
     void * tcpSmallRecvBufFreeList;
     void * tcpLargeRecvBufFreeList;
     cacContextNotify & notify;
@@ -275,6 +279,11 @@ private:
     unsigned beaconAnomalyCount;
     unsigned short _serverPort;
     unsigned iiuExistenceCount;
+    unsigned ioThreads;
+    unsigned long nNameCacheHints;
+    unsigned long nNameCacheConfirmed;
+    unsigned long nNameCacheRefused;
+    bool zeroCopySend;
     bool cacShutdownInProgress;
 
     void recycleReadNotifyIO (
@@ -296,6 +305,12 @@ private:
     void pvMultiplyDefinedNotify ( msgForMultiplyDefinedPV & mfmdpv,
         const char * pChannelName, const char * pAcc, const char * pRej );
 
+    // name cache
+    void nameCacheSearch (
+        epicsGuard < epicsMutex > &, nciu & );
+    void nameCacheReplyNotify (
+        epicsGuard < epicsMutex > &, tcpiiu &, unsigned cid, bool found );
+
     // recv protocol stubs
     bool versionAction ( callbackManager &, tcpiiu &,
         const epicsTime & currentTime, const caHdrLargeArray &, void *pMsgBdy );
@@ -321,6 +336,8 @@ private:
         const epicsTime & currentTime, const caHdrLargeArray &, void *pMsgBdy );
     bool verifyAndDisconnectChan ( callbackManager &, tcpiiu &,
         const epicsTime & currentTime, const caHdrLargeArray &, void *pMsgBdy );
+    bool notHereRespAction ( callbackManager &, tcpiiu &,
+        const epicsTime & currentTime, const caHdrLargeArray &, void *pMsgBdy );
     bool badTCPRespAction ( callbackManager &, tcpiiu &,
         const epicsTime & currentTime, const caHdrLargeArray &, void *pMsgBdy );
 
@@ -364,6 +381,11 @@ inline unsigned cac::getInitializingThreadsPriority () const
     return this->initializingThreadsPriority;
 }
 
+inline bool cac::zeroCopySendEnabled () const
+{
+    return this->zeroCopySend;
+}
+
 inline epicsMutex & cac::mutexRef ()
 {
     return this->mutex;
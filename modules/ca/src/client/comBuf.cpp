@@ -45,6 +45,46 @@ bool comBuf::flushToWire ( wireSendAdapter & wire, const epicsTime & currentTime
     return true;
 }
 
+// sends the buffers with as few calls to the wire as it allows,
+// the bytes sent are removed from the buffers
+bool comBuf::flushToWire ( wireSendAdapter & wire, comBuf * const * ppBufs, 
+    unsigned nBufs, const epicsTime & currentTime )
+{
+    wireSendBuf bufs [ comBufGatherMax ];
+    unsigned first = 0u;
+    while ( true ) {
+        while ( first < nBufs && ppBufs[first]->occupiedBytes () == 0u ) {
+            first++;
+        }
+        if ( first >= nBufs ) {
+            return true;
+        }
+        unsigned n = 0u;
+        for ( unsigned i = first; i < nBufs && n < comBufGatherMax; i++ ) {
+            comBuf & buf = *ppBufs[i];
+            bufs[n].pBuf = & buf.buf[buf.nextReadIndex];
+            bufs[n].nBytes = buf.commitIndex - buf.nextReadIndex;
+            n++;
+        }
+        unsigned nBytes = wire.sendBytes ( bufs, n, currentTime );
+        if ( nBytes == 0u ) {
+            return false;
+        }
+        for ( unsigned i = first; nBytes > 0u && i < nBufs; i++ ) {
+            nBytes -= ppBufs[i]->removeBytes ( nBytes );
+        }
+    }
+}
+
+unsigned wireSendAdapter::sendBytes ( const wireSendBuf * pBufs, 
+    unsigned nBufs, const epicsTime & currentTime )
+{
+    if ( nBufs == 0u ) {
+        return 0u;
+    }
+    return this->sendBytes ( pBufs[0].pBuf, pBufs[0].nBytes, currentTime );
+}
+
 // throwing the exception from a function that isnt inline 
 // shrinks the GNU compiled object code
 void comBuf::throwInsufficentBytesException () 
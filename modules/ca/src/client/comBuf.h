@@ -36,6 +36,9 @@
 
 static const unsigned comBufSize = 0x4000;
 
+// the most buffers passed to one gathered send
+static const unsigned comBufGatherMax = 64u;
+
 // this wrapper avoids Tornado 2.0.1 compiler bugs
 class comBufMemoryManager {
 public:
@@ -44,11 +47,20 @@ public:
     virtual void release ( void * ) = 0; 
 };
 
+struct wireSendBuf {
+    const void * pBuf;
+    unsigned nBytes;
+};
+
 class wireSendAdapter {
 public:
     virtual unsigned sendBytes ( const void * pBuf, 
         unsigned nBytesInBuf, 
         const class epicsTime & currentTime ) = 0;
+    // gathered send of several buffers, returns the number of bytes
+    // sent, by default only the first buffer is sent
+    virtual unsigned sendBytes ( const wireSendBuf * pBufs, 
+        unsigned nBufs, const class epicsTime & currentTime );
 protected:
     virtual ~wireSendAdapter() {}
 };
@@ -98,6 +110,8 @@ public:
     bool copyOutAllBytes ( void *pBuf, unsigned nBytes );
     unsigned removeBytes ( unsigned nBytes );
     bool flushToWire ( wireSendAdapter &, const epicsTime & currentTime );
+    static bool flushToWire ( wireSendAdapter &, comBuf * const * ppBufs, 
+        unsigned nBufs, const epicsTime & currentTime );
     void fillFromWire ( wireRecvAdapter &, statusWireIO & );
     struct popStatus {
         bool success;
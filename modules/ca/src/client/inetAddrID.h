@@ -31,6 +31,7 @@ public:
     bool operator == ( const inetAddrID & ) const;
     resTableIndex hash () const;
     void name ( char *pBuf, unsigned bufSize ) const;
+    const struct sockaddr_in & sockAddr () const;
 private:
     struct sockaddr_in addr;
 };
@@ -67,6 +68,11 @@ inline void inetAddrID::name ( char *pBuf, unsigned bufSize ) const
     ipAddrToDottedIP ( &this->addr, pBuf, bufSize );
 }
 
+inline const struct sockaddr_in & inetAddrID::sockAddr () const
+{
+    return this->addr;
+}
+
 #endif // ifdef inetAddrID
 
 
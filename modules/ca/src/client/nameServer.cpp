@@ -0,0 +1,365 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * The CA name server run by caNameServer, see caNameServer.cpp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osiSock.h"
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+#include "epicsThread.h"
+#include "resourceLib.h"
+#include "tsDLList.h"
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "caProto.h"
+#include "udpiiu.h"
+
+static const unsigned nameServerMinorVersion = 13u; // CA V4.13
+static const unsigned nameServerBufSize = 4u * MAX_TCP;
+// longest record name that is looked up
+static const unsigned nameServerMaxRecordName = 256u;
+
+class nameServerIOC;
+
+class nameEntry :
+    public tsSLNode < nameEntry >,
+    public tsDLNode < nameEntry >,
+    public stringId {
+public:
+    nameEntry ( const char * pName, nameServerIOC & iocIn ) :
+        stringId ( pName ), pIOC ( & iocIn ) {}
+    nameServerIOC * pIOC;
+};
+
+// the names registered by one IOC
+class nameServerIOC {
+public:
+    nameServerIOC ( const osiSockAddr & addrIn ) :
+        addr ( addrIn ), nDuplicates ( 0u ) {}
+    osiSockAddr addr;
+    tsDLList < nameEntry > names;
+    unsigned nDuplicates;
+};
+
+class caNameServer {
+public:
+    caNameServer ( SOCKET listenSock );
+    void run ();
+    void circuit ( SOCKET sock, const osiSockAddr & peer );
+private:
+    epicsMutex mutex;
+    resTable < nameEntry, stringId > index;
+    SOCKET listenSock;
+    bool lookup ( const char * pName, osiSockAddr & addr );
+    unsigned registerNames ( nameServerIOC & ioc,
+        const char * pNames, unsigned nBytes );
+    unsigned removeNames ( nameServerIOC & ioc );
+};
+
+struct nameServerCircuitParm {
+    caNameServer * pServer;
+    SOCKET sock;
+    osiSockAddr peer;
+};
+
+static void nameServerHeader ( char * pBuf, unsigned cmmd,
+    unsigned dataType, unsigned count, ca_uint32_t cid, ca_uint32_t available )
+{
+    caHdr hdr;
+    hdr.m_cmmd = htons ( static_cast < ca_uint16_t > ( cmmd ) );
+    hdr.m_postsize = htons ( 0u );
+    hdr.m_dataType = htons ( static_cast < ca_uint16_t > ( dataType ) );
+    hdr.m_count = htons ( static_cast < ca_uint16_t > ( count ) );
+    hdr.m_cid = htonl ( cid );
+    hdr.m_available = htonl ( available );
+    memcpy ( pBuf, & hdr, sizeof ( hdr ) );
+}
+
+static bool nameServerSend ( SOCKET sock, const char * pBuf, unsigned nBytes )
+{
+    while ( nBytes ) {
+        int status = send ( sock, pBuf, static_cast < int > ( nBytes ), 0 );
+        if ( status <= 0 ) {
+            return false;
+        }
+        pBuf += status;
+        nBytes -= static_cast < unsigned > ( status );
+    }
+    return true;
+}
+
+caNameServer::caNameServer ( SOCKET listenSockIn ) :
+    listenSock ( listenSockIn )
+{
+}
+
+bool caNameServer::lookup ( const char * pName, osiSockAddr & addr )
+{
+    // the record name, without any field name or channel filters
+    char recordName [ nameServerMaxRecordName ];
+    unsigned len = static_cast < unsigned > ( strcspn ( pName, ".{" ) );
+    if ( len == 0u || len >= sizeof ( recordName ) ) {
+        return false;
+    }
+    memcpy ( recordName, pName, len );
+    recordName[len] = '\0';
+
+    stringId id ( recordName, stringId::refString );
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    nameEntry * pEntry = this->index.lookup ( id );
+    if ( ! pEntry ) {
+        return false;
+    }
+    addr = pEntry->pIOC->addr;
+    return true;
+}
+
+// returns the number of names that the IOC has registered, which
+// other circuits may take from it
+unsigned caNameServer::registerNames ( nameServerIOC & ioc,
+    const char * pNames, unsigned nBytes )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    const char * pEnd = pNames + nBytes;
+    while ( pNames < pEnd ) {
+        const char * pNil = static_cast < const char * > (
+            memchr ( pNames, '\0', pEnd - pNames ) );
+        // stop at the padding, or at a name that isn't terminated
+        if ( ! pNil || pNil == pNames ) {
+            break;
+        }
+        stringId id ( pNames, stringId::refString );
+        nameEntry * pEntry = this->index.lookup ( id );
+        if ( ! pEntry ) {
+            pEntry = new nameEntry ( pNames, ioc );
+            this->index.add ( *pEntry );
+            ioc.names.add ( *pEntry );
+        }
+        else if ( pEntry->pIOC != & ioc ) {
+            // the same IOC registering again before the name server
+            // noticed that its old connection was lost
+            if ( sockAddrAreIdentical ( & pEntry->pIOC->addr, & ioc.addr ) ) {
+                pEntry->pIOC->names.remove ( *pEntry );
+                pEntry->pIOC = & ioc;
+                ioc.names.add ( *pEntry );
+            }
+            else {
+                ioc.nDuplicates++;
+            }
+        }
+        pNames = pNil + 1;
+    }
+    return ioc.names.count ();
+}
+
+// returns the number of names removed
+unsigned caNameServer::removeNames ( nameServerIOC & ioc )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    unsigned nNames = 0u;
+    while ( nameEntry * pEntry = ioc.names.get () ) {
+        this->index.remove ( *pEntry );
+        delete pEntry;
+        nNames++;
+    }
+    return nNames;
+}
+
+void caNameServer::circuit ( SOCKET sock, const osiSockAddr & peer )
+{
+    char * pRecvBuf = new char [ nameServerBufSize ];
+    char * pSendBuf = new char [ nameServerBufSize ];
+    unsigned nRecvBytes = 0u;
+    unsigned nSendBytes = 0u;
+    nameServerIOC * pIOC = 0;
+    bool ok = true;
+
+    nameServerHeader ( pSendBuf, CA_PROTO_VERSION, 0u,
+        nameServerMinorVersion, 0u, 0u );
+    nSendBytes = sizeof ( caHdr );
+
+    while ( ok ) {
+        if ( nSendBytes ) {
+            ok = nameServerSend ( sock, pSendBuf, nSendBytes );
+            nSendBytes = 0u;
+            if ( ! ok ) {
+                break;
+            }
+        }
+        int status = recv ( sock, & pRecvBuf[nRecvBytes],
+            static_cast < int > ( nameServerBufSize - nRecvBytes ), 0 );
+        if ( status <= 0 ) {
+            break;
+        }
+        nRecvBytes += static_cast < unsigned > ( status );
+
+        // answer all of the complete messages at once
+        unsigned pos = 0u;
+        while ( nRecvBytes - pos >= sizeof ( caHdr ) ) {
+            caHdr hdr;
+            memcpy ( & hdr, & pRecvBuf[pos], sizeof ( hdr ) );
+            unsigned headerSize = sizeof ( caHdr );
+            ca_uint32_t postsize = ntohs ( hdr.m_postsize );
+            if ( postsize == 0xffff ) {
+                // large header, with the payload size and count following
+                ca_uint32_t ext[2];
+                headerSize += sizeof ( ext );
+                if ( nRecvBytes - pos < headerSize ) {
+                    break;
+                }
+                memcpy ( ext, & pRecvBuf[pos + sizeof ( caHdr )], sizeof ( ext ) );
+                postsize = ntohl ( ext[0] );
+            }
+            if ( postsize > nameServerBufSize - headerSize ) {
+                errlogPrintf ( "caNameServer: %u byte message is too large\n",
+                    postsize );
+                ok = false;
+                break;
+            }
+            if ( nRecvBytes - pos < headerSize + postsize ) {
+                break;
+            }
+            char * pPayload = & pRecvBuf[pos + headerSize];
+            pos += headerSize + postsize;
+
+            // room for one reply
+            if ( nSendBytes + sizeof ( caHdr ) > nameServerBufSize ) {
+                ok = nameServerSend ( sock, pSendBuf, nSendBytes );
+                nSendBytes = 0u;
+                if ( ! ok ) {
+                    break;
+                }
+            }
+
+            unsigned cmmd = ntohs ( hdr.m_cmmd );
+            if ( cmmd == CA_PROTO_SEARCH ) {
+                if ( postsize <= 1u ) {
+                    continue;
+                }
+                pPayload[postsize - 1u] = '\0';
+                osiSockAddr addr;
+                if ( this->lookup ( pPayload, addr ) ) {
+                    nameServerHeader ( & pSendBuf[nSendBytes], CA_PROTO_SEARCH,
+                        ntohs ( addr.ia.sin_port ), 0u,
+                        ntohl ( addr.ia.sin_addr.s_addr ),
+                        ntohl ( hdr.m_available ) );
+                    nSendBytes += sizeof ( caHdr );
+                }
+                else if ( ntohs ( hdr.m_dataType ) == DOREPLY ) {
+                    nameServerHeader ( & pSendBuf[nSendBytes], CA_PROTO_NOT_FOUND,
+                        DOREPLY, nameServerMinorVersion, ntohl ( hdr.m_cid ),
+                        ntohl ( hdr.m_available ) );
+                    nSendBytes += sizeof ( caHdr );
+                }
+            }
+            else if ( cmmd == CA_PROTO_ECHO ) {
+                nameServerHeader ( & pSendBuf[nSendBytes], CA_PROTO_ECHO,
+                    0u, 0u, 0u, 0u );
+                nSendBytes += sizeof ( caHdr );
+            }
+            else if ( cmmd == CA_PROTO_NAME_REGISTER ) {
+                if ( ! pIOC ) {
+                    osiSockAddr iocAddr = peer;
+                    ca_uint32_t iocIP = ntohl ( hdr.m_cid );
+                    if ( iocIP ) {
+                        iocAddr.ia.sin_addr.s_addr = htonl ( iocIP );
+                    }
+                    iocAddr.ia.sin_port = hdr.m_dataType;
+                    pIOC = new nameServerIOC ( iocAddr );
+                }
+                unsigned nNames = this->registerNames ( *pIOC,
+                    pPayload, postsize );
+                if ( ntohl ( hdr.m_available ) ) {
+                    char buf[64];
+                    ipAddrToDottedIP ( & pIOC->addr.ia, buf, sizeof ( buf ) );
+                    errlogPrintf ( "caNameServer: %u names registered by %s\n",
+                        nNames, buf );
+                    if ( pIOC->nDuplicates ) {
+                        errlogPrintf ( "caNameServer: %u names from %s "
+                            "were already registered by another server\n",
+                            pIOC->nDuplicates, buf );
+                    }
+                }
+            }
+            // the version, host and user names, and anything
+            // else are of no interest
+        }
+        nRecvBytes -= pos;
+        memmove ( pRecvBuf, & pRecvBuf[pos], nRecvBytes );
+    }
+
+    if ( pIOC ) {
+        char buf[64];
+        ipAddrToDottedIP ( & pIOC->addr.ia, buf, sizeof ( buf ) );
+        unsigned nNames = this->removeNames ( *pIOC );
+        errlogPrintf ( "caNameServer: %s disconnected, %u names removed\n",
+            buf, nNames );
+        delete pIOC;
+    }
+    epicsSocketDestroy ( sock );
+    delete [] pSendBuf;
+    delete [] pRecvBuf;
+}
+
+extern "C" void caNameServerCircuit ( void * pParm )
+{
+    nameServerCircuitParm * pCircuit =
+        static_cast < nameServerCircuitParm * > ( pParm );
+    pCircuit->pServer->circuit ( pCircuit->sock, pCircuit->peer );
+    delete pCircuit;
+}
+
+void caNameServer::run ()
+{
+    while ( true ) {
+        osiSockAddr peer;
+        osiSocklen_t addrSize = sizeof ( peer );
+        SOCKET sock = epicsSocketAccept ( this->listenSock,
+            & peer.sa, & addrSize );
+        if ( sock == INVALID_SOCKET ) {
+            char sockErrBuf[64];
+            epicsSocketConvertErrnoToString (
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            errlogPrintf ( "caNameServer: accept error \"%s\"\n", sockErrBuf );
+            epicsThreadSleep ( 1.0 );
+            continue;
+        }
+
+        // find out when an IOC goes away without closing its circuit
+        int intTrue = 1;
+        setsockopt ( sock, SOL_SOCKET, SO_KEEPALIVE,
+            reinterpret_cast < char * > ( & intTrue ), sizeof ( intTrue ) );
+        setsockopt ( sock, IPPROTO_TCP, TCP_NODELAY,
+            reinterpret_cast < char * > ( & intTrue ), sizeof ( intTrue ) );
+
+        nameServerCircuitParm * pCircuit = new nameServerCircuitParm;
+        pCircuit->pServer = this;
+        pCircuit->sock = sock;
+        pCircuit->peer = peer;
+        epicsThreadId tid = epicsThreadCreate ( "caNameServerCircuit",
+            epicsThreadPriorityMedium,
+            epicsThreadGetStackSize ( epicsThreadStackMedium ),
+            caNameServerCircuit, pCircuit );
+        if ( ! tid ) {
+            errlogPrintf ( "caNameServer: unable to create a circuit thread\n" );
+            epicsSocketDestroy ( sock );
+            delete pCircuit;
+        }
+    }
+}
+
+// serve clients and IOCs connecting to the listening socket, forever
+extern "C" void caNameServerThread ( void * pListenSock )
+{
+    caNameServer server ( * static_cast < SOCKET * > ( pListenSock ) );
+    server.run ();
+}
@@ -233,8 +233,14 @@ epicsTimerNotify::expireStatus searchTimer::expire (
     this->searchAttempts = 0;
     this->searchResponses = 0;
 
+    // the search rate budget is shared by all of the search timers
+    unsigned nFrameLimit = 0u;
+    if ( this->chanListReqPending.count () ) {
+        nFrameLimit = this->iiu.searchFrameBudget ( guard, currentTime );
+    }
+
     unsigned nFrameSent = 0u;
-    while ( true ) {
+    while ( nFrameLimit > 0u ) {
         nciu * pChan = this->chanListReqPending.get ();
         if ( ! pChan ) {
             break;
@@ -247,7 +253,8 @@ epicsTimerNotify::expireStatus searchTimer::expire (
         if ( ! success ) {
             if ( this->iiu.datagramFlush ( guard, currentTime ) ) {
                 nFrameSent++;
-                if ( nFrameSent < this->framesPerTry ) {
+                if ( nFrameSent < this->framesPerTry && 
+                        nFrameSent < nFrameLimit ) {
                     success = pChan->searchMsg ( guard );
                 }
             }
@@ -276,6 +283,14 @@ epicsTimerNotify::expireStatus searchTimer::expire (
     this->dgSeqNoAtTimerExpireEnd = 
         this->iiu.datagramSeqNumber ( guard ) - 1u;
 
+    // channels left behind because the budget was spent wait 
+    // for the next expiration of this timer
+    if ( nFrameLimit < this->framesPerTry && 
+            this->chanListReqPending.count () ) {
+        this->iiu.searchDeferredNotify ( guard, 
+            this->chanListReqPending.count () );
+    }
+
 #   ifdef DEBUG
         if ( this->searchAttempts ) {
             char buf[64];
@@ -333,6 +348,58 @@ void searchTimer::uninstallChanDueToSuccessfulSearchResponse (
         return;
     }
 
+    if ( this->searchResponseNotify ( guard, respDatagramSeqNo, 
+            seqNumberIsValid, currentTime ) ) {
+        if ( this->chanListReqPending.count () ) {
+            //
+            // when we get 100% success immediately 
+            // send another search request
+            //
+            debugPrintf ( ( "All requests succesful, set timer delay to zero\n" ) );
+            this->timer.start ( *this, currentTime );
+        }
+    }
+}
+
+//
+// A server that does not have the channel answered the search 
+// request. The request was delivered, so this counts as a response
+// when estimating congestion, but the channel moves on to the next 
+// (longer) search period right away.
+//
+void searchTimer::notHereNotify ( 
+    epicsGuard < epicsMutex > & guard, nciu & chan, 
+    ca_uint32_t respDatagramSeqNo, bool seqNumberIsValid, 
+    const epicsTime & currentTime )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    // only the first reply to a request that is outstanding counts
+    unsigned ulistmem = 
+        static_cast <unsigned> ( chan.channelNode::listMember );
+    unsigned uRespBase = 
+        static_cast <unsigned> ( channelNode::cs_searchRespPending0 );
+    if ( this->stopped || ulistmem != this->index + uRespBase ) {
+        return;
+    }
+
+    this->chanListRespPending.remove ( chan );
+    chan.channelNode::listMember = channelNode::cs_none;
+    this->iiu.noSearchRespNotify ( guard, chan, this->index );
+
+    this->searchResponseNotify ( guard, respDatagramSeqNo, 
+        seqNumberIsValid, currentTime );
+}
+
+//
+// returns true when every search request sent at the last
+// expiration has been answered
+//
+bool searchTimer::searchResponseNotify ( 
+    epicsGuard < epicsMutex > & guard,
+    ca_uint32_t respDatagramSeqNo, bool seqNumberIsValid, 
+    const epicsTime & currentTime )
+{
     bool validResponse = true;
     if ( seqNumberIsValid ) {
         validResponse = 
@@ -348,18 +415,10 @@ void searchTimer::uninstallChanDueToSuccessfulSearchResponse (
 
         if ( this->searchResponses < UINT_MAX ) {
             this->searchResponses++;
-            if ( this->searchResponses == this->searchAttempts ) {
-                if ( this->chanListReqPending.count () ) {
-                    //
-                    // when we get 100% success immediately 
-                    // send another search request
-                    //
-                    debugPrintf ( ( "All requests succesful, set timer delay to zero\n" ) );
-                    this->timer.start ( *this, currentTime );
-                }
-            }
+            return this->searchResponses == this->searchAttempts;
         }
     }
+    return false;
 }
 
 void searchTimer::uninstallChan (
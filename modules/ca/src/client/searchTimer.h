@@ -57,6 +57,11 @@ public:
         const epicsTime & currentTime ) = 0;
     virtual ca_uint32_t datagramSeqNumber (
         epicsGuard < epicsMutex > & ) const = 0;
+    virtual unsigned searchFrameBudget (
+        epicsGuard < epicsMutex > &, 
+        const epicsTime & currentTime ) = 0;
+    virtual void searchDeferredNotify (
+        epicsGuard < epicsMutex > &, unsigned nChannels ) = 0;
 };
 
 class searchTimer : private epicsTimerNotify {
@@ -80,6 +85,10 @@ public:
         epicsGuard < epicsMutex > &, nciu &, 
         ca_uint32_t respDatagramSeqNo, bool seqNumberIsValid, 
         const epicsTime & currentTime );
+    void notHereNotify ( 
+        epicsGuard < epicsMutex > &, nciu &, 
+        ca_uint32_t respDatagramSeqNo, bool seqNumberIsValid, 
+        const epicsTime & currentTime );
     void show ( unsigned level ) const;
 private:
     tsDLList < nciu > chanListReqPending;
@@ -100,6 +109,10 @@ private:
     bool stopped;
 
     expireStatus expire ( const epicsTime & currentTime );
+    bool searchResponseNotify ( 
+        epicsGuard < epicsMutex > &, 
+        ca_uint32_t respDatagramSeqNo, bool seqNumberIsValid, 
+        const epicsTime & currentTime );
     double period ( epicsGuard < epicsMutex > & ) const;
 	searchTimer ( const searchTimer & ); // not implemented
 	searchTimer & operator = ( const searchTimer & ); // not implemented
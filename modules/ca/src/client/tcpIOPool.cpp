@@ -0,0 +1,386 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Pool of epoll driven threads servicing virtual circuits, see tcpIOPool.h
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#   include <sys/epoll.h>
+#   include <sys/eventfd.h>
+#   define TCP_IO_POOL_EPOLL
+#endif
+
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "iocinf.h"
+#include "cac.h"
+#include "tcpIOPool.h"
+
+tcpIOClient::tcpIOClient () :
+    ioMask ( 0u ), ioRequested ( false ),
+    ioRetired ( false ), ioTicking ( false )
+{
+}
+
+tcpIOClient::~tcpIOClient ()
+{
+}
+
+tcpIOThread::tcpIOThread ( cac & cacIn, const char * pName,
+        unsigned stackSize, unsigned priority ) :
+    thread ( *this, pName, stackSize, priority ),
+    cacRef ( cacIn ), epfd ( -1 ), wakeupFd ( -1 ), nTicking ( 0u ),
+    nWakeups ( 0ul ), nEvents ( 0ul ), nRequests ( 0ul ),
+    wakeupPending ( false ), exitRequested ( false )
+{
+#ifdef TCP_IO_POOL_EPOLL
+    this->epfd = epoll_create1 ( EPOLL_CLOEXEC );
+    if ( this->epfd >= 0 ) {
+        this->wakeupFd = eventfd ( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    }
+    if ( this->epfd < 0 || this->wakeupFd < 0 ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        if ( this->epfd >= 0 ) {
+            close ( this->epfd );
+        }
+        std::string reason = "epoll set up failed because \"";
+        reason += sockErrBuf;
+        reason += "\"";
+        throw std::runtime_error ( reason );
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = 0;
+    if ( epoll_ctl ( this->epfd, EPOLL_CTL_ADD, this->wakeupFd, & ev ) ) {
+        close ( this->wakeupFd );
+        close ( this->epfd );
+        throw std::runtime_error ( "epoll wakeup registration failed" );
+    }
+#else
+    throw std::runtime_error ( "epoll isn't available" );
+#endif
+}
+
+tcpIOThread::~tcpIOThread ()
+{
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->exitRequested = true;
+        this->wakeup ();
+    }
+    this->thread.exitWait ();
+#ifdef TCP_IO_POOL_EPOLL
+    close ( this->wakeupFd );
+    close ( this->epfd );
+#endif
+}
+
+void tcpIOThread::start ()
+{
+    this->thread.start ();
+}
+
+// call with the mutex held
+void tcpIOThread::wakeup ()
+{
+    if ( ! this->wakeupPending ) {
+        this->wakeupPending = true;
+#ifdef TCP_IO_POOL_EPOLL
+        epicsUInt64 one = 1u;
+        if ( write ( this->wakeupFd, & one, sizeof ( one ) ) < 0 &&
+                errno != EAGAIN ) {
+            errlogPrintf ( "CAC: I/O thread wakeup failed\n" );
+        }
+#endif
+    }
+}
+
+void tcpIOThread::attach ( tcpIOClient & client )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->clients.add ( client );
+    client.ioRequested = true;
+    this->requests.push_back ( & client );
+    this->wakeup ();
+}
+
+void tcpIOThread::request ( tcpIOClient & client )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    if ( ! client.ioRequested && ! client.ioRetired ) {
+        client.ioRequested = true;
+        this->requests.push_back ( & client );
+        this->nRequests++;
+        this->wakeup ();
+    }
+}
+
+unsigned tcpIOThread::clientCount () const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    return this->clients.count ();
+}
+
+void tcpIOThread::watch ( tcpIOClient & client,
+    SOCKET sock, unsigned events )
+{
+#ifdef TCP_IO_POOL_EPOLL
+    if ( events == client.ioMask ) {
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = 0u;
+    if ( events & tcpIOClient::ioRead ) {
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if ( events & tcpIOClient::ioWrite ) {
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.ptr = & client;
+    int op = EPOLL_CTL_MOD;
+    if ( ! client.ioMask ) {
+        op = EPOLL_CTL_ADD;
+    }
+    else if ( ! events ) {
+        op = EPOLL_CTL_DEL;
+    }
+    if ( epoll_ctl ( this->epfd, op, sock, & ev ) ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "CAC: epoll_ctl failed because \"%s\"\n",
+            sockErrBuf );
+    }
+#endif
+    client.ioMask = events;
+}
+
+void tcpIOThread::tick ( tcpIOClient & client, bool enable )
+{
+    if ( enable != client.ioTicking ) {
+        client.ioTicking = enable;
+        if ( enable ) {
+            this->nTicking++;
+        }
+        else {
+            this->nTicking--;
+        }
+    }
+}
+
+void tcpIOThread::retire ( tcpIOClient & client, SOCKET sock )
+{
+    this->watch ( client, sock, 0u );
+    this->tick ( client, false );
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    if ( client.ioRequested ) {
+        std::vector < tcpIOClient * > :: iterator it = std::find (
+            this->requests.begin (), this->requests.end (), & client );
+        if ( it != this->requests.end () ) {
+            this->requests.erase ( it );
+        }
+        client.ioRequested = false;
+    }
+    client.ioRetired = true;
+    this->clients.remove ( client );
+    this->retired.add ( client );
+}
+
+void tcpIOThread::run ()
+{
+#ifdef TCP_IO_POOL_EPOLL
+    epicsThreadPrivateSet ( caClientCallbackThreadId, this );
+    this->cacRef.attachToClientCtx ();
+
+    static const int maxEvents = 64;
+    struct epoll_event events[maxEvents];
+    std::vector < tcpIOClient * > ticking;
+    epicsTime lastTick = epicsTime::getMonotonic ();
+
+    while ( true ) {
+        int timeout = this->nTicking ? 1000 : -1;
+        int n = epoll_wait ( this->epfd, events, maxEvents, timeout );
+        if ( n < 0 ) {
+            if ( errno != EINTR ) {
+                char sockErrBuf[64];
+                epicsSocketConvertErrnoToString (
+                    sockErrBuf, sizeof ( sockErrBuf ) );
+                errlogPrintf ( "CAC: epoll_wait failed because \"%s\"\n",
+                    sockErrBuf );
+                epicsThreadSleep ( 1.0 );
+            }
+            n = 0;
+        }
+
+        for ( int i = 0; i < n; i++ ) {
+            tcpIOClient * pClient =
+                static_cast < tcpIOClient * > ( events[i].data.ptr );
+            if ( ! pClient ) {
+                epicsUInt64 count;
+                if ( read ( this->wakeupFd, & count, sizeof ( count ) ) < 0 &&
+                        errno != EAGAIN ) {
+                    errlogPrintf ( "CAC: I/O thread wakeup read failed\n" );
+                }
+                continue;
+            }
+            // retired earlier in this batch
+            if ( pClient->ioRetired ) {
+                continue;
+            }
+            unsigned ready = 0u;
+            if ( events[i].events & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) {
+                ready |= tcpIOClient::ioRead;
+            }
+            if ( events[i].events & ( EPOLLOUT | EPOLLHUP | EPOLLERR ) ) {
+                ready |= tcpIOClient::ioWrite;
+            }
+            this->nEvents++;
+            pClient->ioReady ( ready & pClient->ioMask );
+        }
+
+        bool exitNow;
+        {
+            epicsGuard < epicsMutex > guard ( this->mutex );
+            this->work.swap ( this->requests );
+            for ( unsigned i = 0u; i < this->work.size (); i++ ) {
+                this->work[i]->ioRequested = false;
+            }
+            this->wakeupPending = false;
+            this->nWakeups++;
+            exitNow = this->exitRequested && this->clients.count () == 0u;
+        }
+        for ( unsigned i = 0u; i < this->work.size (); i++ ) {
+            if ( ! this->work[i]->ioRetired ) {
+                this->work[i]->ioService ();
+            }
+        }
+        this->work.clear ();
+
+        if ( this->nTicking ) {
+            epicsTime current = epicsTime::getMonotonic ();
+            if ( current - lastTick >= 1.0 ) {
+                lastTick = current;
+                {
+                    epicsGuard < epicsMutex > guard ( this->mutex );
+                    tsDLIter < tcpIOClient > iter = this->clients.firstIter ();
+                    while ( iter.valid () ) {
+                        if ( iter->ioTicking ) {
+                            ticking.push_back ( iter.pointer () );
+                        }
+                        iter++;
+                    }
+                }
+                for ( unsigned i = 0u; i < ticking.size (); i++ ) {
+                    ticking[i]->ioTick ();
+                }
+                ticking.clear ();
+            }
+        }
+
+        // the clients are destroyed here, after the last
+        // reference to them in the event batch
+        while ( tcpIOClient * pClient = this->retired.get () ) {
+            pClient->ioRetire ();
+        }
+
+        if ( exitNow ) {
+            break;
+        }
+    }
+#endif
+}
+
+void tcpIOThread::show ( unsigned level ) const
+{
+    char name[64];
+    this->thread.getName ( name, sizeof ( name ) );
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    ::printf ( "\t%s: %u circuits, %lu events, %lu requests, %lu wakeups\n",
+        name, this->clients.count (), this->nEvents,
+        this->nRequests, this->nWakeups );
+    if ( level > 0u ) {
+        ::printf ( "\t\tepoll fd %d, %u closing\n",
+            this->epfd, this->nTicking );
+    }
+}
+
+tcpIOPool::tcpIOPool ( unsigned nThreadsIn ) :
+    pThreads ( new tcpIOThread * [nThreadsIn] ), nThreads ( 0u )
+{
+}
+
+tcpIOPool * tcpIOPool::create ( cac & cacIn,
+    unsigned nThreadsIn, unsigned priority )
+{
+#ifdef TCP_IO_POOL_EPOLL
+    if ( nThreadsIn == 0u ) {
+        return 0;
+    }
+    tcpIOPool * pPool = new tcpIOPool ( nThreadsIn );
+    try {
+        while ( pPool->nThreads < nThreadsIn ) {
+            char name[32];
+            sprintf ( name, "CAC-TCP-io-%u", pPool->nThreads );
+            pPool->pThreads[pPool->nThreads] = new tcpIOThread ( cacIn, name,
+                epicsThreadGetStackSize ( epicsThreadStackBig ), priority );
+            pPool->nThreads++;
+        }
+    }
+    catch ( std::exception & except ) {
+        errlogPrintf ( "CAC: I/O thread pool creation failed because \"%s\""
+            " - using a thread per circuit\n", except.what () );
+        delete pPool;
+        return 0;
+    }
+    for ( unsigned i = 0u; i < pPool->nThreads; i++ ) {
+        pPool->pThreads[i]->start ();
+    }
+    return pPool;
+#else
+    return 0;
+#endif
+}
+
+tcpIOPool::~tcpIOPool ()
+{
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        delete this->pThreads[i];
+    }
+    delete [] this->pThreads;
+}
+
+tcpIOThread & tcpIOPool::assign ()
+{
+    unsigned best = 0u;
+    unsigned bestCount = this->pThreads[0]->clientCount ();
+    for ( unsigned i = 1u; i < this->nThreads; i++ ) {
+        unsigned count = this->pThreads[i]->clientCount ();
+        if ( count < bestCount ) {
+            best = i;
+            bestCount = count;
+        }
+    }
+    return * this->pThreads[best];
+}
+
+void tcpIOPool::show ( unsigned level ) const
+{
+    ::printf ( "I/O thread pool with %u threads\n", this->nThreads );
+    for ( unsigned i = 0u; i < this->nThreads; i++ ) {
+        this->pThreads[i]->show ( level );
+    }
+}
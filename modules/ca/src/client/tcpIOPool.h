@@ -0,0 +1,114 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * A small fixed pool of threads servicing the virtual circuits of
+ * a preemptive callback client context with non-blocking sockets,
+ * as an alternative to a receive and a send thread per circuit.
+ * Each circuit is bound to one thread of the pool for its lifetime,
+ * so its socket events are never handled concurrently.
+ *
+ * The pool is only available where epoll is (Linux), see
+ * EPICS_CA_IO_THREADS.
+ */
+
+#ifndef tcpIOPoolh
+#define tcpIOPoolh
+
+#include <vector>
+
+#include "tsDLList.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "osiSock.h"
+
+class cac;
+class tcpIOThread;
+
+// implemented by a virtual circuit serviced by the pool
+class tcpIOClient : public tsDLNode < tcpIOClient > {
+public:
+    enum ioEvents { ioRead = 0x1, ioWrite = 0x2 };
+    tcpIOClient ();
+protected:
+    virtual ~tcpIOClient ();
+    // called by the pool thread when the socket is ready
+    virtual void ioReady ( unsigned events ) = 0;
+    // called by the pool thread after tcpIOThread::request ()
+    virtual void ioService () = 0;
+    // called by the pool thread about once a second while ticking
+    virtual void ioTick () = 0;
+    // called by the pool thread after tcpIOThread::retire (),
+    // the client is no longer known to the pool
+    virtual void ioRetire () = 0;
+private:
+    unsigned ioMask;        // events registered with epoll
+    bool ioRequested;       // in the request list, guarded by the thread mutex
+    bool ioRetired;         // guarded by the thread mutex
+    bool ioTicking;         // only used by the pool thread
+    friend class tcpIOThread;
+};
+
+class tcpIOThread : private epicsThreadRunable {
+public:
+    tcpIOThread ( cac &, const char * pName,
+        unsigned stackSize, unsigned priority );
+    ~tcpIOThread ();
+    void start ();
+    // any thread
+    void attach ( tcpIOClient & );
+    void request ( tcpIOClient & );
+    unsigned clientCount () const;
+    void show ( unsigned level ) const;
+    // pool thread only
+    void watch ( tcpIOClient &, SOCKET, unsigned events );
+    void tick ( tcpIOClient &, bool enable );
+    void retire ( tcpIOClient &, SOCKET );
+private:
+    std::vector < tcpIOClient * > requests;
+    std::vector < tcpIOClient * > work;
+    tsDLList < tcpIOClient > clients;
+    tsDLList < tcpIOClient > retired;
+    epicsThread thread;
+    mutable epicsMutex mutex;
+    cac & cacRef;
+    int epfd;
+    int wakeupFd;
+    unsigned nTicking;
+    unsigned long nWakeups;
+    unsigned long nEvents;
+    unsigned long nRequests;
+    bool wakeupPending;
+    bool exitRequested;
+    void run ();
+    void wakeup ();
+    tcpIOThread ( const tcpIOThread & );
+    tcpIOThread & operator = ( const tcpIOThread & );
+};
+
+class tcpIOPool {
+public:
+    // returns NULL if the pool can't be created on this system
+    static tcpIOPool * create ( cac &, unsigned nThreads,
+        unsigned priority );
+    ~tcpIOPool ();
+    // the thread servicing the fewest circuits
+    tcpIOThread & assign ();
+    unsigned threadCount () const;
+    void show ( unsigned level ) const;
+private:
+    tcpIOThread ** pThreads;
+    unsigned nThreads;
+    tcpIOPool ( unsigned nThreads );
+    tcpIOPool ( const tcpIOPool & );
+    tcpIOPool & operator = ( const tcpIOPool & );
+};
+
+inline unsigned tcpIOPool::threadCount () const
+{
+    return this->nThreads;
+}
+
+#endif // ifndef tcpIOPoolh
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 
 #include "errlog.h"
+#include "epicsAtomic.h"
 
 #define epicsExportSharedSymbols
 #include "localHostName.h"
@@ -45,6 +46,23 @@
 #include "caerr.h"
 #include "udpiiu.h"
 
+// the send queue is gathered into one sendmsg () call where it's available
+#if defined ( __unix__ ) || defined ( __APPLE__ )
+#   include <sys/uio.h>
+#   define CA_SEND_GATHER
+#endif
+
+#if defined ( CA_SEND_GATHER ) && defined ( __linux__ )
+#   include <linux/errqueue.h>
+#   if defined ( MSG_ZEROCOPY ) && defined ( SO_ZEROCOPY ) && \
+        defined ( SO_EE_ORIGIN_ZEROCOPY )
+#       define CA_SEND_ZEROCOPY
+#   endif
+#endif
+
+// zero copy only pays off for large sends, such as array puts
+static const unsigned zeroCopySendThreshold = 0x10000;
+
 using namespace std;
 
 tcpSendThread::tcpSendThread (
@@ -91,79 +109,7 @@ void tcpSendThread::run ()
                 break;
             }
 
-            laborPending = false;
-            bool flowControlLaborNeeded = 
-                this->iiu.busyStateDetected != this->iiu.flowControlActive;
-            bool echoLaborNeeded = this->iiu.echoRequestPending;
-            this->iiu.echoRequestPending = false;
-
-            if ( flowControlLaborNeeded ) {
-                if ( this->iiu.flowControlActive ) {
-                    this->iiu.disableFlowControlRequest ( guard );
-                    this->iiu.flowControlActive = false;
-                    debugPrintf ( ( "fc off\n" ) );
-                }
-                else {
-                    this->iiu.enableFlowControlRequest ( guard );
-                    this->iiu.flowControlActive = true;
-                    debugPrintf ( ( "fc on\n" ) );
-                }
-            }
-
-            if ( echoLaborNeeded ) {
-                this->iiu.echoRequest ( guard );
-            }
-
-            while ( nciu * pChan = this->iiu.createReqPend.get () ) {
-                this->iiu.createChannelRequest ( *pChan, guard );
-
-                if ( CA_V42 ( this->iiu.minorProtocolVersion ) ) {
-                    this->iiu.createRespPend.add ( *pChan );
-                    pChan->channelNode::listMember = 
-                        channelNode::cs_createRespPend;
-                }
-                else {
-                    // This wakes up the resp thread so that it can call
-                    // the connect callback. This isnt maximally efficent
-                    // but it has the excellent side effect of not requiring
-                    // that the UDP thread take the callback lock. There are
-                    // almost no V42 servers left at this point.
-                    this->iiu.v42ConnCallbackPend.add ( *pChan );
-                    pChan->channelNode::listMember = 
-                        channelNode::cs_v42ConnCallbackPend;
-                    this->iiu.echoRequestPending = true;
-                    laborPending = true;
-                }
-                
-                if ( this->iiu.sendQue.flushBlockThreshold () ) {
-                    laborPending = true;
-                    break;
-                }
-            }
-
-            while ( nciu * pChan = this->iiu.subscripReqPend.get () ) {
-                // this installs any subscriptions as needed
-                pChan->resubscribe ( guard );
-                this->iiu.connectedList.add ( *pChan );
-                pChan->channelNode::listMember = 
-                    channelNode::cs_connected;
-                if ( this->iiu.sendQue.flushBlockThreshold () ) {
-                    laborPending = true;
-                    break;
-                }
-            }
-
-            while ( nciu * pChan = this->iiu.subscripUpdateReqPend.get () ) {
-                // this updates any subscriptions as needed
-                pChan->sendSubscriptionUpdateRequests ( guard );
-                this->iiu.connectedList.add ( *pChan );
-                pChan->channelNode::listMember = 
-                    channelNode::cs_connected;
-                if ( this->iiu.sendQue.flushBlockThreshold () ) {
-                    laborPending = true;
-                    break;
-                }
-            }
+            laborPending = this->iiu.sendLabor ( guard );
 
             if ( ! this->iiu.sendThreadFlush ( guard ) ) {
                 break;
@@ -202,7 +148,7 @@ void tcpSendThread::run ()
     this->iiu.sendDog.cancel ();
     this->iiu.recvDog.shutdown ();
 
-    while ( ! this->iiu.recvThread.exitWait ( 30.0 ) ) {
+    while ( ! this->iiu.pRecvThread->exitWait ( 30.0 ) ) {
         // it is possible to get stuck here if the user calls 
         // ca_context_destroy() when a circuit isnt known to
         // be unresponsive, but is. That situation is probably
@@ -229,20 +175,134 @@ void tcpSendThread::run ()
     this->iiu.cacRef.destroyIIU ( this->iiu );
 }
 
+// queue the requests pending for this circuit, returns true if labor
+// remains after the send queue reached its flush threshold
+bool tcpiiu::sendLabor ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    bool laborPending = false;
+    bool flowControlLaborNeeded = 
+        this->busyStateDetected != this->flowControlActive;
+    bool echoLaborNeeded = this->echoRequestPending;
+    this->echoRequestPending = false;
+
+    if ( flowControlLaborNeeded ) {
+        if ( this->flowControlActive ) {
+            this->disableFlowControlRequest ( guard );
+            this->flowControlActive = false;
+            debugPrintf ( ( "fc off\n" ) );
+        }
+        else {
+            this->enableFlowControlRequest ( guard );
+            this->flowControlActive = true;
+            debugPrintf ( ( "fc on\n" ) );
+        }
+    }
+
+    if ( echoLaborNeeded ) {
+        this->echoRequest ( guard );
+    }
+
+    while ( nciu * pChan = this->createReqPend.get () ) {
+        this->createChannelRequest ( *pChan, guard );
+
+        if ( CA_V42 ( this->minorProtocolVersion ) ) {
+            this->createRespPend.add ( *pChan );
+            pChan->channelNode::listMember = 
+                channelNode::cs_createRespPend;
+        }
+        else {
+            // This wakes up the resp thread so that it can call
+            // the connect callback. This isnt maximally efficent
+            // but it has the excellent side effect of not requiring
+            // that the UDP thread take the callback lock. There are
+            // almost no V42 servers left at this point.
+            this->v42ConnCallbackPend.add ( *pChan );
+            pChan->channelNode::listMember = 
+                channelNode::cs_v42ConnCallbackPend;
+            this->echoRequestPending = true;
+            laborPending = true;
+        }
+        
+        if ( this->sendQue.flushBlockThreshold () ) {
+            laborPending = true;
+            break;
+        }
+    }
+
+    while ( nciu * pChan = this->subscripReqPend.get () ) {
+        // this installs any subscriptions as needed
+        pChan->resubscribe ( guard );
+        this->connectedList.add ( *pChan );
+        pChan->channelNode::listMember = 
+            channelNode::cs_connected;
+        if ( this->sendQue.flushBlockThreshold () ) {
+            laborPending = true;
+            break;
+        }
+    }
+
+    while ( nciu * pChan = this->subscripUpdateReqPend.get () ) {
+        // this updates any subscriptions as needed
+        pChan->sendSubscriptionUpdateRequests ( guard );
+        this->connectedList.add ( *pChan );
+        pChan->channelNode::listMember = 
+            channelNode::cs_connected;
+        if ( this->sendQue.flushBlockThreshold () ) {
+            laborPending = true;
+            break;
+        }
+    }
+
+    return laborPending;
+}
+
 unsigned tcpiiu::sendBytes ( const void *pBuf, 
     unsigned nBytesInBuf, const epicsTime & currentTime )
+{
+    wireSendBuf buf;
+    buf.pBuf = pBuf;
+    buf.nBytes = nBytesInBuf;
+    return this->sendBytes ( & buf, 1u, currentTime );
+}
+
+unsigned tcpiiu::sendBytes ( const wireSendBuf * pBufs, 
+    unsigned nBufs, const epicsTime & currentTime )
 {
     unsigned nBytes = 0u;
-    assert ( nBytesInBuf <= INT_MAX );
+
+    if ( this->pIOThread ) {
+        return this->ioSendBytes ( pBufs, nBufs, currentTime );
+    }
+
+    int flags = 0;
+#   if defined ( CA_SEND_ZEROCOPY )
+        if ( this->zeroCopy ) {
+            unsigned nBytesInBufs = 0u;
+            for ( unsigned i = 0u; i < nBufs; i++ ) {
+                nBytesInBufs += pBufs[i].nBytes;
+            }
+            if ( nBytesInBufs >= zeroCopySendThreshold ) {
+                flags = MSG_ZEROCOPY;
+            }
+        }
+#   endif
 
     this->sendDog.start ( currentTime );
 
     while ( true ) {
-        int status = ::send ( this->sock, 
-            static_cast < const char * > (pBuf), (int) nBytesInBuf, 0 );
+        int status = this->sendCall ( pBufs, nBufs, flags );
         if ( status > 0 ) {
             nBytes = static_cast <unsigned> ( status );
             // printf("SEND: %u\n", nBytes );
+#           if defined ( CA_SEND_ZEROCOPY )
+                if ( flags & MSG_ZEROCOPY ) {
+                    // the kernel numbers the zero copy sends
+                    this->zeroCopyId++;
+                    epicsAtomicIncrSizeT ( & this->nZeroCopySends );
+                }
+#           endif
             break;
         }
         else {
@@ -263,6 +323,15 @@ unsigned tcpiiu::sendBytes ( const void *pBuf,
                 continue;
             }
 
+#           if defined ( CA_SEND_ZEROCOPY )
+                // out of the socket option memory tracking zero copy
+                // sends, retry with a copy
+                if ( localError == SOCK_ENOBUFS && flags ) {
+                    flags = 0;
+                    continue;
+                }
+#           endif
+
             if ( localError == SOCK_ENOBUFS ) {
                 errlogPrintf ( 
                     "CAC: system low on network buffers "
@@ -297,6 +366,100 @@ unsigned tcpiiu::sendBytes ( const void *pBuf,
     return nBytes;
 }
 
+int tcpiiu::sendCall ( const wireSendBuf * pBufs, 
+    unsigned nBufs, int flags )
+{
+    epicsAtomicIncrSizeT ( & this->nSendCalls );
+#   if defined ( CA_SEND_GATHER )
+        struct iovec iov [ comBufGatherMax ];
+        if ( nBufs > comBufGatherMax ) {
+            nBufs = comBufGatherMax;
+        }
+        for ( unsigned i = 0u; i < nBufs; i++ ) {
+            iov[i].iov_base = const_cast < void * > ( pBufs[i].pBuf );
+            iov[i].iov_len = pBufs[i].nBytes;
+        }
+        struct msghdr msg;
+        memset ( & msg, 0, sizeof ( msg ) );
+        msg.msg_iov = iov;
+        msg.msg_iovlen = nBufs;
+        return static_cast < int > ( ::sendmsg ( this->sock, & msg, flags ) );
+#   else
+        assert ( pBufs[0].nBytes <= INT_MAX );
+        return ::send ( this->sock, 
+            static_cast < const char * > ( pBufs[0].pBuf ), 
+            (int) pBufs[0].nBytes, flags );
+#   endif
+}
+
+void tcpiiu::releaseSendBufs ( comBuf * const * ppBufs, unsigned nBufs )
+{
+    for ( unsigned i = 0u; i < nBufs; i++ ) {
+        ppBufs[i]->~comBuf ();
+        this->comBufMemMgr.release ( ppBufs[i] );
+    }
+}
+
+// The kernel reads the buffers of a zero copy send after the send
+// call returns, they are kept until it reports that the last zero
+// copy send they were part of has completed. Only the send thread
+// may touch zeroCopyPend and zeroCopyId, which is why they are used
+// without the lock, and the destructor releases what is left after
+// the send thread has exited.
+void tcpiiu::zeroCopyHold ( comBuf * const * ppBufs, unsigned nBufs )
+{
+    zeroCopyBuf held;
+    held.id = this->zeroCopyId - 1u;
+    for ( unsigned i = 0u; i < nBufs; i++ ) {
+        held.pBuf = ppBufs[i];
+        this->zeroCopyPend.push_back ( held );
+    }
+}
+
+void tcpiiu::zeroCopyReap ()
+{
+#   if defined ( CA_SEND_ZEROCOPY )
+        while ( this->zeroCopyPend.size () ) {
+            char control [ 128 ];
+            struct msghdr msg;
+            memset ( & msg, 0, sizeof ( msg ) );
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof ( control );
+            if ( ::recvmsg ( this->sock, & msg, MSG_ERRQUEUE | MSG_DONTWAIT ) < 0 ) {
+                break;
+            }
+            for ( struct cmsghdr * pCmsg = CMSG_FIRSTHDR ( & msg ); pCmsg; 
+                    pCmsg = CMSG_NXTHDR ( & msg, pCmsg ) ) {
+                if ( pCmsg->cmsg_level != IPPROTO_IP || 
+                        pCmsg->cmsg_type != IP_RECVERR ) {
+                    continue;
+                }
+                const struct sock_extended_err * pErr = 
+                    reinterpret_cast < const struct sock_extended_err * > 
+                        ( CMSG_DATA ( pCmsg ) );
+                if ( pErr->ee_errno != 0 || 
+                        pErr->ee_origin != SO_EE_ORIGIN_ZEROCOPY ) {
+                    continue;
+                }
+                // the kernel had to copy the data anyway (loopback
+                // or no scatter gather in the interface) so stop
+                // paying for the completion notifications
+                if ( pErr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED ) {
+                    epicsAtomicIncrSizeT ( & this->nZeroCopyCopied );
+                    this->zeroCopy = false;
+                }
+                // TCP completes the zero copy sends in order
+                while ( this->zeroCopyPend.size () && 
+                        static_cast < epicsInt32 > ( 
+                            this->zeroCopyPend.front ().id - pErr->ee_data ) <= 0 ) {
+                    this->releaseSendBufs ( & this->zeroCopyPend.front ().pBuf, 1u );
+                    this->zeroCopyPend.pop_front ();
+                }
+            }
+        }
+#   endif
+}
+
 void tcpiiu::recvBytes ( 
         void * pBuf, unsigned nBytesInBuf, statusWireIO & stat )
 {
@@ -313,6 +476,15 @@ void tcpiiu::recvBytes (
             return;
         }
         else {
+            // nothing more to read from the non-blocking
+            // socket of a circuit serviced by an I/O thread
+            if ( status < 0 && this->pIOThread &&
+                    SOCKERRNO == SOCK_EWOULDBLOCK ) {
+                stat.bytesCopied = 0u;
+                stat.circuitState = swioConnected;
+                return;
+            }
+
             epicsGuard < epicsMutex > guard ( this->mutex );
 
             if ( status == 0 ) {
@@ -407,11 +579,11 @@ void tcpRecvThread::exitWait ()
     this->thread.exitWait ();
 }
 
-bool tcpRecvThread::validFillStatus ( 
+bool tcpiiu::validFillStatus ( 
     epicsGuard < epicsMutex > & guard, const statusWireIO & stat )
 {
-    if ( this->iiu.state != tcpiiu::iiucs_connected &&
-        this->iiu.state != tcpiiu::iiucs_clean_shutdown ) {
+    if ( this->state != iiucs_connected &&
+        this->state != iiucs_clean_shutdown ) {
         return false;
     }
     if ( stat.circuitState == swioConnected ) {
@@ -419,21 +591,102 @@ bool tcpRecvThread::validFillStatus (
     }
     if ( stat.circuitState == swioPeerHangup ||
         stat.circuitState == swioPeerAbort ) {
-        this->iiu.disconnectNotify ( guard );
+        this->disconnectNotify ( guard );
     }
     else if ( stat.circuitState == swioLinkFailure ) {
-        this->iiu.initiateAbortShutdown ( guard );
+        this->initiateAbortShutdown ( guard );
     }
     else if ( stat.circuitState == swioLocalAbort ) {
         // state change already occurred
     }
     else {
         errlogMessage ( "cac: invalid fill status - disconnecting" );
-        this->iiu.disconnectNotify ( guard );
+        this->disconnectNotify ( guard );
     }
     return false;
 }
 
+// process the buffers pushed onto the receive queue, returns false if
+// the circuit must be shut down
+bool tcpiiu::processReceived ( 
+    const epicsTime & currentTime, bool & sendWakeupNeeded )
+{
+    sendWakeupNeeded = false;
+    {
+        // only one recv thread at a time may call callbacks
+        // - pendEvent() blocks until threads waiting for
+        // this lock get a chance to run
+        callbackManager mgr ( this->ctxNotify, this->cbMutex );
+
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        
+        // route legacy V42 channel connect through the recv thread -
+        // the only thread that should be taking the callback lock
+        while ( nciu * pChan = this->v42ConnCallbackPend.first () ) {
+            this->connectNotify ( guard, *pChan );
+            pChan->connect ( mgr.cbGuard, guard );
+        }
+
+        this->unacknowledgedSendBytes = 0u;
+
+        bool protocolOK = false;
+        {
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            // execute receive labor
+            protocolOK = this->processIncoming ( currentTime, mgr );
+        }
+
+        if ( ! protocolOK ) {
+            this->initiateAbortShutdown ( guard );
+            return false;
+        }
+        this->_receiveThreadIsBusy = false;
+        // reschedule connection activity watchdog
+        this->recvDog.messageArrivalNotify ( guard ); 
+        //
+        // if this thread has connected channels with subscriptions
+        // that need to be sent then wakeup the send thread
+        if ( this->subscripReqPend.count() ) {
+            sendWakeupNeeded = true;
+        }
+    }
+    
+    //
+    // we dont feel comfortable calling this with a lock applied
+    // (it might block for longer than we like)
+    //
+    // we would prefer to improve efficency by trying, first, a 
+    // recv with the new MSG_DONTWAIT flag set, but there isnt 
+    // universal support
+    //
+    bool bytesArePending = this->bytesArePendingInOS ();
+    {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        if ( bytesArePending ) {
+            if ( ! this->busyStateDetected ) {
+                this->contigRecvMsgCount++;
+                if ( this->contigRecvMsgCount >= 
+                    this->cacRef.maxContiguousFrames ( guard ) ) {
+                    this->busyStateDetected = true;
+                    sendWakeupNeeded = true;
+                }
+            }
+        }
+        else {
+            // if no bytes are pending then we must immediately
+            // switch off flow control w/o waiting for more
+            // data to arrive
+            this->contigRecvMsgCount = 0u;
+            if ( this->busyStateDetected ) {
+                sendWakeupNeeded = true;
+                this->busyStateDetected = false;
+            }
+        }
+    }
+
+    return true;
+}
+
 void tcpRecvThread::run ()
 {
     try {
@@ -455,7 +708,7 @@ void tcpRecvThread::run ()
             }
         }
 
-        this->iiu.sendThread.start ();
+        this->iiu.pSendThread->start ();
         epicsThreadPrivateSet ( caClientCallbackThreadId, &this->iiu );
         this->iiu.cacRef.attachToClientCtx ();
 
@@ -481,7 +734,7 @@ void tcpRecvThread::run ()
             {
                 epicsGuard < epicsMutex > guard ( this->iiu.mutex );
                 
-                if ( ! this->validFillStatus ( guard, stat ) ) {
+                if ( ! this->iiu.validFillStatus ( guard, stat ) ) {
                     break;
                 }
                 if ( stat.bytesCopied == 0u ) {
@@ -495,76 +748,8 @@ void tcpRecvThread::run ()
             }
 
             bool sendWakeupNeeded = false;
-            {
-                // only one recv thread at a time may call callbacks
-                // - pendEvent() blocks until threads waiting for
-                // this lock get a chance to run
-                callbackManager mgr ( this->ctxNotify, this->cbMutex );
-
-                epicsGuard < epicsMutex > guard ( this->iiu.mutex );
-                
-                // route legacy V42 channel connect through the recv thread -
-                // the only thread that should be taking the callback lock
-                while ( nciu * pChan = this->iiu.v42ConnCallbackPend.first () ) {
-                    this->iiu.connectNotify ( guard, *pChan );
-                    pChan->connect ( mgr.cbGuard, guard );
-                }
-
-                this->iiu.unacknowledgedSendBytes = 0u;
-
-                bool protocolOK = false;
-                {
-                    epicsGuardRelease < epicsMutex > unguard ( guard );
-                    // execute receive labor
-                    protocolOK = this->iiu.processIncoming ( currentTime, mgr );
-                }
-
-                if ( ! protocolOK ) {
-                    this->iiu.initiateAbortShutdown ( guard );
-                    break;
-                }
-                this->iiu._receiveThreadIsBusy = false;
-                // reschedule connection activity watchdog
-                this->iiu.recvDog.messageArrivalNotify ( guard ); 
-                //
-                // if this thread has connected channels with subscriptions
-                // that need to be sent then wakeup the send thread
-                if ( this->iiu.subscripReqPend.count() ) {
-                    sendWakeupNeeded = true;
-                }
-            }
-            
-            //
-            // we dont feel comfortable calling this with a lock applied
-            // (it might block for longer than we like)
-            //
-            // we would prefer to improve efficency by trying, first, a 
-            // recv with the new MSG_DONTWAIT flag set, but there isnt 
-            // universal support
-            //
-            bool bytesArePending = this->iiu.bytesArePendingInOS ();
-            {
-                epicsGuard < epicsMutex > guard ( this->iiu.mutex );
-                if ( bytesArePending ) {
-                    if ( ! this->iiu.busyStateDetected ) {
-                        this->iiu.contigRecvMsgCount++;
-                        if ( this->iiu.contigRecvMsgCount >= 
-                            this->iiu.cacRef.maxContiguousFrames ( guard ) ) {
-                            this->iiu.busyStateDetected = true;
-                            sendWakeupNeeded = true;
-                        }
-                    }
-                }
-                else {
-                    // if no bytes are pending then we must immediately
-                    // switch off flow control w/o waiting for more
-                    // data to arrive
-                    this->iiu.contigRecvMsgCount = 0u;
-                    if ( this->iiu.busyStateDetected ) {
-                        sendWakeupNeeded = true;
-                        this->iiu.busyStateDetected = false;
-                    }
-                }
+            if ( ! this->iiu.processReceived ( currentTime, sendWakeupNeeded ) ) {
+                break;
             }
 
             if ( sendWakeupNeeded ) {
@@ -670,16 +855,12 @@ tcpiiu::tcpiiu (
         comBufMemoryManager & comBufMemMgrIn,
         unsigned minorVersion, ipAddrToAsciiEngine & engineIn, 
         const cacChannel::priLev & priorityIn,
-        SearchDestTCP * pSearchDestIn ) :
+        SearchDestTCP * pSearchDestIn, tcpIOThread * pIOThreadIn ) :
     caServerID ( addrIn.ia, priorityIn ),
     hostNameCacheInstance ( addrIn, engineIn ),
-    recvThread ( *this, cbMutexIn, ctxNotifyIn, "CAC-TCP-recv", 
-        epicsThreadGetStackSize ( epicsThreadStackBig ),
-        cac::highestPriorityLevelBelow ( cac.getInitializingThreadsPriority() ) ),
-    sendThread ( *this, "CAC-TCP-send",
-        epicsThreadGetStackSize ( epicsThreadStackMedium ),
-        cac::lowestPriorityLevelAbove (
-            cac.getInitializingThreadsPriority() ) ),
+    pRecvThread ( 0 ),
+    pSendThread ( 0 ),
+    pIOThread ( pIOThreadIn ),
     recvDog ( cbMutexIn, ctxNotifyIn, mutexIn, 
         *this, connectionTimeout, timerQueue ),
     sendDog ( cbMutexIn, ctxNotifyIn, mutexIn,
@@ -694,6 +875,14 @@ tcpiiu::tcpiiu (
     pSearchDest ( pSearchDestIn ),
     mutex ( mutexIn ),
     cbMutex ( cbMutexIn ),
+    ctxNotify ( ctxNotifyIn ),
+    nIOSendBufs ( 0u ),
+    ioSendBufBytes ( 0u ),
+    zeroCopyId ( 0u ),
+    nFlushes ( 0ul ),
+    nSendCalls ( 0ul ),
+    nZeroCopySends ( 0ul ),
+    nZeroCopyCopied ( 0ul ),
     minorProtocolVersion ( minorVersion ),
     state ( iiucs_connecting ),
     sock ( INVALID_SOCKET ),
@@ -702,6 +891,7 @@ tcpiiu::tcpiiu (
     socketLibrarySendBufferSize ( 0x1000 ),
     unacknowledgedSendBytes ( 0u ),
     channelCountTot ( 0u ),
+    nameCacheHintsPending ( 0u ),
     _receiveThreadIsBusy ( false ),
     busyStateDetected ( false ),
     flowControlActive ( false ),
@@ -712,7 +902,12 @@ tcpiiu::tcpiiu (
     recvProcessPostponedFlush ( false ),
     discardingPendingData ( false ),
     socketHasBeenClosed ( false ),
-    unresponsiveCircuit ( false )
+    unresponsiveCircuit ( false ),
+    ioStarted ( false ),
+    ioSendBlocked ( false ),
+    ioSendDogActive ( false ),
+    ioShutdownSent ( false ),
+    zeroCopy ( false )
 {
     if(!pCurData)
         throw std::bad_alloc();
@@ -808,6 +1003,45 @@ tcpiiu::tcpiiu (
         }
     }
 
+#   if defined ( CA_SEND_ZEROCOPY )
+        // only the send thread reaps the zero copy completions
+        if ( ! this->pIOThread && this->cacRef.zeroCopySendEnabled () ) {
+            int flag = true;
+            status = setsockopt ( this->sock, SOL_SOCKET, SO_ZEROCOPY,
+                ( char * ) &flag, sizeof ( flag ) );
+            if ( status < 0 ) {
+                char sockErrBuf[64];
+                epicsSocketConvertErrnoToString ( 
+                    sockErrBuf, sizeof ( sockErrBuf ) );
+                errlogPrintf ( "CAC: problems setting socket option SO_ZEROCOPY = \"%s\"\n",
+                    sockErrBuf );
+            }
+            else {
+                this->zeroCopy = true;
+            }
+        }
+#   endif
+
+    if ( ! this->pIOThread ) {
+        try {
+            this->pRecvThread = new tcpRecvThread ( *this, cbMutexIn,
+                ctxNotifyIn, "CAC-TCP-recv", 
+                epicsThreadGetStackSize ( epicsThreadStackBig ),
+                cac::highestPriorityLevelBelow ( 
+                    this->cacRef.getInitializingThreadsPriority() ) );
+            this->pSendThread = new tcpSendThread ( *this, "CAC-TCP-send",
+                epicsThreadGetStackSize ( epicsThreadStackMedium ),
+                cac::lowestPriorityLevelAbove (
+                    this->cacRef.getInitializingThreadsPriority() ) );
+        }
+        catch ( ... ) {
+            delete this->pRecvThread;
+            epicsSocketDestroy ( this->sock );
+            freeListFree(this->cacRef.tcpSmallRecvBufFreeList, this->pCurData);
+            throw;
+        }
+    }
+
     if ( isNameService() ) {
         pSearchDest->setCircuit ( this );
     }
@@ -821,7 +1055,427 @@ void tcpiiu::start (
     epicsGuard < epicsMutex > & guard )
 {
     guard.assertIdenticalMutex ( this->mutex );
-    this->recvThread.start ();
+    if ( this->pIOThread ) {
+        this->pIOThread->attach ( *this );
+    }
+    else {
+        this->pRecvThread->start ();
+    }
+}
+
+void tcpiiu::sendWakeup ()
+{
+    if ( this->pIOThread ) {
+        this->pIOThread->request ( *this );
+    }
+    else {
+        this->sendThreadFlushEvent.signal ();
+    }
+}
+
+//
+// A circuit serviced by an I/O thread of the pool does the labor of
+// the receive and send threads in the methods below, all of them
+// called by its I/O thread only. The socket is non-blocking, sends
+// which would block leave partially sent buffers in ioSendBufs
+// until the socket becomes writable.
+//
+
+void tcpiiu::ioService ()
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    if ( ! this->ioStarted ) {
+        this->ioStarted = true;
+        this->ioConnect ( guard );
+    }
+    if ( this->state == iiucs_connected ) {
+        this->ioSendLabor ( guard );
+    }
+    if ( this->state != iiucs_connecting &&
+            this->state != iiucs_connected ) {
+        this->ioShutdown ( guard );
+    }
+}
+
+void tcpiiu::ioReady ( unsigned events )
+{
+    bool sendLaborNeeded = false;
+    if ( events & tcpIOClient::ioRead ) {
+        sendLaborNeeded = this->ioReceive ();
+    }
+
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    if ( this->state == iiucs_connecting ) {
+        if ( events & tcpIOClient::ioWrite ) {
+            int error = 0;
+            osiSocklen_t len = sizeof ( error );
+            int status = getsockopt ( this->sock, SOL_SOCKET, SO_ERROR,
+                reinterpret_cast < char * > ( & error ), & len );
+            if ( status == 0 && error == 0 ) {
+                this->ioConnectComplete ( guard );
+                sendLaborNeeded = true;
+            }
+            else {
+                char sockErrBuf[64];
+                if ( status ) {
+                    epicsSocketConvertErrnoToString (
+                        sockErrBuf, sizeof ( sockErrBuf ) );
+                }
+                else {
+                    epicsSocketConvertErrorToString (
+                        sockErrBuf, sizeof ( sockErrBuf ), error );
+                }
+                errlogPrintf ( "CAC: Unable to connect because \"%s\"\n",
+                    sockErrBuf );
+                this->disconnectNotify ( guard );
+            }
+        }
+    }
+    else if ( ( events & tcpIOClient::ioWrite ) && this->ioSendBlocked ) {
+        this->ioSendBlocked = false;
+        sendLaborNeeded = true;
+    }
+
+    if ( sendLaborNeeded && this->state == iiucs_connected ) {
+        this->ioSendLabor ( guard );
+    }
+    if ( this->state != iiucs_connecting &&
+            this->state != iiucs_connected ) {
+        this->ioShutdown ( guard );
+    }
+}
+
+void tcpiiu::ioConnect ( epicsGuard < epicsMutex > & guard )
+{
+    osiSockIoctl_t yes = true;
+    if ( socket_ioctl ( this->sock, FIONBIO, & yes ) < 0 ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "CAC: unable to make the socket non-blocking because \"%s\"\n",
+            sockErrBuf );
+        this->disconnectNotify ( guard );
+        return;
+    }
+
+    while ( true ) {
+        int status;
+        {
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            osiSockAddr tmp = this->address ();
+            status = ::connect ( this->sock,
+                            & tmp.sa, sizeof ( tmp.sa ) );
+        }
+
+        if ( this->state != iiucs_connecting ) {
+            return;
+        }
+        if ( status >= 0 ) {
+            this->ioConnectComplete ( guard );
+            return;
+        }
+
+        int errnoCpy = SOCKERRNO;
+        if ( errnoCpy == SOCK_EINTR ) {
+            continue;
+        }
+        if ( errnoCpy == SOCK_EINPROGRESS ) {
+            // completion is reported when the socket becomes writable
+            this->pIOThread->watch ( *this, this->sock, tcpIOClient::ioWrite );
+            return;
+        }
+        if ( errnoCpy != SOCK_SHUTDOWN ) {
+            char sockErrBuf[64];
+            epicsSocketConvertErrnoToString (
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            errlogPrintf ( "CAC: Unable to connect because \"%s\"\n",
+                sockErrBuf );
+        }
+        this->disconnectNotify ( guard );
+        return;
+    }
+}
+
+void tcpiiu::ioConnectComplete ( epicsGuard < epicsMutex > & guard )
+{
+    // put the iiu into the connected state
+    this->state = iiucs_connected;
+    this->recvDog.connectNotify ( guard );
+    this->pIOThread->watch ( *this, this->sock, tcpIOClient::ioRead );
+}
+
+// read and process what the socket holds, returns true if
+// there is send labor to be done
+bool tcpiiu::ioReceive ()
+{
+    // bound the buffers read per event so that a busy
+    // circuit doesnt starve the others of this thread
+    static const unsigned maxBufsPerEvent = 8u;
+    bool sendLaborNeeded = false;
+
+    try {
+        for ( unsigned i = 0u; i < maxBufsPerEvent; i++ ) {
+            comBuf * pComBuf = new ( this->comBufMemMgr ) comBuf;
+
+            statusWireIO stat;
+            pComBuf->fillFromWire ( *this, stat );
+
+            epicsTime currentTime = epicsTime::getMonotonic ();
+
+            {
+                epicsGuard < epicsMutex > guard ( this->mutex );
+                if ( ! this->validFillStatus ( guard, stat ) ||
+                        stat.bytesCopied == 0u ) {
+                    pComBuf->~comBuf ();
+                    this->comBufMemMgr.release ( pComBuf );
+                    break;
+                }
+                this->recvQue.pushLastComBufReceived ( *pComBuf );
+                this->_receiveThreadIsBusy = true;
+            }
+
+            bool sendWakeupNeeded = false;
+            if ( ! this->processReceived ( currentTime, sendWakeupNeeded ) ) {
+                break;
+            }
+            if ( sendWakeupNeeded ) {
+                sendLaborNeeded = true;
+            }
+            // a short read drained the socket
+            if ( stat.bytesCopied < comBuf::capacityBytes () ) {
+                break;
+            }
+        }
+    }
+    catch ( std::exception & except ) {
+        errlogPrintf (
+            "CA client library tcp I/O thread "
+            "disconnecting due to C++ exception \"%s\"\n",
+            except.what () );
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->initiateCleanShutdown ( guard );
+    }
+    return sendLaborNeeded;
+}
+
+void tcpiiu::ioSendLabor ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    // wait for the socket to become writable
+    if ( this->ioSendBlocked ) {
+        return;
+    }
+
+    bool laborPending = true;
+    while ( laborPending && this->state == iiucs_connected ) {
+        laborPending = this->sendLabor ( guard );
+        if ( ! this->ioFlush ( guard ) ) {
+            break;
+        }
+    }
+}
+
+// returns false if the socket can't take all of the send queue
+// or if the circuit failed
+bool tcpiiu::ioFlush ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    if ( this->nIOSendBufs || this->sendQue.occupiedBytes () > 0 ) {
+        this->nFlushes++;
+    }
+
+    while ( true ) {
+        if ( ! this->nIOSendBufs ) {
+            this->ioSendBufBytes = 0u;
+            while ( this->nIOSendBufs < comBufGatherMax ) {
+                comBuf * pBuf = this->sendQue.popNextComBufToSend ();
+                if ( ! pBuf ) {
+                    break;
+                }
+                this->ioSendBufBytes += pBuf->occupiedBytes ();
+                this->ioSendBufs[this->nIOSendBufs++] = pBuf;
+            }
+            if ( ! this->nIOSendBufs ) {
+                break;
+            }
+        }
+
+        bool success = false;
+        {
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            success = comBuf::flushToWire ( *this, this->ioSendBufs, 
+                this->nIOSendBufs, epicsTime::getMonotonic () );
+        }
+
+        if ( ! success ) {
+            if ( this->ioSendBlocked ) {
+                this->pIOThread->watch ( *this, this->sock,
+                    tcpIOClient::ioRead | tcpIOClient::ioWrite );
+                if ( this->blockingForFlush ) {
+                    this->flushBlockEvent.signal ();
+                }
+                return false;
+            }
+            this->releaseSendBufs ( this->ioSendBufs, this->nIOSendBufs );
+            this->nIOSendBufs = 0u;
+            while ( comBuf * pBuf = this->sendQue.popNextComBufToSend () ) {
+                this->releaseSendBufs ( & pBuf, 1u );
+            }
+            return false;
+        }
+
+        this->releaseSendBufs ( this->ioSendBufs, this->nIOSendBufs );
+        this->nIOSendBufs = 0u;
+
+        this->unacknowledgedSendBytes += this->ioSendBufBytes;
+        if ( this->unacknowledgedSendBytes > 
+            this->socketLibrarySendBufferSize ) {
+            this->recvDog.sendBacklogProgressNotify ( guard );
+        }
+    }
+
+    this->pIOThread->watch ( *this, this->sock, tcpIOClient::ioRead );
+
+    this->earlyFlush = false;
+    if ( this->blockingForFlush ) {
+        this->flushBlockEvent.signal ();
+    }
+
+    return true;
+}
+
+unsigned tcpiiu::ioSendBytes ( const wireSendBuf * pBufs, 
+    unsigned nBufs, const epicsTime & currentTime )
+{
+    while ( true ) {
+        int status = this->sendCall ( pBufs, nBufs, 0 );
+        if ( status > 0 ) {
+            if ( this->ioSendDogActive ) {
+                this->ioSendDogActive = false;
+                this->sendDog.cancel ();
+            }
+            return static_cast <unsigned> ( status );
+        }
+
+        int localError = SOCKERRNO;
+
+        // the send watchdog runs while the socket stays full
+        if ( status < 0 && ( localError == SOCK_EWOULDBLOCK ||
+                localError == SOCK_ENOBUFS ) ) {
+            this->ioSendBlocked = true;
+            if ( ! this->ioSendDogActive ) {
+                this->ioSendDogActive = true;
+                this->sendDog.start ( currentTime );
+            }
+            return 0u;
+        }
+
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        if ( this->state != iiucs_connected &&
+            this->state != iiucs_clean_shutdown ) {
+            return 0u;
+        }
+        if ( status == 0 ) {
+            this->disconnectNotify ( guard );
+            return 0u;
+        }
+        if ( localError == SOCK_EINTR ) {
+            continue;
+        }
+        if ( 
+                localError != SOCK_EPIPE && 
+                localError != SOCK_ECONNRESET &&
+                localError != SOCK_ETIMEDOUT && 
+                localError != SOCK_ECONNABORTED &&
+                localError != SOCK_SHUTDOWN ) {
+            char sockErrBuf[64];
+            epicsSocketConvertErrnoToString ( 
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            errlogPrintf ( "CAC: unexpected TCP send error: %s\n", 
+                sockErrBuf );
+        }
+        this->disconnectNotify ( guard );
+        return 0u;
+    }
+}
+
+void tcpiiu::ioShutdown ( epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    if ( this->state == iiucs_clean_shutdown ) {
+        if ( this->ioShutdownSent ) {
+            // waiting for the server to disconnect
+            return;
+        }
+        if ( ! this->ioFlush ( guard ) && this->ioSendBlocked &&
+                this->state == iiucs_clean_shutdown ) {
+            return;
+        }
+        if ( this->state == iiucs_clean_shutdown ) {
+            // this should cause the server to disconnect from 
+            // the client
+            int status = ::shutdown ( this->sock, SHUT_WR );
+            if ( status ) {
+                char sockErrBuf[64];
+                epicsSocketConvertErrnoToString ( 
+                    sockErrBuf, sizeof ( sockErrBuf ) );
+                errlogPrintf ("CAC TCP clean socket shutdown error was %s\n", 
+                    sockErrBuf );
+            }
+            this->ioShutdownSent = true;
+            this->ioShutdownTime = epicsTime::getMonotonic ();
+            this->pIOThread->tick ( *this, true );
+            return;
+        }
+    }
+
+    {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        this->ioSendDogActive = false;
+        this->sendDog.cancel ();
+        this->recvDog.shutdown ();
+    }
+
+    // user threads blocking for send backlog to be reduced
+    // will abort their attempt to get space if 
+    // the state of the tcpiiu changes from connected to a
+    // disconnecting state. Nevertheless, they must finish
+    // prior to destroying the IIU. The last one to leave
+    // requests service, and the tick is a backstop, so that
+    // the I/O thread isnt held up waiting here.
+    if ( this->blockingForFlush ) {
+        this->flushBlockEvent.signal ();
+        this->pIOThread->tick ( *this, true );
+        return;
+    }
+
+    this->pIOThread->retire ( *this, this->sock );
+}
+
+void tcpiiu::ioTick ()
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    // it is possible to get stuck waiting for the server to
+    // disconnect if the circuit isnt known to be unresponsive,
+    // but is, so give up after waiting a reasonable amount of
+    // time for a clean shutdown to finish
+    if ( this->ioShutdownSent && 
+            epicsTime::getMonotonic () - this->ioShutdownTime > 30.0 ) {
+        this->initiateAbortShutdown ( guard );
+    }
+    else if ( this->state == iiucs_abort_shutdown ||
+            this->state == iiucs_disconnected ) {
+        // waiting for user threads blocking for flush
+        this->ioShutdown ( guard );
+    }
+}
+
+void tcpiiu::ioRetire ()
+{
+    this->cacRef.destroyIIU ( *this );
 }
 
 void tcpiiu::initiateCleanShutdown ( 
@@ -835,7 +1489,7 @@ void tcpiiu::initiateCleanShutdown (
         }
         else {
             this->state = iiucs_clean_shutdown;
-            this->sendThreadFlushEvent.signal ();
+            this->sendWakeup ();
             this->flushBlockEvent.signal ();
         }
     }
@@ -854,7 +1508,7 @@ void tcpiiu::disconnectNotify (
 {
     guard.assertIdenticalMutex ( this->mutex );
     this->state = iiucs_disconnected;
-    this->sendThreadFlushEvent.signal ();
+    this->sendWakeup ();
     this->flushBlockEvent.signal ();
 }
 
@@ -872,7 +1526,7 @@ void tcpiiu::responsiveCircuitNotify (
                 channelNode::cs_subscripUpdateReqPend;
             pChan->connect ( cbGuard, guard );
         }
-        this->sendThreadFlushEvent.signal ();
+        this->sendWakeup ();
     }
 }
 
@@ -906,7 +1560,7 @@ void tcpiiu::unresponsiveCircuitNotify (
     if ( ! this->unresponsiveCircuit ) {
         this->unresponsiveCircuit = true;
         this->echoRequestPending = true;
-        this->sendThreadFlushEvent.signal ();
+        this->sendWakeup ();
         this->flushBlockEvent.signal ();
 
         // must not hold lock when canceling timer
@@ -994,8 +1648,10 @@ void tcpiiu::initiateAbortShutdown (
             }
             break;
         case esscimqi_socketSigAlarmRequired:
-            this->recvThread.interruptSocketRecv ();
-            this->sendThread.interruptSocketSend ();
+            if ( this->pRecvThread ) {
+                this->pRecvThread->interruptSocketRecv ();
+                this->pSendThread->interruptSocketSend ();
+            }
             break;
         default:
             break;
@@ -1004,7 +1660,7 @@ void tcpiiu::initiateAbortShutdown (
         // 
         // wake up the send thread if it isnt blocking in send()
         //
-        this->sendThreadFlushEvent.signal ();
+        this->sendWakeup ();
         this->flushBlockEvent.signal ();
     }
 }
@@ -1018,11 +1674,22 @@ tcpiiu :: ~tcpiiu ()
         this->pSearchDest->disable ();
     }
 
-    this->sendThread.exitWait ();
-    this->recvThread.exitWait ();
+    if ( this->pSendThread ) {
+        this->pSendThread->exitWait ();
+        this->pRecvThread->exitWait ();
+    }
     this->sendDog.cancel ();
     this->recvDog.shutdown ();
 
+    delete this->pSendThread;
+    delete this->pRecvThread;
+
+    this->releaseSendBufs ( this->ioSendBufs, this->nIOSendBufs );
+    while ( this->zeroCopyPend.size () ) {
+        this->releaseSendBufs ( & this->zeroCopyPend.front ().pBuf, 1u );
+        this->zeroCopyPend.pop_front ();
+    }
+
     if ( ! this->socketHasBeenClosed ) {
         epicsSocketDestroy ( this->sock );
     }
@@ -1041,6 +1708,26 @@ tcpiiu :: ~tcpiiu ()
     }
 }
 
+void tcpiiu::showSendStatistics ( 
+    epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    char buf[256];
+    this->hostNameCacheInstance.getName ( buf, sizeof ( buf ) );
+    size_t nSendCalls = epicsAtomicGetSizeT ( & this->nSendCalls );
+    ::printf ( "\tsends to \"%s\": %lu flushes, %lu send calls", 
+        buf, this->nFlushes, static_cast < unsigned long > ( nSendCalls ) );
+    if ( this->nFlushes ) {
+        ::printf ( " (%.2f per flush)", 
+            static_cast < double > ( nSendCalls ) / this->nFlushes );
+    }
+    ::printf ( ", %lu zero copy sends, %lu copied\n",
+        static_cast < unsigned long > (
+            epicsAtomicGetSizeT ( & this->nZeroCopySends ) ),
+        static_cast < unsigned long > (
+            epicsAtomicGetSizeT ( & this->nZeroCopyCopied ) ) );
+}
+
 void tcpiiu::show ( unsigned level ) const
 {
     epicsGuard < epicsMutex > locker ( this->mutex );
@@ -1049,6 +1736,9 @@ void tcpiiu::show ( unsigned level ) const
     ::printf ( "Virtual circuit to \"%s\" at version V%u.%u state %u\n", 
         buf, CA_MAJOR_PROTOCOL_REVISION,
         this->minorProtocolVersion, this->state );
+    if ( level > 0u ) {
+        this->showSendStatistics ( locker );
+    }
     if ( level > 1u ) {
         ::printf ( "\tcurrent data cache pointer = %p current data cache size = %lu\n",
             static_cast < void * > ( this->pCurData ), this->curDataMax );
@@ -1059,12 +1749,19 @@ void tcpiiu::show ( unsigned level ) const
     }
     if ( level > 2u ) {
         ::printf ( "\tvirtual circuit socket identifier %d\n", this->sock );
-        ::printf ( "\tsend thread flush signal:\n" );
-        this->sendThreadFlushEvent.show ( level-2u );
-        ::printf ( "\tsend thread:\n" );
-        this->sendThread.show ( level-2u );
-        ::printf ( "\trecv thread:\n" );
-        this->recvThread.show ( level-2u );
+        if ( this->pIOThread ) {
+            ::printf ( "\tserviced by I/O thread, send blocked=%u\n",
+                this->ioSendBlocked );
+            this->pIOThread->show ( level-3u );
+        }
+        else {
+            ::printf ( "\tsend thread flush signal:\n" );
+            this->sendThreadFlushEvent.show ( level-2u );
+            ::printf ( "\tsend thread:\n" );
+            this->pSendThread->show ( level-2u );
+            ::printf ( "\trecv thread:\n" );
+            this->pRecvThread->show ( level-2u );
+        }
         ::printf ("\techo pending bool = %u\n", this->echoRequestPending );
         ::printf ( "IO identifier hash table:\n" );
 
@@ -1124,7 +1821,7 @@ bool tcpiiu::setEchoRequestPending ( epicsGuard < epicsMutex > & guard )
     guard.assertIdenticalMutex ( this->mutex );
 
     this->echoRequestPending = true;
-    this->sendThreadFlushEvent.signal ();
+    this->sendWakeup ();
     if ( CA_V43 ( this->minorProtocolVersion ) ) {
         // we send an echo
         return true;
@@ -1534,6 +2231,59 @@ void tcpiiu::createChannelRequest (
     minder.commit ();
 }
 
+//
+// A search over this circuit for a channel that the name cache
+// says this server has. The server replies with a search
+// response if it has the channel, and otherwise with a not
+// found reply.
+//
+void tcpiiu::nameCacheSearchRequest ( 
+    epicsGuard < epicsMutex > & guard, nciu & chan )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    if ( this->state != iiucs_connected && 
+        this->state != iiucs_connecting ) {
+        return;
+    }
+
+    unsigned nameLength = chan.nameLen ( guard );
+    unsigned postCnt = CA_MESSAGE_ALIGN ( nameLength );
+    if ( postCnt >= 0xffff ) {
+        return;
+    }
+
+    comQueSendMsgMinder minder ( this->sendQue, guard );
+    this->sendQue.insertRequestHeader ( 
+        CA_PROTO_SEARCH, postCnt, 
+        DOREPLY, CA_MINOR_PROTOCOL_REVISION, 
+        chan.getCID ( guard ), chan.getCID ( guard ), 
+        CA_V49 ( this->minorProtocolVersion ) );
+    this->sendQue.pushString ( chan.pName ( guard ), nameLength );
+    if ( postCnt > nameLength ) {
+        this->sendQue.pushString ( cacNillBytes, postCnt - nameLength );
+    }
+    minder.commit ();
+    this->nameCacheHintsPending++;
+    this->flushRequest ( guard );
+}
+
+void tcpiiu::nameCacheHintDone ( 
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+
+    if ( this->nameCacheHintsPending == 0u ) {
+        return;
+    }
+    this->nameCacheHintsPending--;
+    // a circuit opened only for the hints
+    if ( this->nameCacheHintsPending == 0u && 
+            this->channelCountTot == 0u && ! this->isNameService () ) {
+        this->initiateCleanShutdown ( guard );
+    }
+}
+
 void tcpiiu::clearChannelRequest ( epicsGuard < epicsMutex > & guard,
                                   ca_uint32_t sid, ca_uint32_t cid )
 {
@@ -1668,23 +2418,46 @@ bool tcpiiu::sendThreadFlush ( epicsGuard < epicsMutex > & guard )
     guard.assertIdenticalMutex ( this->mutex );
 
     if ( this->sendQue.occupiedBytes() > 0 ) {
-        while ( comBuf * pBuf = this->sendQue.popNextComBufToSend () ) {
+        this->nFlushes++;
+        while ( true ) {
+            // buffers the kernel is done with are reused by this flush
+            this->zeroCopyReap ();
+
+            comBuf * bufs [ comBufGatherMax ];
+            unsigned nBufs = 0u;
+            unsigned bytesToBeSent = 0u;
+            while ( nBufs < comBufGatherMax ) {
+                comBuf * pBuf = this->sendQue.popNextComBufToSend ();
+                if ( ! pBuf ) {
+                    break;
+                }
+                bytesToBeSent += pBuf->occupiedBytes ();
+                bufs[nBufs++] = pBuf;
+            }
+            if ( ! nBufs ) {
+                break;
+            }
+
             epicsTime current = epicsTime::getMonotonic ();
 
-            unsigned bytesToBeSent = pBuf->occupiedBytes ();
             bool success = false;
             {
                 // no lock while blocking to send
                 epicsGuardRelease < epicsMutex > unguard ( guard );
-                success = pBuf->flushToWire ( *this, current );
-                pBuf->~comBuf ();
-                this->comBufMemMgr.release ( pBuf );
+                epicsUInt32 zeroCopyIdBefore = this->zeroCopyId;
+                success = comBuf::flushToWire ( *this, bufs, nBufs, current );
+                if ( this->zeroCopyId != zeroCopyIdBefore ) {
+                    this->zeroCopyHold ( bufs, nBufs );
+                }
+                else {
+                    this->releaseSendBufs ( bufs, nBufs );
+                }
+                this->zeroCopyReap ();
             }
 
             if ( ! success ) {
-                while ( ( pBuf = this->sendQue.popNextComBufToSend () ) ) {
-                    pBuf->~comBuf ();
-                    this->comBufMemMgr.release ( pBuf );
+                while ( comBuf * pBuf = this->sendQue.popNextComBufToSend () ) {
+                    this->releaseSendBufs ( & pBuf, 1u );
                 }
                 return false;
             }
@@ -1750,7 +2523,7 @@ unsigned tcpiiu::requestMessageBytesPending (
 #if 0
     if ( ! this->earlyFlush && this->sendQue.flushEarlyThreshold(0u) ) {
         this->earlyFlush = true;
-        this->sendThreadFlushEvent.signal ();
+        this->sendWakeup ();
     }
 #endif
     return sendQue.occupiedBytes ();
@@ -1765,6 +2538,11 @@ void tcpiiu::decrementBlockingForFlushCount (
     if ( this->blockingForFlush > 0 ) {
         this->flushBlockEvent.signal ();
     }
+    else if ( this->pIOThread && this->state != iiucs_connecting &&
+            this->state != iiucs_connected ) {
+        // the I/O thread may be waiting to retire the circuit
+        this->sendWakeup ();
+    }
 }
 
 osiSockAddr tcpiiu::getNetworkAddress (
@@ -1953,7 +2731,7 @@ void tcpiiu::installChannel (
     chan.searchReplySetUp ( *this, sidIn, typeIn, countIn, guard );
     // The tcp send thread runs at apriority below the udp thread 
     // so that this will not send small packets
-    this->sendThreadFlushEvent.signal ();
+    this->sendWakeup ();
 }
 
 bool tcpiiu :: connectNotify ( 
@@ -2013,7 +2791,8 @@ void tcpiiu::uninstallChan (
     }
     chan.channelNode::listMember = channelNode::cs_none;
     this->channelCountTot--;
-    if ( this->channelCountTot == 0 && ! this->isNameService() ) {
+    if ( this->channelCountTot == 0 && this->nameCacheHintsPending == 0u && 
+            ! this->isNameService() ) {
         this->initiateCleanShutdown ( guard );
     }
 }
@@ -2039,7 +2818,7 @@ int tcpiiu :: printFormated (
 void tcpiiu::flushRequest ( epicsGuard < epicsMutex > & )
 {
     if ( this->sendQue.occupiedBytes () > 0 ) {
-        this->sendThreadFlushEvent.signal ();
+        this->sendWakeup ();
     }
 }
 
@@ -2210,4 +2989,10 @@ void tcpiiu :: searchRespNotify (
     cacRef.transferChanToVirtCircuit 
             ( msg.m_available, msg.m_cid, 0xffff, 
                 0, minorProtocolVersion, serverAddr, currentTime );
+    // only name cache searches are sent to an ordinary server
+    if ( ! this->isNameService () ) {
+        epicsGuard < epicsMutex > guard ( this->mutex );
+        this->cacRef.nameCacheReplyNotify ( 
+            guard, *this, msg.m_available, true );
+    }
 }
@@ -24,6 +24,9 @@
 
 #define epicsAssertAuthor "Jeff Hill johill@lanl.gov"
 
+#include <float.h>
+#include <limits.h>
+
 #include "envDefs.h"
 #include "dbDefs.h"
 #include "osiProcess.h"
@@ -93,6 +96,31 @@ double getMaxPeriod()
     return maxPeriod;
 }
 
+static
+double getMaxSearchRate()
+{
+    double maxRate = 0.0;
+
+    if ( envGetConfigParamPtr ( & EPICS_CA_MAX_SEARCH_RATE ) ) {
+        long longStatus = envGetDoubleConfigParam (
+            & EPICS_CA_MAX_SEARCH_RATE, & maxRate );
+        if ( longStatus ) {
+            epicsPrintf ( "EPICS \"%s\" wasnt a real number\n",
+                            EPICS_CA_MAX_SEARCH_RATE.name );
+            epicsPrintf ( "Search request rate will not be limited\n" );
+            maxRate = 0.0;
+        }
+        else if ( maxRate < 0.0 ) {
+            epicsPrintf ( "\"%s\" out of range (low)\n",
+                            EPICS_CA_MAX_SEARCH_RATE.name );
+            epicsPrintf ( "Search request rate will not be limited\n" );
+            maxRate = 0.0;
+        }
+    }
+
+    return maxRate;
+}
+
 static
 unsigned getNTimers(double maxPeriod)
 {
@@ -132,6 +160,13 @@ udpiiu::udpiiu (
         m_repeaterTimerNotify, timerQueue, cbMutexIn, ctxNotifyIn ),
     govTmr ( *this, timerQueue, cacMutexIn ),
     maxPeriod ( getMaxPeriod() ),
+    maxSearchRate ( getMaxSearchRate() ),
+    searchBudget ( DBL_MAX ), // clipped to the burst limit when first used
+    searchBudgetTime ( epicsTime::getMonotonic () ),
+    nSearchFrames ( 0u ),
+    nSearchDatagrams ( 0u ),
+    nSearchDeferred ( 0u ),
+    nNotHereResp ( 0u ),
     rtteMean ( minRoundTripEstimate ),
     rtteMeanDev ( 0 ),
     cacRef ( cac ),
@@ -797,10 +832,32 @@ bool udpiiu::repeaterAckAction (
     return true;
 }
 
+//
+// servers only send this if asked to reply when the channel
+// isnt found, but when one does it tells the search timer that 
+// the request got through
+//
 bool udpiiu::notHereRespAction ( 
-    const caHdr &,  
-        const osiSockAddr &, const epicsTime & )
+    const caHdr & msg,  
+        const osiSockAddr &, const epicsTime & currentTime )
 {
+    epicsGuard < epicsMutex > guard ( this->cacMutex );
+
+    this->nNotHereResp++;
+
+    nciu * pChan = this->cacRef.lookupChannel ( guard, msg.m_available );
+    if ( ! pChan || pChan->getPIIU ( guard ) != this ) {
+        return true;
+    }
+    channelNode::channelState chanState = 
+        pChan->channelNode::listMember;
+    if ( chanState >= channelNode::cs_searchRespPending0 &&
+            chanState <= channelNode::cs_searchRespPending17 ) {
+        this->ppSearchTmr[ pChan->getSearchTimerIndex ( guard ) ]-> 
+            notHereNotify ( guard, *pChan, this->lastReceivedSeqNo, 
+                this->lastReceivedSeqNoIsValid, currentTime );
+    }
+
     return true;
 }
 
@@ -1134,6 +1191,13 @@ bool udpiiu :: datagramFlush (
         iter++;
     }
 
+    unsigned nDest = _searchDestList.count ();
+    this->nSearchFrames++;
+    this->nSearchDatagrams += nDest;
+    if ( this->maxSearchRate > 0.0 ) {
+        this->searchBudget -= nDest;
+    }
+
     this->nBytesInXmitBuf = 0u;
 
     this->pushVersionMsg ();
@@ -1141,11 +1205,63 @@ bool udpiiu :: datagramFlush (
     return true;
 }
 
+//
+// Returns the number of search frames that may be sent now. Each
+// frame is sent to every search destination, and the budget
+// refills at EPICS_CA_MAX_SEARCH_RATE datagrams per second, with
+// a burst limit of searchBudgetBurstPeriod worth of datagrams
+// (but never less than one frame).
+//
+unsigned udpiiu :: searchFrameBudget ( 
+    epicsGuard < epicsMutex > & guard, const epicsTime & currentTime )
+{
+    guard.assertIdenticalMutex ( cacMutex );
+
+    if ( this->maxSearchRate <= 0.0 ) {
+        return UINT_MAX;
+    }
+
+    double nDest = _searchDestList.count ();
+    if ( nDest < 1.0 ) {
+        nDest = 1.0;
+    }
+    double budgetMax = epicsMax ( nDest, 
+        this->maxSearchRate * searchBudgetBurstPeriod );
+
+    double delay = currentTime - this->searchBudgetTime;
+    if ( delay > 0.0 ) {
+        this->searchBudget += delay * this->maxSearchRate;
+        this->searchBudgetTime = currentTime;
+    }
+    if ( this->searchBudget > budgetMax ) {
+        this->searchBudget = budgetMax;
+    }
+    if ( this->searchBudget < nDest ) {
+        return 0u;
+    }
+    return static_cast < unsigned > ( this->searchBudget / nDest );
+}
+
+void udpiiu :: searchDeferredNotify ( 
+    epicsGuard < epicsMutex > & guard, unsigned nChannels )
+{
+    guard.assertIdenticalMutex ( cacMutex );
+    this->nSearchDeferred += nChannels;
+}
+
 void udpiiu :: show ( unsigned level ) const
 {
     epicsGuard < epicsMutex > guard ( this->cacMutex );
 
     ::printf ( "Datagram IO circuit (and disconnected channel repository)\n");
+    ::printf ( "\t%lu search frames sent as %lu datagrams, "
+        "%lu channel searches deferred, %lu not found replies\n",
+        this->nSearchFrames, this->nSearchDatagrams, 
+        this->nSearchDeferred, this->nNotHereResp );
+    if ( this->maxSearchRate > 0.0 ) {
+        ::printf ( "\tsearch rate limited to %g datagrams per second\n",
+            this->maxSearchRate );
+    }
     if ( level > 1u ) {
         ::printf ("\trepeater port %u\n", this->repeaterPort );
         ::printf ("\tdefault server port %u\n", this->serverPort );
@@ -57,6 +57,8 @@ epicsShareFunc void epicsShareAPI caRepeaterRegistrationMessage (
 extern "C" epicsShareFunc void caRepeaterThread ( 
     void * pDummy );
 epicsShareFunc void ca_repeater ( void );
+extern "C" epicsShareFunc void caNameServerThread (
+    void * pListenSock );
 
 class cac;
 class cacContextNotify;
@@ -84,6 +86,7 @@ static const double maxRoundTripEstimate = 30; // seconds
 static const double maxSearchPeriodDefault = 5.0 * 60.0; // seconds
 static const double maxSearchPeriodLowerLimit = 60.0; // seconds
 static const double beaconAnomalySearchPeriod = 5.0; // seconds
+static const double searchBudgetBurstPeriod = 0.1; // seconds
 
 class udpiiu : 
     private netiiu, 
@@ -154,7 +157,7 @@ private:
     private:
         udpiiu & m_udpiiu;
     };
-    char xmitBuf [MAX_UDP_SEND];   
+    char xmitBuf [ETHERNET_MAX_UDP];   
     char recvBuf [MAX_UDP_RECV];
     udpRecvThread recvThread;
     M_repeaterTimerNotify m_repeaterTimerNotify;
@@ -162,6 +165,15 @@ private:
     disconnectGovernorTimer govTmr;
     tsDLList < SearchDest > _searchDestList;
     const double maxPeriod;
+    // search rate budget in datagrams per second, zero if unlimited
+    const double maxSearchRate;
+    double searchBudget;
+    epicsTime searchBudgetTime;
+    // search statistics
+    unsigned long nSearchFrames;
+    unsigned long nSearchDatagrams;
+    unsigned long nSearchDeferred;
+    unsigned long nNotHereResp;
     double rtteMean;
     double rtteMeanDev;
     cac & cacRef;
@@ -298,6 +310,10 @@ private:
         epicsGuard < epicsMutex > &, const epicsTime & currentTime );
     ca_uint32_t datagramSeqNumber ( 
         epicsGuard < epicsMutex > & ) const;
+    unsigned searchFrameBudget (
+        epicsGuard < epicsMutex > &, const epicsTime & currentTime );
+    void searchDeferredNotify (
+        epicsGuard < epicsMutex > &, unsigned nChannels );
 
     // disconnectGovernorNotify
     void govExpireNotify ( 
@@ -25,6 +25,8 @@
 #ifndef virtualCircuith  
 #define virtualCircuith
 
+#include <deque>
+
 #include "tsDLList.h"
 
 #include "comBuf.h"
@@ -36,6 +38,7 @@
 #include "tcpSendWatchdog.h"
 #include "hostNameCache.h"
 #include "SearchDest.h"
+#include "tcpIOPool.h"
 #include "compilerDependencies.h"
 
 class callbackManager;
@@ -71,9 +74,6 @@ private:
     void run ();
     void connect (
         epicsGuard < epicsMutex > & guard );
-    bool validFillStatus ( 
-        epicsGuard < epicsMutex > & guard, 
-        const statusWireIO & stat );
 };
 
 class tcpSendThread : private epicsThreadRunable {
@@ -111,7 +111,8 @@ private:
 class tcpiiu :
         public netiiu, public tsDLNode < tcpiiu >,
         public tsSLNode < tcpiiu >, public caServerID, 
-        private wireSendAdapter, private wireRecvAdapter {
+        private wireSendAdapter, private wireRecvAdapter,
+        private tcpIOClient {
     friend void SearchDestTCP::searchRequest ( epicsGuard < epicsMutex > & guard,
                                                const char * pbuf, size_t len );
 public:
@@ -119,7 +120,7 @@ public:
         cacContextNotify &, double connectionTimeout, epicsTimerQueue & timerQueue, 
         const osiSockAddr & addrIn, comBufMemoryManager &, unsigned minorVersion, 
         ipAddrToAsciiEngine & engineIn, const cacChannel::priLev & priorityIn,
-        SearchDestTCP * pSearchDestIn = NULL);
+        SearchDestTCP * pSearchDestIn = NULL, tcpIOThread * pIOThreadIn = NULL );
     ~tcpiiu ();
     void start (
         epicsGuard < epicsMutex > & );
@@ -147,6 +148,8 @@ public:
         epicsGuard < epicsMutex > & mutualExclusionGuard );
 
     void show ( unsigned level ) const;
+    void showSendStatistics ( 
+        epicsGuard < epicsMutex > & ) const;
     bool setEchoRequestPending ( 
         epicsGuard < epicsMutex > & );
     void requestRecvProcessPostponedFlush (
@@ -154,6 +157,12 @@ public:
     void clearChannelRequest ( 
         epicsGuard < epicsMutex > &, 
         ca_uint32_t sid, ca_uint32_t cid );
+    void nameCacheSearchRequest ( 
+        epicsGuard < epicsMutex > &, nciu & chan );
+    void nameCacheHintDone ( 
+        epicsGuard < epicsMutex > & );
+    unsigned nameCacheHintCount ( 
+        epicsGuard < epicsMutex > & ) const;
 
     bool ca_v41_ok (
         epicsGuard < epicsMutex > & ) const;
@@ -163,6 +172,8 @@ public:
         epicsGuard < epicsMutex > & ) const;
     bool ca_v49_ok (
         epicsGuard < epicsMutex > & ) const;
+    unsigned minorVersionNumber (
+        epicsGuard < epicsMutex > & ) const;
 
     unsigned getHostName ( 
         epicsGuard < epicsMutex > &,
@@ -205,8 +216,10 @@ public:
 
 private:
     hostNameCache hostNameCacheInstance;
-    tcpRecvThread recvThread;
-    tcpSendThread sendThread;
+    // the threads of a circuit that isnt serviced by an I/O thread pool
+    tcpRecvThread * pRecvThread;
+    tcpSendThread * pSendThread;
+    tcpIOThread * pIOThread;
     tcpRecvWatchdog recvDog;
     tcpSendWatchdog sendDog;
     comQueSend sendQue;
@@ -229,6 +242,26 @@ private:
     SearchDestTCP * pSearchDest;
     epicsMutex & mutex;
     epicsMutex & cbMutex;
+    cacContextNotify & ctxNotify;
+    // partially sent buffers of a circuit serviced by an I/O thread
+    comBuf * ioSendBufs [ comBufGatherMax ];
+    unsigned nIOSendBufs;
+    unsigned ioSendBufBytes;
+    // buffers still read by the kernel after a zero copy send,
+    // only touched by the send thread, so not guarded by the lock
+    struct zeroCopyBuf {
+        comBuf * pBuf;
+        epicsUInt32 id;
+    };
+    std::deque < zeroCopyBuf > zeroCopyPend;
+    epicsUInt32 zeroCopyId;
+    // send statistics, nFlushes is guarded by the lock, the others
+    // are counted without it by the thread sending, so atomically
+    unsigned long nFlushes;
+    size_t nSendCalls;
+    size_t nZeroCopySends;
+    size_t nZeroCopyCopied;
+    epicsTime ioShutdownTime;
     unsigned minorProtocolVersion;
     enum iiu_conn_state { 
         iiucs_connecting, // pending circuit connect
@@ -245,6 +278,8 @@ private:
     unsigned socketLibrarySendBufferSize;
     unsigned unacknowledgedSendBytes;
     unsigned channelCountTot;
+    // name cache searches not yet answered
+    unsigned nameCacheHintsPending;
     bool _receiveThreadIsBusy;
     bool busyStateDetected; // only modified by the recv thread
     bool flowControlActive; // only modified by the send process thread
@@ -256,11 +291,24 @@ private:
     bool discardingPendingData;
     bool socketHasBeenClosed;
     bool unresponsiveCircuit;
+    // only used by the I/O thread
+    bool ioStarted;
+    bool ioSendBlocked;
+    bool ioSendDogActive;
+    bool ioShutdownSent;
+    bool zeroCopy;
 
     bool processIncoming ( 
         const epicsTime & currentTime, callbackManager & );
     unsigned sendBytes ( const void *pBuf, 
         unsigned nBytesInBuf, const epicsTime & currentTime );
+    unsigned sendBytes ( const wireSendBuf * pBufs, 
+        unsigned nBufs, const epicsTime & currentTime );
+    int sendCall ( const wireSendBuf * pBufs, 
+        unsigned nBufs, int flags );
+    void releaseSendBufs ( comBuf * const * ppBufs, unsigned nBufs );
+    void zeroCopyHold ( comBuf * const * ppBufs, unsigned nBufs );
+    void zeroCopyReap ();
     void recvBytes ( 
         void * pBuf, unsigned nBytesInBuf, statusWireIO & );
     const char * pHostName (
@@ -280,6 +328,33 @@ private:
     void decrementBlockingForFlushCount ( 
         epicsGuard < epicsMutex > & guard );
     bool isNameService () const;
+    void sendWakeup ();
+    bool validFillStatus ( 
+        epicsGuard < epicsMutex > & guard, 
+        const statusWireIO & stat );
+    bool processReceived ( 
+        const epicsTime & currentTime, bool & sendWakeupNeeded );
+    bool sendLabor ( 
+        epicsGuard < epicsMutex > & );
+
+    // I/O thread pool client
+    void ioReady ( unsigned events );
+    void ioService ();
+    void ioTick ();
+    void ioRetire ();
+    void ioConnect ( 
+        epicsGuard < epicsMutex > & );
+    void ioConnectComplete ( 
+        epicsGuard < epicsMutex > & );
+    bool ioReceive ();
+    void ioSendLabor ( 
+        epicsGuard < epicsMutex > & );
+    bool ioFlush ( 
+        epicsGuard < epicsMutex > & );
+    void ioShutdown ( 
+        epicsGuard < epicsMutex > & );
+    unsigned ioSendBytes ( const wireSendBuf * pBufs, 
+        unsigned nBufs, const epicsTime & currentTime );
 
     // send protocol stubs
     void echoRequest ( 
@@ -368,6 +443,18 @@ inline bool tcpiiu::ca_v49_ok (
     return CA_V49 ( this->minorProtocolVersion );
 }
 
+inline unsigned tcpiiu::minorVersionNumber (
+    epicsGuard < epicsMutex > & ) const
+{
+    return this->minorProtocolVersion;
+}
+
+inline unsigned tcpiiu::nameCacheHintCount (
+    epicsGuard < epicsMutex > & ) const
+{
+    return this->nameCacheHintsPending;
+}
+
 inline bool tcpiiu::alive (
     epicsGuard < epicsMutex > & ) const
 {
@@ -0,0 +1,241 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * caNameCacheTest
+ *
+ * Exercises the memory mapped channel name cache in a scratch
+ * file: entries added, replaced and removed by name or by server,
+ * more servers forgotten than the header remembers, a file reused
+ * or reset by a later client, and eviction when a probe chain is
+ * full.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "osiSock.h"
+#include "inetAddrID.h"
+#include "caNameCache.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+const char * const pCacheFile = "caNameCacheTest.cache";
+
+osiSockAddr server ( unsigned short port )
+{
+    osiSockAddr addr;
+    memset ( & addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+    addr.ia.sin_port = htons ( port );
+    return addr;
+}
+
+// the name is cached for the server on this port
+bool cached ( caNameCache & cache, const char * pName, unsigned short port )
+{
+    osiSockAddr addr;
+    unsigned minorVersion = 0u;
+    return cache.lookup ( pName, addr, minorVersion ) &&
+        addr.ia.sin_family == AF_INET &&
+        addr.ia.sin_addr.s_addr == htonl ( INADDR_LOOPBACK ) &&
+        addr.ia.sin_port == htons ( port ) && minorVersion == 13u;
+}
+
+bool missing ( caNameCache & cache, const char * pName )
+{
+    osiSockAddr addr;
+    unsigned minorVersion;
+    return ! cache.lookup ( pName, addr, minorVersion );
+}
+
+void forget ( caNameCache & cache, unsigned short port )
+{
+    cache.removeServer ( inetAddrID ( server ( port ).ia ) );
+}
+
+void testUpdate ( caNameCache & cache )
+{
+    testDiag ( "Adding, replacing and removing names" );
+    cache.update ( "cache:a", server ( 5064 ), 13u );
+    testOk ( cached ( cache, "cache:a", 5064 ), "cache:a found" );
+    testOk ( missing ( cache, "cache:none" ), "cache:none isn't" );
+    cache.update ( "cache:a", server ( 5065 ), 13u );
+    testOk ( cached ( cache, "cache:a", 5065 ), "cache:a moved" );
+    cache.remove ( "cache:a", server ( 5064 ) );
+    testOk ( cached ( cache, "cache:a", 5065 ),
+        "not removed for the server it left" );
+    cache.remove ( "cache:a", server ( 5065 ) );
+    testOk ( missing ( cache, "cache:a" ), "removed for its server" );
+}
+
+void testRemoveServer ( caNameCache & cache )
+{
+    char name[32];
+    unsigned nA = 0u, nB = 0u;
+
+    testDiag ( "Forgetting a server" );
+    for ( unsigned i = 0u; i < 10u; i++ ) {
+        sprintf ( name, "a:%u", i );
+        cache.update ( name, server ( 6001 ), 13u );
+        sprintf ( name, "b:%u", i );
+        cache.update ( name, server ( 6002 ), 13u );
+    }
+    forget ( cache, 6001 );
+    for ( unsigned i = 0u; i < 10u; i++ ) {
+        sprintf ( name, "a:%u", i );
+        nA += missing ( cache, name );
+        sprintf ( name, "b:%u", i );
+        nB += cached ( cache, name, 6002 );
+    }
+    testOk ( nA == 10u, "%u of 10 names of the server forgotten", nA );
+    testOk ( nB == 10u, "%u of 10 names of another server kept", nB );
+    cache.update ( "a:0", server ( 6001 ), 13u );
+    testOk ( cached ( cache, "a:0", 6001 ),
+        "a name added again after the server was forgotten" );
+    forget ( cache, 6001 );
+    testOk ( missing ( cache, "a:0" ), "and forgotten with it again" );
+}
+
+void testManyServers ( caNameCache & cache )
+{
+    const unsigned nServers = caNameCacheServers + 8u;
+    char name[32];
+    unsigned nMissing = 0u;
+
+    testDiag ( "Forgetting more servers than the header holds" );
+    for ( unsigned i = 0u; i < nServers; i++ ) {
+        sprintf ( name, "many:%u", i );
+        cache.update ( name, server ( 7000 + i ), 13u );
+    }
+    for ( unsigned i = 0u; i < nServers; i++ ) {
+        forget ( cache, 7000 + i );
+    }
+    for ( unsigned i = 0u; i < nServers; i++ ) {
+        sprintf ( name, "many:%u", i );
+        nMissing += missing ( cache, name );
+    }
+    testOk ( nMissing == nServers, "%u of %u names forgotten",
+        nMissing, nServers );
+    cache.update ( "many:0", server ( 7000 ), 13u );
+    testOk ( cached ( cache, "many:0", 7000 ),
+        "a name added afterwards is found" );
+}
+
+// names which all hash to the same first slot
+void collidingNames ( char names[][32], unsigned count )
+{
+    const unsigned mask = caNameCacheSlots - 1u;
+    unsigned index = 0u;
+    unsigned n = 0u;
+    for ( unsigned i = 0u; n < count; i++ ) {
+        sprintf ( names[n], "evict:%u", i );
+        unsigned nameIndex =
+            static_cast < unsigned > ( caNameCache::hash ( names[n] ) ) & mask;
+        if ( n == 0u ) {
+            index = nameIndex;
+            n++;
+        }
+        else if ( nameIndex == index ) {
+            n++;
+        }
+    }
+}
+
+void testEviction ( caNameCache & cache )
+{
+    char names[caNameCacheProbes + 1u][32];
+    unsigned nFound = 0u;
+
+    testDiag ( "Eviction from a full probe chain" );
+    collidingNames ( names, caNameCacheProbes + 1u );
+    for ( unsigned i = 0u; i < caNameCacheProbes; i++ ) {
+        cache.update ( names[i], server ( 8000 + i ), 13u );
+    }
+    for ( unsigned i = 0u; i < caNameCacheProbes; i++ ) {
+        nFound += cached ( cache, names[i], 8000 + i );
+    }
+    testOk ( nFound == caNameCacheProbes, "%u of %u colliding names found",
+        nFound, caNameCacheProbes );
+
+    cache.update ( names[caNameCacheProbes], server ( 8100 ), 13u );
+    testOk ( cached ( cache, names[caNameCacheProbes], 8100 ),
+        "one more is found" );
+    testOk ( missing ( cache, names[0] ), "the first one probed was evicted" );
+    nFound = 0u;
+    for ( unsigned i = 1u; i < caNameCacheProbes; i++ ) {
+        nFound += cached ( cache, names[i], 8000 + i );
+    }
+    testOk ( nFound == caNameCacheProbes - 1u, "%u of %u others kept",
+        nFound, caNameCacheProbes - 1u );
+}
+
+// overwrite part of the file header, as another version might
+void corruptHeader ( long offset, const void * pBytes, size_t nBytes )
+{
+    FILE * pFile = fopen ( pCacheFile, "r+b" );
+    if ( ! pFile ) {
+        testAbort ( "Can't open %s", pCacheFile );
+    }
+    if ( fseek ( pFile, offset, SEEK_SET ) ||
+            fwrite ( pBytes, 1u, nBytes, pFile ) != nBytes ) {
+        testAbort ( "Can't write %s", pCacheFile );
+    }
+    fclose ( pFile );
+}
+
+caNameCache & reopen ( caNameCache * pCache )
+{
+    delete pCache;
+    pCache = caNameCache::create ( pCacheFile );
+    if ( ! pCache ) {
+        testAbort ( "Can't open the name cache again" );
+    }
+    return *pCache;
+}
+
+} // namespace
+
+MAIN ( caNameCacheTest )
+{
+    testPlan ( 19 );
+
+    remove ( pCacheFile );
+    caNameCache * pCache = caNameCache::create ( pCacheFile );
+    testOk ( pCache != 0, "name cache created in %s", pCacheFile );
+    if ( ! pCache ) {
+        testAbort ( "No name cache" );
+    }
+
+    testUpdate ( *pCache );
+    testRemoveServer ( *pCache );
+    testManyServers ( *pCache );
+    testEviction ( *pCache );
+
+    testDiag ( "Reopening the file" );
+    pCache->update ( "keep", server ( 5064 ), 13u );
+    pCache = & reopen ( pCache );
+    testOk ( cached ( *pCache, "keep", 5064 ), "entries are kept" );
+
+    static const char badMagic[] = "XANAMES";
+    corruptHeader ( 0, badMagic, sizeof ( badMagic ) - 1u );
+    pCache = & reopen ( pCache );
+    testOk ( missing ( *pCache, "keep" ),
+        "entries are dropped with an unknown header" );
+
+    pCache->update ( "keep", server ( 5064 ), 13u );
+    epicsUInt32 nSlots = caNameCacheSlots / 2u;
+    corruptHeader ( 8, & nSlots, sizeof ( nSlots ) );
+    pCache = & reopen ( pCache );
+    testOk ( missing ( *pCache, "keep" ),
+        "and with a different number of slots" );
+
+    delete pCache;
+    remove ( pCacheFile );
+    return testDone ();
+}
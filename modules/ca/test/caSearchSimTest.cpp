@@ -0,0 +1,583 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * caSearchSimTest
+ *
+ * Runs a simulated CA server on the loopback interface, which
+ * only knows the "sim:live:<n>" names, and points a CA client
+ * context at it. The server drops the requested percentage of the
+ * search datagrams, and optionally answers every name it doesnt
+ * have with a not found reply. Checks that the live channels
+ * connect, that search datagrams are filled with names, and that
+ * EPICS_CA_MAX_SEARCH_RATE bounds the datagram rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osiSock.h"
+#include "epicsAtomic.h"
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "envDefs.h"
+#include "cadef.h"
+#include "caProto.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+static const char * const pLivePrefix = "sim:live:";
+static const char * const pDeadPrefix = "sim:dead:";
+static const unsigned simMinorVersion = 13u; // CA V4.13
+
+struct searchSimServer {
+    SOCKET udpSock;
+    SOCKET tcpSock;
+    unsigned short udpPort;
+    unsigned short tcpPort;
+    double lossFraction;
+    bool replyNotFound;
+    int stopping;
+    epicsThreadId udpThread;
+    epicsThreadId tcpThread;
+    size_t nCircuits;
+    size_t nDatagrams;
+    size_t nDropped;
+    size_t nSearches;
+    size_t nDeadSearches;
+};
+
+struct searchSimCircuitParm {
+    searchSimServer * pServer;
+    SOCKET sock;
+};
+
+struct searchSimClient {
+    epicsMutex mutex;
+    epicsTime begin;
+    unsigned nConnected;
+    double sumDelay;
+    double maxDelay;
+};
+
+static void simHeader ( caHdr & hdr, unsigned cmmd, unsigned postsize,
+    unsigned dataType, unsigned count, ca_uint32_t cid, ca_uint32_t available )
+{
+    hdr.m_cmmd = htons ( static_cast < ca_uint16_t > ( cmmd ) );
+    hdr.m_postsize = htons ( static_cast < ca_uint16_t > ( postsize ) );
+    hdr.m_dataType = htons ( static_cast < ca_uint16_t > ( dataType ) );
+    hdr.m_count = htons ( static_cast < ca_uint16_t > ( count ) );
+    hdr.m_cid = htonl ( cid );
+    hdr.m_available = htonl ( available );
+}
+
+static bool simRecvAll ( SOCKET sock, char * pBuf, unsigned nBytes )
+{
+    while ( nBytes ) {
+        int status = recv ( sock, pBuf, static_cast < int > ( nBytes ), 0 );
+        if ( status <= 0 ) {
+            return false;
+        }
+        pBuf += status;
+        nBytes -= static_cast < unsigned > ( status );
+    }
+    return true;
+}
+
+static bool simSendAll ( SOCKET sock, const void * pBuf, unsigned nBytes )
+{
+    const char * pCur = static_cast < const char * > ( pBuf );
+    while ( nBytes ) {
+        int status = send ( sock, pCur, static_cast < int > ( nBytes ), 0 );
+        if ( status <= 0 ) {
+            return false;
+        }
+        pCur += status;
+        nBytes -= static_cast < unsigned > ( status );
+    }
+    return true;
+}
+
+/*
+ * one virtual circuit, which knows just enough of the protocol
+ * to connect channels
+ */
+extern "C" void searchSimCircuit ( void * pParm )
+{
+    searchSimCircuitParm * pCircuit =
+        static_cast < searchSimCircuitParm * > ( pParm );
+    searchSimServer * pServer = pCircuit->pServer;
+    SOCKET sock = pCircuit->sock;
+    char payload [ MAX_TCP ];
+    ca_uint32_t sid = 0u;
+
+    while ( true ) {
+        caHdr hdr;
+        if ( ! simRecvAll ( sock, reinterpret_cast < char * > ( & hdr ),
+                sizeof ( hdr ) ) ) {
+            break;
+        }
+        unsigned postsize = ntohs ( hdr.m_postsize );
+        if ( postsize > sizeof ( payload ) ||
+                ! simRecvAll ( sock, payload, postsize ) ) {
+            break;
+        }
+        unsigned cmmd = ntohs ( hdr.m_cmmd );
+        ca_uint32_t cid = ntohl ( hdr.m_cid );
+        bool ok = true;
+        if ( cmmd == CA_PROTO_VERSION ) {
+            caHdr reply;
+            simHeader ( reply, CA_PROTO_VERSION, 0u, 0u,
+                simMinorVersion, 0u, 0u );
+            ok = simSendAll ( sock, & reply, sizeof ( reply ) );
+        }
+        else if ( cmmd == CA_PROTO_CREATE_CHAN ) {
+            caHdr reply[2];
+            simHeader ( reply[0], CA_PROTO_ACCESS_RIGHTS, 0u, 0u, 0u,
+                cid, CA_PROTO_ACCESS_RIGHT_READ | CA_PROTO_ACCESS_RIGHT_WRITE );
+            simHeader ( reply[1], CA_PROTO_CREATE_CHAN, 0u, DBR_DOUBLE, 1u,
+                cid, sid++ );
+            ok = simSendAll ( sock, reply, sizeof ( reply ) );
+        }
+        else if ( cmmd == CA_PROTO_SEARCH ) {
+            // from a client with a name cache
+            bool live = postsize > strlen ( pLivePrefix ) &&
+                strncmp ( payload, pLivePrefix, strlen ( pLivePrefix ) ) == 0;
+            if ( live ) {
+                // the server address is the circuit's
+                caHdr reply;
+                simHeader ( reply, CA_PROTO_SEARCH, 0u, 0u, 0u,
+                    INADDR_BROADCAST, ntohl ( hdr.m_available ) );
+                ok = simSendAll ( sock, & reply, sizeof ( reply ) );
+            }
+            else if ( ntohs ( hdr.m_dataType ) == DOREPLY ) {
+                caHdr reply;
+                simHeader ( reply, CA_PROTO_NOT_FOUND, 0u, DOREPLY,
+                    simMinorVersion, cid, ntohl ( hdr.m_available ) );
+                ok = simSendAll ( sock, & reply, sizeof ( reply ) );
+            }
+        }
+        else if ( cmmd == CA_PROTO_CLEAR_CHANNEL || cmmd == CA_PROTO_ECHO ) {
+            ok = simSendAll ( sock, & hdr, sizeof ( hdr ) );
+        }
+        if ( ! ok ) {
+            break;
+        }
+    }
+    epicsSocketDestroy ( sock );
+    delete pCircuit;
+    epicsAtomicDecrSizeT ( & pServer->nCircuits );
+}
+
+extern "C" void searchSimListen ( void * pParm )
+{
+    searchSimServer * pServer = static_cast < searchSimServer * > ( pParm );
+
+    while ( true ) {
+        osiSockAddr addr;
+        osiSocklen_t addrSize = sizeof ( addr );
+        SOCKET sock = epicsSocketAccept ( pServer->tcpSock,
+            & addr.sa, & addrSize );
+        if ( sock == INVALID_SOCKET ) {
+            break;
+        }
+        if ( epicsAtomicGetIntT ( & pServer->stopping ) ) {
+            // woken up by searchSimStop ()
+            epicsSocketDestroy ( sock );
+            break;
+        }
+        searchSimCircuitParm * pCircuit = new searchSimCircuitParm;
+        pCircuit->pServer = pServer;
+        pCircuit->sock = sock;
+        epicsAtomicIncrSizeT ( & pServer->nCircuits );
+        epicsThreadId tid = epicsThreadCreate ( "caSearchSimCircuit",
+            epicsThreadPriorityMedium,
+            epicsThreadGetStackSize ( epicsThreadStackMedium ),
+            searchSimCircuit, pCircuit );
+        if ( ! tid ) {
+            epicsAtomicDecrSizeT ( & pServer->nCircuits );
+            epicsSocketDestroy ( sock );
+            delete pCircuit;
+        }
+    }
+}
+
+/*
+ * answers the search requests in each datagram with one
+ * datagram that begins with the request's sequence number
+ */
+extern "C" void searchSimDatagrams ( void * pParm )
+{
+    searchSimServer * pServer = static_cast < searchSimServer * > ( pParm );
+    char recvBuf [ MAX_UDP_RECV ];
+    char sendBuf [ ETHERNET_MAX_UDP ];
+
+    while ( true ) {
+        osiSockAddr addr;
+        osiSocklen_t addrSize = sizeof ( addr );
+        int status = recvfrom ( pServer->udpSock, recvBuf, sizeof ( recvBuf ), 0,
+            & addr.sa, & addrSize );
+        if ( status < 0 || epicsAtomicGetIntT ( & pServer->stopping ) ) {
+            break;
+        }
+        // drop the same datagrams every run
+        size_t n = epicsAtomicIncrSizeT ( & pServer->nDatagrams );
+        if ( static_cast < size_t > ( n * pServer->lossFraction ) !=
+                static_cast < size_t > ( ( n - 1u ) * pServer->lossFraction ) ) {
+            epicsAtomicIncrSizeT ( & pServer->nDropped );
+            continue;
+        }
+
+        caHdr * pVersion = reinterpret_cast < caHdr * > ( sendBuf );
+        simHeader ( *pVersion, CA_PROTO_VERSION, 0u, sequenceNoIsValid,
+            simMinorVersion, 0u, 0u );
+        unsigned nSendBytes = sizeof ( caHdr );
+
+        unsigned nBytes = static_cast < unsigned > ( status );
+        const char * pCur = recvBuf;
+        while ( nBytes >= sizeof ( caHdr ) ) {
+            caHdr hdr;
+            memcpy ( & hdr, pCur, sizeof ( hdr ) );
+            unsigned size = sizeof ( caHdr ) + ntohs ( hdr.m_postsize );
+            if ( size > nBytes ) {
+                break;
+            }
+            unsigned cmmd = ntohs ( hdr.m_cmmd );
+            if ( cmmd == CA_PROTO_VERSION ) {
+                pVersion->m_cid = hdr.m_cid;
+            }
+            else if ( cmmd == CA_PROTO_SEARCH ) {
+                const char * pName = pCur + sizeof ( caHdr );
+                unsigned nameLen = size - sizeof ( caHdr );
+                bool live = nameLen > strlen ( pLivePrefix ) &&
+                    strncmp ( pName, pLivePrefix, strlen ( pLivePrefix ) ) == 0;
+                epicsAtomicIncrSizeT ( & pServer->nSearches );
+                if ( ! live ) {
+                    epicsAtomicIncrSizeT ( & pServer->nDeadSearches );
+                }
+                if ( live || pServer->replyNotFound ) {
+                    if ( nSendBytes + sizeof ( caHdr ) + 8u > sizeof ( sendBuf ) ) {
+                        sendto ( pServer->udpSock, sendBuf, nSendBytes, 0,
+                            & addr.sa, sizeof ( addr.ia ) );
+                        nSendBytes = sizeof ( caHdr );
+                    }
+                    caHdr * pReply = reinterpret_cast < caHdr * > (
+                        & sendBuf[nSendBytes] );
+                    ca_uint32_t cid = ntohl ( hdr.m_available );
+                    if ( live ) {
+                        simHeader ( *pReply, CA_PROTO_SEARCH, 8u,
+                            pServer->tcpPort, 0u, INADDR_BROADCAST, cid );
+                        char * pMinor = reinterpret_cast < char * > ( pReply + 1 );
+                        memset ( pMinor, '\0', 8u );
+                        pMinor[0] = static_cast < char > ( simMinorVersion >> 8u );
+                        pMinor[1] = static_cast < char > ( simMinorVersion );
+                        nSendBytes += sizeof ( caHdr ) + 8u;
+                    }
+                    else {
+                        simHeader ( *pReply, CA_PROTO_NOT_FOUND, 0u,
+                            DOREPLY, simMinorVersion, cid, cid );
+                        nSendBytes += sizeof ( caHdr );
+                    }
+                }
+            }
+            pCur += size;
+            nBytes -= size;
+        }
+        if ( nSendBytes > sizeof ( caHdr ) ) {
+            sendto ( pServer->udpSock, sendBuf, nSendBytes, 0,
+                & addr.sa, sizeof ( addr.ia ) );
+        }
+    }
+}
+
+static unsigned short searchSimBind ( SOCKET sock, unsigned short port )
+{
+    osiSockAddr addr;
+    memset ( & addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+    addr.ia.sin_port = htons ( port );
+    if ( bind ( sock, & addr.sa, sizeof ( addr.ia ) ) < 0 ) {
+        return 0u;
+    }
+    osiSocklen_t addrSize = sizeof ( addr );
+    if ( getsockname ( sock, & addr.sa, & addrSize ) < 0 ) {
+        return 0u;
+    }
+    return ntohs ( addr.ia.sin_port );
+}
+
+extern "C" void caSearchSimConnHandler ( struct connection_handler_args args )
+{
+    if ( args.op != CA_OP_CONN_UP ) {
+        return;
+    }
+    searchSimClient * pClient =
+        static_cast < searchSimClient * > ( ca_puser ( args.chid ) );
+    epicsGuard < epicsMutex > guard ( pClient->mutex );
+    double delay = epicsTime::getMonotonic () - pClient->begin;
+    pClient->nConnected++;
+    pClient->sumDelay += delay;
+    if ( delay > pClient->maxDelay ) {
+        pClient->maxDelay = delay;
+    }
+}
+
+static bool searchSimStart ( searchSimServer & server,
+    double lossPercent, bool replyNotFound )
+{
+    memset ( & server, 0, sizeof ( server ) );
+    server.lossFraction = lossPercent / 100.0;
+    server.replyNotFound = replyNotFound;
+
+    server.udpSock = epicsSocketCreate ( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+    server.tcpSock = epicsSocketCreate ( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+    if ( server.udpSock == INVALID_SOCKET || server.tcpSock == INVALID_SOCKET ) {
+        testDiag ( "unable to create sockets" );
+        return false;
+    }
+    server.udpPort = searchSimBind ( server.udpSock, 0u );
+    server.tcpPort = searchSimBind ( server.tcpSock, 0u );
+    if ( ! server.udpPort || ! server.tcpPort ||
+            listen ( server.tcpSock, 10 ) < 0 ) {
+        testDiag ( "unable to bind to the loopback interface" );
+        return false;
+    }
+
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    opts.priority = epicsThreadPriorityMedium;
+    opts.joinable = 1;
+    opts.stackSize = epicsThreadGetStackSize ( epicsThreadStackBig );
+    server.udpThread = epicsThreadCreateOpt ( "caSearchSimUDP",
+        searchSimDatagrams, & server, & opts );
+    opts.stackSize = epicsThreadGetStackSize ( epicsThreadStackMedium );
+    server.tcpThread = epicsThreadCreateOpt ( "caSearchSimTCP",
+        searchSimListen, & server, & opts );
+    return server.udpThread && server.tcpThread;
+}
+
+/*
+ * wake up the server threads with a datagram and a connection
+ * of their own, and wait for them and the circuits to exit
+ */
+static void searchSimStop ( searchSimServer & server )
+{
+    epicsAtomicSetIntT ( & server.stopping, 1 );
+
+    osiSockAddr addr;
+    memset ( & addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+    if ( server.udpThread ) {
+        addr.ia.sin_port = htons ( server.udpPort );
+        sendto ( server.udpSock, "", 0, 0, & addr.sa, sizeof ( addr.ia ) );
+        epicsThreadMustJoin ( server.udpThread );
+    }
+    if ( server.tcpThread ) {
+        SOCKET sock = epicsSocketCreate ( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+        addr.ia.sin_port = htons ( server.tcpPort );
+        if ( sock != INVALID_SOCKET ) {
+            connect ( sock, & addr.sa, sizeof ( addr.ia ) );
+            epicsThreadMustJoin ( server.tcpThread );
+            epicsSocketDestroy ( sock );
+        }
+    }
+
+    // the circuits close with the client context
+    epicsTime begin = epicsTime::getMonotonic ();
+    while ( epicsAtomicGetSizeT ( & server.nCircuits ) &&
+            epicsTime::getMonotonic () - begin < 10.0 ) {
+        epicsThreadSleep ( 0.01 );
+    }
+    if ( epicsAtomicGetSizeT ( & server.nCircuits ) ) {
+        testDiag ( "%lu circuits still open", static_cast < unsigned long > (
+            epicsAtomicGetSizeT ( & server.nCircuits ) ) );
+    }
+
+    if ( server.udpSock != INVALID_SOCKET ) {
+        epicsSocketDestroy ( server.udpSock );
+    }
+    if ( server.tcpSock != INVALID_SOCKET ) {
+        epicsSocketDestroy ( server.tcpSock );
+    }
+}
+
+struct searchSimResult {
+    unsigned nConnected;
+    size_t nDatagramsConnect;
+    size_t nSearchesConnect;
+    size_t nDatagrams;
+    double elapsed;
+    // most datagrams received beyond the rate limit at any time
+    double maxExcess;
+};
+
+static void searchSimSample ( searchSimServer & server, const epicsTime & begin,
+    double maxRate, searchSimResult & result )
+{
+    double elapsed = epicsTime::getMonotonic () - begin;
+    double excess = epicsAtomicGetSizeT ( & server.nDatagrams ) -
+        maxRate * elapsed;
+    if ( excess > result.maxExcess ) {
+        result.maxExcess = excess;
+    }
+}
+
+static void caSearchSim ( unsigned nLive, unsigned nDead, double lossPercent,
+    double observeDelay, bool replyNotFound, searchSimResult & result )
+{
+    static const double connectTimeout = 60.0;
+    searchSimServer server;
+    searchSimClient client;
+    char buf[64];
+
+    memset ( & result, 0, sizeof ( result ) );
+    client.nConnected = 0u;
+    client.sumDelay = 0.0;
+    client.maxDelay = 0.0;
+
+    if ( ! searchSimStart ( server, lossPercent, replyNotFound ) ) {
+        testAbort ( "caSearchSim: unable to start the server" );
+    }
+
+    sprintf ( buf, "127.0.0.1:%u", server.udpPort );
+    epicsEnvSet ( "EPICS_CA_ADDR_LIST", buf );
+    epicsEnvSet ( "EPICS_CA_AUTO_ADDR_LIST", "NO" );
+    epicsEnvSet ( "EPICS_CA_NAME_SERVERS", "" );
+    epicsEnvSet ( "EPICS_CA_NAME_CACHE", "" );
+
+    const char * pRate = envGetConfigParamPtr ( & EPICS_CA_MAX_SEARCH_RATE );
+    double maxRate = pRate ? atof ( pRate ) : 0.0;
+    testDiag ( "%u live and %u dead channels, %g%% search datagram loss, "
+        "not found replies %s, search rate limit %s",
+        nLive, nDead, lossPercent, replyNotFound ? "on" : "off",
+        maxRate > 0.0 ? pRate : "none" );
+
+    int status = ca_context_create ( ca_enable_preemptive_callback );
+    if ( status != ECA_NORMAL ) {
+        testAbort ( "ca_context_create() failed" );
+    }
+
+    unsigned total = nLive + nDead;
+    chid * pChidTable = new chid [ total ];
+    client.begin = epicsTime::getMonotonic ();
+    // spread the live channels evenly among the dead ones
+    unsigned iLive = 0u;
+    for ( unsigned i = 0u; i < total; i++ ) {
+        bool live = ( ( i + 1u ) * static_cast < double > ( nLive ) ) / total > iLive;
+        if ( live ) {
+            sprintf ( buf, "%s%u", pLivePrefix, iLive++ );
+        }
+        else {
+            sprintf ( buf, "%s%u", pDeadPrefix, i - iLive );
+        }
+        status = ca_create_channel ( buf, caSearchSimConnHandler,
+            & client, CA_PRIORITY_DEFAULT, & pChidTable[i] );
+        if ( status != ECA_NORMAL ) {
+            testAbort ( "ca_create_channel() failed" );
+        }
+    }
+    ca_flush_io ();
+
+    while ( true ) {
+        {
+            epicsGuard < epicsMutex > guard ( client.mutex );
+            result.nConnected = client.nConnected;
+        }
+        searchSimSample ( server, client.begin, maxRate, result );
+        double elapsed = epicsTime::getMonotonic () - client.begin;
+        if ( result.nConnected >= nLive || elapsed > connectTimeout ) {
+            break;
+        }
+        epicsThreadSleep ( 0.01 );
+    }
+    result.nDatagramsConnect = epicsAtomicGetSizeT ( & server.nDatagrams );
+    result.nSearchesConnect = epicsAtomicGetSizeT ( & server.nSearches );
+    size_t nDeadConnect = epicsAtomicGetSizeT ( & server.nDeadSearches );
+
+    epicsTime observeBegin = epicsTime::getMonotonic ();
+    while ( epicsTime::getMonotonic () - observeBegin < observeDelay ) {
+        searchSimSample ( server, client.begin, maxRate, result );
+        epicsThreadSleep ( 0.01 );
+    }
+
+    result.nDatagrams = epicsAtomicGetSizeT ( & server.nDatagrams );
+    result.elapsed = epicsTime::getMonotonic () - client.begin;
+    size_t nSearches = epicsAtomicGetSizeT ( & server.nSearches );
+    size_t nDeadSearches = epicsAtomicGetSizeT ( & server.nDeadSearches );
+
+    {
+        epicsGuard < epicsMutex > guard ( client.mutex );
+        testDiag ( "connected %u of %u live channels, "
+            "mean %f sec, last %f sec", client.nConnected, nLive,
+            client.nConnected ? client.sumDelay / client.nConnected : 0.0,
+            client.maxDelay );
+    }
+    testDiag ( "until connected: %lu search datagrams, %lu names "
+        "(%.1f per datagram), %lu searches for dead names",
+        static_cast < unsigned long > ( result.nDatagramsConnect ),
+        static_cast < unsigned long > ( result.nSearchesConnect ),
+        result.nDatagramsConnect ? static_cast < double > (
+            result.nSearchesConnect ) / result.nDatagramsConnect : 0.0,
+        static_cast < unsigned long > ( nDeadConnect ) );
+    testDiag ( "the following %g sec: %lu search datagrams (%.1f per sec), "
+        "%.2f searches per dead name", observeDelay,
+        static_cast < unsigned long > (
+            result.nDatagrams - result.nDatagramsConnect ),
+        observeDelay > 0.0 ?
+            ( result.nDatagrams - result.nDatagramsConnect ) / observeDelay : 0.0,
+        nDead ? static_cast < double > ( nDeadSearches - nDeadConnect ) / nDead : 0.0 );
+    testDiag ( "total: %lu search datagrams in %.2f sec, %lu dropped, "
+        "%lu names", static_cast < unsigned long > ( result.nDatagrams ),
+        result.elapsed, static_cast < unsigned long > (
+            epicsAtomicGetSizeT ( & server.nDropped ) ),
+        static_cast < unsigned long > ( nSearches ) );
+
+    for ( unsigned i = 0u; i < total; i++ ) {
+        ca_clear_channel ( pChidTable[i] );
+    }
+    delete [] pChidTable;
+    ca_context_destroy ();
+
+    searchSimStop ( server );
+}
+
+MAIN ( caSearchSimTest )
+{
+    static const double maxRate = 20.0;
+    searchSimResult result;
+
+    testPlan ( 6 );
+    osiSockAttach ();
+
+    epicsEnvSet ( "EPICS_CA_MAX_SEARCH_RATE", "" );
+    caSearchSim ( 1000u, 0u, 0.0, 0.5, false, result );
+    testOk ( result.nConnected == 1000u, "all 1000 live channels connected" );
+    testOk ( result.nSearchesConnect > 30u * result.nDatagramsConnect,
+        "more than 30 names per search datagram" );
+
+    // each search datagram is one frame, sent to the one address
+    epicsEnvSet ( "EPICS_CA_MAX_SEARCH_RATE", "20" );
+    caSearchSim ( 100u, 1000u, 0.0, 2.0, false, result );
+    testOk ( result.nConnected == 100u,
+        "all 100 live channels connected with the rate limited" );
+    // a burst of a tenth of a second, or one frame, plus one for sampling
+    double allowed = maxRate * 0.1 + 2.0;
+    testOk ( result.maxExcess <= allowed,
+        "at most %.1f search datagrams beyond 20 per sec, %.1f allowed",
+        result.maxExcess, allowed );
+    testOk ( result.nDatagrams - result.nDatagramsConnect > 0u,
+        "dead channels are still searched for" );
+    epicsEnvSet ( "EPICS_CA_MAX_SEARCH_RATE", "" );
+
+    caSearchSim ( 400u, 400u, 25.0, 0.5, true, result );
+    testOk ( result.nConnected == 400u,
+        "all 400 live channels connected with 25%% datagram loss" );
+
+    return testDone ();
+}
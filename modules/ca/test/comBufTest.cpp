@@ -0,0 +1,250 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * comBufTest
+ *
+ * Drives the gathered comBuf::flushToWire() with a wire that takes
+ * a scripted number of bytes per call, so that the writes end part
+ * way through buffers, on buffer boundaries, or block, and checks
+ * that the bytes arrive in order and are removed from the buffers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "epicsTime.h"
+#include "comBuf.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+class mallocMemoryManager : public comBufMemoryManager {
+public:
+    void * allocate ( size_t size )
+    {
+        void * p = malloc ( size );
+        if ( ! p ) {
+            testAbort ( "Out of memory" );
+        }
+        return p;
+    }
+    void release ( void * p )
+    {
+        free ( p );
+    }
+};
+
+// takes limits[i] bytes on the i'th call, cycling, 0 blocks
+class mockWire : public wireSendAdapter {
+public:
+    mockWire ( const unsigned * pLimits, unsigned nLimits, bool gatherIn ) :
+        limits ( pLimits, pLimits + nLimits ), nextLimit ( 0u ),
+        nCalls ( 0u ), maxBufs ( 0u ), gather ( gatherIn ) {}
+    unsigned sendBytes ( const void * pBuf, unsigned nBytesInBuf,
+        const epicsTime & )
+    {
+        wireSendBuf buf;
+        buf.pBuf = pBuf;
+        buf.nBytes = nBytesInBuf;
+        return this->take ( & buf, 1u );
+    }
+    unsigned sendBytes ( const wireSendBuf * pBufs, unsigned nBufs,
+        const epicsTime & currentTime )
+    {
+        if ( ! this->gather ) {
+            return wireSendAdapter::sendBytes ( pBufs, nBufs, currentTime );
+        }
+        return this->take ( pBufs, nBufs );
+    }
+    std::vector < unsigned > limits;
+    unsigned nextLimit;
+    std::vector < epicsUInt8 > out;
+    unsigned nCalls;
+    unsigned maxBufs;
+    bool gather;
+private:
+    unsigned take ( const wireSendBuf * pBufs, unsigned nBufs )
+    {
+        unsigned limit = this->limits[this->nextLimit++ % this->limits.size ()];
+        unsigned nBytes = 0u;
+        this->nCalls++;
+        if ( nBufs > this->maxBufs ) {
+            this->maxBufs = nBufs;
+        }
+        for ( unsigned i = 0u; i < nBufs && nBytes < limit; i++ ) {
+            const epicsUInt8 * p =
+                static_cast < const epicsUInt8 * > ( pBufs[i].pBuf );
+            unsigned n = pBufs[i].nBytes;
+            if ( n > limit - nBytes ) {
+                n = limit - nBytes;
+            }
+            this->out.insert ( this->out.end (), p, p + n );
+            nBytes += n;
+        }
+        return nBytes;
+    }
+};
+
+// buffers filled with a running byte pattern
+class bufSet {
+public:
+    bufSet ( const unsigned * pSizes, unsigned nBufsIn ) :
+        nBufs ( nBufsIn ), nBytes ( 0u )
+    {
+        this->ppBufs = new comBuf * [nBufsIn];
+        for ( unsigned i = 0u; i < nBufsIn; i++ ) {
+            this->ppBufs[i] = new ( this->mgr ) comBuf;
+            for ( unsigned j = 0u; j < pSizes[i]; j++ ) {
+                epicsUInt8 byte = pattern ( this->nBytes++ );
+                this->ppBufs[i]->copyInBytes ( & byte, 1u );
+            }
+            this->ppBufs[i]->commitIncomming ();
+        }
+    }
+    ~bufSet ()
+    {
+        for ( unsigned i = 0u; i < this->nBufs; i++ ) {
+            this->ppBufs[i]->~comBuf ();
+            this->mgr.release ( this->ppBufs[i] );
+        }
+        delete [] this->ppBufs;
+    }
+    bool flush ( mockWire & wire )
+    {
+        return comBuf::flushToWire ( wire, this->ppBufs, this->nBufs,
+            epicsTime::getMonotonic () );
+    }
+    unsigned occupied ( unsigned i ) const
+    {
+        return this->ppBufs[i]->occupiedBytes ();
+    }
+    bool empty () const
+    {
+        for ( unsigned i = 0u; i < this->nBufs; i++ ) {
+            if ( this->ppBufs[i]->occupiedBytes () ) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // the wire received all of the bytes, in order
+    bool received ( const mockWire & wire ) const
+    {
+        if ( wire.out.size () != this->nBytes ) {
+            return false;
+        }
+        for ( unsigned i = 0u; i < this->nBytes; i++ ) {
+            if ( wire.out[i] != pattern ( i ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static epicsUInt8 pattern ( unsigned offset )
+    {
+        return static_cast < epicsUInt8 > ( offset * 7u + offset / 251u );
+    }
+private:
+    mallocMemoryManager mgr;
+    comBuf ** ppBufs;
+    unsigned nBufs;
+    unsigned nBytes;
+};
+
+void testShortWrites ( bool gather )
+{
+    static const unsigned sizes[] = { 100u, 0u, comBufSize, 1u, 5000u, 0u };
+    static const unsigned limits[] = { 7u, 3u, 4096u, 1u, 16383u, 16385u };
+    bufSet set ( sizes, 6u );
+    mockWire wire ( limits, 6u, gather );
+
+    testDiag ( "Short writes across buffer boundaries, %s",
+        gather ? "gathered" : "one buffer per call" );
+    bool success = set.flush ( wire );
+    testOk ( success && set.empty (), "flushed and emptied in %u calls",
+        wire.nCalls );
+    testOk ( set.received ( wire ), "%u bytes received in order",
+        (unsigned) wire.out.size () );
+    testOk ( gather ? wire.maxBufs > 1u : wire.maxBufs == 1u,
+        "at most %u buffers per call", wire.maxBufs );
+}
+
+void testBoundaries ()
+{
+    static const unsigned sizes[] = { 100u, comBufSize, 50u };
+    static const unsigned limits[] = { 100u, comBufSize, 50u };
+    bufSet set ( sizes, 3u );
+    mockWire wire ( limits, 3u, true );
+
+    testDiag ( "Writes ending on buffer boundaries" );
+    bool success = set.flush ( wire );
+    testOk ( success && set.empty () && wire.nCalls == 3u &&
+        set.received ( wire ), "flushed in %u calls", wire.nCalls );
+}
+
+void testBlocked ()
+{
+    static const unsigned sizes[] = { 100u, 100u, 100u };
+    static const unsigned limits[] = { 150u, 0u, 1000u };
+    bufSet set ( sizes, 3u );
+    mockWire wire ( limits, 3u, true );
+
+    testDiag ( "A write that blocks part way through a buffer" );
+    bool success = set.flush ( wire );
+    unsigned occupied[3] = { set.occupied ( 0u ), set.occupied ( 1u ),
+        set.occupied ( 2u ) };
+    testOk ( ! success && wire.out.size () == 150u,
+        "flush fails with %u bytes sent", (unsigned) wire.out.size () );
+    testOk ( occupied[0] == 0u && occupied[1] == 50u && occupied[2] == 100u,
+        "%u, %u and %u bytes left", occupied[0], occupied[1], occupied[2] );
+    success = set.flush ( wire );
+    testOk ( success && set.empty () && set.received ( wire ),
+        "the next flush sends the rest" );
+}
+
+void testGatherMax ()
+{
+    static const unsigned limits[] = { 100000u };
+    std::vector < unsigned > sizes ( comBufGatherMax + 6u, 10u );
+    bufSet set ( & sizes[0], (unsigned) sizes.size () );
+    mockWire wire ( limits, 1u, true );
+
+    testDiag ( "More buffers than are gathered in one call" );
+    bool success = set.flush ( wire );
+    testOk ( success && set.empty () && set.received ( wire ),
+        "%u buffers flushed", (unsigned) sizes.size () );
+    testOk ( wire.nCalls == 2u && wire.maxBufs == comBufGatherMax,
+        "%u calls of at most %u buffers", wire.nCalls, wire.maxBufs );
+}
+
+void testEmpty ()
+{
+    static const unsigned sizes[] = { 0u, 0u };
+    static const unsigned limits[] = { 0u };
+    bufSet set ( sizes, 2u );
+    mockWire wire ( limits, 1u, true );
+
+    bool success = set.flush ( wire );
+    testOk ( success && wire.nCalls == 0u,
+        "empty buffers are not sent" );
+}
+
+} // namespace
+
+MAIN ( comBufTest )
+{
+    testPlan ( 13 );
+    testShortWrites ( true );
+    testShortWrites ( false );
+    testBoundaries ();
+    testBlocked ();
+    testGatherMax ();
+    testEmpty ();
+    return testDone ();
+}
@@ -25,7 +25,7 @@
 #include "epicsAtomic.h"
 #include "epicsEvent.h"
 #include "epicsInterrupt.h"
-#include "epicsRingPointer.h"
+#include "epicsRingMPMC.h"
 #include "epicsString.h"
 #include "epicsThread.h"
 #include "epicsTimer.h"
@@ -50,14 +50,28 @@
 
 static int callbackQueueSize = 2000;
 
+struct cbQueueSet;
+
+/* Per-thread queue of a work-stealing priority */
+typedef struct cbWorker {
+    epicsEventId semWakeUp;
+    epicsRingMPMCId queue;
+    int sleeping; // use atomic
+    int index;
+    struct cbQueueSet *set;
+} cbWorker;
+
 typedef struct cbQueueSet {
     epicsEventId semWakeUp;
-    epicsRingPointerId queue;
+    epicsRingMPMCId queue;
     int queueOverflow;
     int queueOverflows;
     int shutdown; // use atomic
     int threadsConfigured;
     int threadsRunning;
+    int threadsSleeping; // use atomic
+    int workStealing;
+    cbWorker *workers;  /* threadsConfigured entries if workStealing */
 } cbQueueSet;
 
 static cbQueueSet callbackQueue[NUM_CALLBACK_PRIORITIES];
@@ -107,18 +121,59 @@ int callbackSetQueueSize(int size)
     return 0;
 }
 
+/* Queue statistics of a work-stealing set are those of its fullest worker */
+static int queueUsed(cbQueueSet *mySet)
+{
+    int i, used = 0;
+
+    if (!mySet->workStealing)
+        return epicsRingMPMCGetUsed(mySet->queue);
+    for (i = 0; i < mySet->threadsConfigured; i++) {
+        int n = epicsRingMPMCGetUsed(mySet->workers[i].queue);
+        if (n > used) used = n;
+    }
+    return used;
+}
+
+static int queueHighWaterMark(cbQueueSet *mySet)
+{
+    int i, hwm = 0;
+
+    if (!mySet->workStealing)
+        return epicsRingMPMCGetHighWaterMark(mySet->queue);
+    for (i = 0; i < mySet->threadsConfigured; i++) {
+        int n = epicsRingMPMCGetHighWaterMark(mySet->workers[i].queue);
+        if (n > hwm) hwm = n;
+    }
+    return hwm;
+}
+
+static void queueResetHighWaterMark(cbQueueSet *mySet)
+{
+    int i;
+
+    if (!mySet->workStealing) {
+        epicsRingMPMCResetHighWaterMark(mySet->queue);
+        return;
+    }
+    for (i = 0; i < mySet->threadsConfigured; i++)
+        epicsRingMPMCResetHighWaterMark(mySet->workers[i].queue);
+}
+
 int callbackQueueStatus(const int reset, callbackQueueStats *result)
 {
     int ret;
     if (epicsAtomicGetIntT(&cbState)==cbInit) return -1;
     if (result) {
         int prio;
-        result->size = callbackQueueSize;
+        cbQueueSet *set0 = &callbackQueue[0];
+        result->size = epicsRingMPMCGetSize(set0->workStealing ?
+            set0->workers[0].queue : set0->queue);
         for(prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsRingPointerId qId = callbackQueue[prio].queue;
-            result->numUsed[prio] = epicsRingPointerGetUsed(qId);
-            result->maxUsed[prio] = epicsRingPointerGetHighWaterMark(qId);
-            result->numOverflow[prio] = epicsAtomicGetIntT(&callbackQueue[prio].queueOverflows);
+            cbQueueSet *mySet = &callbackQueue[prio];
+            result->numUsed[prio] = queueUsed(mySet);
+            result->maxUsed[prio] = queueHighWaterMark(mySet);
+            result->numOverflow[prio] = epicsAtomicGetIntT(&mySet->queueOverflows);
         }
         ret = 0;
     } else {
@@ -127,7 +182,7 @@ int callbackQueueStatus(const int reset, callbackQueueStats *result)
     if (reset) {
         int prio;
         for(prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsRingPointerResetHighWaterMark(callbackQueue[prio].queue);
+            queueResetHighWaterMark(&callbackQueue[prio]);
         }
     }
     return ret;
@@ -152,7 +207,8 @@ void callbackQueueShow(const int reset)
     }
 }
 
-int callbackParallelThreads(int count, const char *prio)
+static int configureThreads(const char *func, int count, const char *prio,
+    int workStealing)
 {
     if (epicsAtomicGetIntT(&cbState)!=cbInit) {
         fprintf(stderr, "Callback system already initialized\n");
@@ -170,6 +226,7 @@ int callbackParallelThreads(int count, const char *prio)
 
         for (i = 0; i < NUM_CALLBACK_PRIORITIES; i++) {
             callbackQueue[i].threadsConfigured = count;
+            callbackQueue[i].workStealing = workStealing;
         }
     }
     else {
@@ -177,14 +234,14 @@ int callbackParallelThreads(int count, const char *prio)
         int i;
 
         if (!pdbbase) {
-            fprintf(stderr, "callbackParallelThreads: pdbbase not set\n");
+            fprintf(stderr, "%s: pdbbase not set\n", func);
             return -1;
         }
 
         /* Find prio in menuPriority */
         pdbMenu = dbFindMenu(pdbbase, "menuPriority");
         if (!pdbMenu) {
-            fprintf(stderr, "callbackParallelThreads: No Priority menu\n");
+            fprintf(stderr, "%s: No Priority menu\n", func);
             return -1;
         }
 
@@ -192,16 +249,26 @@ int callbackParallelThreads(int count, const char *prio)
             if (epicsStrCaseCmp(prio, pdbMenu->papChoiceValue[i]) == 0)
                 goto found;
         }
-        fprintf(stderr, "callbackParallelThreads: "
-            "Unknown priority \"%s\"\n", prio);
+        fprintf(stderr, "%s: Unknown priority \"%s\"\n", func, prio);
         return -1;
 
 found:
         callbackQueue[i].threadsConfigured = count;
+        callbackQueue[i].workStealing = workStealing;
     }
     return 0;
 }
 
+int callbackParallelThreads(int count, const char *prio)
+{
+    return configureThreads("callbackParallelThreads", count, prio, FALSE);
+}
+
+int callbackWorkStealingThreads(int count, const char *prio)
+{
+    return configureThreads("callbackWorkStealingThreads", count, prio, TRUE);
+}
+
 static void callbackTask(void *arg)
 {
     int prio = *(int*)arg;
@@ -211,17 +278,29 @@ static void callbackTask(void *arg)
     epicsEventSignal(startStopEvent);
 
     while(!epicsAtomicGetIntT(&mySet->shutdown)) {
-        void *ptr;
-        if (epicsRingPointerIsEmpty(mySet->queue))
-            epicsEventMustWait(mySet->semWakeUp);
-
-        while ((ptr = epicsRingPointerPop(mySet->queue))) {
-            epicsCallback *pcallback = (epicsCallback *)ptr;
-            if(!epicsRingPointerIsEmpty(mySet->queue))
-                epicsEventMustTrigger(mySet->semWakeUp);
-            mySet->queueOverflow = FALSE;
-            (*pcallback->callback)(pcallback);
+        epicsCallback *pcallback = epicsRingMPMCPop(mySet->queue);
+
+        if (!pcallback) {
+            /* Producers only signal semWakeUp when some thread is
+             * sleeping, so announce ourselves before the final check.
+             * Don't spin on a request which is still being pushed,
+             * its producer will wake us when it is complete.
+             */
+            epicsAtomicIncrIntT(&mySet->threadsSleeping);
+            pcallback = epicsRingMPMCPop(mySet->queue);
+            if (!pcallback)
+                epicsEventMustWait(mySet->semWakeUp);
+            epicsAtomicDecrIntT(&mySet->threadsSleeping);
+            if (!pcallback)
+                continue;
         }
+
+        /* pass the wakeup along only if there is work and a sleeper */
+        if (epicsAtomicGetIntT(&mySet->threadsSleeping) &&
+            !epicsRingMPMCIsEmpty(mySet->queue))
+            epicsEventMustTrigger(mySet->semWakeUp);
+        mySet->queueOverflow = FALSE;
+        (*pcallback->callback)(pcallback);
     }
 
     if(!epicsAtomicDecrIntT(&mySet->threadsRunning))
@@ -229,6 +308,97 @@ static void callbackTask(void *arg)
     taskwdRemove(0);
 }
 
+/* Take the next request, preferring the worker's own queue */
+static epicsCallback *workerPop(cbWorker *me)
+{
+    cbQueueSet *mySet = me->set;
+    int n = mySet->threadsConfigured;
+    epicsCallback *pcallback = epicsRingMPMCPop(me->queue);
+    int i;
+
+    for (i = 1; !pcallback && i < n; i++)
+        pcallback = epicsRingMPMCPop(mySet->workers[(me->index + i) % n].queue);
+    return pcallback;
+}
+
+static int workersPending(cbQueueSet *mySet)
+{
+    int i;
+
+    for (i = 0; i < mySet->threadsConfigured; i++) {
+        if (!epicsRingMPMCIsEmpty(mySet->workers[i].queue))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Wake one sleeping worker, preferring the target */
+static void wakeWorker(cbQueueSet *mySet, cbWorker *target)
+{
+    int n = mySet->threadsConfigured;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        cbWorker *pw = &mySet->workers[(target->index + i) % n];
+
+        if (epicsAtomicGetIntT(&pw->sleeping)) {
+            epicsEventSignal(pw->semWakeUp);
+            return;
+        }
+    }
+}
+
+static void callbackWorkerTask(void *arg)
+{
+    cbWorker *me = (cbWorker *) arg;
+    cbQueueSet *mySet = me->set;
+
+    taskwdInsert(0, NULL, NULL);
+    epicsEventSignal(startStopEvent);
+
+    while(!epicsAtomicGetIntT(&mySet->shutdown)) {
+        epicsCallback *pcallback = workerPop(me);
+
+        if (!pcallback) {
+            /* Same protocol as callbackTask(), but producers also
+             * look at our flag to decide which worker to wake.
+             */
+            epicsAtomicSetIntT(&me->sleeping, 1);
+            epicsAtomicIncrIntT(&mySet->threadsSleeping);
+            pcallback = workerPop(me);
+            if (!pcallback)
+                epicsEventMustWait(me->semWakeUp);
+            epicsAtomicDecrIntT(&mySet->threadsSleeping);
+            epicsAtomicSetIntT(&me->sleeping, 0);
+            if (!pcallback)
+                continue;
+        }
+
+        if (epicsAtomicGetIntT(&mySet->threadsSleeping) &&
+            workersPending(mySet))
+            wakeWorker(mySet, &mySet->workers[(me->index + 1) %
+                mySet->threadsConfigured]);
+        mySet->queueOverflow = FALSE;
+        (*pcallback->callback)(pcallback);
+    }
+
+    if(!epicsAtomicDecrIntT(&mySet->threadsRunning))
+        epicsEventSignal(startStopEvent);
+    taskwdRemove(0);
+}
+
+static void wakeAll(cbQueueSet *mySet)
+{
+    int j;
+
+    if (!mySet->workStealing) {
+        epicsEventSignal(mySet->semWakeUp);
+        return;
+    }
+    for (j = 0; j < mySet->threadsConfigured; j++)
+        epicsEventSignal(mySet->workers[j].semWakeUp);
+}
+
 void callbackStop(void)
 {
     int i;
@@ -237,14 +407,14 @@ void callbackStop(void)
 
     for (i = 0; i < NUM_CALLBACK_PRIORITIES; i++) {
         epicsAtomicSetIntT(&callbackQueue[i].shutdown, 1);
-        epicsEventSignal(callbackQueue[i].semWakeUp);
+        wakeAll(&callbackQueue[i]);
     }
 
     for (i = 0; i < NUM_CALLBACK_PRIORITIES; i++) {
         cbQueueSet *mySet = &callbackQueue[i];
 
         while (epicsAtomicGetIntT(&mySet->threadsRunning)) {
-            epicsEventSignal(mySet->semWakeUp);
+            wakeAll(mySet);
             epicsEventWaitWithTimeout(startStopEvent, 0.1);
         }
     }
@@ -262,8 +432,19 @@ void callbackCleanup(void)
         cbQueueSet *mySet = &callbackQueue[i];
 
         assert(epicsAtomicGetIntT(&mySet->threadsRunning)==0);
-        epicsEventDestroy(mySet->semWakeUp);
-        epicsRingPointerDelete(mySet->queue);
+        if (mySet->workStealing) {
+            int j;
+
+            for (j = 0; j < mySet->threadsConfigured; j++) {
+                epicsEventDestroy(mySet->workers[j].semWakeUp);
+                epicsRingMPMCDelete(mySet->workers[j].queue);
+            }
+            free(mySet->workers);
+        }
+        else {
+            epicsEventDestroy(mySet->semWakeUp);
+            epicsRingMPMCDelete(mySet->queue);
+        }
     }
 
     epicsTimerQueueRelease(timerQueue);
@@ -287,35 +468,96 @@ void callbackInit(void)
     timerQueue = epicsTimerQueueAllocate(0, epicsThreadPriorityScanHigh);
 
     for (i = 0; i < NUM_CALLBACK_PRIORITIES; i++) {
+        cbQueueSet *mySet = &callbackQueue[i];
         epicsThreadId tid;
 
-        callbackQueue[i].semWakeUp = epicsEventMustCreate(epicsEventEmpty);
-        callbackQueue[i].queue = epicsRingPointerLockedCreate(callbackQueueSize);
-        if (callbackQueue[i].queue == 0)
-            cantProceed("epicsRingPointerLockedCreate failed for %s\n",
-                threadNamePrefix[i]);
-        callbackQueue[i].queueOverflow = FALSE;
-        if (callbackQueue[i].threadsConfigured == 0)
-            callbackQueue[i].threadsConfigured = callbackThreadsDefault;
-
-        for (j = 0; j < callbackQueue[i].threadsConfigured; j++) {
-            if (callbackQueue[i].threadsConfigured > 1 )
+        mySet->queueOverflow = FALSE;
+        if (mySet->threadsConfigured == 0)
+            mySet->threadsConfigured = callbackThreadsDefault;
+
+        if (mySet->workStealing) {
+            mySet->workers = callocMustSucceed(mySet->threadsConfigured,
+                sizeof(cbWorker), "callbackInit");
+            for (j = 0; j < mySet->threadsConfigured; j++) {
+                cbWorker *pw = &mySet->workers[j];
+
+                pw->semWakeUp = epicsEventMustCreate(epicsEventEmpty);
+                pw->queue = epicsRingMPMCCreate(callbackQueueSize);
+                if (pw->queue == 0)
+                    cantProceed("epicsRingMPMCCreate failed for %s-%d\n",
+                        threadNamePrefix[i], j);
+                pw->index = j;
+                pw->set = mySet;
+            }
+        }
+        else {
+            mySet->semWakeUp = epicsEventMustCreate(epicsEventEmpty);
+            mySet->queue = epicsRingMPMCCreate(callbackQueueSize);
+            if (mySet->queue == 0)
+                cantProceed("epicsRingMPMCCreate failed for %s\n",
+                    threadNamePrefix[i]);
+        }
+
+        for (j = 0; j < mySet->threadsConfigured; j++) {
+            if (mySet->threadsConfigured > 1 )
                 sprintf(threadName, "%s-%d", threadNamePrefix[i], j);
             else
                 strcpy(threadName, threadNamePrefix[i]);
-            tid = epicsThreadCreate(threadName, threadPriority[i],
-                epicsThreadGetStackSize(epicsThreadStackBig),
-                (EPICSTHREADFUNC)callbackTask, &priorityValue[i]);
+            if (mySet->workStealing)
+                tid = epicsThreadCreate(threadName, threadPriority[i],
+                    epicsThreadGetStackSize(epicsThreadStackBig),
+                    callbackWorkerTask, &mySet->workers[j]);
+            else
+                tid = epicsThreadCreate(threadName, threadPriority[i],
+                    epicsThreadGetStackSize(epicsThreadStackBig),
+                    (EPICSTHREADFUNC)callbackTask, &priorityValue[i]);
             if (tid == 0) {
                 cantProceed("Failed to spawn callback thread %s\n", threadName);
             } else {
                 epicsEventWait(startStopEvent);
-                epicsAtomicIncrIntT(&callbackQueue[i].threadsRunning);
+                epicsAtomicIncrIntT(&mySet->threadsRunning);
             }
         }
     }
 }
 
+static void ProcessCallback(epicsCallback *pcallback);
+
+/* Requests for the same lock set go to the same worker, others are
+ * spread by their user pointer.  This only picks the starting queue,
+ * idle workers steal from the others, and uses the lock set the record
+ * is in when it is queued.
+ */
+static unsigned long workerHash(epicsCallback *pcallback)
+{
+    if (pcallback->callback == ProcessCallback && pcallback->user) {
+        dbCommon *pRec = (dbCommon *) pcallback->user;
+
+        if (pRec->lset)
+            return dbLockGetLockId(pRec);
+    }
+    return (unsigned long) ((size_t) (pcallback->user ?
+        pcallback->user : (void *) pcallback) >> 4);
+}
+
+static int workerPush(cbQueueSet *mySet, epicsCallback *pcallback)
+{
+    int n = mySet->threadsConfigured;
+    unsigned long home = workerHash(pcallback) % n;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        cbWorker *pw = &mySet->workers[(home + i) % n];
+
+        if (epicsRingMPMCPush(pw->queue, pcallback)) {
+            if (epicsAtomicGetIntT(&mySet->threadsSleeping))
+                wakeWorker(mySet, pw);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 /* This routine can be called from interrupt context */
 int callbackRequest(epicsCallback *pcallback)
 {
@@ -335,7 +577,10 @@ int callbackRequest(epicsCallback *pcallback)
     mySet = &callbackQueue[priority];
     if (mySet->queueOverflow) return S_db_bufFull;
 
-    pushOK = epicsRingPointerPush(mySet->queue, pcallback);
+    if (mySet->workStealing)
+        pushOK = workerPush(mySet, pcallback);
+    else
+        pushOK = epicsRingMPMCPush(mySet->queue, pcallback);
 
     if (!pushOK) {
         epicsInterruptContextMessage(fullMessage[priority]);
@@ -343,7 +588,10 @@ int callbackRequest(epicsCallback *pcallback)
         epicsAtomicIncrIntT(&mySet->queueOverflows);
         return S_db_bufFull;
     }
-    epicsEventSignal(mySet->semWakeUp);
+    /* busy threads will find the request without being woken */
+    if (!mySet->workStealing &&
+        epicsAtomicGetIntT(&mySet->threadsSleeping))
+        epicsEventSignal(mySet->semWakeUp);
     return 0;
 }
 
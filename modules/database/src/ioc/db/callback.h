@@ -85,6 +85,7 @@ epicsShareFunc int callbackSetQueueSize(int size);
 epicsShareFunc int callbackQueueStatus(const int reset, callbackQueueStats *result);
 epicsShareFunc void callbackQueueShow(const int reset);
 epicsShareFunc int callbackParallelThreads(int count, const char *prio);
+epicsShareFunc int callbackWorkStealingThreads(int count, const char *prio);
 
 #ifdef __cplusplus
 }
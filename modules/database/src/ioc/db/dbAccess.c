@@ -51,6 +51,7 @@
 #include "dbLink.h"
 #include "dbLockPvt.h"
 #include "dbNotify.h"
+#include "dbProcStats.h"
 #include "dbScan.h"
 #include "dbServer.h"
 #include "dbStaticLib.h"
@@ -469,6 +470,7 @@ long dbProcess(dbCommon *precord)
     int	set_trace = FALSE;
     dbFldDes *pdbFldDes;
     int callNotifyCompletion = FALSE;
+    dbProcStats *pstats = dbRec2Pvt(precord)->pstats;
 
     ptrace = dbLockSetAddrTrace(precord);
     /*
@@ -585,7 +587,14 @@ long dbProcess(dbCommon *precord)
         printf("%s: dbProcess of '%s'\n", context, precord->name);
 
     /* process record */
-    status = prset->process(precord);
+    if (pstats && pstats->enabled) {
+        epicsUInt64 start = epicsMonotonicGet();
+
+        status = prset->process(precord);
+        dbProcStatsAdd(pstats, epicsMonotonicGet() - start);
+    }
+    else
+        status = prset->process(precord);
 
     /* Print record's fields if PRINT_MASK set in breakpoint field */
     if (lset_stack_count != 0) {
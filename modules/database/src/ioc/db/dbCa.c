@@ -58,17 +58,30 @@
 extern void dbServiceIOInit();
 extern int dbServiceIsolate;
 
-static ELLLIST workList = ELLLIST_INIT;    /* Work list for dbCaTask */
-static epicsMutexId workListLock; /*Mutual exclusions semaphores for workList*/
-static epicsEventId workListEvent; /*wakeup event for dbCaTask*/
-static int removesOutstanding = 0;
+/* Each dbCa worker thread has its own CA client context and work list.
+ * A link is given to a worker by the hash of its target PV name when it
+ * is created, and stays there.
+ */
+typedef struct caWorker {
+    ELLLIST workList;           /* Work list for dbCaTask */
+    epicsMutexId workListLock;  /*Mutual exclusions semaphores for workList*/
+    epicsEventId workListEvent; /*wakeup event for dbCaTask*/
+    epicsEventId startStopEvent;
+    int removesOutstanding;
+    int chanCount;
+    unsigned long nActions;     /* links taken off workList */
+    struct ca_client_context *context;
+    epicsThreadId thread;
+} caWorker;
+
+static int nWorkersConfig = 1;  /* set by dbCaSetThreads() */
+static int nWorkers;
+static caWorker *workers;
 #define removesOutstandingWarning 10000
 
 static volatile enum dbCaCtl_t {
     ctlInit, ctlRun, ctlPause, ctlExit
 } dbCaCtl;
-static epicsEventId startStopEvent;
-static epicsThreadId dbCaWorker;
 
 struct ca_client_context * dbCaClientContext;
 
@@ -81,15 +94,13 @@ static lset dbCa_lset;
     errlogPrintf("%s has DB CA link to %s\n",\
         pcaLink->plink->precord->name, pcaLink->pvname)
 
-static int dbca_chan_count;
-
 /* caLink locking
  *
  * Lock ordering:
  *  dbScanLock -> caLink.lock -> workListLock
  *
  * workListLock:
- *   Guards access to workList.
+ *   Guards access to the workList of its worker.
  *
  * dbScanLock:
  *   All dbCa* functions operating on a single link may only be called when
@@ -127,9 +138,10 @@ static int dbca_chan_count;
 
 static void addAction(caLink *pca, short link_action)
 {
+    caWorker *pw = pca->worker;
     int callAdd;
 
-    epicsMutexMustLock(workListLock);
+    epicsMutexMustLock(pw->workListLock);
     callAdd = (pca->link_action == 0);
     if (pca->link_action & CA_CLEAR_CHANNEL) {
         errlogPrintf("dbCa::addAction %d with CA_CLEAR_CHANNEL set\n",
@@ -138,22 +150,22 @@ static void addAction(caLink *pca, short link_action)
         link_action = 0;
     }
     if (link_action & CA_CLEAR_CHANNEL) {
-        if (++removesOutstanding >= removesOutstandingWarning) {
+        if (++pw->removesOutstanding >= removesOutstandingWarning) {
             errlogPrintf("dbCa::addAction pausing, %d channels to clear\n",
-                removesOutstanding);
+                pw->removesOutstanding);
         }
-        while (removesOutstanding >= removesOutstandingWarning) {
-            epicsMutexUnlock(workListLock);
+        while (pw->removesOutstanding >= removesOutstandingWarning) {
+            epicsMutexUnlock(pw->workListLock);
             epicsThreadSleep(1.0);
-            epicsMutexMustLock(workListLock);
+            epicsMutexMustLock(pw->workListLock);
         }
     }
     pca->link_action |= link_action;
     if (callAdd)
-        ellAdd(&workList, &pca->node);
-    epicsMutexUnlock(workListLock);
+        ellAdd(&pw->workList, &pca->node);
+    epicsMutexUnlock(pw->workListLock);
     if (callAdd)
-        epicsEventSignal(workListEvent);
+        epicsEventSignal(pw->workListEvent);
 }
 
 static void caLinkInc(caLink *pca)
@@ -175,7 +187,7 @@ static void caLinkDec(caLink *pca)
 
     if (pca->chid) {
         ca_clear_channel(pca->chid);
-        --dbca_chan_count;
+        epicsAtomicDecrIntT(&pca->worker->chanCount);
     }
     callback = pca->putCallback;
     if (callback) {
@@ -193,13 +205,14 @@ static void caLinkDec(caLink *pca)
     if (callback) callback(userPvt);
 }
 
-/* Block until worker thread has processed all previously queued actions.
- * Does not prevent additional actions from being queued.
+/* Block until the worker threads have processed all previously queued
+ * actions.  Does not prevent additional actions from being queued.
  */
 void dbCaSync(void)
 {
     epicsEventId wake;
     caLink templink;
+    int i;
 
     /* we only partially initialize templink.
      * It has no link field and no subscription
@@ -213,15 +226,20 @@ void dbCaSync(void)
 
     templink.userPvt = wake;
 
-    addAction(&templink, CA_SYNC);
+    for (i = 0; i < nWorkers; i++) {
+        caWorker *pw = &workers[i];
 
-    epicsEventMustWait(wake);
-    /* Worker holds workListLock when calling epicsEventMustTrigger()
-     * we cycle through workListLock to ensure worker call to
-     * epicsEventMustTrigger() returns before we destroy the event.
-     */
-    epicsMutexMustLock(workListLock);
-    epicsMutexUnlock(workListLock);
+        templink.worker = pw;
+        addAction(&templink, CA_SYNC);
+
+        epicsEventMustWait(wake);
+        /* Worker holds workListLock when calling epicsEventMustTrigger()
+         * we cycle through workListLock to ensure worker call to
+         * epicsEventMustTrigger() returns before we reuse the event.
+         */
+        epicsMutexMustLock(pw->workListLock);
+        epicsMutexUnlock(pw->workListLock);
+    }
 
     assert(templink.refcount==1);
 
@@ -252,20 +270,97 @@ void dbCaCallbackProcess(void *userPvt)
     dbLinkAsyncComplete(plink);
 }
 
+static void signalWorkers(void)
+{
+    int i;
+
+    for (i = 0; i < nWorkers; i++)
+        epicsEventSignal(workers[i].workListEvent);
+}
+
 void dbCaShutdown(void)
 {
     enum dbCaCtl_t cur = dbCaCtl;
+    int i;
+
     assert(cur == ctlRun || cur == ctlPause);
     dbCaCtl = ctlExit;
-    epicsEventSignal(workListEvent);
-    epicsEventMustWait(startStopEvent);
-    if(dbCaWorker)
-        epicsThreadMustJoin(dbCaWorker);
+    signalWorkers();
+    for (i = 0; i < nWorkers; i++) {
+        caWorker *pw = &workers[i];
+
+        epicsEventMustWait(pw->startStopEvent);
+        if (pw->thread)
+            epicsThreadMustJoin(pw->thread);
+        pw->thread = NULL;
+    }
+    /* Links may still refer to the workers, they are freed by the next
+     * dbCaLinkInit() if that is safe, see freeWorkers() */
+    dbCaClientContext = NULL;
+}
+
+/* Free the workers of a previous IOC run.  A worker whose channels were
+ * not all cleared kept its CA context, so late callbacks can still reach
+ * its links and the worker array is then left until process exit.
+ */
+static void freeWorkers(void)
+{
+    int i;
+
+    if (!workers)
+        return;
+    for (i = 0; i < nWorkers; i++) {
+        if (epicsAtomicGetIntT(&workers[i].chanCount))
+            break;
+    }
+    if (i == nWorkers) {
+        for (i = 0; i < nWorkers; i++) {
+            caWorker *pw = &workers[i];
+
+            epicsMutexDestroy(pw->workListLock);
+            epicsEventDestroy(pw->workListEvent);
+            epicsEventDestroy(pw->startStopEvent);
+        }
+        free(workers);
+    }
+    workers = NULL;
+    nWorkers = 0;
+}
+
+int dbCaSetThreads(int count)
+{
+    if (dbCaCtl == ctlRun || dbCaCtl == ctlPause) {
+        fprintf(stderr, "dbCaSetThreads: dbCa already initialized\n");
+        return -1;
+    }
+    if (count <= 0)
+        count = epicsThreadGetCPUs() + count;
+    if (count < 1) count = 1;
+    nWorkersConfig = count;
+    return 0;
+}
+
+int dbCaWorkerStatus(int worker, dbCaWorkerStats *pstats)
+{
+    caWorker *pw;
+
+    if (worker < 0 || worker >= nWorkers)
+        return -1;
+    pw = &workers[worker];
+    epicsMutexMustLock(pw->workListLock);
+    pstats->backlog = ellCount(&pw->workList);
+    pstats->removes = pw->removesOutstanding;
+    pstats->actions = pw->nActions;
+    epicsMutexUnlock(pw->workListLock);
+    pstats->channels = epicsAtomicGetIntT(&pw->chanCount);
+    pstats->context = pw->context;
+    return 0;
 }
 
 static void dbCaLinkInitImpl(int isolate)
 {
     epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    int i;
 
     opts.stackSize = epicsThreadGetStackSize(epicsThreadStackBig);
     opts.priority = epicsThreadPriorityMedium;
@@ -274,18 +369,28 @@ static void dbCaLinkInitImpl(int isolate)
     dbServiceIsolate = isolate;
     dbServiceIOInit();
 
-    if (!workListLock)
-        workListLock = epicsMutexMustCreate();
-    if (!workListEvent)
-        workListEvent = epicsEventMustCreate(epicsEventEmpty);
-
-    if(!startStopEvent)
-        startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+    freeWorkers();
     dbCaCtl = ctlPause;
 
-    dbCaWorker = epicsThreadCreateOpt("dbCaLink", dbCaTask, NULL, &opts);
-    /* wait for worker to startup and initialize dbCaClientContext */
-    epicsEventMustWait(startStopEvent);
+    nWorkers = nWorkersConfig;
+    workers = dbCalloc(nWorkers, sizeof(caWorker));
+    for (i = 0; i < nWorkers; i++) {
+        caWorker *pw = &workers[i];
+        char name[24];
+
+        ellInit(&pw->workList);
+        pw->workListLock = epicsMutexMustCreate();
+        pw->workListEvent = epicsEventMustCreate(epicsEventEmpty);
+        pw->startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+        if (nWorkers > 1)
+            sprintf(name, "dbCaLink-%d", i);
+        else
+            strcpy(name, "dbCaLink");
+        pw->thread = epicsThreadCreateOpt(name, dbCaTask, pw, &opts);
+        /* wait for worker to startup and initialize its context */
+        epicsEventMustWait(pw->startStopEvent);
+    }
+    dbCaClientContext = workers[0].context;
 }
 
 void dbCaLinkInitIsolated(void)
@@ -302,7 +407,7 @@ void dbCaRun(void)
 {
     if (dbCaCtl == ctlPause) {
         dbCaCtl = ctlRun;
-        epicsEventSignal(workListEvent);
+        signalWorkers();
     }
 }
 
@@ -310,7 +415,7 @@ void dbCaPause(void)
 {
     if (dbCaCtl == ctlRun) {
         dbCaCtl = ctlPause;
-        epicsEventSignal(workListEvent);
+        signalWorkers();
     }
 }
 
@@ -326,6 +431,8 @@ void dbCaAddLinkCallback(struct link *plink,
     pca->lock = epicsMutexMustCreate();
     pca->plink = plink;
     pca->pvname = epicsStrDup(plink->value.pv_link.pvname);
+    pca->worker = &workers[nWorkers > 1 ?
+        epicsStrHash(pca->pvname, 0) % nWorkers : 0];
     pca->connect = connect;
     pca->monitor = monitor;
     pca->userPvt = userPvt;
@@ -1046,36 +1153,39 @@ static void getAttribEventCallback(struct event_handler_args arg)
 
 static void dbCaTask(void *arg)
 {
+    caWorker *pw = (caWorker *)arg;
+
     taskwdInsert(0, NULL, NULL);
     SEVCHK(ca_context_create(ca_enable_preemptive_callback),
         "dbCaTask calling ca_context_create");
-    dbCaClientContext = ca_current_context ();
+    pw->context = ca_current_context ();
     SEVCHK(ca_add_exception_event(exceptionCallback,NULL),
         "ca_add_exception_event");
-    epicsEventSignal(startStopEvent);
+    epicsEventSignal(pw->startStopEvent);
 
     /* channel access event loop */
     while (TRUE){
         do {
-            epicsEventMustWait(workListEvent);
+            epicsEventMustWait(pw->workListEvent);
         } while (dbCaCtl == ctlPause);
         while (TRUE) { /* process all requests in workList*/
             caLink *pca;
             short  link_action;
             int    status;
 
-            epicsMutexMustLock(workListLock);
-            if (!(pca = (caLink *)ellGet(&workList))){  /* Take off list head */
-                epicsMutexUnlock(workListLock);
+            epicsMutexMustLock(pw->workListLock);
+            if (!(pca = (caLink *)ellGet(&pw->workList))){  /* Take off list head */
+                epicsMutexUnlock(pw->workListLock);
                 if (dbCaCtl == ctlExit) goto shutdown;
                 break; /* workList is empty */
             }
+            pw->nActions++;
             link_action = pca->link_action;
             if (link_action&CA_SYNC)
                 epicsEventMustTrigger((epicsEventId)pca->userPvt); /* dbCaSync() requires workListLock to be held here */
             pca->link_action = 0;
-            if (link_action & CA_CLEAR_CHANNEL) --removesOutstanding;
-            epicsMutexUnlock(workListLock);         /* Give back immediately */
+            if (link_action & CA_CLEAR_CHANNEL) --pw->removesOutstanding;
+            epicsMutexUnlock(pw->workListLock);         /* Give back immediately */
             if (link_action&CA_SYNC)
                 continue;
             if (link_action & CA_CLEAR_CHANNEL) {   /* This must be first */
@@ -1093,7 +1203,7 @@ static void dbCaTask(void *arg)
                     printLinks(pca);
                     continue;
                 }
-                dbca_chan_count++;
+                epicsAtomicIncrIntT(&pw->chanCount);
                 status = ca_replace_access_rights_event(pca->chid,
                     accessRightsCallback);
                 if (status != ECA_NORMAL) {
@@ -1197,9 +1307,9 @@ static void dbCaTask(void *arg)
     }
 shutdown:
     taskwdRemove(0);
-    if (dbca_chan_count == 0)
+    if (pw->chanCount == 0)
         ca_context_destroy();
     else
-        fprintf(stderr, "dbCa: chan_count = %d at shutdown\n", dbca_chan_count);
-    epicsEventSignal(startStopEvent);
+        fprintf(stderr, "dbCa: chan_count = %d at shutdown\n", pw->chanCount);
+    epicsEventSignal(pw->startStopEvent);
 }
@@ -25,6 +25,8 @@ epicsShareFunc void dbCaLinkInitIsolated(void); /* internal initialization for i
 epicsShareFunc void dbCaRun(void);
 epicsShareFunc void dbCaPause(void);
 epicsShareFunc void dbCaShutdown(void);
+/* number of dbCa worker threads, before iocInit */
+epicsShareFunc int dbCaSetThreads(int count);
 
 struct dbLocker;
 epicsShareFunc void dbCaAddLinkCallback(struct link *plink,
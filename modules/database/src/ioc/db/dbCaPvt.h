@@ -34,10 +34,13 @@
 #define CA_PUT          0x1
 #define CA_PUT_CALLBACK 0x2
 
+struct caWorker;
+
 typedef struct caLink
 {
     ELLNODE		node;
     int         refcount;
+    struct caWorker *worker;    /* thread handling this link's actions */
     epicsMutexId	lock;
     struct link	*plink;
     char		*pvname;
@@ -95,4 +98,16 @@ typedef struct caLink
     unsigned long   nUpdate;
 }caLink;
 
+/* State of one dbCa worker thread, for dbcar */
+typedef struct dbCaWorkerStats {
+    int backlog;                /* links with actions queued */
+    int removes;                /* channels waiting to be cleared */
+    int channels;               /* channels created */
+    unsigned long actions;      /* links taken off the queue */
+    struct ca_client_context *context;
+} dbCaWorkerStats;
+
+/* Fills in *pstats, returns -1 if there is no such worker */
+epicsShareFunc int dbCaWorkerStatus(int worker, dbCaWorkerStats *pstats);
+
 #endif /* INC_dbCaPvt_H */
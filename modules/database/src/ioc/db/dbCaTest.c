@@ -155,9 +155,31 @@ done:
     printf("  (%lu disconnects, %lu writes prohibited)\n\n",
            nDisconnect, nNoWrite);
     dbFinishEntry(pdbentry);
-    
-    if ( level > 2  && dbCaClientContext != 0 ) {
-        ca_context_status ( dbCaClientContext, level - 2 );
+
+    {
+        dbCaWorkerStats stats;
+        int nWorkers = 0;
+
+        while (dbCaWorkerStatus(nWorkers, &stats) == 0)
+            nWorkers++;
+        if (nWorkers > 1 || level > 0) {
+            printf("%-12s %8s %8s %8s %12s\n", "Worker", "Channels",
+                "Backlog", "Removes", "Actions");
+            for (j = 0; j < nWorkers; j++) {
+                dbCaWorkerStatus(j, &stats);
+                printf("dbCaLink-%-3d %8d %8d %8d %12lu\n", j,
+                    stats.channels, stats.backlog, stats.removes,
+                    stats.actions);
+            }
+            printf("\n");
+        }
+        if (level > 2) {
+            for (j = 0; j < nWorkers; j++) {
+                dbCaWorkerStatus(j, &stats);
+                if (stats.context)
+                    ca_context_status(stats.context, level - 2);
+            }
+        }
     }
 
     return(0);
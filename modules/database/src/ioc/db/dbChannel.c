@@ -19,6 +19,7 @@
 
 #include "cantProceed.h"
 #include "epicsAssert.h"
+#include "epicsAtomic.h"
 #include "epicsString.h"
 #include "epicsStdio.h"
 #include "errlog.h"
@@ -768,6 +769,88 @@ void dbChannelMakeArrayCopy(void *pvt, db_field_log *pfl, dbChannel *chan)
     pfl->u.r.field = p;
 }
 
+/* Immutable copy of an array field, shared by reference counting between
+ * the field logs of all subscriptions that were posted together.
+ */
+struct dbChannelSnapshot {
+    int refcount;
+    /* source of the copy, to decide whether another channel can share it */
+    void *pfield;
+    short field_type;
+    short field_size;
+    long capacity;
+    long no_elements;
+    union {
+        epicsFloat64 align;
+        char bytes[1];
+    } data;
+};
+
+static dbChannelSnapshot* makeSnapshot(dbChannel *chan)
+{
+    dbChannelSnapshot *psnap;
+    void *pfieldsave = chan->addr.pfield;
+    size_t size = offsetof(dbChannelSnapshot, data) +
+        (size_t) chan->addr.no_elements * chan->addr.field_size;
+
+    psnap = malloc(size);
+    if (!psnap) return NULL;
+
+    psnap->refcount = 1;
+    psnap->pfield = chan->addr.pfield;
+    psnap->field_type = chan->addr.field_type;
+    psnap->field_size = chan->addr.field_size;
+    psnap->capacity = chan->addr.no_elements;
+    psnap->no_elements = chan->addr.no_elements;
+    if (dbGet(&chan->addr, mapDBFToDBR[psnap->field_type], psnap->data.bytes,
+            NULL, &psnap->no_elements, NULL))
+        psnap->no_elements = 0;
+    /* get_array_info() may have moved it */
+    chan->addr.pfield = pfieldsave;
+    return psnap;
+}
+
+void dbChannelReleaseSnapshot(dbChannelSnapshot *psnap)
+{
+    if (psnap && epicsAtomicDecrIntT(&psnap->refcount) == 0)
+        free(psnap);
+}
+
+static void releaseShared(db_field_log *pfl) {
+    dbChannelReleaseSnapshot((dbChannelSnapshot *) pfl->u.r.pvt);
+}
+
+void dbChannelShareArrayCopy(dbChannelSnapshot **ppsnap, db_field_log *pfl,
+    dbChannel *chan)
+{
+    dbChannelSnapshot *psnap = *ppsnap;
+    struct dbCommon *prec = dbChannelRecord(chan);
+
+    if (pfl->type != dbfl_type_rec) return;
+
+    if (!psnap ||
+        psnap->pfield != chan->addr.pfield ||
+        psnap->field_type != chan->addr.field_type ||
+        psnap->field_size != chan->addr.field_size ||
+        psnap->capacity != chan->addr.no_elements) {
+        dbChannelReleaseSnapshot(psnap);
+        *ppsnap = psnap = makeSnapshot(chan);
+        if (!psnap) return;
+    }
+    epicsAtomicIncrIntT(&psnap->refcount);
+
+    pfl->type = dbfl_type_ref;
+    pfl->stat = prec->stat;
+    pfl->sevr = prec->sevr;
+    pfl->time = prec->time;
+    pfl->field_type  = psnap->field_type;
+    pfl->no_elements = psnap->no_elements;
+    pfl->field_size  = psnap->field_size;
+    pfl->u.r.dtor = releaseShared;
+    pfl->u.r.pvt = psnap;
+    pfl->u.r.field = psnap->data.bytes;
+}
+
 /* FIXME: Do these belong in a different file? */
 
 void dbRegisterFilter(const char *name, const chFilterIf *fif, void *puser)
@@ -226,6 +226,19 @@ epicsShareFunc db_field_log* dbChannelRunPostChain(dbChannel *chan, db_field_log
 epicsShareFunc const chFilterPlugin * dbFindFilter(const char *key, size_t len);
 epicsShareFunc void dbChannelMakeArrayCopy(void *pvt, db_field_log *pfl, dbChannel *chan);
 
+/* Reference counted array snapshots.
+ * dbChannelShareArrayCopy() turns a dbfl_type_rec field log into a
+ * dbfl_type_ref log that refers to an immutable copy of the channel's array.
+ * The caller keeps *ppsnap (initially NULL) while the record stays locked,
+ * so later channels to the same field share the copy instead of making
+ * their own, and finally drops its own reference to that copy with
+ * dbChannelReleaseSnapshot().
+ */
+typedef struct dbChannelSnapshot dbChannelSnapshot;
+epicsShareFunc void dbChannelShareArrayCopy(dbChannelSnapshot **ppsnap,
+        db_field_log *pfl, dbChannel *chan);
+epicsShareFunc void dbChannelReleaseSnapshot(dbChannelSnapshot *psnap);
+
 #ifdef __cplusplus
 }
 #endif
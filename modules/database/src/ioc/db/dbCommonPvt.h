@@ -6,6 +6,7 @@
 #include "dbCommon.h"
 
 struct epicsThreadOSD;
+struct dbProcStats;
 
 /** Base internal additional information for every record
  */
@@ -15,6 +16,17 @@ typedef struct dbCommonPvt {
     /* Thread which is currently processing this record */
     struct epicsThreadOSD* procThread;
 
+    /* Number of scanOnce queue entries for this record, only counted
+     * when the queue coalesces requests.  Accessed with epicsAtomic. */
+    int oncePending;
+
+    /* scanOnce worker index + 1 which queues this record, chosen by its
+     * lock set when first queued.  Accessed with epicsAtomic. */
+    int onceWorker;
+
+    /* Processing time statistics, allocated when first enabled */
+    struct dbProcStats *pstats;
+
     struct dbCommon common;
 } dbCommonPvt;
 
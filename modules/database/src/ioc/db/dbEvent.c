@@ -46,19 +46,32 @@
 #include "db_field_log.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
+#include "epicsExport.h"
 #include "link.h"
 #include "special.h"
 
-/* Queue size based on Ethernet MTU of 1500 bytes.
- * Assume <=66 bytes of ethernet+IP+TCP overhead
- * and 40 byte CA messages (DBF_TIME_DOUBLE).
- *
- * (1500-66)/40 -> 35
+/*
+ * Each subscription is assigned EVENTENTRIES entries in its event queue.
+ * The ring buffer of a queue grows with the number of subscriptions
+ * assigned to it, up to dbEventQueueMax entries, after which another queue
+ * is added.  It shrinks again as subscriptions are canceled, but never
+ * below dbEventQueueMin entries.
  */
-#define EVENTSPERQUE    36
 #define EVENTENTRIES    4      /* the number of que entries for each event */
-#define EVENTQUESIZE    (EVENTENTRIES  * EVENTSPERQUE)
+#define EVENTQUEMIN     (2 * EVENTENTRIES)
+#define EVENTQUELIMIT   (1u << 20)
 #define EVENTQEMPTY     ((struct evSubscrip *)NULL)
+#define CACHE_LINE      64
+
+epicsShareDef int dbEventQueueMin = 32;
+epicsExportAddress(int, dbEventQueueMin);
+epicsShareDef int dbEventQueueMax = 65536;
+epicsExportAddress(int, dbEventQueueMax);
+
+struct event_slot {
+    struct evSubscrip       *ev;
+    db_field_log            *val;
+};
 
 /*
  * really a ring buffer
@@ -67,15 +80,18 @@ struct event_que {
     /* lock writers to the ring buffer only */
     /* readers must never slow up writers */
     epicsMutexId            writelock;
-    db_field_log            *valque[EVENTQUESIZE];
-    struct evSubscrip       *evque[EVENTQUESIZE];
+    struct event_slot       *ring;          /* cache line aligned */
+    void                    *ringAlloc;     /* ring as allocated */
     struct event_que        *nextque;       /* in case que quota exceeded */
     struct event_user       *evUser;        /* event user parent struct */
-    unsigned short          putix;
-    unsigned short          getix;
-    unsigned short          quota;          /* the number of assigned entries*/
-    unsigned short          nDuplicates;    /* N events duplicated on this q */
-    unsigned short          nCanceled;      /* the number of canceled entries */
+    unsigned                size;           /* entries in the ring */
+    unsigned                putix;
+    unsigned                getix;
+    unsigned                quota;          /* the number of assigned entries*/
+    unsigned                nDuplicates;    /* N events duplicated on this q */
+    unsigned                nCanceled;      /* the number of canceled entries */
+    unsigned                highWaterMark;  /* most entries used at once */
+    unsigned long           nOverflow;      /* events replaced or dropped */
 };
 
 struct event_user {
@@ -97,6 +113,14 @@ struct event_user {
     unsigned char       extraLaborBusy;
     void                (*init_func)();
     epicsThreadId       init_func_arg;
+
+    EVENTBATCHFUNC      *batch_sub;     /* batch consumer, if any */
+    void                *batch_arg;     /* parameter to above */
+    unsigned            batchMax;       /* most events per batch */
+    dbEventBatchEntry   *batchEntries;  /* handed to batch_sub */
+    struct evSubscrip   **batchEvents;  /* taken from the queue */
+    unsigned            batchCount;     /* entries of above in use */
+    db_field_log        **batchLogs;    /* to delete after the batch */
 };
 
 /*
@@ -105,8 +129,8 @@ struct event_user {
  * into only 10 or 20 total steps part of the time.
  */
 
-#define RNGINC(OLD)\
-( (unsigned short) ( (OLD) >= (EVENTQUESIZE-1) ? 0 : (OLD)+1 ) )
+#define RNGINC(EV_QUE, OLD)\
+( (OLD) >= ((EV_QUE)->size-1) ? 0u : (OLD)+1 )
 
 #define LOCKEVQUE(EV_QUE)   epicsMutexMustLock((EV_QUE)->writelock)
 #define UNLOCKEVQUE(EV_QUE) epicsMutexUnlock((EV_QUE)->writelock)
@@ -118,23 +142,141 @@ static void *dbevEventQueueFreeList;
 static void *dbevEventSubscriptionFreeList;
 static void *dbevFieldLogFreeList;
 
+/*
+ * Array fields of at least this many bytes are copied once per
+ * db_post_events() call into a snapshot which all subscribers share,
+ * instead of being read from the record when each event is delivered.
+ * Set to 0 to disable.
+ */
+epicsShareDef int dbEventArraySnapshotBytes = 16384;
+epicsExportAddress(int, dbEventArraySnapshotBytes);
+
 static char *EVENT_PEND_NAME = "eventTask";
 
 static struct evSubscrip canceledEvent;
 
-static unsigned short ringSpace ( const struct event_que *pevq )
+static unsigned ringSpace ( const struct event_que *pevq )
 {
-    if ( pevq->evque[pevq->putix] == EVENTQEMPTY ) {
+    if ( pevq->ring[pevq->putix].ev == EVENTQEMPTY ) {
         if ( pevq->getix > pevq->putix ) {
-            return ( unsigned short ) ( pevq->getix - pevq->putix );
+            return pevq->getix - pevq->putix;
         }
         else {
-            return ( unsigned short ) ( ( EVENTQUESIZE + pevq->getix ) - pevq->putix );
+            return ( pevq->size + pevq->getix ) - pevq->putix;
         }
     }
     return 0;
 }
 
+static unsigned queueMinSize ( void )
+{
+    unsigned min = dbEventQueueMin < EVENTQUEMIN ?
+        EVENTQUEMIN : ( unsigned ) dbEventQueueMin;
+
+    return min > EVENTQUELIMIT ? EVENTQUELIMIT : min;
+}
+
+static unsigned queueMaxSize ( void )
+{
+    unsigned min = queueMinSize ();
+    unsigned max = dbEventQueueMax < ( int ) min ?
+        min : ( unsigned ) dbEventQueueMax;
+
+    return max > EVENTQUELIMIT ? EVENTQUELIMIT : max;
+}
+
+/*
+ * resize_ev_que()
+ *
+ * Move the queued entries to a new ring of newSize entries, which must be
+ * able to hold them all.  Event queue lock must be applied (except for a
+ * new queue).
+ */
+static int resize_ev_que ( struct event_que *ev_que, unsigned newSize )
+{
+    unsigned used = ev_que->ring ? ev_que->size - ringSpace ( ev_que ) : 0u;
+    void *alloc;
+    struct event_slot *ring;
+    unsigned i, ix;
+
+    assert ( newSize >= used && newSize > 0u );
+    alloc = calloc ( 1, newSize * sizeof ( struct event_slot ) + CACHE_LINE - 1 );
+    if ( ! alloc ) {
+        return DB_EVENT_ERROR;
+    }
+    ring = ( struct event_slot * )
+        ( ( ( size_t ) alloc + CACHE_LINE - 1 ) & ~( size_t ) ( CACHE_LINE - 1 ) );
+
+    for ( i = 0u, ix = ev_que->getix; i < used; i++ ) {
+        struct evSubscrip * const pevent = ev_que->ring[ix].ev;
+
+        ring[i] = ev_que->ring[ix];
+        if ( pevent->pLastLog == &ev_que->ring[ix].val ) {
+            pevent->pLastLog = &ring[i].val;
+        }
+        ix = RNGINC ( ev_que, ix );
+    }
+
+    free ( ev_que->ringAlloc );
+    ev_que->ringAlloc = alloc;
+    ev_que->ring = ring;
+    ev_que->size = newSize;
+    ev_que->getix = 0u;
+    ev_que->putix = used < newSize ? used : 0u;
+    return DB_EVENT_OK;
+}
+
+/*
+ * reserve_ev_que()
+ *
+ * Assign the entries for one more subscription to this queue, growing it
+ * if necessary.  Event queue lock must be applied.
+ */
+static int reserve_ev_que ( struct event_que *ev_que )
+{
+    unsigned need = ev_que->quota + ev_que->nCanceled + EVENTENTRIES + 1u;
+
+    if ( need > ev_que->size ) {
+        unsigned max = queueMaxSize ();
+        unsigned newSize = ev_que->size;
+
+        while ( newSize < need && newSize < max ) {
+            newSize *= 2u;
+        }
+        if ( newSize > max ) {
+            newSize = max;
+        }
+        if ( newSize < need ||
+                resize_ev_que ( ev_que, newSize ) != DB_EVENT_OK ) {
+            return FALSE;
+        }
+    }
+    ev_que->quota += EVENTENTRIES;
+    return TRUE;
+}
+
+/*
+ * release_ev_que()
+ *
+ * Return the entries of a canceled subscription, shrinking the queue when
+ * most of it is unused.  Event queue lock must be applied.
+ */
+static void release_ev_que ( struct event_que *ev_que )
+{
+    unsigned need, used, min = queueMinSize ();
+
+    ev_que->quota -= EVENTENTRIES;
+    need = ev_que->quota + ev_que->nCanceled + EVENTENTRIES + 1u;
+    used = ev_que->size - ringSpace ( ev_que );
+    if ( ev_que->size > min &&
+            need <= ev_que->size / 4u && used <= ev_que->size / 4u ) {
+        unsigned newSize = ev_que->size / 2u;
+
+        /* failure leaves the queue as it was */
+        resize_ev_que ( ev_que, newSize < min ? min : newSize );
+    }
+}
+
 /*
  *  db_event_list ()
  */
@@ -191,17 +333,21 @@ int dbel ( const char *pname, unsigned level )
             }
 
             if ( level > 1 ) {
-                unsigned nEntriesFree;
+                unsigned nEntriesFree, size, highWaterMark;
+                unsigned long nOverflow;
                 const void * taskId;
                 LOCKEVQUE(pevent->ev_que);
                 nEntriesFree = ringSpace ( pevent->ev_que );
+                size = pevent->ev_que->size;
+                highWaterMark = pevent->ev_que->highWaterMark;
+                nOverflow = pevent->ev_que->nOverflow;
                 taskId = ( void * ) pevent->ev_que->evUser->taskid;
                 UNLOCKEVQUE(pevent->ev_que);
                 if ( nEntriesFree == 0u ) {
                     printf ( ", thread=%p, queue full",
                         (void *) taskId );
                 }
-                else if ( nEntriesFree == EVENTQUESIZE ) {
+                else if ( nEntriesFree == size ) {
                     printf ( ", thread=%p, queue empty",
                         (void *) taskId );
                 }
@@ -209,6 +355,8 @@ int dbel ( const char *pname, unsigned level )
                     printf ( ", thread=%p, unused entries=%u",
                         (void *) taskId, nEntriesFree );
                 }
+                printf ( ", queue size=%u, high water mark=%u, overflows=%lu",
+                    size, highWaterMark, nOverflow );
             }
 
             if ( level > 2 ) {
@@ -250,6 +398,39 @@ int dbel ( const char *pname, unsigned level )
     return DB_EVENT_OK;
 }
 
+/*
+ * db_event_queue_stats()
+ */
+int db_event_queue_stats ( dbEventCtx ctx, dbEventQueueStats *pstats,
+    int reset )
+{
+    struct event_user * const evUser = (struct event_user *) ctx;
+    struct event_que *ev_que;
+
+    if ( ! evUser || ! pstats ) return DB_EVENT_ERROR;
+
+    memset ( pstats, 0, sizeof ( *pstats ) );
+    epicsMutexMustLock ( evUser->lock );
+    for ( ev_que = &evUser->firstque; ev_que; ev_que = ev_que->nextque ) {
+        unsigned used;
+
+        LOCKEVQUE ( ev_que );
+        used = ev_que->size - ringSpace ( ev_que );
+        pstats->nQueues++;
+        pstats->size += ev_que->size;
+        pstats->used += used;
+        pstats->highWaterMark += ev_que->highWaterMark;
+        pstats->nOverflow += ev_que->nOverflow;
+        if ( reset ) {
+            ev_que->highWaterMark = used;
+            ev_que->nOverflow = 0ul;
+        }
+        UNLOCKEVQUE ( ev_que );
+    }
+    epicsMutexUnlock ( evUser->lock );
+    return DB_EVENT_OK;
+}
+
 /*
  * DB_INIT_EVENTS()
  *
@@ -287,6 +468,8 @@ dbEventCtx db_init_events (void)
     }
 
     evUser->firstque.evUser = evUser;
+    if (resize_ev_que(&evUser->firstque, queueMinSize()) != DB_EVENT_OK)
+        goto fail;
     evUser->firstque.writelock = epicsMutexCreate();
     if (!evUser->firstque.writelock)
         goto fail;
@@ -314,6 +497,7 @@ fail:
         epicsEventDestroy (evUser->ppendsem);
     if(evUser->pflush_sem)
         epicsEventDestroy (evUser->pflush_sem);
+    free(evUser->firstque.ringAlloc);
     freeListFree(dbevEventUserFreeList,evUser);
     return NULL;
 }
@@ -376,8 +560,13 @@ static struct event_que * create_ev_que ( struct event_user * const evUser )
     if ( ! ev_que ) {
         return NULL;
     }
+    if ( resize_ev_que ( ev_que, queueMinSize () ) != DB_EVENT_OK ) {
+        freeListFree ( dbevEventQueueFreeList, ev_que );
+        return NULL;
+    }
     ev_que->writelock = epicsMutexCreate();
     if ( ! ev_que->writelock ) {
+        free ( ev_que->ringAlloc );
         freeListFree ( dbevEventQueueFreeList, ev_que );
         return NULL;
     }
@@ -415,11 +604,7 @@ dbEventSubscription db_add_event (
     while ( TRUE ) {
         int success = 0;
         LOCKEVQUE ( ev_que );
-        success = ( ev_que->quota + ev_que->nCanceled < 
-                                EVENTQUESIZE - EVENTENTRIES );
-        if ( success ) {
-            ev_que->quota += EVENTENTRIES;
-        }
+        success = reserve_ev_que ( ev_que );
         UNLOCKEVQUE ( ev_que );
         if ( success ) {
             break;
@@ -506,12 +691,12 @@ void db_event_disable (dbEventSubscription event)
  * this nulls the entry in the queue, but doesn't delete the db_field_log chunk
  */
 static void event_remove ( struct event_que *ev_que,
-    unsigned short index, struct evSubscrip *placeHolder )
+    unsigned index, struct evSubscrip *placeHolder )
 {
-    struct evSubscrip * const pevent = ev_que->evque[index];
+    struct evSubscrip * const pevent = ev_que->ring[index].ev;
 
-    ev_que->evque[index] = placeHolder;
-    ev_que->valque[index] = NULL;
+    ev_que->ring[index].ev = placeHolder;
+    ev_que->ring[index].val = NULL;
     if ( pevent->npend == 1u ) {
         pevent->pLastLog = NULL;
     }
@@ -533,7 +718,7 @@ static void event_remove ( struct event_que *ev_que,
 void db_cancel_event (dbEventSubscription event)
 {
     struct evSubscrip * const pevent = (struct evSubscrip *) event;
-    unsigned short getix;
+    unsigned getix;
 
     db_event_disable ( event );
 
@@ -558,13 +743,13 @@ void db_cancel_event (dbEventSubscription event)
      * would be possible.
      */
     for (   getix = pevent->ev_que->getix;
-            pevent->ev_que->evque[getix] != EVENTQEMPTY; ) {
-        if ( pevent->ev_que->evque[getix] == pevent ) {
-            assert ( pevent->ev_que->nCanceled < USHRT_MAX );
+            pevent->ev_que->ring[getix].ev != EVENTQEMPTY; ) {
+        if ( pevent->ev_que->ring[getix].ev == pevent ) {
+            assert ( pevent->ev_que->nCanceled < UINT_MAX );
             pevent->ev_que->nCanceled++;
             event_remove ( pevent->ev_que, getix, &canceledEvent );
         }
-        getix = RNGINC ( getix );
+        getix = RNGINC ( pevent->ev_que, getix );
         if ( getix == pevent->ev_que->getix ) {
             break;
         }
@@ -572,7 +757,16 @@ void db_cancel_event (dbEventSubscription event)
     assert ( pevent->npend == 0u );
 
     if ( pevent->ev_que->evUser->taskid == epicsThreadGetIdSelf() ) {
-        pevent->ev_que->evUser->pSuicideEvent = pevent;
+        struct event_user * const evUser = pevent->ev_que->evUser;
+        unsigned i;
+
+        /* canceled from within a batch, forget it there */
+        for ( i = 0u; i < evUser->batchCount; i++ ) {
+            if ( evUser->batchEvents[i] == pevent ) {
+                evUser->batchEvents[i] = NULL;
+            }
+        }
+        evUser->pSuicideEvent = pevent;
     }
     else {
         while ( pevent->callBackInProgress ) {
@@ -582,7 +776,7 @@ void db_cancel_event (dbEventSubscription event)
         }
     }
 
-    pevent->ev_que->quota -= EVENTENTRIES;
+    release_ev_que ( pevent->ev_que );
 
     UNLOCKEVQUE (pevent->ev_que);
 
@@ -629,6 +823,57 @@ int db_add_extra_labor_event (
     return DB_EVENT_OK;
 }
 
+/*
+ * DB_SET_EVENT_BATCH()
+ *
+ * Deliver events to a single batch function instead of calling each
+ * subscription's user_sub.  Must be called before db_start_events().
+ */
+int db_set_event_batch ( dbEventCtx ctx, EVENTBATCHFUNC *func, void *arg,
+    unsigned maxBatch )
+{
+    struct event_user * const evUser = (struct event_user *) ctx;
+    dbEventBatchEntry *entries = NULL;
+    struct evSubscrip **events = NULL;
+    db_field_log **logs = NULL;
+
+    if ( func ) {
+        if ( maxBatch == 0u ) {
+            return DB_EVENT_ERROR;
+        }
+        entries = calloc ( maxBatch, sizeof ( *entries ) );
+        events = calloc ( maxBatch, sizeof ( *events ) );
+        logs = calloc ( maxBatch, sizeof ( *logs ) );
+        if ( ! entries || ! events || ! logs ) {
+            free ( entries );
+            free ( events );
+            free ( logs );
+            return DB_EVENT_ERROR;
+        }
+    }
+
+    epicsMutexMustLock ( evUser->lock );
+    if ( evUser->taskid ) {
+        epicsMutexUnlock ( evUser->lock );
+        free ( entries );
+        free ( events );
+        free ( logs );
+        return DB_EVENT_ERROR;
+    }
+    free ( evUser->batchEntries );
+    free ( evUser->batchEvents );
+    free ( evUser->batchLogs );
+    evUser->batch_sub = func;
+    evUser->batch_arg = arg;
+    evUser->batchMax = func ? maxBatch : 0u;
+    evUser->batchEntries = entries;
+    evUser->batchEvents = events;
+    evUser->batchLogs = logs;
+    epicsMutexUnlock ( evUser->lock );
+
+    return DB_EVENT_OK;
+}
+
 /*
  *  DB_POST_EXTRA_LABOR()
  */
@@ -713,7 +958,7 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
 {
     struct event_que    *ev_que;
     int firstEventFlag;
-    unsigned rngSpace;
+    unsigned rngSpace, used;
 
     ev_que = pevent->ev_que;
     /*
@@ -748,7 +993,11 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
      */
     rngSpace = ringSpace ( ev_que );
     if ( pevent->npend>0u &&
-        (ev_que->evUser->flowCtrlMode || rngSpace<=EVENTSPERQUE) ) {
+        (ev_que->evUser->flowCtrlMode ||
+            rngSpace <= ev_que->quota / EVENTENTRIES) ) {
+        if ( ! ev_que->evUser->flowCtrlMode ) {
+            ev_que->nOverflow++;
+        }
         /*
          * replace last event if no space is left
          */
@@ -763,15 +1012,23 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
          */
         firstEventFlag = 0;
     }
+    /*
+     * Not expected, since each monitor has entries reserved.
+     */
+    else if ( rngSpace == 0u ) {
+        ev_que->nOverflow++;
+        db_delete_field_log(pLog);
+        firstEventFlag = 0;
+    }
     /*
      * Otherwise, the current entry must be available.
      * Fill it in and advance the ring buffer.
      */
     else {
-        assert ( ev_que->evque[ev_que->putix] == EVENTQEMPTY );
-        ev_que->evque[ev_que->putix] = pevent;
-        ev_que->valque[ev_que->putix] = pLog;
-        pevent->pLastLog = &ev_que->valque[ev_que->putix];
+        assert ( ev_que->ring[ev_que->putix].ev == EVENTQEMPTY );
+        ev_que->ring[ev_que->putix].ev = pevent;
+        ev_que->ring[ev_que->putix].val = pLog;
+        pevent->pLastLog = &ev_que->ring[ev_que->putix].val;
         if (pevent->npend>0u) {
             ev_que->nDuplicates++;
         }
@@ -780,13 +1037,17 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
          * if the ring buffer was empty before
          * adding this event
          */
-        if (rngSpace==EVENTQUESIZE) {
+        if (rngSpace==ev_que->size) {
             firstEventFlag = 1;
         }
         else {
             firstEventFlag = 0;
         }
-        ev_que->putix = RNGINC ( ev_que->putix );
+        used = ev_que->size - rngSpace + 1u;
+        if (used > ev_que->highWaterMark) {
+            ev_que->highWaterMark = used;
+        }
+        ev_que->putix = RNGINC ( ev_que, ev_que->putix );
     }
 
     UNLOCKEVQUE (ev_que);
@@ -805,6 +1066,21 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
     }
 }
 
+/*
+ *  USE_SNAPSHOT()
+ *
+ *  Large arrays are copied once per post and shared (see
+ *  dbEventArraySnapshotBytes)
+ */
+static int useSnapshot (const struct evSubscrip *pevent)
+{
+    const dbAddr *paddr = &pevent->chan->addr;
+
+    return dbEventArraySnapshotBytes > 0 && !pevent->useValque &&
+        paddr->no_elements > 1 &&
+        paddr->no_elements * paddr->field_size >= dbEventArraySnapshotBytes;
+}
+
 /*
  *  DB_POST_EVENTS()
  *
@@ -819,6 +1095,7 @@ unsigned int    caEventMask
 {
     struct dbCommon   * const prec = (struct dbCommon *) pRecord;
     struct evSubscrip *pevent;
+    dbChannelSnapshot *psnap = NULL;
 
     if (prec->mlis.count == 0) return DB_EVENT_OK;       /* no monitors set */
 
@@ -834,12 +1111,15 @@ unsigned int    caEventMask
         if ( (dbChannelField(pevent->chan) == (void *)pField || pField==NULL) &&
             (caEventMask & pevent->select)) {
             db_field_log *pLog = db_create_event_log(pevent);
+            if (pLog && useSnapshot(pevent))
+                dbChannelShareArrayCopy(&psnap, pLog, pevent->chan);
             pLog = dbChannelRunPreChain(pevent->chan, pLog);
             if (pLog) db_queue_event_log(pevent, pLog);
         }
     }
 
     UNLOCKREC (prec);
+    dbChannelReleaseSnapshot(psnap);
     return DB_EVENT_OK;
 
 }
@@ -851,15 +1131,119 @@ void db_post_single_event (dbEventSubscription event)
 {
     struct evSubscrip * const pevent = (struct evSubscrip *) event;
     struct dbCommon * const prec = dbChannelRecord(pevent->chan);
+    dbChannelSnapshot *psnap = NULL;
     db_field_log *pLog;
 
     dbScanLock (prec);
 
     pLog = db_create_event_log(pevent);
+    if (pLog && useSnapshot(pevent))
+        dbChannelShareArrayCopy(&psnap, pLog, pevent->chan);
     pLog = dbChannelRunPreChain(pevent->chan, pLog);
     if(pLog) db_queue_event_log(pevent, pLog);
 
     dbScanUnlock (prec);
+    dbChannelReleaseSnapshot(psnap);
+}
+
+/*
+ * EVENT_READ_BATCH()
+ *
+ * Like event_read() below, but takes up to batchMax events off the queue
+ * with one lock round trip and hands them to the batch function together.
+ */
+static int event_read_batch ( struct event_que *ev_que )
+{
+    struct event_user * const evUser = ev_que->evUser;
+    dbEventBatchEntry * const entries = evUser->batchEntries;
+    struct evSubscrip ** const events = evUser->batchEvents;
+    db_field_log ** const logs = evUser->batchLogs;
+
+    LOCKEVQUE (ev_que);
+
+    if ( evUser->flowCtrlMode && ev_que->nDuplicates == 0u ) {
+        UNLOCKEVQUE (ev_que);
+        return DB_EVENT_OK;
+    }
+
+    while ( ev_que->ring[ev_que->getix].ev != EVENTQEMPTY ) {
+        unsigned n = 0u, nDeliver = 0u, i;
+        int eventsRemaining;
+
+        while ( n < evUser->batchMax &&
+                ev_que->ring[ev_que->getix].ev != EVENTQEMPTY ) {
+            struct evSubscrip *pevent = ev_que->ring[ev_que->getix].ev;
+            db_field_log *pfl = ev_que->ring[ev_que->getix].val;
+
+            if ( pevent == &canceledEvent ) {
+                ev_que->ring[ev_que->getix].ev = EVENTQEMPTY;
+                ev_que->ring[ev_que->getix].val = NULL;
+                db_delete_field_log(pfl);
+                ev_que->getix = RNGINC ( ev_que, ev_que->getix );
+                assert ( ev_que->nCanceled > 0 );
+                ev_que->nCanceled--;
+                continue;
+            }
+
+            event_remove ( ev_que, ev_que->getix, EVENTQEMPTY );
+            ev_que->getix = RNGINC ( ev_que, ev_que->getix );
+
+            if ( ! pevent->user_sub ) {
+                db_delete_field_log(pfl);
+                continue;
+            }
+            pevent->callBackInProgress = TRUE;
+            events[n] = pevent;
+            entries[n].sub = pevent;
+            entries[n].user_sub = pevent->user_sub;
+            entries[n].user_arg = pevent->user_arg;
+            entries[n].chan = pevent->chan;
+            entries[n].pfl = pfl;
+            n++;
+        }
+        eventsRemaining = ev_que->ring[ev_que->getix].ev != EVENTQEMPTY;
+        evUser->batchCount = n;
+        UNLOCKEVQUE (ev_que);
+
+        /* Run post-event-queue filter chains, drop what they discard */
+        for ( i = 0u; i < n; i++ ) {
+            db_field_log *pfl = entries[i].pfl;
+
+            if (ellCount(&events[i]->chan->post_chain)) {
+                pfl = dbChannelRunPostChain(events[i]->chan, pfl);
+            }
+            logs[i] = pfl;
+            if (pfl) {
+                entries[nDeliver] = entries[i];
+                entries[nDeliver].pfl = pfl;
+                nDeliver++;
+            }
+        }
+        if ( nDeliver ) {
+            ( *evUser->batch_sub ) ( evUser->batch_arg, entries, nDeliver,
+                eventsRemaining );
+        }
+
+        LOCKEVQUE (ev_que);
+        for ( i = 0u; i < n; i++ ) {
+            struct evSubscrip * const pevent = events[i];
+
+            /* NULL if canceled by the batch function */
+            if ( pevent ) {
+                pevent->callBackInProgress = FALSE;
+                if ( pevent->user_sub==NULL && pevent->npend==0u ) {
+                    epicsEventSignal ( evUser->pflush_sem );
+                }
+            }
+            db_delete_field_log(logs[i]);
+        }
+        evUser->batchCount = 0u;
+        evUser->pSuicideEvent = NULL;
+    }
+
+    UNLOCKEVQUE (ev_que);
+
+    return DB_EVENT_OK;
 }
 
 /*
@@ -887,17 +1271,18 @@ static int event_read ( struct event_que *ev_que )
         return DB_EVENT_OK;
     }
 
-    while ( ev_que->evque[ev_que->getix] != EVENTQEMPTY ) {
-        struct evSubscrip *pevent = ev_que->evque[ev_que->getix];
+    while ( ev_que->ring[ev_que->getix].ev != EVENTQEMPTY ) {
+        struct evSubscrip *pevent = ev_que->ring[ev_que->getix].ev;
+        int eventsRemaining;
 
-        pfl = ev_que->valque[ev_que->getix];
+        pfl = ev_que->ring[ev_que->getix].val;
         if ( pevent == &canceledEvent ) {
-            ev_que->evque[ev_que->getix] = EVENTQEMPTY;
-            if (ev_que->valque[ev_que->getix]) {
-                db_delete_field_log(ev_que->valque[ev_que->getix]);
-                ev_que->valque[ev_que->getix] = NULL;
+            ev_que->ring[ev_que->getix].ev = EVENTQEMPTY;
+            if (ev_que->ring[ev_que->getix].val) {
+                db_delete_field_log(ev_que->ring[ev_que->getix].val);
+                ev_que->ring[ev_que->getix].val = NULL;
             }
-            ev_que->getix = RNGINC ( ev_que->getix );
+            ev_que->getix = RNGINC ( ev_que, ev_que->getix );
             assert ( ev_que->nCanceled > 0 );
             ev_que->nCanceled--;
             continue;
@@ -910,7 +1295,9 @@ static int event_read ( struct event_que *ev_que )
          */
 
         event_remove ( ev_que, ev_que->getix, EVENTQEMPTY );
-        ev_que->getix = RNGINC ( ev_que->getix );
+        ev_que->getix = RNGINC ( ev_que, ev_que->getix );
+        /* the ring may be resized while unlocked */
+        eventsRemaining = ev_que->ring[ev_que->getix].ev != EVENTQEMPTY;
 
         /*
          * create a local copy of the call back parameters while
@@ -943,7 +1330,7 @@ static int event_read ( struct event_que *ev_que )
             if (pfl) {
                 /* Issue user callback */
                 ( *user_sub ) ( pevent->user_arg, pevent->chan,
-                                ev_que->evque[ev_que->getix] != EVENTQEMPTY, pfl );
+                                eventsRemaining, pfl );
             }
             LOCKEVQUE (ev_que);
 
@@ -1021,7 +1408,12 @@ static void event_task (void *pParm)
         for ( ev_que = &evUser->firstque; ev_que;
                 ev_que = ev_que->nextque ) {
             epicsMutexUnlock ( evUser->lock );
-            event_read (ev_que);
+            if ( evUser->batch_sub ) {
+                event_read_batch (ev_que);
+            }
+            else {
+                event_read (ev_que);
+            }
             epicsMutexMustLock ( evUser->lock );
         }
         pendexit = evUser->pendexit;
@@ -1030,6 +1422,7 @@ static void event_task (void *pParm)
     } while( ! pendexit );
 
     epicsMutexDestroy(evUser->firstque.writelock);
+    free(evUser->firstque.ringAlloc);
 
     {
         struct event_que    *nextque;
@@ -1038,6 +1431,7 @@ static void event_task (void *pParm)
         while (ev_que) {
             nextque = ev_que->nextque;
             epicsMutexDestroy(ev_que->writelock);
+            free(ev_que->ringAlloc);
             freeListFree(dbevEventQueueFreeList, ev_que);
             ev_que = nextque;
         }
@@ -1047,6 +1441,9 @@ static void event_task (void *pParm)
     epicsEventDestroy(evUser->pflush_sem);
     epicsMutexDestroy(evUser->lock);
 
+    free(evUser->batchEntries);
+    free(evUser->batchEvents);
+    free(evUser->batchLogs);
     freeListFree(dbevEventUserFreeList, evUser);
 
     taskwdRemove(epicsThreadGetIdSelf());
@@ -40,6 +40,10 @@ struct dbChannel;
 struct db_field_log;
 struct evSubscrip;
 
+epicsShareExtern int dbEventArraySnapshotBytes;
+epicsShareExtern int dbEventQueueMin;
+epicsShareExtern int dbEventQueueMax;
+
 epicsShareFunc int db_event_list (
     const char *name, unsigned level);
 epicsShareFunc int dbel (
@@ -63,6 +67,17 @@ epicsShareFunc void db_flush_extra_labor_event (dbEventCtx);
 epicsShareFunc int db_post_extra_labor (dbEventCtx ctx);
 epicsShareFunc void db_event_change_priority ( dbEventCtx ctx, unsigned epicsPriority );
 
+typedef struct dbEventQueueStats {
+    unsigned nQueues;           /* event queues of this context */
+    unsigned size;              /* entries in all of their ring buffers */
+    unsigned used;              /* entries holding undelivered events */
+    unsigned highWaterMark;     /* sum of each queue's high water mark */
+    unsigned long nOverflow;    /* events replaced or dropped for lack of space */
+} dbEventQueueStats;
+
+epicsShareFunc int db_event_queue_stats ( dbEventCtx ctx,
+    dbEventQueueStats *pstats, int reset );
+
 #ifdef EPICS_PRIVATE_API
 epicsShareFunc void db_cleanup_events(void);
 #endif
@@ -74,6 +89,25 @@ typedef void * dbEventSubscription;
 epicsShareFunc dbEventSubscription db_add_event (
     dbEventCtx ctx, struct dbChannel *chan,
     EVENTFUNC *user_sub, void *user_arg, unsigned select);
+
+/* One event of a batch, see db_set_event_batch() */
+typedef struct dbEventBatchEntry {
+    dbEventSubscription sub;
+    EVENTFUNC *user_sub;        /* as given to db_add_event() */
+    void *user_arg;
+    struct dbChannel *chan;
+    struct db_field_log *pfl;
+} dbEventBatchEntry;
+
+/* eventsRemaining is set if more events are waiting after this batch.
+ * A batch function which cancels a subscription must ignore that
+ * subscription's remaining entries in the batch.
+ */
+typedef void EVENTBATCHFUNC (void *batch_arg, dbEventBatchEntry *entries,
+    unsigned count, int eventsRemaining);
+
+epicsShareFunc int db_set_event_batch (dbEventCtx ctx,
+    EVENTBATCHFUNC *func, void *arg, unsigned maxBatch);
 epicsShareFunc void db_cancel_event (dbEventSubscription es);
 epicsShareFunc void db_post_single_event (dbEventSubscription es);
 epicsShareFunc void db_event_enable (dbEventSubscription es);
@@ -13,12 +13,14 @@
 #include "callback.h"
 #include "dbAccess.h"
 #include "dbBkpt.h"
+#include "dbCa.h"
 #include "dbCaTest.h"
 #include "dbEvent.h"
 #include "dbIocRegister.h"
 #include "dbJLink.h"
 #include "dbLock.h"
 #include "dbNotify.h"
+#include "dbProcStats.h"
 #include "dbScan.h"
 #include "dbServer.h"
 #include "dbState.h"
@@ -110,6 +112,16 @@ static void dbcarCallFunc(const iocshArgBuf *args)
     dbcar(args[0].sval,args[1].ival);
 }
 
+/* dbCaSetThreads */
+static const iocshArg dbCaSetThreadsArg0 = { "no of threads",iocshArgInt};
+static const iocshArg * const dbCaSetThreadsArgs[1] = {&dbCaSetThreadsArg0};
+static const iocshFuncDef dbCaSetThreadsFuncDef =
+    {"dbCaSetThreads",1,dbCaSetThreadsArgs};
+static void dbCaSetThreadsCallFunc(const iocshArgBuf *args)
+{
+    dbCaSetThreads(args[0].ival);
+}
+
 /* dbjlr */
 static const iocshArg dbjlrArg0 = { "record name",iocshArgString};
 static const iocshArg dbjlrArg1 = { "level",iocshArgInt};
@@ -285,6 +297,43 @@ static const iocshFuncDef dbLockShowLockedFuncDef =
 static void dbLockShowLockedCallFunc(const iocshArgBuf *args)
 { dbLockShowLocked(args[0].ival);}
 
+/* dblsp */
+static const iocshArg dblspArg0 = { "count",iocshArgInt};
+static const iocshArg * const dblspArgs[1] = {&dblspArg0};
+static const iocshFuncDef dblspFuncDef = {"dblsp",1,dblspArgs};
+static void dblspCallFunc(const iocshArgBuf *args)
+{ dblsp(args[0].ival);}
+
+/* dblspReset */
+static const iocshFuncDef dblspResetFuncDef = {"dblspReset",0,0};
+static void dblspResetCallFunc(const iocshArgBuf *args)
+{ dblspReset();}
+
+/* dbProcStatsStart */
+static const iocshFuncDef dbProcStatsStartFuncDef = {"dbProcStatsStart",0,0};
+static void dbProcStatsStartCallFunc(const iocshArgBuf *args)
+{ iocshSetError(dbProcStatsStart());}
+
+/* dbProcStatsStop */
+static const iocshFuncDef dbProcStatsStopFuncDef = {"dbProcStatsStop",0,0};
+static void dbProcStatsStopCallFunc(const iocshArgBuf *args)
+{ dbProcStatsStop();}
+
+/* dbProcStatsReset */
+static const iocshFuncDef dbProcStatsResetFuncDef = {"dbProcStatsReset",0,0};
+static void dbProcStatsResetCallFunc(const iocshArgBuf *args)
+{ dbProcStatsReset();}
+
+/* dbProcStatsReport */
+static const iocshArg dbProcStatsReportArg0 = { "count",iocshArgInt};
+static const iocshArg dbProcStatsReportArg1 = { "interest level",iocshArgInt};
+static const iocshArg * const dbProcStatsReportArgs[2] =
+    {&dbProcStatsReportArg0,&dbProcStatsReportArg1};
+static const iocshFuncDef dbProcStatsReportFuncDef =
+    {"dbProcStatsReport",2,dbProcStatsReportArgs};
+static void dbProcStatsReportCallFunc(const iocshArgBuf *args)
+{ dbProcStatsReport(args[0].ival,args[1].ival);}
+
 /* scanOnceSetQueueSize */
 static const iocshArg scanOnceSetQueueSizeArg0 = { "size",iocshArgInt};
 static const iocshArg * const scanOnceSetQueueSizeArgs[1] =
@@ -296,6 +345,28 @@ static void scanOnceSetQueueSizeCallFunc(const iocshArgBuf *args)
     scanOnceSetQueueSize(args[0].ival);
 }
 
+/* scanOnceSetThreads */
+static const iocshArg scanOnceSetThreadsArg0 = { "no of threads",iocshArgInt};
+static const iocshArg * const scanOnceSetThreadsArgs[1] =
+    {&scanOnceSetThreadsArg0};
+static const iocshFuncDef scanOnceSetThreadsFuncDef =
+    {"scanOnceSetThreads",1,scanOnceSetThreadsArgs};
+static void scanOnceSetThreadsCallFunc(const iocshArgBuf *args)
+{
+    scanOnceSetThreads(args[0].ival);
+}
+
+/* scanOnceSetCoalesce */
+static const iocshArg scanOnceSetCoalesceArg0 = { "enable",iocshArgInt};
+static const iocshArg * const scanOnceSetCoalesceArgs[1] =
+    {&scanOnceSetCoalesceArg0};
+static const iocshFuncDef scanOnceSetCoalesceFuncDef =
+    {"scanOnceSetCoalesce",1,scanOnceSetCoalesceArgs};
+static void scanOnceSetCoalesceCallFunc(const iocshArgBuf *args)
+{
+    scanOnceSetCoalesce(args[0].ival);
+}
+
 /* scanOnceQueueShow */
 static const iocshArg scanOnceQueueShowArg0 = { "reset",iocshArgInt};
 static const iocshArg * const scanOnceQueueShowArgs[1] =
@@ -314,6 +385,18 @@ static const iocshFuncDef scanpplFuncDef = {"scanppl",1,scanpplArgs};
 static void scanpplCallFunc(const iocshArgBuf *args)
 { scanppl(args[0].dval);}
 
+/* scanPeriodicThreads */
+static const iocshArg scanPeriodicThreadsArg0 = { "no of threads", iocshArgInt};
+static const iocshArg scanPeriodicThreadsArg1 = { "scan rate", iocshArgString};
+static const iocshArg * const scanPeriodicThreadsArgs[2] =
+    {&scanPeriodicThreadsArg0,&scanPeriodicThreadsArg1};
+static const iocshFuncDef scanPeriodicThreadsFuncDef =
+    {"scanPeriodicThreads",2,scanPeriodicThreadsArgs};
+static void scanPeriodicThreadsCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(scanPeriodicThreads(args[0].ival, args[1].sval));
+}
+
 /* scanpel */
 static const iocshArg scanpelArg0 = { "event name",iocshArgString};
 static const iocshArg * const scanpelArgs[1] = {&scanpelArg0};
@@ -369,6 +452,18 @@ static void callbackParallelThreadsCallFunc(const iocshArgBuf *args)
     callbackParallelThreads(args[0].ival, args[1].sval);
 }
 
+/* callbackWorkStealingThreads */
+static const iocshArg callbackWorkStealingThreadsArg0 = { "no of threads", iocshArgInt};
+static const iocshArg callbackWorkStealingThreadsArg1 = { "priority", iocshArgString};
+static const iocshArg * const callbackWorkStealingThreadsArgs[2] =
+    {&callbackWorkStealingThreadsArg0,&callbackWorkStealingThreadsArg1};
+static const iocshFuncDef callbackWorkStealingThreadsFuncDef =
+    {"callbackWorkStealingThreads",2,callbackWorkStealingThreadsArgs};
+static void callbackWorkStealingThreadsCallFunc(const iocshArgBuf *args)
+{
+    callbackWorkStealingThreads(args[0].ival, args[1].sval);
+}
+
 /* dbStateCreate */
 static const iocshArg dbStateArgName = { "name", iocshArgString };
 static const iocshArg * const dbStateCreateArgs[] = { &dbStateArgName };
@@ -433,6 +528,7 @@ void dbIocRegister(void)
 
     iocshRegister(&dbsrFuncDef,dbsrCallFunc);
     iocshRegister(&dbcarFuncDef,dbcarCallFunc);
+    iocshRegister(&dbCaSetThreadsFuncDef,dbCaSetThreadsCallFunc);
     iocshRegister(&dbelFuncDef,dbelCallFunc);
     iocshRegister(&dbjlrFuncDef,dbjlrCallFunc);
 
@@ -461,10 +557,20 @@ void dbIocRegister(void)
     iocshRegister(&tpnFuncDef,tpnCallFunc);
     iocshRegister(&dblsrFuncDef,dblsrCallFunc);
     iocshRegister(&dbLockShowLockedFuncDef,dbLockShowLockedCallFunc);
+    iocshRegister(&dblspFuncDef,dblspCallFunc);
+    iocshRegister(&dblspResetFuncDef,dblspResetCallFunc);
+
+    iocshRegister(&dbProcStatsStartFuncDef,dbProcStatsStartCallFunc);
+    iocshRegister(&dbProcStatsStopFuncDef,dbProcStatsStopCallFunc);
+    iocshRegister(&dbProcStatsResetFuncDef,dbProcStatsResetCallFunc);
+    iocshRegister(&dbProcStatsReportFuncDef,dbProcStatsReportCallFunc);
 
     iocshRegister(&scanOnceSetQueueSizeFuncDef,scanOnceSetQueueSizeCallFunc);
+    iocshRegister(&scanOnceSetThreadsFuncDef,scanOnceSetThreadsCallFunc);
+    iocshRegister(&scanOnceSetCoalesceFuncDef,scanOnceSetCoalesceCallFunc);
     iocshRegister(&scanOnceQueueShowFuncDef,scanOnceQueueShowCallFunc);
     iocshRegister(&scanpplFuncDef,scanpplCallFunc);
+    iocshRegister(&scanPeriodicThreadsFuncDef,scanPeriodicThreadsCallFunc);
     iocshRegister(&scanpelFuncDef,scanpelCallFunc);
     iocshRegister(&postEventFuncDef,postEventCallFunc);
     iocshRegister(&scanpiolFuncDef,scanpiolCallFunc);
@@ -472,6 +578,7 @@ void dbIocRegister(void)
     iocshRegister(&callbackSetQueueSizeFuncDef,callbackSetQueueSizeCallFunc);
     iocshRegister(&callbackQueueShowFuncDef,callbackQueueShowCallFunc);
     iocshRegister(&callbackParallelThreadsFuncDef,callbackParallelThreadsCallFunc);
+    iocshRegister(&callbackWorkStealingThreadsFuncDef,callbackWorkStealingThreadsCallFunc);
 
     /* Needed before callback system is initialized */
     callbackParallelThreadsDefault = epicsThreadGetCPUs();
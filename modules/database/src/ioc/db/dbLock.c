@@ -23,6 +23,7 @@
 #include "epicsSpin.h"
 #include "epicsStdio.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
 #include "errMdef.h"
 
 #define epicsExportSharedSymbols
@@ -33,8 +34,10 @@
 #include "dbCommon.h"
 #include "dbFldTypes.h"
 #include "dbLockPvt.h"
+#include "dbScan.h"
 #include "dbStaticLib.h"
 #include "link.h"
+#include "epicsExport.h"
 
 typedef struct dbScanLockNode dbScanLockNode;
 
@@ -57,6 +60,10 @@ static epicsMutexId lockSetsGuard;
 static size_t recomputeCnt;
 #endif
 
+/* Lock set contention profiling, off by default */
+epicsShareDef int dbLockProfile = 0;
+epicsExportAddress(int, dbLockProfile);
+
 /*private routines */
 static void dbLockOnce(void* ignore)
 {
@@ -91,6 +98,7 @@ static lockSet* makeSet(void)
         epicsMutexMustLock(lockSetsGuard);
     }
 #endif
+    memset(&ls->prof, 0, sizeof(ls->prof));
     /* the initial reference for the first lockRecord */
     iref = epicsAtomicIncrIntT(&ls->refcount);
     ellAdd(&lockSetsActive, &ls->node);
@@ -184,6 +192,73 @@ unsigned long dbLockGetLockId(dbCommon *precord)
     return id;
 }
 
+/* Take a lockSet's lock, profiling the acquisition if enabled.
+ * An uncontended lock only costs one extra clock read; the wait is
+ * timed only when the first attempt fails.
+ */
+static void lockSetLock(lockSet *ls)
+{
+    lockSetProfile *prof = &ls->prof;
+    epicsUInt64 now;
+
+    if (!dbLockProfile) {
+        epicsMutexMustLock(ls->lock);
+        return;
+    }
+
+    if (epicsMutexTryLock(ls->lock) == epicsMutexLockOK) {
+        now = epicsMonotonicGet();
+    }
+    else {
+        epicsUInt64 start = epicsMonotonicGet();
+
+        epicsMutexMustLock(ls->lock);
+        now = epicsMonotonicGet();
+        prof->nContended++;
+        prof->waitTime += now - start;
+    }
+    prof->nLock++;
+    if (prof->depth++ == 0)
+        prof->lockedAt = now;
+}
+
+static void lockSetUnlock(lockSet *ls)
+{
+    lockSetProfile *prof = &ls->prof;
+
+    /* depth is only non-zero if the lock was taken while profiling */
+    if (prof->depth && --prof->depth == 0) {
+        epicsUInt64 held = epicsMonotonicGet() - prof->lockedAt;
+
+        if (held > prof->maxHold) {
+            const char *name = epicsThreadGetNameSelf();
+
+            prof->maxHold = held;
+            strncpy(prof->maxHolder, name ? name : "",
+                sizeof(prof->maxHolder) - 1);
+            prof->maxHolder[sizeof(prof->maxHolder) - 1] = '\0';
+        }
+    }
+    epicsMutexUnlock(ls->lock);
+}
+
+/* Fold the counters of a lock set which is being merged away into the
+ * one which absorbs it.  Both must be locked.
+ */
+static void lockSetProfileMerge(lockSet *A, const lockSet *B)
+{
+    lockSetProfile *pa = &A->prof;
+    const lockSetProfile *pb = &B->prof;
+
+    pa->nLock += pb->nLock;
+    pa->nContended += pb->nContended;
+    pa->waitTime += pb->waitTime;
+    if (pb->maxHold > pa->maxHold) {
+        pa->maxHold = pb->maxHold;
+        strcpy(pa->maxHolder, pb->maxHolder);
+    }
+}
+
 void dbScanLock(dbCommon *precord)
 {
     int cnt;
@@ -196,7 +271,7 @@ void dbScanLock(dbCommon *precord)
     assert(epicsAtomicGetIntT(&ls->refcount)>0);
 
 retry:
-    epicsMutexMustLock(ls->lock);
+    lockSetLock(ls);
 
     epicsSpinLock(lr->spin);
     if(ls!=lr->plockSet) {
@@ -208,7 +283,7 @@ retry:
         assert(newcnt>=2); /* at least lockRecord and us */
         epicsSpinUnlock(lr->spin);
 
-        epicsMutexUnlock(ls->lock);
+        lockSetUnlock(ls);
         dbLockDecRef(ls);
 
         ls = ls2;
@@ -248,7 +323,7 @@ void dbScanUnlock(dbCommon *precord)
     if(ls->ownercount==0)
         ls->owner = NULL;
 #endif
-    epicsMutexUnlock(ls->lock);
+    lockSetUnlock(ls);
     dbLockDecRef(ls);
 }
 
@@ -412,7 +487,7 @@ retry:
             continue;
         plock = ref->plockSet;
 
-        epicsMutexMustLock(plock->lock);
+        lockSetLock(plock);
         assert(plock->ownerlocker==NULL);
         plock->ownerlocker = locker;
         ellAdd(&locker->locked, &plock->lockernode);
@@ -470,7 +545,7 @@ void dbScanUnlockMany(dbLocker* locker)
             plock->owner = NULL;
 #endif
 
-        epicsMutexUnlock(plock->lock);
+        lockSetUnlock(plock);
         /* release ref for locked list */
         dbLockDecRef(plock);
     }
@@ -635,8 +710,14 @@ void dbLockSetMerge(dbLocker *locker, dbCommon *pfirst, dbCommon *psecond)
         epicsAtomicIncrSizeT(&recomputeCnt);
 #endif
         epicsSpinUnlock(lr->spin);
+
+        /* keep it on the periodic scan thread of its new lock set */
+        scanLockSetMoved(lr->precord);
     }
 
+    /* keep B's contention history */
+    lockSetProfileMerge(A, B);
+
     /* there are at minimum, 1 ref for each lockRecord,
      * and one for the locker's locked list
      * (and perhaps another for its refs cache)
@@ -664,7 +745,7 @@ void dbLockSetMerge(dbLocker *locker, dbCommon *pfirst, dbCommon *psecond)
         B->ownerlocker = NULL;
         epicsAtomicDecrIntT(&B->refcount);
 
-        epicsMutexUnlock(B->lock);
+        lockSetUnlock(B);
     }
 
     dbLockDecRef(B); /* last ref we hold */
@@ -981,6 +1062,107 @@ long dbLockShowLocked(int level)
     return 0;
 }
 
+typedef struct {
+    unsigned long id;
+    int nRecords;
+    const char *first;
+    lockSetProfile prof;
+} lockSetProfileCopy;
+
+static int profileCompare(const void *rawA, const void *rawB)
+{
+    const lockSetProfileCopy *A = rawA, *B = rawB;
+
+    if (A->prof.waitTime != B->prof.waitTime)
+        return A->prof.waitTime > B->prof.waitTime ? -1 : 1;
+    if (A->prof.nContended != B->prof.nContended)
+        return A->prof.nContended > B->prof.nContended ? -1 : 1;
+    return A->id < B->id ? -1 : A->id > B->id;
+}
+
+/* The counters are read without taking the lock sets, so a report made
+ * while the IOC is busy is a close rather than an exact snapshot.
+ */
+long dblsp(int count)
+{
+    lockSetProfileCopy *pcopy;
+    lockSet *plockSet;
+    int n = 0, i;
+
+    if (!lockSetsGuard) {
+        printf("Lock sets not initialized\n");
+        return 0;
+    }
+
+    epicsMutexMustLock(lockSetsGuard);
+    pcopy = malloc(ellCount(&lockSetsActive) * sizeof(*pcopy) + 1);
+    if (!pcopy) {
+        epicsMutexUnlock(lockSetsGuard);
+        printf("Out of memory\n");
+        return -1;
+    }
+    for (plockSet = (lockSet *)ellFirst(&lockSetsActive); plockSet;
+         plockSet = (lockSet *)ellNext(&plockSet->node)) {
+        lockRecord *plr = (lockRecord *)ellFirst(&plockSet->lockRecordList);
+        lockSetProfileCopy *pc;
+
+        if (!plockSet->prof.nLock)
+            continue;
+        pc = &pcopy[n++];
+        pc->id = plockSet->id;
+        pc->nRecords = ellCount(&plockSet->lockRecordList);
+        pc->first = plr ? plr->precord->name : "";
+        pc->prof = plockSet->prof;
+    }
+    epicsMutexUnlock(lockSetsGuard);
+
+    qsort(pcopy, n, sizeof(*pcopy), profileCompare);
+    if (count <= 0 || count > n)
+        count = n;
+
+    if (!dbLockProfile)
+        printf("Lock set profiling is off, set dbLockProfile to enable\n");
+    printf("%8s %6s %12s %12s %12s %13s %-16s %s\n", "Lock Set", "Recs",
+        "Locks", "Contended", "Wait (ms)", "Max hold (ms)", "Held by",
+        "First record");
+    for (i = 0; i < count; i++) {
+        lockSetProfileCopy *pc = &pcopy[i];
+
+        printf("%8lu %6d %12llu %12llu %12.3f %13.3f %-16s %s\n",
+            pc->id, pc->nRecords,
+            (unsigned long long) pc->prof.nLock,
+            (unsigned long long) pc->prof.nContended,
+            pc->prof.waitTime * 1e-6, pc->prof.maxHold * 1e-6,
+            pc->prof.maxHolder, pc->first);
+    }
+    free(pcopy);
+    return 0;
+}
+
+/* Counters are cleared without the lock sets being locked, an update
+ * racing with the reset may survive it.
+ */
+void dblspReset(void)
+{
+    lockSet *plockSet;
+
+    if (!lockSetsGuard)
+        return;
+
+    epicsMutexMustLock(lockSetsGuard);
+    for (plockSet = (lockSet *)ellFirst(&lockSetsActive); plockSet;
+         plockSet = (lockSet *)ellNext(&plockSet->node)) {
+        lockSetProfile *prof = &plockSet->prof;
+
+        prof->nLock = 0;
+        prof->nContended = 0;
+        prof->waitTime = 0;
+        prof->maxHold = 0;
+        prof->maxHolder[0] = '\0';
+    }
+    epicsMutexUnlock(lockSetsGuard);
+}
+
 int * dbLockSetAddrTrace(dbCommon *precord)
 {
     lockRecord	*plockRecord = precord->lset;
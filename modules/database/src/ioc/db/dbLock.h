@@ -52,6 +52,12 @@ epicsShareFunc long dblsr(char *recordname,int level);
 
 epicsShareFunc long dbLockShowLocked(int level);
 
+/* Lock set contention profile, collected while dbLockProfile is non-zero */
+epicsShareExtern int dbLockProfile;
+/* Show the count lock sets with the most time spent waiting (0 = all) */
+epicsShareFunc long dblsp(int count);
+epicsShareFunc void dblspReset(void);
+
 /*KLUDGE to support field TPRO*/
 epicsShareFunc int * dbLockSetAddrTrace(struct dbCommon *precord);
 
@@ -10,6 +10,7 @@
 
 #include "dbLock.h"
 #include "epicsSpin.h"
+#include "epicsTypes.h"
 
 /* Define to enable additional error checking */
 #undef LOCKSET_DEBUG
@@ -20,6 +21,19 @@
 /* Define to disable use of recomputeCnt optimization */
 #undef LOCKSET_NOCNT
 
+/* Contention statistics, collected while dbLockProfile is set.
+ * Times are in epicsMonotonicGet() ticks (ns).
+ */
+typedef struct lockSetProfile {
+    epicsUInt64         nLock;      /* acquisitions */
+    epicsUInt64         nContended; /* acquisitions which had to wait */
+    epicsUInt64         waitTime;   /* total time spent waiting */
+    epicsUInt64         maxHold;    /* longest time held */
+    char                maxHolder[32]; /* thread which held it longest */
+    epicsUInt64         lockedAt;   /* when the outermost lock was taken */
+    int                 depth;      /* recursive locks being timed */
+} lockSetProfile;
+
 /* except for refcount (and lock), all members of dbLockSet
  * are guarded by its lock.
  */
@@ -38,6 +52,8 @@ typedef struct dbLockSet {
     ELLNODE             lockernode;
 
     int                 trace; /*For field TPRO*/
+
+    lockSetProfile      prof;
 } lockSet;
 
 struct lockRecord;
@@ -0,0 +1,351 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Record processing time statistics, see dbProcStats.h
+ *
+ * The statistics of a record are only updated by dbProcess(), with the
+ * record locked.  The report and reset routines don't lock the records,
+ * so a report taken while the IOC is busy is close to, rather than an
+ * exact snapshot of the counters.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "dbAccessDefs.h"
+#include "dbBase.h"
+#include "dbCommonPvt.h"
+#include "dbProcStats.h"
+#include "dbStaticLib.h"
+
+static epicsThreadOnceId statsOnce = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId statsLock;  /* guards allocation and enabling */
+static int running;             /* started by dbProcStatsStart() */
+
+static void statsInit(void *junk)
+{
+    statsLock = epicsMutexMustCreate();
+}
+
+/* Call with statsLock held */
+static dbProcStats * statsAlloc(dbCommon *prec)
+{
+    dbCommonPvt *ppvt = dbRec2Pvt(prec);
+
+    if (!ppvt->pstats) {
+        dbProcStats *pstats = calloc(1, sizeof(dbProcStats));
+
+        if (!pstats) {
+            errlogPrintf("dbProcStats: Out of memory for %s\n", prec->name);
+            return NULL;
+        }
+        /* dbProcess() reads this without a lock, it only times the record
+         * once it also sees enabled set.  The counters must be visible
+         * before the pointer is. */
+        epicsAtomicWriteMemoryBarrier();
+        epicsAtomicSetPtrT((EpicsAtomicPtrT *)&ppvt->pstats, pstats);
+    }
+    return ppvt->pstats;
+}
+
+typedef void (*recordFunc)(dbCommon *prec, DBENTRY *pdbentry, void *user);
+
+static void forEachRecord(recordFunc func, void *user)
+{
+    DBENTRY dbentry;
+    long status;
+
+    if (!pdbbase)
+        return;
+
+    dbInitEntry(pdbbase, &dbentry);
+    for (status = dbFirstRecordType(&dbentry); !status;
+         status = dbNextRecordType(&dbentry)) {
+        for (status = dbFirstRecord(&dbentry); !status;
+             status = dbNextRecord(&dbentry)) {
+            dbCommon *prec = dbentry.precnode->precord;
+
+            if (!prec || dbIsAlias(&dbentry))
+                continue;
+            func(prec, &dbentry, user);
+        }
+    }
+    dbFinishEntry(&dbentry);
+}
+
+static void doInit(dbCommon *prec, DBENTRY *pdbentry, void *user)
+{
+    dbProcStats *pstats;
+
+    if (dbFindInfo(pdbentry, "procStats"))
+        return;
+    pstats = statsAlloc(prec);
+    if (pstats) {
+        pstats->always = 1;
+        pstats->enabled = 1;
+    }
+}
+
+void dbProcStatsInit(void)
+{
+    epicsThreadOnce(&statsOnce, statsInit, NULL);
+    epicsMutexMustLock(statsLock);
+    running = 0;
+    forEachRecord(doInit, NULL);
+    epicsMutexUnlock(statsLock);
+}
+
+static void doStart(dbCommon *prec, DBENTRY *pdbentry, void *user)
+{
+    dbProcStats *pstats = statsAlloc(prec);
+
+    if (pstats)
+        pstats->enabled = 1;
+}
+
+long dbProcStatsStart(void)
+{
+    if (!pdbbase) {
+        printf("No database loaded\n");
+        return -1;
+    }
+    epicsThreadOnce(&statsOnce, statsInit, NULL);
+    epicsMutexMustLock(statsLock);
+    forEachRecord(doStart, NULL);
+    running = 1;
+    epicsMutexUnlock(statsLock);
+    return 0;
+}
+
+static void doStop(dbCommon *prec, DBENTRY *pdbentry, void *user)
+{
+    dbProcStats *pstats = dbRec2Pvt(prec)->pstats;
+
+    if (pstats)
+        pstats->enabled = pstats->always;
+}
+
+long dbProcStatsStop(void)
+{
+    epicsThreadOnce(&statsOnce, statsInit, NULL);
+    epicsMutexMustLock(statsLock);
+    forEachRecord(doStop, NULL);
+    running = 0;
+    epicsMutexUnlock(statsLock);
+    return 0;
+}
+
+static void doReset(dbCommon *prec, DBENTRY *pdbentry, void *user)
+{
+    dbProcStats *pstats = dbRec2Pvt(prec)->pstats;
+
+    if (pstats) {
+        pstats->count = 0;
+        pstats->total = 0;
+        pstats->min = 0;
+        pstats->max = 0;
+        pstats->last = 0;
+        memset(pstats->hist, 0, sizeof(pstats->hist));
+    }
+}
+
+long dbProcStatsReset(void)
+{
+    forEachRecord(doReset, NULL);
+    return 0;
+}
+
+dbProcStats * dbProcStatsFind(dbCommon *prec)
+{
+    return dbRec2Pvt(prec)->pstats;
+}
+
+dbProcStats * dbProcStatsGet(dbCommon *prec)
+{
+    dbProcStats *pstats;
+
+    epicsThreadOnce(&statsOnce, statsInit, NULL);
+    epicsMutexMustLock(statsLock);
+    pstats = statsAlloc(prec);
+    if (pstats) {
+        pstats->always = 1;
+        pstats->enabled = 1;
+    }
+    epicsMutexUnlock(statsLock);
+    return pstats;
+}
+
+void dbProcStatsAdd(dbProcStats *pstats, epicsUInt64 dt)
+{
+    epicsUInt64 v = dt;
+    unsigned bin = 0;
+
+    /* bin = floor(log2(dt)) */
+    if (v >> 32) { v >>= 32; bin += 32; }
+    if (v >> 16) { v >>= 16; bin += 16; }
+    if (v >> 8)  { v >>= 8;  bin += 8; }
+    if (v >> 4)  { v >>= 4;  bin += 4; }
+    if (v >> 2)  { v >>= 2;  bin += 2; }
+    if (v >> 1)  { bin += 1; }
+    if (bin >= DBPS_NBINS)
+        bin = DBPS_NBINS - 1;
+
+    if (!pstats->count || dt < pstats->min)
+        pstats->min = dt;
+    if (dt > pstats->max)
+        pstats->max = dt;
+    pstats->count++;
+    pstats->total += dt;
+    pstats->last = dt;
+    pstats->hist[bin]++;
+}
+
+/* Report */
+
+typedef struct {
+    const char *name;
+    const char *type;
+    dbProcStats stats;
+} statsCopy;
+
+typedef struct {
+    statsCopy *pcopy;
+    size_t n, size;
+} statsList;
+
+static void doCopy(dbCommon *prec, DBENTRY *pdbentry, void *user)
+{
+    statsList *plist = user;
+    dbProcStats *pstats = dbRec2Pvt(prec)->pstats;
+    statsCopy *pc;
+
+    if (!pstats || !pstats->count)
+        return;
+
+    if (plist->n == plist->size) {
+        size_t size = plist->size ? 2 * plist->size : 64;
+        statsCopy *pnew = realloc(plist->pcopy, size * sizeof(statsCopy));
+
+        if (!pnew)
+            return;
+        plist->pcopy = pnew;
+        plist->size = size;
+    }
+    pc = &plist->pcopy[plist->n++];
+    pc->name = prec->name;
+    pc->type = pdbentry->precordType->name;
+    pc->stats = *pstats;
+}
+
+static int totalCompare(const void *rawA, const void *rawB)
+{
+    const statsCopy *A = rawA, *B = rawB;
+
+    if (A->stats.total != B->stats.total)
+        return A->stats.total > B->stats.total ? -1 : 1;
+    return strcmp(A->name, B->name);
+}
+
+static void showHistogram(const dbProcStats *pstats)
+{
+    int i;
+
+    for (i = 0; i < DBPS_NBINS; i++) {
+        double lo = i ? (double) (1ull << i) : 0.0;
+
+        if (!pstats->hist[i])
+            continue;
+        if (i == DBPS_NBINS - 1)
+            printf("    %12.3f us and over: %u\n", lo * 1e-3,
+                pstats->hist[i]);
+        else
+            printf("    %12.3f us to %10.3f us: %u\n", lo * 1e-3,
+                (double) (2ull << i) * 1e-3, pstats->hist[i]);
+    }
+}
+
+static void showLine(const char *name, const char *type,
+    const dbProcStats *pstats)
+{
+    printf("%-28s %-10s %10llu %10.3f %10.3f %10.3f %12.3f\n", name, type,
+        (unsigned long long) pstats->count,
+        pstats->total * 1e-3 / pstats->count,
+        pstats->min * 1e-3, pstats->max * 1e-3, pstats->total * 1e-6);
+}
+
+long dbProcStatsReport(int count, int level)
+{
+    statsList list = {NULL, 0, 0};
+    statsCopy *ptypes;
+    size_t i, j, ntypes = 0;
+
+    forEachRecord(doCopy, &list);
+    if (!running)
+        printf("Processing statistics are stopped, "
+            "see dbProcStatsStart\n");
+    if (!list.n) {
+        printf("No records timed\n");
+        return 0;
+    }
+    qsort(list.pcopy, list.n, sizeof(statsCopy), totalCompare);
+
+    printf("%-28s %-10s %10s %10s %10s %10s %12s\n", "Record", "Type",
+        "Count", "Avg (us)", "Min (us)", "Max (us)", "Total (ms)");
+    for (i = 0; i < list.n && (count <= 0 || i < (size_t) count); i++) {
+        statsCopy *pc = &list.pcopy[i];
+
+        showLine(pc->name, pc->type, &pc->stats);
+        if (level > 0)
+            showHistogram(&pc->stats);
+    }
+
+    /* Per record type totals, the record names are no longer needed */
+    ptypes = list.pcopy;
+    for (i = 0; i < list.n; i++) {
+        statsCopy *pc = &list.pcopy[i];
+
+        for (j = 0; j < ntypes; j++) {
+            if (ptypes[j].type == pc->type)
+                break;
+        }
+        if (j == ntypes) {
+            ptypes[ntypes] = *pc;
+            ptypes[ntypes++].name = "";
+        }
+        else {
+            dbProcStats *pt = &ptypes[j].stats;
+            int k;
+
+            if (pc->stats.min < pt->min)
+                pt->min = pc->stats.min;
+            if (pc->stats.max > pt->max)
+                pt->max = pc->stats.max;
+            pt->count += pc->stats.count;
+            pt->total += pc->stats.total;
+            for (k = 0; k < DBPS_NBINS; k++)
+                pt->hist[k] += pc->stats.hist[k];
+        }
+    }
+    qsort(ptypes, ntypes, sizeof(statsCopy), totalCompare);
+
+    printf("\n%-28s %-10s %10s %10s %10s %10s %12s\n", "All records", "Type",
+        "Count", "Avg (us)", "Min (us)", "Max (us)", "Total (ms)");
+    for (i = 0; i < ntypes; i++) {
+        showLine("", ptypes[i].type, &ptypes[i].stats);
+        if (level > 0)
+            showHistogram(&ptypes[i].stats);
+    }
+
+    free(list.pcopy);
+    return 0;
+}
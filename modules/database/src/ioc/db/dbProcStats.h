@@ -0,0 +1,79 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#ifndef INCdbProcStatsH
+#define INCdbProcStatsH
+
+#include "epicsTypes.h"
+#include "shareLib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file dbProcStats.h
+ * @brief Record processing time statistics
+ *
+ * While enabled for a record, dbProcess() times each call to the record
+ * support's process() routine with epicsMonotonicGet() and accumulates the
+ * durations here.  An asynchronous record is timed once when it starts and
+ * again when it completes.
+ *
+ * Collection is enabled for all records by dbProcStatsStart() and disabled
+ * again by dbProcStatsStop().  Records with an info tag "procStats" and
+ * records whose statistics are read through the "Process Stats" device
+ * support are always timed.
+ */
+
+/** Number of histogram bins */
+#define DBPS_NBINS 32
+
+struct dbCommon;
+
+typedef struct dbProcStats {
+    int enabled;        /* timing process() calls */
+    int always;         /* keep timing when stopped */
+    epicsUInt64 count;  /* number of process() calls timed */
+    epicsUInt64 total;  /* sum of durations, ns */
+    epicsUInt64 min;    /* shortest duration, ns */
+    epicsUInt64 max;    /* longest duration, ns */
+    epicsUInt64 last;   /* latest duration, ns */
+    /* hist[i] counts durations from 2^i up to 2^(i+1) ns, hist[0]
+     * includes 0 ns and the last bin everything longer */
+    epicsUInt32 hist[DBPS_NBINS];
+} dbProcStats;
+
+/** @brief Start timing all records. */
+epicsShareFunc long dbProcStatsStart(void);
+
+/** @brief Stop timing records not marked to be always timed. */
+epicsShareFunc long dbProcStatsStop(void);
+
+/** @brief Clear the statistics of all records. */
+epicsShareFunc long dbProcStatsReset(void);
+
+/** @brief Show the count records with the largest total processing time,
+ * or all timed records if count is 0, then the totals for each record type.
+ * If level is greater than 0 the histogram of each record shown is printed.
+ */
+epicsShareFunc long dbProcStatsReport(int count, int level);
+
+/** @brief Find the statistics of a record, NULL if it was never timed. */
+epicsShareFunc dbProcStats * dbProcStatsFind(struct dbCommon *prec);
+
+/** @brief Get the statistics of a record, enabling them permanently. */
+epicsShareFunc dbProcStats * dbProcStatsGet(struct dbCommon *prec);
+
+/** @brief Add one process() duration; called by dbProcess(). */
+epicsShareFunc void dbProcStatsAdd(dbProcStats *pstats, epicsUInt64 dt);
+
+/** @brief Enable records with a "procStats" info tag; called by iocInit. */
+epicsShareFunc void dbProcStatsInit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCdbProcStatsH */
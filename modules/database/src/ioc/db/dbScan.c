@@ -42,6 +42,7 @@
 #include "dbAddr.h"
 #include "dbBase.h"
 #include "dbCommon.h"
+#include "dbCommonPvt.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
 #include "dbScan.h"
@@ -49,6 +50,7 @@
 #include "devSup.h"
 #include "link.h"
 #include "recGbl.h"
+#include "epicsExport.h"
 
 
 /* Task Control */
@@ -62,12 +64,28 @@ static volatile enum ctl scanCtl;
 /* SCAN ONCE */
 
 static int onceQueueSize = 1000;
-static epicsEventId onceSem;
-static epicsRingBytesId onceQ;
-static int onceQOverruns = 0;
-static epicsThreadId onceTaskId;
+static int onceThreadsConfig = 1;   /* set by scanOnceSetThreads() */
+static int onceCoalesceConfig;  /* set by scanOnceSetCoalesce() */
+static int onceCoalesce;        /* in effect since iocInit */
 static void *exitOnce;
 
+/* Each worker thread has its own queue.  A record is given to a worker by
+ * its lock set when it is first queued and stays with it, so the requests
+ * for a record are processed in order.  Records whose lock sets are merged
+ * later may then be on different workers, dbScanLock() still serializes
+ * their processing.
+ */
+typedef struct once_worker {
+    epicsEventId        sem;
+    epicsRingBytesId    queue;
+    int                 overruns;
+    int                 suppressed;
+    epicsThreadId       taskId;
+} once_worker;
+
+static int nOnceWorkers;
+static once_worker *onceWorkers;
+
 
 /* All other scan types */
 typedef struct scan_list{
@@ -81,24 +99,61 @@ typedef struct scan_element{
     scan_list           *pscan_list;
     struct dbCommon     *precord;
 } scan_element;
+/*slowest record found by one pass through a list*/
+typedef struct scan_timing {
+    struct dbCommon     *slowest;
+    epicsUInt64         slowestTime;    /* ns */
+} scan_timing;
 
 
 /* PERIODIC */
 
 #define OVERRUN_REPORT_DELAY 10.0   /* Time between initial reports */
 #define OVERRUN_REPORT_MAX 3600.0   /* Maximum time between reports */
+
+/* Deadline scheduling, see dbScan.h */
+epicsShareDef int dbScanDeadline = 0;
+epicsExportAddress(int, dbScanDeadline);
+epicsShareDef int dbScanEpoch = 0;
+epicsExportAddress(int, dbScanEpoch);
+
+/* Added to a monotonic time gives the time since the common epoch, the
+ * deadlines of a period are the multiples of the period after it.
+ */
+static epicsUInt64 epochOffset;
+/* papPeriodic[i] points to an array of nWorkers periodic_scan_lists.
+ * Each member is scanned by its own thread.  Records are assigned to
+ * a member by their lock set, so records sharing a lock set are always
+ * processed by the same thread in PHAS order.
+ */
 typedef struct periodic_scan_list {
     scan_list           scan_list;
     double              period;
     const char          *name;
     unsigned long       overruns;
+    unsigned long       skipped;    /* cycles missed by deadline scans */
     volatile enum ctl   scanCtl;
     epicsEventId        loopEvent;
+    epicsThreadId       taskId;
+    int                 worker;     /* index of this member */
+    int                 nWorkers;   /* members in this group */
+    /* statistics, guarded by scan_list.lock */
+    unsigned long       cycles;
+    double              jitterLast;
+    double              jitterSum;
+    double              jitterMax;
+    double              execLast;
+    double              execSum;
+    double              execMin;
+    double              execMax;
+    unsigned long       execHist[SCAN_PERIODIC_NBINS];
+    struct dbCommon     *slowest;
+    double              slowestTime;
 } periodic_scan_list;
 
 static int nPeriodic = 0;
 static periodic_scan_list **papPeriodic; /* pointer to array of pointers */
-static epicsThreadId *periodicTaskId;    /* array of thread ids */
+static int *periodicThreadsConfigured;   /* array of worker counts */
 
 
 static char *priorityName[NUM_CALLBACK_PRIORITIES] = {
@@ -137,16 +192,19 @@ static epicsMutexId ioscan_lock;
 /* Private routines */
 static void onceTask(void *);
 static void initOnce(void);
+static void onceExit(once_worker *pw);
 static void periodicTask(void *arg);
 static void initPeriodic(void);
 static void deletePeriodic(void);
 static void spawnPeriodic(int ind);
+static periodic_scan_list *periodicWorker(periodic_scan_list *ppsl,
+    struct dbCommon *precord);
 static void eventCallback(epicsCallback *pcallback);
 static void ioscanInit(void);
 static void ioscanCallback(epicsCallback *pcallback);
 static void ioscanDestroy(void);
 static void printList(scan_list *psl, char *message);
-static void scanList(scan_list *psl);
+static void scanList(scan_list *psl, scan_timing *ptiming);
 static void buildScanLists(void);
 static void addToList(struct dbCommon *precord, scan_list *psl);
 static void deleteFromList(struct dbCommon *precord, scan_list *psl);
@@ -162,28 +220,40 @@ void scanStop(void)
 
     for (i = 0; i < nPeriodic; i++) {
         periodic_scan_list *ppsl = papPeriodic[i];
+        int w;
 
         if (!ppsl) continue;
-        ppsl->scanCtl = ctlExit;
-        epicsEventSignal(ppsl->loopEvent);
-        epicsEventWait(startStopEvent);
+        for (w = 0; w < ppsl->nWorkers; w++) {
+            ppsl[w].scanCtl = ctlExit;
+            epicsEventSignal(ppsl[w].loopEvent);
+            epicsEventWait(startStopEvent);
+        }
     }
 
-    scanOnce((dbCommon *)&exitOnce);
-    epicsEventWait(startStopEvent);
+    for (i = 0; i < nOnceWorkers; i++) {
+        onceExit(&onceWorkers[i]);
+        epicsEventWait(startStopEvent);
+    }
 }
 
 void scanCleanup(void)
 {
+    int i;
 
     deletePeriodic();
     ioscanDestroy();
 
-    epicsRingBytesDelete(onceQ);
+    for (i = 0; i < nOnceWorkers; i++) {
+        epicsRingBytesDelete(onceWorkers[i].queue);
+        epicsEventDestroy(onceWorkers[i].sem);
+    }
+    free(onceWorkers);
+    onceWorkers = NULL;
+    nOnceWorkers = 0;
 
-    free(periodicTaskId);
+    free(periodicThreadsConfigured);
     papPeriodic = NULL;
-    periodicTaskId = NULL;
+    periodicThreadsConfigured = NULL;
 }
 
 long scanInit(void)
@@ -212,9 +282,11 @@ void scanRun(void)
 
     for (i = 0; i < nPeriodic; i++) {
         periodic_scan_list *ppsl = papPeriodic[i];
+        int w;
 
         if (!ppsl) continue;
-        ppsl->scanCtl = ctlRun;
+        for (w = 0; w < ppsl->nWorkers; w++)
+            ppsl[w].scanCtl = ctlRun;
     }
 }
 
@@ -224,9 +296,11 @@ void scanPause(void)
 
     for (i = nPeriodic - 1; i >= 0; --i) {
         periodic_scan_list *ppsl = papPeriodic[i];
+        int w;
 
         if (!ppsl) continue;
-        ppsl->scanCtl = ctlPause;
+        for (w = ppsl->nWorkers - 1; w >= 0; --w)
+            ppsl[w].scanCtl = ctlPause;
     }
 
     scanCtl = ctlPause;
@@ -297,7 +371,7 @@ void scanAdd(struct dbCommon *precord)
         periodic_scan_list *ppsl = papPeriodic[scan - SCAN_1ST_PERIODIC];
 
         if (ppsl)
-            addToList(precord, &ppsl->scan_list);
+            addToList(precord, &periodicWorker(ppsl, precord)->scan_list);
     }
 }
 
@@ -356,12 +430,45 @@ void scanDelete(struct dbCommon *precord)
         deleteFromList(precord, &piosh->iosl[prio].scan_list);
     } else if (scan >= SCAN_1ST_PERIODIC) {
         periodic_scan_list *ppsl = papPeriodic[scan - SCAN_1ST_PERIODIC];
-
-        if (ppsl)
-            deleteFromList(precord, &ppsl->scan_list);
+        scan_element *pse = precord->spvt;
+        int w;
+
+        if (!ppsl) return;
+        /* The lock set may have changed since the record was added,
+         * so find the member which actually holds it.
+         */
+        for (w = 0; w < ppsl->nWorkers - 1; w++) {
+            if (pse && pse->pscan_list == &ppsl[w].scan_list)
+                break;
+        }
+        deleteFromList(precord, &ppsl[w].scan_list);
     }
 }
 
+/* Called by dbLockSetMerge() with the record locked after it has been
+ * moved into another lock set.  A periodic record is moved to the member
+ * which scans its new lock set, so records which share a lock set stay on
+ * one thread.
+ */
+void scanLockSetMoved(struct dbCommon *precord)
+{
+    periodic_scan_list *ppsl, *pnew;
+    scan_element *pse = precord->spvt;
+    int scan = precord->scan;
+
+    if (!papPeriodic || scan < SCAN_1ST_PERIODIC ||
+        scan >= nPeriodic + SCAN_1ST_PERIODIC)
+        return;
+    ppsl = papPeriodic[scan - SCAN_1ST_PERIODIC];
+    if (!ppsl || ppsl->nWorkers <= 1 || !pse || !pse->pscan_list)
+        return;
+    pnew = periodicWorker(ppsl, precord);
+    if (pse->pscan_list == &pnew->scan_list)
+        return;
+    deleteFromList(precord, pse->pscan_list);
+    addToList(precord, &pnew->scan_list);
+}
+
 double scanPeriod(int scan) {
     periodic_scan_list *ppsl;
 
@@ -372,6 +479,130 @@ double scanPeriod(int scan) {
     return ppsl ? ppsl->period : 0.0;
 }
 
+/* Add the statistics of one worker to *result, with the sums of the
+ * averages' numerators.
+ */
+static void addStats(periodic_scan_list *ppsl, const int reset,
+    scanPeriodicStats *result, double *jitterSum, double *execSum)
+{
+    epicsMutexMustLock(ppsl->scan_list.lock);
+    if (result && ppsl->cycles) {
+        int first = !result->cycles;
+        int i;
+
+        if (first || fabs(ppsl->jitterLast) > fabs(result->jitterLast))
+            result->jitterLast = ppsl->jitterLast;
+        if (ppsl->jitterMax > result->jitterMax)
+            result->jitterMax = ppsl->jitterMax;
+        if (ppsl->execLast > result->execLast)
+            result->execLast = ppsl->execLast;
+        if (first || ppsl->execMin < result->execMin)
+            result->execMin = ppsl->execMin;
+        if (ppsl->execMax > result->execMax)
+            result->execMax = ppsl->execMax;
+        for (i = 0; i < SCAN_PERIODIC_NBINS; i++)
+            result->execHist[i] += ppsl->execHist[i];
+        if (ppsl->slowest &&
+            (!result->slowest[0] || ppsl->slowestTime > result->slowestTime)) {
+            strcpy(result->slowest, ppsl->slowest->name);
+            result->slowestTime = ppsl->slowestTime;
+        }
+        *jitterSum += ppsl->jitterSum;
+        *execSum += ppsl->execSum;
+        result->cycles += ppsl->cycles;
+    }
+    if (result) {
+        result->overruns += ppsl->overruns;
+        result->skipped += ppsl->skipped;
+    }
+    if (reset) {
+        ppsl->cycles = 0;
+        ppsl->overruns = 0;
+        ppsl->skipped = 0;
+        ppsl->jitterLast = ppsl->jitterSum = ppsl->jitterMax = 0.0;
+        ppsl->execLast = ppsl->execSum = ppsl->execMin = ppsl->execMax = 0.0;
+        memset(ppsl->execHist, 0, sizeof(ppsl->execHist));
+        ppsl->slowest = NULL;
+        ppsl->slowestTime = 0.0;
+    }
+    epicsMutexUnlock(ppsl->scan_list.lock);
+}
+
+static periodic_scan_list * findPeriodic(const char *rate)
+{
+    int i;
+
+    if (!papPeriodic || !rate)
+        return NULL;
+    for (i = 0; i < nPeriodic; i++) {
+        periodic_scan_list *ppsl = papPeriodic[i];
+
+        if (ppsl && !epicsStrCaseCmp(ppsl->name, rate))
+            return ppsl;
+    }
+    return NULL;
+}
+
+int scanPeriodicStatus(const char *rate, int worker, const int reset,
+    scanPeriodicStats *result)
+{
+    periodic_scan_list *ppsl = findPeriodic(rate);
+    double jitterSum = 0.0, execSum = 0.0;
+    int w;
+
+    if (!ppsl || worker >= ppsl->nWorkers) return -1;
+    if (result) {
+        memset(result, 0, sizeof(*result));
+        result->period = ppsl->period;
+        result->nWorkers = ppsl->nWorkers;
+    }
+    for (w = 0; w < ppsl->nWorkers; w++) {
+        if (worker < 0 || w == worker)
+            addStats(&ppsl[w], reset, result, &jitterSum, &execSum);
+    }
+    if (!result) return -2;
+    if (result->cycles) {
+        result->jitterAvg = jitterSum / result->cycles;
+        result->execAvg = execSum / result->cycles;
+    }
+    return 0;
+}
+
+static void printStats(periodic_scan_list *ppsl)
+{
+    scanPeriodicStats stats;
+    double jitterSum = 0.0, execSum = 0.0;
+    int i;
+
+    memset(&stats, 0, sizeof(stats));
+    addStats(ppsl, 0, &stats, &jitterSum, &execSum);
+    if (!stats.cycles)
+        return;
+
+    printf("    %lu cycles, start jitter avg %.3f max %.3f ms, "
+        "execution avg %.3f min %.3f max %.3f ms\n", stats.cycles,
+        jitterSum * 1e3 / stats.cycles, stats.jitterMax * 1e3,
+        execSum * 1e3 / stats.cycles, stats.execMin * 1e3,
+        stats.execMax * 1e3);
+    if (stats.skipped)
+        printf("    %lu cycles skipped after over-runs\n", stats.skipped);
+    printf("    Last cycle: jitter %.3f ms, execution %.3f ms",
+        stats.jitterLast * 1e3, stats.execLast * 1e3);
+    if (stats.slowest[0])
+        printf(", slowest '%s' %.3f ms", stats.slowest,
+            stats.slowestTime * 1e3);
+    printf("\n    Execution time in %% of period:");
+    for (i = 0; i < SCAN_PERIODIC_NBINS; i++) {
+        if (!stats.execHist[i])
+            continue;
+        if (i == SCAN_PERIODIC_NBINS - 1)
+            printf(" >=%d%%: %lu", i * 10, stats.execHist[i]);
+        else
+            printf(" %d-%d%%: %lu", i * 10, i * 10 + 10, stats.execHist[i]);
+    }
+    printf("\n");
+}
+
 int scanppl(double period)      /* print periodic scan list(s) */
 {
     dbMenu *pmenu = dbFindMenu(pdbbase, "menuScan");
@@ -397,13 +628,76 @@ int scanppl(double period)      /* print periodic scan list(s) */
             (fabs(period - ppsl->period) > 0.05))
             continue;
 
-        sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
-            ppsl->name, ppsl->overruns);
-        printList(&ppsl->scan_list, message);
+        if (ppsl->nWorkers == 1) {
+            sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
+                ppsl->name, ppsl->overruns);
+            printList(&ppsl->scan_list, message);
+            printStats(ppsl);
+        }
+        else {
+            int w;
+
+            for (w = 0; w < ppsl->nWorkers; w++) {
+                sprintf(message, "Records with SCAN = '%s' worker %d/%d "
+                    "(%lu over-runs):", ppsl->name, w + 1, ppsl->nWorkers,
+                    ppsl[w].overruns);
+                printList(&ppsl[w].scan_list, message);
+                printStats(&ppsl[w]);
+            }
+        }
     }
     return 0;
 }
 
+int scanPeriodicThreads(int count, const char *rate)
+{
+    dbMenu *pmenu;
+    int nChoice;
+    int i;
+
+    if (papPeriodic) {
+        fprintf(stderr, "scanPeriodicThreads: "
+            "dbScan subsystem already initialized\n");
+        return -1;
+    }
+    if (!pdbbase) {
+        fprintf(stderr, "scanPeriodicThreads: pdbbase not set\n");
+        return -1;
+    }
+    pmenu = dbFindMenu(pdbbase, "menuScan");
+    if (!pmenu) {
+        fprintf(stderr, "scanPeriodicThreads: menuScan not present\n");
+        return -1;
+    }
+    nChoice = pmenu->nChoice - SCAN_1ST_PERIODIC;
+    if (nChoice <= 0)
+        return 0;
+
+    if (count <= 0)
+        count = epicsThreadGetCPUs() + count;
+    if (count < 1) count = 1;
+
+    if (!periodicThreadsConfigured)
+        periodicThreadsConfigured = dbCalloc(nChoice, sizeof(int));
+
+    if (!rate || *rate == 0 || strcmp(rate, "*") == 0) {
+        for (i = 0; i < nChoice; i++)
+            periodicThreadsConfigured[i] = count;
+        return 0;
+    }
+
+    for (i = 0; i < nChoice; i++) {
+        if (epicsStrCaseCmp(rate,
+                pmenu->papChoiceValue[i + SCAN_1ST_PERIODIC]) == 0) {
+            periodicThreadsConfigured[i] = count;
+            return 0;
+        }
+    }
+    fprintf(stderr, "scanPeriodicThreads: "
+        "Unknown periodic scan rate \"%s\"\n", rate);
+    return -1;
+}
+
 int scanpel(const char* eventname)   /* print event list */
 {
     char message[80];
@@ -453,7 +747,7 @@ static void eventCallback(epicsCallback *pcallback)
     scan_list *psl;
 
     callbackGetUser(psl, pcallback);
-    scanList(psl);
+    scanList(psl, NULL);
 }
 
 static void eventOnce(void *arg)
@@ -638,7 +932,7 @@ unsigned int scanIoImmediate(IOSCANPVT piosh, int prio)
     if (ellCount(&piosl->scan_list.list) == 0)
         return 0;
 
-    scanList(&piosl->scan_list);
+    scanList(&piosl->scan_list, NULL);
 
     if (piosh->cb)
         piosh->cb(piosh->arg, piosh, prio);
@@ -663,9 +957,29 @@ typedef struct {
     void *usr;
 } onceEntry;
 
+static once_worker *onceWorker(struct dbCommon *precord)
+{
+    dbCommonPvt *ppvt;
+    int w;
+
+    if (nOnceWorkers <= 1 || !precord->lset)
+        return onceWorkers;
+    ppvt = dbRec2Pvt(precord);
+    w = epicsAtomicGetIntT(&ppvt->onceWorker);
+    if (!w) {
+        int mine = (int)(dbLockGetLockId(precord) % nOnceWorkers) + 1;
+
+        w = epicsAtomicCmpAndSwapIntT(&ppvt->onceWorker, 0, mine);
+        if (!w)
+            w = mine;
+    }
+    return &onceWorkers[w - 1];
+}
+
 int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
 {
     static int newOverflow = TRUE;
+    once_worker *pw = onceWorker(precord);
     onceEntry ent;
     int pushOK;
 
@@ -673,31 +987,66 @@ int scanOnceCallback(struct dbCommon *precord, once_complete cb, void *usr)
     ent.cb = cb;
     ent.usr = usr;
 
-    pushOK = epicsRingBytesPut(onceQ, (void*)&ent, sizeof(ent));
+    if (onceCoalesce) {
+        dbCommonPvt *ppvt = dbRec2Pvt(precord);
+
+        /* A queued entry processes the record after this request, only
+         * requests with a callback need their own entry.  The worker
+         * decrements oncePending before processing, so a request which
+         * sees it non-zero is always followed by a dbProcess().
+         */
+        if (cb)
+            epicsAtomicIncrIntT(&ppvt->oncePending);
+        else if (epicsAtomicCmpAndSwapIntT(&ppvt->oncePending, 0, 1) != 0) {
+            epicsAtomicIncrIntT(&pw->suppressed);
+            return 0;
+        }
+        pushOK = epicsRingBytesPut(pw->queue, (void*)&ent, sizeof(ent));
+        if (!pushOK)
+            epicsAtomicDecrIntT(&ppvt->oncePending);
+    }
+    else
+        pushOK = epicsRingBytesPut(pw->queue, (void*)&ent, sizeof(ent));
 
     if (!pushOK) {
         if (newOverflow) errlogPrintf("scanOnce: Ring buffer overflow\n");
         newOverflow = FALSE;
-        epicsAtomicIncrIntT(&onceQOverruns);
+        epicsAtomicIncrIntT(&pw->overruns);
     } else {
         newOverflow = TRUE;
     }
-    epicsEventSignal(onceSem);
+    epicsEventSignal(pw->sem);
 
     return !pushOK;
 }
 
+static void onceExit(once_worker *pw)
+{
+    onceEntry ent;
+
+    ent.prec = (struct dbCommon *)&exitOnce;
+    ent.cb = NULL;
+    ent.usr = NULL;
+    while (!epicsRingBytesPut(pw->queue, (void*)&ent, sizeof(ent))) {
+        epicsEventSignal(pw->sem);
+        epicsThreadSleep(epicsThreadSleepQuantum());
+    }
+    epicsEventSignal(pw->sem);
+}
+
 static void onceTask(void *arg)
 {
+    once_worker *pw = (once_worker *)arg;
+
     taskwdInsert(0, NULL, NULL);
     epicsEventSignal(startStopEvent);
 
     while (TRUE) {
 
-        epicsEventMustWait(onceSem);
+        epicsEventMustWait(pw->sem);
         while(1) {
             onceEntry ent;
-            int bytes = epicsRingBytesGet(onceQ, (void*)&ent, sizeof(ent));
+            int bytes = epicsRingBytesGet(pw->queue, (void*)&ent, sizeof(ent));
             if(bytes==0)
                 break;
             if(bytes!=sizeof(ent)) {
@@ -706,6 +1055,9 @@ static void onceTask(void *arg)
                 continue; /* what to do? */
             } else if (ent.prec == (void*)&exitOnce) goto shutdown;
 
+            if (onceCoalesce)
+                epicsAtomicDecrIntT(&dbRec2Pvt(ent.prec)->oncePending);
+
             dbScanLock(ent.prec);
             dbProcess(ent.prec);
             dbScanUnlock(ent.prec);
@@ -725,57 +1077,188 @@ int scanOnceSetQueueSize(int size)
     return 0;
 }
 
-int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result)
+int scanOnceSetCoalesce(int enable)
+{
+    onceCoalesceConfig = enable;
+    return 0;
+}
+
+int scanOnceSetThreads(int count)
+{
+    if (onceWorkers) {
+        fprintf(stderr, "scanOnceSetThreads: "
+            "dbScan subsystem already initialized\n");
+        return -1;
+    }
+    if (count <= 0)
+        count = epicsThreadGetCPUs() + count;
+    if (count < 1) count = 1;
+    onceThreadsConfig = count;
+    return 0;
+}
+
+static void workerStatus(once_worker *pw, const int reset,
+    scanOnceQueueStats *result)
 {
-    int ret;
-    if (!onceQ) return -1;
     if (result) {
-        result->size = epicsRingBytesSize(onceQ) / sizeof(onceEntry);
-        result->numUsed = epicsRingBytesUsedBytes(onceQ) / sizeof(onceEntry);
-        result->maxUsed = epicsRingBytesHighWaterMark(onceQ) / sizeof(onceEntry);
-        result->numOverflow = epicsAtomicGetIntT(&onceQOverruns);
-        ret = 0;
-    } else {
-        ret = -2;
+        result->size += epicsRingBytesSize(pw->queue) / sizeof(onceEntry);
+        result->numUsed += epicsRingBytesUsedBytes(pw->queue) / sizeof(onceEntry);
+        result->maxUsed += epicsRingBytesHighWaterMark(pw->queue) / sizeof(onceEntry);
+        result->numOverflow += epicsAtomicGetIntT(&pw->overruns);
+        result->numSuppressed += epicsAtomicGetIntT(&pw->suppressed);
     }
     if (reset) {
-        epicsRingBytesResetHighWaterMark(onceQ);
+        epicsRingBytesResetHighWaterMark(pw->queue);
+    }
+}
+
+int scanOnceWorkerStatus(int worker, const int reset,
+    scanOnceQueueStats *result)
+{
+    int i;
+
+    if (!onceWorkers) return -1;
+    if (worker >= nOnceWorkers) return -1;
+    if (result)
+        memset(result, 0, sizeof(*result));
+    for (i = 0; i < nOnceWorkers; i++) {
+        if (worker < 0 || i == worker)
+            workerStatus(&onceWorkers[i], reset, result);
     }
-    return ret;
+    return result ? 0 : -2;
+}
+
+int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result)
+{
+    return scanOnceWorkerStatus(-1, reset, result);
+}
+
+static void showStats(const char *name, const scanOnceQueueStats *pstats)
+{
+    double qusage = 100.0 * pstats->numUsed / pstats->size;
+
+    printf("%8s  %15d  %10d  %6d  %6.1f  %11d", name, pstats->maxUsed,
+           pstats->numUsed, pstats->size, qusage, pstats->numOverflow);
+    if (onceCoalesce)
+        printf("  %10d", pstats->numSuppressed);
+    printf("\n");
 }
 
 void scanOnceQueueShow(const int reset)
 {
     scanOnceQueueStats stats;
-    if (scanOnceQueueStatus(reset, &stats) == -1) {
+    int i;
+
+    if (scanOnceQueueStatus(0, &stats) == -1) {
         fprintf(stderr, "scanOnce system not initialized, yet. Please run "
             "iocInit before using this command.\n");
-    } else {
-        double qusage = 100.0 * stats.numUsed / stats.size;
-        printf("PRIORITY  HIGH-WATER MARK  ITEMS IN Q  Q SIZE  %% USED  Q OVERFLOWS\n");
-        printf("%8s  %15d  %10d  %6d  %6.1f  %11d\n", "scanOnce", stats.maxUsed,
-               stats.numUsed, stats.size, qusage,
-               epicsAtomicGetIntT(&onceQOverruns));
+        return;
+    }
+    printf("PRIORITY  HIGH-WATER MARK  ITEMS IN Q  Q SIZE  %% USED  Q OVERFLOWS%s\n",
+           onceCoalesce ? "  DUPLICATES" : "");
+    if (nOnceWorkers > 1) {
+        for (i = 0; i < nOnceWorkers; i++) {
+            char name[24];
+
+            sprintf(name, "worker%d", i);
+            scanOnceWorkerStatus(i, 0, &stats);
+            showStats(name, &stats);
+        }
+        scanOnceQueueStatus(0, &stats);
     }
+    showStats("scanOnce", &stats);
+    if (reset)
+        scanOnceQueueStatus(reset, NULL);
 }
 
 static void initOnce(void)
 {
-    if ((onceQ = epicsRingBytesLockedCreate(sizeof(onceEntry)*onceQueueSize)) == NULL) {
-        cantProceed("initOnce: Ring buffer create failed\n");
+    int i;
+
+    onceCoalesce = onceCoalesceConfig;
+    nOnceWorkers = onceThreadsConfig;
+    onceWorkers = dbCalloc(nOnceWorkers, sizeof(once_worker));
+    for (i = 0; i < nOnceWorkers; i++) {
+        once_worker *pw = &onceWorkers[i];
+        char name[24];
+
+        if ((pw->queue = epicsRingBytesLockedCreate(sizeof(onceEntry)*onceQueueSize)) == NULL) {
+            cantProceed("initOnce: Ring buffer create failed\n");
+        }
+        pw->sem = epicsEventMustCreate(epicsEventEmpty);
+        if (nOnceWorkers > 1)
+            sprintf(name, "scanOnce-%d", i);
+        else
+            strcpy(name, "scanOnce");
+        pw->taskId = epicsThreadCreate(name,
+            epicsThreadPriorityScanLow + nPeriodic,
+            epicsThreadGetStackSize(epicsThreadStackBig), onceTask, pw);
+
+        epicsEventWait(startStopEvent);
     }
-    if(!onceSem)
-        onceSem = epicsEventMustCreate(epicsEventEmpty);
-    onceTaskId = epicsThreadCreate("scanOnce",
-        epicsThreadPriorityScanLow + nPeriodic,
-        epicsThreadGetStackSize(epicsThreadStackBig), onceTask, 0);
+}
 
-    epicsEventWait(startStopEvent);
+/* Account for one pass through the list.  jitter is how late it started,
+ * exec how long it took.
+ */
+static void periodicStats(periodic_scan_list *ppsl, double jitter,
+    double exec, const scan_timing *ptiming)
+{
+    int bin = (int) (exec * 10 / ppsl->period);
+
+    if (bin < 0)
+        bin = 0;
+    else if (bin >= SCAN_PERIODIC_NBINS)
+        bin = SCAN_PERIODIC_NBINS - 1;
+
+    epicsMutexMustLock(ppsl->scan_list.lock);
+    if (!ppsl->cycles || exec < ppsl->execMin)
+        ppsl->execMin = exec;
+    if (exec > ppsl->execMax)
+        ppsl->execMax = exec;
+    ppsl->execLast = exec;
+    ppsl->execSum += exec;
+    ppsl->execHist[bin]++;
+    ppsl->jitterLast = jitter;
+    if (jitter < 0)
+        jitter = -jitter;
+    if (jitter > ppsl->jitterMax)
+        ppsl->jitterMax = jitter;
+    ppsl->jitterSum += jitter;
+    ppsl->slowest = ptiming->slowest;
+    ppsl->slowestTime = ptiming->slowestTime * 1e-9;
+    ppsl->cycles++;
+    epicsMutexUnlock(ppsl->scan_list.lock);
 }
-
+
+static void monotonicStamp(epicsTimeStamp *pstamp, epicsUInt64 ns)
+{
+    pstamp->secPastEpoch = ns / 1000000000u;
+    pstamp->nsec = ns % 1000000000u;
+}
+
+/* Wait until the monotonic clock reaches deadline, or the thread is told
+ * to exit.  Timed waits are relative and may use another clock, so if a
+ * wait ends early it is repeated for the remainder.
+ */
+static void waitDeadline(periodic_scan_list *ppsl, epicsUInt64 deadline)
+{
+    while (ppsl->scanCtl != ctlExit) {
+        epicsUInt64 now = epicsMonotonicGet();
+
+        if (now >= deadline ||
+            epicsEventWaitWithTimeout(ppsl->loopEvent,
+                (deadline - now) * 1e-9) == epicsEventOK)
+            break;
+    }
+}
+
 static void periodicTask(void *arg)
 {
     periodic_scan_list *ppsl = (periodic_scan_list *)arg;
+    const int aligned = dbScanDeadline;
+    const epicsUInt64 periodNs = (epicsUInt64) (ppsl->period * 1e9 + 0.5);
+    epicsUInt64 deadline = 0;
     epicsTimeStamp next, reported;
     unsigned int overruns = 0;
     double report_delay = OVERRUN_REPORT_DELAY;
@@ -783,21 +1266,45 @@ static void periodicTask(void *arg)
     double over_min = 0.0;
     double over_max = 0.0;
     const double penalty = (ppsl->period >= 2) ? 1 : (ppsl->period / 2);
+    char worker[24] = "";
+
+    if (ppsl->nWorkers > 1)
+        sprintf(worker, " %d/%d", ppsl->worker + 1, ppsl->nWorkers);
 
     taskwdInsert(0, NULL, NULL);
     epicsEventSignal(startStopEvent);
 
     epicsTimeGetMonotonic(&next);
     reported = next;
+    if (aligned) {
+        deadline = epicsMonotonicGet();
+        if (dbScanEpoch)    /* first multiple of the period from the epoch */
+            deadline += (periodNs - (deadline + epochOffset) % periodNs) %
+                periodNs;
+        monotonicStamp(&next, deadline);
+    }
 
     while (ppsl->scanCtl != ctlExit) {
         double delay;
         epicsTimeStamp now;
 
-        if (ppsl->scanCtl == ctlRun)
-            scanList(&ppsl->scan_list);
+        if (ppsl->scanCtl == ctlRun) {
+            scan_timing timing = {NULL, 0};
+            epicsTimeStamp start;
 
-        epicsTimeAddSeconds(&next, ppsl->period);
+            epicsTimeGetMonotonic(&start);
+            scanList(&ppsl->scan_list, &timing);
+            epicsTimeGetMonotonic(&now);
+            periodicStats(ppsl, epicsTimeDiffInSeconds(&start, &next),
+                epicsTimeDiffInSeconds(&now, &start), &timing);
+        }
+
+        if (aligned) {
+            deadline += periodNs;
+            monotonicStamp(&next, deadline);
+        }
+        else
+            epicsTimeAddSeconds(&next, ppsl->period);
         epicsTimeGetMonotonic(&now);
         delay = epicsTimeDiffInSeconds(&next, &now);
         if (delay <= 0.0) {
@@ -811,17 +1318,30 @@ static void periodicTask(void *arg)
                 if (over_max + delay < 0)
                     over_max = -delay;
             }
-            delay = penalty;
             ppsl->overruns++;
-            next = now;
-            epicsTimeAddSeconds(&next, delay);
+            if (aligned) {
+                /* Skip every deadline already passed */
+                epicsUInt64 late = (epicsUInt64) now.secPastEpoch *
+                    1000000000u + now.nsec - deadline;
+                epicsUInt64 missed = late / periodNs + 1;
+
+                deadline += missed * periodNs;
+                ppsl->skipped += missed;
+                monotonicStamp(&next, deadline);
+                delay = epicsTimeDiffInSeconds(&next, &now);
+            }
+            else {
+                delay = penalty;
+                next = now;
+                epicsTimeAddSeconds(&next, delay);
+            }
             if (++overruns >= 10 &&
                 epicsTimeDiffInSeconds(&now, &reported) > report_delay) {
-                errlogPrintf("\ndbScan warning from '%s' scan thread:\n"
+                errlogPrintf("\ndbScan warning from '%s' scan thread%s:\n"
                     "\tScan processing averages %.3f seconds (%.3f .. %.3f).\n"
                     "\tOver-runs have now happened %u times in a row.\n"
                     "\tTo fix this, move some records to a slower scan rate.\n",
-                    ppsl->name, ppsl->period + overtime / overruns,
+                    ppsl->name, worker, ppsl->period + overtime / overruns,
                     ppsl->period + over_min, ppsl->period + over_max, overruns);
 
                 reported = now;
@@ -837,7 +1357,10 @@ static void periodicTask(void *arg)
             overtime = 0.0;
         }
 
-        epicsEventWaitWithTimeout(ppsl->loopEvent, delay);
+        if (aligned)
+            waitDeadline(ppsl, deadline);
+        else
+            epicsEventWaitWithTimeout(ppsl->loopEvent, delay);
     }
 
     taskwdRemove(0);
@@ -855,15 +1378,29 @@ static void initPeriodic(void)
         errlogPrintf("initPeriodic: menuScan not present\n");
         return;
     }
+    if (dbScanEpoch == 2) {
+        epicsTimeStamp now;
+
+        epicsTimeGetCurrent(&now);
+        epochOffset = (epicsUInt64) now.secPastEpoch * 1000000000u +
+            now.nsec - epicsMonotonicGet();
+    }
+    else
+        epochOffset = 0u - epicsMonotonicGet();
     nPeriodic = pmenu->nChoice - SCAN_1ST_PERIODIC;
     papPeriodic = dbCalloc(nPeriodic, sizeof(periodic_scan_list*));
-    periodicTaskId = dbCalloc(nPeriodic, sizeof(void *));
     for (i = 0; i < nPeriodic; i++) {
-        periodic_scan_list *ppsl = dbCalloc(1, sizeof(periodic_scan_list));
+        int nWorkers = periodicThreadsConfigured ?
+            periodicThreadsConfigured[i] : 1;
+        periodic_scan_list *ppsl;
         const char *choice = pmenu->papChoiceValue[i + SCAN_1ST_PERIODIC];
         double number;
         char *unit;
         int status = epicsParseDouble(choice, &number, &unit);
+        int w;
+
+        if (nWorkers < 1) nWorkers = 1;
+        ppsl = dbCalloc(nWorkers, sizeof(periodic_scan_list));
 
         if (status || number <= 0) {
             errlogPrintf("initPeriodic: Bad menuScan choice '%s'\n", choice);
@@ -893,11 +1430,18 @@ static void initPeriodic(void)
             continue;
         }
 
-        ppsl->scan_list.lock = epicsMutexMustCreate();
-        ellInit(&ppsl->scan_list.list);
-        ppsl->name = choice;
-        ppsl->scanCtl = ctlPause;
-        ppsl->loopEvent = epicsEventMustCreate(epicsEventEmpty);
+        for (w = 0; w < nWorkers; w++) {
+            periodic_scan_list *pworker = &ppsl[w];
+
+            pworker->scan_list.lock = epicsMutexMustCreate();
+            ellInit(&pworker->scan_list.list);
+            pworker->period = ppsl->period;
+            pworker->name = choice;
+            pworker->scanCtl = ctlPause;
+            pworker->loopEvent = epicsEventMustCreate(epicsEventEmpty);
+            pworker->worker = w;
+            pworker->nWorkers = nWorkers;
+        }
 
         number = ppsl->period / quantum;
         if ((ppsl->period < 2 * quantum) ||
@@ -916,11 +1460,14 @@ static void deletePeriodic(void)
 
     for (i = 0; i < nPeriodic; i++) {
         periodic_scan_list *ppsl = papPeriodic[i];
+        int w;
 
         if (!ppsl) continue;
-        ellFree(&ppsl->scan_list.list);
-        epicsEventDestroy(ppsl->loopEvent);
-        epicsMutexDestroy(ppsl->scan_list.lock);
+        for (w = 0; w < ppsl->nWorkers; w++) {
+            ellFree(&ppsl[w].scan_list.list);
+            epicsEventDestroy(ppsl[w].loopEvent);
+            epicsMutexDestroy(ppsl[w].scan_list.lock);
+        }
         free(ppsl);
     }
 
@@ -931,17 +1478,35 @@ static void deletePeriodic(void)
 static void spawnPeriodic(int ind)
 {
     periodic_scan_list *ppsl = papPeriodic[ind];
-    char taskName[20];
+    char taskName[32];
+    int w;
 
     if (!ppsl) return;
 
-    sprintf(taskName, "scan-%g", ppsl->period);
-    periodicTaskId[ind] = epicsThreadCreate(
-        taskName, epicsThreadPriorityScanLow + ind,
-        epicsThreadGetStackSize(epicsThreadStackBig),
-        periodicTask, (void *)ppsl);
+    for (w = 0; w < ppsl->nWorkers; w++) {
+        if (ppsl->nWorkers > 1)
+            sprintf(taskName, "scan-%g-%d", ppsl->period, w);
+        else
+            sprintf(taskName, "scan-%g", ppsl->period);
+        ppsl[w].taskId = epicsThreadCreate(
+            taskName, epicsThreadPriorityScanLow + ind,
+            epicsThreadGetStackSize(epicsThreadStackBig),
+            periodicTask, (void *)&ppsl[w]);
 
-    epicsEventWait(startStopEvent);
+        epicsEventWait(startStopEvent);
+    }
+}
+
+/* Select the member of a periodic group which scans precord.
+ * Records in the same lock set always map to the same member, records
+ * whose lock set is merged into another are moved by scanLockSetMoved().
+ */
+static periodic_scan_list *periodicWorker(periodic_scan_list *ppsl,
+    struct dbCommon *precord)
+{
+    if (ppsl->nWorkers <= 1 || !precord->lset)
+        return ppsl;
+    return &ppsl[dbLockGetLockId(precord) % ppsl->nWorkers];
 }
 
 static void ioscanCallback(epicsCallback *pcallback)
@@ -951,7 +1516,7 @@ static void ioscanCallback(epicsCallback *pcallback)
 
     callbackGetUser(piosh, pcallback);
     callbackGetPriority(prio, pcallback);
-    scanList(&piosh->iosl[prio].scan_list);
+    scanList(&piosh->iosl[prio].scan_list, NULL);
     if (piosh->cb)
         piosh->cb(piosh->arg, piosh, prio);
 }
@@ -981,7 +1546,7 @@ static void printList(scan_list *psl, char *message)
     }
 }
 
-static void scanList(scan_list *psl)
+static void scanList(scan_list *psl, scan_timing *ptiming)
 {
     /* When reading this code remember that the call to dbProcess can result
      * in the SCAN field being changed in an arbitrary number of records.
@@ -990,6 +1555,10 @@ static void scanList(scan_list *psl)
     scan_element *pse;
     scan_element *prev = NULL;
     scan_element *next = NULL;
+    epicsUInt64 start = 0;
+
+    if (ptiming)
+        start = epicsMonotonicGet();
 
     epicsMutexMustLock(psl->lock);
     psl->modified = FALSE;
@@ -1004,6 +1573,17 @@ static void scanList(scan_list *psl)
         dbProcess(precord);
         dbScanUnlock(precord);
 
+        if (ptiming) {
+            /* includes waiting for the lock, it delays the list all the same */
+            epicsUInt64 done = epicsMonotonicGet();
+
+            if (!ptiming->slowest || done - start > ptiming->slowestTime) {
+                ptiming->slowest = precord;
+                ptiming->slowestTime = done - start;
+            }
+            start = done;
+        }
+
         epicsMutexMustLock(psl->lock);
         if (!psl->modified) {
             prev = pse;
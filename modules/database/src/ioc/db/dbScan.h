@@ -33,6 +33,17 @@ extern "C" {
 #define MAX_PHASE           SHRT_MAX
 #define MIN_PHASE           SHRT_MIN
 
+/* Non-zero to schedule periodic scans by absolute deadlines on the
+ * monotonic clock.  The deadlines of a rate are multiples of its period,
+ * a pass that would start after its deadline is skipped.  Read by iocInit.
+ */
+epicsShareExtern int dbScanDeadline;
+/* Where the deadlines start from: 0 when each scan thread starts, 1 at
+ * iocInit so that all rates are in phase, 2 at the EPICS epoch of the
+ * system clock so that IOCs with synchronized clocks are in phase.
+ */
+epicsShareExtern int dbScanEpoch;
+
 /*definitions for I/O Interrupt Scanning */
 /* IOSCANPVT now defined in devSup.h */
 typedef struct event_list *EVENTPVT;
@@ -47,8 +58,36 @@ typedef struct scanOnceQueueStats {
     int numUsed;
     int maxUsed;
     int numOverflow;
+    int numSuppressed;  /* requests merged into a queued one */
 } scanOnceQueueStats;
 
+/* Number of execution time bins in scanPeriodicStats */
+#define SCAN_PERIODIC_NBINS 11
+
+typedef struct scanPeriodicStats {
+    double period;          /* seconds */
+    int nWorkers;           /* threads scanning this rate */
+    unsigned long cycles;   /* scan passes completed */
+    unsigned long overruns;
+    unsigned long skipped;  /* deadlines missed, see dbScanDeadline */
+    /* Start time deviation from the schedule, seconds.  Avg and max are
+     * of the absolute deviation */
+    double jitterLast;
+    double jitterAvg;
+    double jitterMax;
+    /* Time to process the whole list, seconds */
+    double execLast;
+    double execAvg;
+    double execMin;
+    double execMax;
+    /* execHist[i] counts passes taking from i*10% up to (i+1)*10% of the
+     * period, the last bin those taking the whole period or longer */
+    unsigned long execHist[SCAN_PERIODIC_NBINS];
+    /* Slowest record in the last pass and its time in seconds */
+    char slowest[61];
+    double slowestTime;
+} scanPeriodicStats;
+
 epicsShareFunc long scanInit(void);
 epicsShareFunc void scanRun(void);
 epicsShareFunc void scanPause(void);
@@ -60,16 +99,31 @@ epicsShareFunc void postEvent(EVENTPVT epvt);
 epicsShareFunc void post_event(int event);
 epicsShareFunc void scanAdd(struct dbCommon *);
 epicsShareFunc void scanDelete(struct dbCommon *);
+epicsShareFunc void scanLockSetMoved(struct dbCommon *);
 epicsShareFunc double scanPeriod(int scan);
 epicsShareFunc int scanOnce(struct dbCommon *);
 epicsShareFunc int scanOnceCallback(struct dbCommon *, once_complete cb, void *usr);
 epicsShareFunc int scanOnceSetQueueSize(int size);
+/*don't queue a record again while it's waiting in the queue, before iocInit*/
+epicsShareFunc int scanOnceSetCoalesce(int enable);
 epicsShareFunc int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result);
+/*number of scanOnce threads, before iocInit*/
+epicsShareFunc int scanOnceSetThreads(int count);
+/*statistics of one scanOnce thread's queue, or of all if worker < 0*/
+epicsShareFunc int scanOnceWorkerStatus(int worker, const int reset,
+    scanOnceQueueStats *result);
 epicsShareFunc void scanOnceQueueShow(const int reset);
 
 /*print periodic lists*/
 epicsShareFunc int scanppl(double rate);
 
+/*statistics of a periodic scan rate, worker < 0 for all its threads*/
+epicsShareFunc int scanPeriodicStatus(const char *rate, int worker,
+    const int reset, scanPeriodicStats *result);
+
+/*configure parallel periodic scan threads, before iocInit*/
+epicsShareFunc int scanPeriodicThreads(int count, const char *rate);
+
 /*print event lists*/
 epicsShareFunc int scanpel(const char *event_name);
 
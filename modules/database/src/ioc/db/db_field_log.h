@@ -81,6 +81,9 @@ struct dbfl_val {
  * db_delete_field_log().  Any code which changes a dbfl_type_ref
  * field log to another type, or to reference different data,
  * must explicitly call the dtor function.
+ * The referenced data must be treated as read-only, it may be a snapshot
+ * shared with the field logs of other subscriptions (see
+ * dbChannelShareArrayCopy()).
  */
 struct dbfl_ref {
     dbfl_freeFunc     *dtor;  /* Callback to free filter-allocated resources */
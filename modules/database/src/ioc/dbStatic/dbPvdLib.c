@@ -15,32 +15,90 @@
 #include <string.h>
 
 #include "dbDefs.h"
-#include "ellLib.h"
+#include "epicsAtomic.h"
 #include "epicsMutex.h"
 #include "epicsStdio.h"
 #include "epicsString.h"
+#include "epicsTypes.h"
 
 #define epicsExportSharedSymbols
 #include "dbBase.h"
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
 
-typedef struct {
-    ELLLIST      list;
-    epicsMutexId lock;
-} dbPvdBucket;
-
-typedef struct dbPvd {
+/*
+ * The directory is an open-addressing hash table with linear probing.
+ * Writers are serialized by a mutex, readers take no lock at all:
+ * an entry or table is completely filled in before it is published
+ * with a single pointer store, and anything a reader might still see
+ * is not freed until the readers which might have seen it are done.
+ * Readers announce themselves on one of several padded counters to
+ * limit contention.
+ *
+ * Reclamation uses grace periods.  Each reader counter has two halves,
+ * a reader counts itself in the half of the current phase.  Memory is
+ * tagged with the phase it was retired in.  A writer only advances the
+ * phase once the readers of the previous phase have left, so memory
+ * retired in phase p is unreachable once the phase reaches p+2.  Under
+ * steady lookups the old half still drains, unlike waiting for an
+ * instant with no readers at all.
+ *
+ * An optional counting Bloom filter over all names lets most lookups
+ * of names which don't exist return without probing the table.
+ */
+
+typedef struct dbPvdTable {
     unsigned int size;
     unsigned int mask;
-    dbPvdBucket **buckets;
+    PVDENTRY *slots[1];     /* size entries */
+} dbPvdTable;
+
+typedef struct dbPvdRetired {
+    struct dbPvdRetired *next;
+    void *mem;
+    int phase;              /* when it was retired */
+} dbPvdRetired;
+
+typedef struct dbPvdFilter {
+    unsigned int mask;
+    unsigned int capacity;  /* entries it was sized for */
+    epicsUInt8 counts[1];   /* mask + 1 entries, saturating */
+} dbPvdFilter;
+
+#define FILTER_PROBES 4
+
+#define NREADERS 8
+
+typedef union dbPvdReaders {
+    struct {
+        int active[2];      /* readers in even and odd phases */
+        size_t rejected;    /* filter hits */
+        size_t passed;      /* filter misses */
+        size_t falsePositive;
+    } s;
+    char pad[64];           /* keep counters on separate cache lines */
+} dbPvdReaders;
+
+typedef struct dbPvd {
+    dbPvdTable *table;
+    dbPvdFilter *filter;    /* NULL unless enabled */
+    unsigned int used;      /* live entries */
+    unsigned int deleted;   /* tombstones */
+    epicsMutexId lock;
+    dbPvdRetired *retired;  /* newest first */
+    int phase;              /* only changed by writers */
+    dbPvdReaders readers[NREADERS];
 } dbPvd;
 
+/* Marks a deleted slot, which lookups must probe past */
+static PVDENTRY deletedEntry;
+#define DELETED (&deletedEntry)
+
 unsigned int dbPvdHashTableSize = 0;
+unsigned int dbPvdFilterCounters = 0;
 
 #define MIN_SIZE 256
 #define DEFAULT_SIZE 512
-#define MAX_SIZE 65536
 
 
 int dbPvdTableSize(int size)
@@ -53,13 +111,31 @@ int dbPvdTableSize(int size)
     if (size < MIN_SIZE)
         size = MIN_SIZE;
 
-    if (size > MAX_SIZE)
-        size = MAX_SIZE;
-
     dbPvdHashTableSize = size;
     return 0;
 }
 
+int dbPvdFilterSize(int countersPerName)
+{
+    if (countersPerName < 0) {
+        printf("dbPvdFilterSize: %d is negative\n", countersPerName);
+        return -1;
+    }
+
+    dbPvdFilterCounters = countersPerName;
+    return 0;
+}
+
+static dbPvdTable *pvdTableCreate(unsigned int size)
+{
+    dbPvdTable *ptab = dbCalloc(1, sizeof(dbPvdTable) +
+        (size - 1) * sizeof(PVDENTRY *));
+
+    ptab->size = size;
+    ptab->mask = size - 1;
+    return ptab;
+}
+
 void dbPvdInitPvt(dbBase *pdbbase)
 {
     dbPvd *ppvd;
@@ -70,130 +146,366 @@ void dbPvdInitPvt(dbBase *pdbbase)
         dbPvdHashTableSize = DEFAULT_SIZE;
     }
 
-    ppvd = (dbPvd *)dbMalloc(sizeof(dbPvd));
-    ppvd->size    = dbPvdHashTableSize;
-    ppvd->mask    = dbPvdHashTableSize - 1;
-    ppvd->buckets = dbCalloc(ppvd->size, sizeof(dbPvdBucket *));
+    ppvd = dbCalloc(1, sizeof(dbPvd));
+    ppvd->table = pvdTableCreate(dbPvdHashTableSize);
+    ppvd->lock = epicsMutexMustCreate();
 
     pdbbase->ppvd = ppvd;
     return;
 }
 
-PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
+static PVDENTRY *pvdLookup(const dbPvdTable *ptab, unsigned int hash,
+    const char *name, size_t lenName)
+{
+    unsigned int i = hash & ptab->mask;
+
+    for (;;) {
+        PVDENTRY *ppvdNode = ((PVDENTRY * volatile *) ptab->slots)[i];
+
+        if (!ppvdNode)
+            return NULL;
+        if (ppvdNode != DELETED && ppvdNode->hash == hash &&
+            strncmp(name, ppvdNode->name, lenName) == 0 &&
+            ppvdNode->name[lenName] == 0)
+            return ppvdNode;
+        i = (i + 1) & ptab->mask;
+    }
+}
+
+static void pvdRetire(dbPvd *ppvd, void *mem)
+{
+    dbPvdRetired *pret = dbMalloc(sizeof(dbPvdRetired));
+
+    pret->mem = mem;
+    pret->phase = ppvd->phase;
+    pret->next = ppvd->retired;
+    ppvd->retired = pret;
+}
+
+static int pvdPhaseReaders(dbPvd *ppvd, int phase)
+{
+    int i;
+
+    for (i = 0; i < NREADERS; i++) {
+        if (epicsAtomicGetIntT(&ppvd->readers[i].s.active[phase & 1]))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Caller holds the lock.  Advance the phase as far as the readers allow,
+ * then free whatever was retired two or more phases ago.
+ */
+static void pvdReclaim(dbPvd *ppvd)
+{
+    dbPvdRetired **ppret;
+    int i;
+
+    if (!ppvd->retired) return;
+
+    for (i = 0; i < 2; i++) {
+        if ((unsigned) (ppvd->phase - ppvd->retired->phase) >= 2)
+            break;
+        /* the half the next phase uses still has old readers */
+        if (pvdPhaseReaders(ppvd, ppvd->phase + 1))
+            break;
+        epicsAtomicIncrIntT(&ppvd->phase);
+    }
+
+    /* the list is newest first, once one can go so can the rest */
+    for (ppret = &ppvd->retired; *ppret; ppret = &(*ppret)->next) {
+        if ((unsigned) (ppvd->phase - (*ppret)->phase) >= 2)
+            break;
+    }
+    while (*ppret) {
+        dbPvdRetired *pret = *ppret;
+
+        *ppret = pret->next;
+        free(pret->mem);
+        free(pret);
+    }
+}
+
+unsigned int dbPvdRetiredCount(dbBase *pdbbase)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
-    PVDENTRY *ppvdNode;
-    
-    pbucket = ppvd->buckets[epicsMemHash(name, lenName, 0) & ppvd->mask];
-    if (pbucket == NULL) return NULL;
+    dbPvdRetired *pret;
+    unsigned int count = 0;
+
+    if (!ppvd) return 0;
+    epicsMutexMustLock(ppvd->lock);
+    for (pret = ppvd->retired; pret; pret = pret->next)
+        count++;
+    epicsMutexUnlock(ppvd->lock);
+    return count;
+}
+
+static void pvdInsert(dbPvdTable *ptab, PVDENTRY *ppvdNode)
+{
+    unsigned int i = ppvdNode->hash & ptab->mask;
+
+    while (ptab->slots[i] && ptab->slots[i] != DELETED)
+        i = (i + 1) & ptab->mask;
+    epicsAtomicWriteMemoryBarrier();
+    ((PVDENTRY * volatile *) ptab->slots)[i] = ppvdNode;
+}
+
+/* Double hashing, the second hash is derived from the first */
+#define FILTER_STEP(hash) \
+    ((((hash) >> 16 | (hash) << 16) * 0x9e3779b1u) | 1u)
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        const char *recordname = ppvdNode->precnode->recordname;
+static int filterTest(const dbPvdFilter *pfilter, unsigned int hash)
+{
+    const volatile epicsUInt8 *counts = pfilter->counts;
+    unsigned int step = FILTER_STEP(hash);
+    int i;
 
-        if (strncmp(name, recordname, lenName) == 0 &&
-            strlen(recordname) == lenName)
+    for (i = 0; i < FILTER_PROBES; i++, hash += step) {
+        if (!counts[hash & pfilter->mask])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void filterAdd(dbPvdFilter *pfilter, unsigned int hash)
+{
+    volatile epicsUInt8 *counts = pfilter->counts;
+    unsigned int step = FILTER_STEP(hash);
+    int i;
+
+    for (i = 0; i < FILTER_PROBES; i++, hash += step) {
+        unsigned int j = hash & pfilter->mask;
+
+        if (counts[j] < 255)
+            counts[j]++;
+    }
+}
+
+static void filterRemove(dbPvdFilter *pfilter, unsigned int hash)
+{
+    volatile epicsUInt8 *counts = pfilter->counts;
+    unsigned int step = FILTER_STEP(hash);
+    int i;
+
+    for (i = 0; i < FILTER_PROBES; i++, hash += step) {
+        unsigned int j = hash & pfilter->mask;
+
+        /* a saturated counter has lost track and must stay set */
+        if (counts[j] && counts[j] < 255)
+            counts[j]--;
+    }
+}
+
+/* Caller holds the lock.  Build a filter for twice the current number
+ * of entries and replace the old one.
+ */
+static void pvdFilterBuild(dbPvd *ppvd)
+{
+    dbPvdTable *ptab = ppvd->table;
+    dbPvdFilter *pfilter;
+    unsigned int capacity = MIN_SIZE;
+    unsigned int size = 1;
+    unsigned int i;
+
+    while (capacity < ppvd->used * 2)
+        capacity <<= 1;
+    while (size < capacity * dbPvdFilterCounters)
+        size <<= 1;
+
+    pfilter = dbCalloc(1, sizeof(dbPvdFilter) + size - 1);
+    pfilter->mask = size - 1;
+    pfilter->capacity = capacity;
+    for (i = 0; i < ptab->size; i++) {
+        PVDENTRY *ppvdNode = ptab->slots[i];
+
+        if (ppvdNode && ppvdNode != DELETED)
+            filterAdd(pfilter, ppvdNode->hash);
+    }
+    epicsAtomicWriteMemoryBarrier();
+    if (ppvd->filter)
+        pvdRetire(ppvd, ppvd->filter);
+    ppvd->filter = pfilter;
+}
+
+void dbPvdFilterInit(dbBase *pdbbase)
+{
+    dbPvd *ppvd = pdbbase->ppvd;
+
+    if (!ppvd || !dbPvdFilterCounters) return;
+
+    epicsMutexMustLock(ppvd->lock);
+    pvdFilterBuild(ppvd);
+    pvdReclaim(ppvd);
+    epicsMutexUnlock(ppvd->lock);
+}
+
+/* Rehash into a table at most half full, dropping all tombstones */
+static void pvdResize(dbPvd *ppvd)
+{
+    dbPvdTable *old = ppvd->table;
+    dbPvdTable *ptab;
+    unsigned int size = old->size;
+    unsigned int i;
+
+    while ((ppvd->used + 1) * 2 > size)
+        size <<= 1;
+    ptab = pvdTableCreate(size);
+    for (i = 0; i < old->size; i++) {
+        PVDENTRY *ppvdNode = old->slots[i];
+
+        if (ppvdNode && ppvdNode != DELETED)
+            pvdInsert(ptab, ppvdNode);
+    }
+    epicsAtomicWriteMemoryBarrier();
+    ppvd->table = ptab;
+    ppvd->deleted = 0;
+    pvdRetire(ppvd, old);
+}
+
+PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
+{
+    dbPvd *ppvd = pdbbase->ppvd;
+    unsigned int hash = epicsMemHash(name, lenName, 0);
+    dbPvdReaders *preader = &ppvd->readers[hash % NREADERS];
+    dbPvdFilter *pfilter;
+    PVDENTRY *ppvdNode;
+    int phase;
+
+    /* Count ourselves in the current phase.  If a writer advanced it
+     * meanwhile it may not have seen us, so try again.
+     */
+    for (;;) {
+        phase = epicsAtomicGetIntT(&ppvd->phase);
+        epicsAtomicIncrIntT(&preader->s.active[phase & 1]);
+        if (epicsAtomicGetIntT(&ppvd->phase) == phase)
             break;
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
+        epicsAtomicDecrIntT(&preader->s.active[phase & 1]);
     }
-    epicsMutexUnlock(pbucket->lock);
+    pfilter = ((dbPvdFilter * volatile *) &ppvd->filter)[0];
+    if (pfilter && !filterTest(pfilter, hash)) {
+        epicsAtomicIncrSizeT(&preader->s.rejected);
+        ppvdNode = NULL;
+    }
+    else {
+        ppvdNode = pvdLookup(((dbPvdTable * volatile *) &ppvd->table)[0],
+            hash, name, lenName);
+        if (pfilter) {
+            epicsAtomicIncrSizeT(&preader->s.passed);
+            if (!ppvdNode)
+                epicsAtomicIncrSizeT(&preader->s.falsePositive);
+        }
+    }
+    epicsAtomicDecrIntT(&preader->s.active[phase & 1]);
     return ppvdNode;
 }
-
+
 PVDENTRY *dbPvdAdd(dbBase *pdbbase, dbRecordType *precordType,
     dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
     PVDENTRY *ppvdNode;
     char *name = precnode->recordname;
-    unsigned int h;
+    size_t lenName = strlen(name);
+    unsigned int hash = epicsStrHash(name, 0);
 
-    h = epicsStrHash(name, 0) & ppvd->mask;
-    pbucket = ppvd->buckets[h];
-    if (pbucket == NULL) {
-        pbucket = dbCalloc(1, sizeof(dbPvdBucket));
-        ellInit(&pbucket->list);
-        pbucket->lock = epicsMutexCreate();
-        ppvd->buckets[h] = pbucket;
+    epicsMutexMustLock(ppvd->lock);
+    if (pvdLookup(ppvd->table, hash, name, lenName)) {
+        epicsMutexUnlock(ppvd->lock);
+        return NULL;
     }
+    if ((ppvd->used + ppvd->deleted + 1) * 4 > ppvd->table->size * 3)
+        pvdResize(ppvd);
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        if (strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            epicsMutexUnlock(pbucket->lock);
-            return NULL;
-        }
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
-    }
-    ppvdNode = dbCalloc(1, sizeof(PVDENTRY));
+    /* The entry keeps its own copy of the name, readers may look at
+     * it after the record node has been freed.
+     */
+    ppvdNode = dbCalloc(1, sizeof(PVDENTRY) + lenName + 1);
     ppvdNode->precordType = precordType;
     ppvdNode->precnode = precnode;
-    ellAdd(&pbucket->list, (ELLNODE *)ppvdNode);
-    epicsMutexUnlock(pbucket->lock);
+    ppvdNode->hash = hash;
+    ppvdNode->name = (char *) (ppvdNode + 1);
+    strcpy(ppvdNode->name, name);
+    if (ppvd->filter) {
+        if (ppvd->used >= ppvd->filter->capacity)
+            pvdFilterBuild(ppvd);
+        filterAdd(ppvd->filter, hash);
+    }
+    pvdInsert(ppvd->table, ppvdNode);
+    ppvd->used++;
+    pvdReclaim(ppvd);
+    epicsMutexUnlock(ppvd->lock);
     return ppvdNode;
 }
 
 void dbPvdDelete(dbBase *pdbbase, dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
-    PVDENTRY *ppvdNode;
+    dbPvdTable *ptab;
     char *name = precnode->recordname;
-
-    pbucket = ppvd->buckets[epicsStrHash(name, 0) & ppvd->mask];
-    if (pbucket == NULL) return;
-
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        if (ppvdNode->precnode &&
-            ppvdNode->precnode->recordname &&
-            strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
-            free(ppvdNode);
+    unsigned int hash;
+    unsigned int i;
+
+    if (!name) return;
+    hash = epicsStrHash(name, 0);
+
+    epicsMutexMustLock(ppvd->lock);
+    ptab = ppvd->table;
+    for (i = hash & ptab->mask; ptab->slots[i]; i = (i + 1) & ptab->mask) {
+        PVDENTRY *ppvdNode = ptab->slots[i];
+
+        if (ppvdNode != DELETED && ppvdNode->hash == hash &&
+            strcmp(name, ppvdNode->name) == 0) {
+            ((PVDENTRY * volatile *) ptab->slots)[i] = DELETED;
+            if (ppvd->filter)
+                filterRemove(ppvd->filter, hash);
+            ppvd->used--;
+            ppvd->deleted++;
+            pvdRetire(ppvd, ppvdNode);
             break;
         }
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
     }
-    epicsMutexUnlock(pbucket->lock);
+    pvdReclaim(ppvd);
+    epicsMutexUnlock(ppvd->lock);
     return;
 }
 
 void dbPvdFreeMem(dbBase *pdbbase)
 {
     dbPvd *ppvd = pdbbase->ppvd;
+    dbPvdTable *ptab;
     unsigned int h;
 
     if (ppvd == NULL) return;
     pdbbase->ppvd = NULL;
 
-    for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
-        PVDENTRY *ppvdNode;
+    epicsMutexMustLock(ppvd->lock);
+    ptab = ppvd->table;
+    for (h = 0; h < ptab->size; h++) {
+        PVDENTRY *ppvdNode = ptab->slots[h];
 
-        if (pbucket == NULL) continue;
-        epicsMutexMustLock(pbucket->lock);
-        ppvd->buckets[h] = NULL;
-        while ((ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list))) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
+        if (ppvdNode && ppvdNode != DELETED)
             free(ppvdNode);
-        }
-        epicsMutexUnlock(pbucket->lock);
-        epicsMutexDestroy(pbucket->lock);
-        free(pbucket);
     }
-    free(ppvd->buckets);
+    free(ptab);
+    free(ppvd->filter);
+    while (ppvd->retired) {
+        dbPvdRetired *pret = ppvd->retired;
+
+        ppvd->retired = pret->next;
+        free(pret->mem);
+        free(pret);
+    }
+    epicsMutexUnlock(ppvd->lock);
+    epicsMutexDestroy(ppvd->lock);
     free(ppvd);
 }
 
 void dbPvdDump(dbBase *pdbbase, int verbose)
 {
-    unsigned int empty = 0;
+    unsigned int maxProbe = 0;
+    unsigned long totalProbe = 0;
     dbPvd *ppvd;
+    dbPvdTable *ptab;
     unsigned int h;
 
     if (!pdbbase) {
@@ -203,27 +515,74 @@ void dbPvdDump(dbBase *pdbbase, int verbose)
     ppvd = pdbbase->ppvd;
     if (ppvd == NULL) return;
 
-    printf("Process Variable Directory has %u buckets", ppvd->size);
+    epicsMutexMustLock(ppvd->lock);
+    ptab = ppvd->table;
+    printf("Process Variable Directory has %u slots, %u entries, "
+        "%u deleted\n", ptab->size, ppvd->used, ppvd->deleted);
 
-    for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
-        PVDENTRY *ppvdNode;
-        int i = 1;
+    for (h = 0; h < ptab->size; h++) {
+        PVDENTRY *ppvdNode = ptab->slots[h];
+        unsigned int probe;
 
-        if (pbucket == NULL) {
-            empty++;
+        if (!ppvdNode || ppvdNode == DELETED)
             continue;
+        probe = (h - ppvdNode->hash) & ptab->mask;
+        totalProbe += probe;
+        if (probe > maxProbe)
+            maxProbe = probe;
+        if (verbose)
+            printf(" [%6u] %4u  %s\n", h, probe, ppvdNode->name);
+    }
+    printf("Probe distance: max %u, average %.2f\n", maxProbe,
+        ppvd->used ? (double) totalProbe / ppvd->used : 0.0);
+    epicsMutexUnlock(ppvd->lock);
+}
+
+void dbPvdFilterShow(dbBase *pdbbase, int reset)
+{
+    size_t rejected = 0, passed = 0, falsePositive = 0;
+    dbPvd *ppvd;
+    dbPvdFilter *pfilter;
+    int i;
+
+    if (!pdbbase) {
+        fprintf(stderr,"pdbbase not specified\n");
+        return;
+    }
+    ppvd = pdbbase->ppvd;
+    if (ppvd == NULL) return;
+
+    epicsMutexMustLock(ppvd->lock);
+    pfilter = ppvd->filter;
+    if (!pfilter) {
+        epicsMutexUnlock(ppvd->lock);
+        printf("Negative lookup filter not enabled, "
+            "use dbPvdFilterSize before iocInit\n");
+        return;
+    }
+    for (i = 0; i < NREADERS; i++) {
+        dbPvdReaders *preader = &ppvd->readers[i];
+
+        rejected += epicsAtomicGetSizeT(&preader->s.rejected);
+        passed += epicsAtomicGetSizeT(&preader->s.passed);
+        falsePositive += epicsAtomicGetSizeT(&preader->s.falsePositive);
+        if (reset) {
+            epicsAtomicSetSizeT(&preader->s.rejected, 0);
+            epicsAtomicSetSizeT(&preader->s.passed, 0);
+            epicsAtomicSetSizeT(&preader->s.falsePositive, 0);
         }
-        epicsMutexMustLock(pbucket->lock);
-        ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-        printf("\n [%4u] %4d  ", h, ellCount(&pbucket->list));
-        while (ppvdNode && verbose) {
-            if (!(++i % 4))
-                printf("\n         ");
-            printf("  %s", ppvdNode->precnode->recordname);
-            ppvdNode = (PVDENTRY *) ellNext((ELLNODE*)ppvdNode);
-        }
-        epicsMutexUnlock(pbucket->lock);
     }
-    printf("\n%u buckets empty.\n", empty);
+    printf("Negative lookup filter has %u counters for %u names "
+        "(%u present), %d probes\n",
+        pfilter->mask + 1, pfilter->capacity, ppvd->used, FILTER_PROBES);
+    epicsMutexUnlock(ppvd->lock);
+
+    printf("    %lu lookups rejected (hits), %lu passed (misses), "
+        "%lu false positives",
+        (unsigned long) rejected, (unsigned long) passed,
+        (unsigned long) falsePositive);
+    if (rejected + falsePositive)
+        printf(" (%.2f%% of absent names)",
+            100.0 * falsePositive / (rejected + falsePositive));
+    printf("\n");
 }
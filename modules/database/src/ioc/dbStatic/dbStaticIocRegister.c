@@ -150,6 +150,28 @@ static void dbPvdTableSizeCallFunc(const iocshArgBuf *args)
     dbPvdTableSize(args[0].ival);
 }
 
+/* dbPvdFilterSize */
+static const iocshArg dbPvdFilterSizeArg0 = { "counters per name",iocshArgInt};
+static const iocshArg * const dbPvdFilterSizeArgs[1] =
+    {&dbPvdFilterSizeArg0};
+static const iocshFuncDef dbPvdFilterSizeFuncDef =
+    {"dbPvdFilterSize",1,dbPvdFilterSizeArgs};
+static void dbPvdFilterSizeCallFunc(const iocshArgBuf *args)
+{
+    dbPvdFilterSize(args[0].ival);
+}
+
+/* dbPvdFilterShow */
+static const iocshArg dbPvdFilterShowArg1 = { "reset",iocshArgInt};
+static const iocshArg * const dbPvdFilterShowArgs[] = {
+    &argPdbbase,&dbPvdFilterShowArg1};
+static const iocshFuncDef dbPvdFilterShowFuncDef =
+    {"dbPvdFilterShow",2,dbPvdFilterShowArgs};
+static void dbPvdFilterShowCallFunc(const iocshArgBuf *args)
+{
+    dbPvdFilterShow(*iocshPpdbbase,args[1].ival);
+}
+
 /* dbReportDeviceConfig */
 static const iocshArg * const dbReportDeviceConfigArgs[] = {&argPdbbase};
 static const iocshFuncDef dbReportDeviceConfigFuncDef = {
@@ -175,5 +197,7 @@ void dbStaticIocRegister(void)
     iocshRegister(&dbDumpBreaktableFuncDef, dbDumpBreaktableCallFunc);
     iocshRegister(&dbPvdDumpFuncDef, dbPvdDumpCallFunc);
     iocshRegister(&dbPvdTableSizeFuncDef,dbPvdTableSizeCallFunc);
+    iocshRegister(&dbPvdFilterSizeFuncDef,dbPvdFilterSizeCallFunc);
+    iocshRegister(&dbPvdFilterShowFuncDef,dbPvdFilterShowCallFunc);
     iocshRegister(&dbReportDeviceConfigFuncDef, dbReportDeviceConfigCallFunc);
 }
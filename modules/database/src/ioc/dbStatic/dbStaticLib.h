@@ -220,6 +220,7 @@ epicsShareFunc void dbDumpVariable(DBBASE *pdbbase);
 epicsShareFunc void dbDumpBreaktable(DBBASE *pdbbase,
     const char *name);
 epicsShareFunc void dbPvdDump(DBBASE *pdbbase, int verbose);
+epicsShareFunc void dbPvdFilterShow(DBBASE *pdbbase, int reset);
 epicsShareFunc void dbReportDeviceConfig(DBBASE *pdbbase,
     FILE *report);
 
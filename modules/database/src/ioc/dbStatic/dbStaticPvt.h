@@ -93,17 +93,22 @@ typedef struct dbGuiGroup {
 /*The following are in dbPvdLib.c*/
 /*directory*/
 typedef struct{
-	ELLNODE		node;
 	dbRecordType	*precordType;
 	dbRecordNode	*precnode;
+	unsigned int	hash;
+	char		*name;	/*copy of precnode->recordname*/
 }PVDENTRY;
 epicsShareFunc int dbPvdTableSize(int size);
+epicsShareFunc int dbPvdFilterSize(int countersPerName);
+epicsShareFunc void dbPvdFilterInit(DBBASE *pdbbase);
 extern int dbStaticDebug;
 void	dbPvdInitPvt(DBBASE *pdbbase);
-PVDENTRY *dbPvdFind(DBBASE *pdbbase,const char *name,size_t lenname);
-PVDENTRY *dbPvdAdd(DBBASE *pdbbase,dbRecordType *precordType,dbRecordNode *precnode);
-void dbPvdDelete(DBBASE *pdbbase,dbRecordNode *precnode);
+epicsShareFunc PVDENTRY *dbPvdFind(DBBASE *pdbbase,const char *name,size_t lenname);
+epicsShareFunc PVDENTRY *dbPvdAdd(DBBASE *pdbbase,dbRecordType *precordType,dbRecordNode *precnode);
+epicsShareFunc void dbPvdDelete(DBBASE *pdbbase,dbRecordNode *precnode);
 void dbPvdFreeMem(DBBASE *pdbbase);
+/* Retired tables and entries not yet freed, for tests */
+epicsShareFunc unsigned int dbPvdRetiredCount(DBBASE *pdbbase);
 
 #ifdef __cplusplus
 }
@@ -51,6 +51,7 @@
 #include "dbFldTypes.h"
 #include "dbLock.h"
 #include "dbNotify.h"
+#include "dbProcStats.h"
 #include "dbScan.h"
 #include "dbServer.h"
 #include "dbStaticLib.h"
@@ -159,7 +160,9 @@ static int iocBuild_2(void)
 
     iterateRecords(prepareLinks, NULL);
 
+    dbPvdFilterInit(pdbbase);
     dbLockInitRecords(pdbbase);
+    dbProcStatsInit();
     initDatabase();
     dbBkptInit();
     initHookAnnounce(initHookAfterInitDatabase); /* used by autosave pass 1 */
@@ -23,6 +23,7 @@
 #include <stdarg.h>
 #include <limits.h>
 
+#include "epicsEndian.h"
 #include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "epicsStdio.h"
@@ -42,6 +43,7 @@
 #include "callback.h"
 #include "db_access.h"
 #include "db_access_routines.h"
+#include "db_convert.h"
 #include "dbChannel.h"
 #include "dbCommon.h"
 #include "dbEvent.h"
@@ -480,9 +482,76 @@ static void no_read_access_event ( struct client *pClient,
 }
 
 /*
- *  read_reply()
+ * read_reply_ref()
+ *
+ * Send a large array from a field log snapshot without copying it into
+ * the protocol buffer.  This is only possible when the client asks for
+ * the native type and the network representation of that type is the
+ * same as the host's.  Returns TRUE if the reply was sent.
+ *
+ * !! LOCK needs to applied by caller !!
  */
-static void read_reply ( void *pArg, struct dbChannel *dbch,
+static int read_reply_ref ( struct client *pClient,
+    struct event_ext *pevext, struct dbChannel *dbch, db_field_log *pfl )
+{
+    unsigned dataType = pevext->msg.m_dataType;
+    long item_count = pevext->msg.m_count;
+    long one = 1;
+    union db_access_val meta;
+    ca_uint32_t dataSize, payloadSize;
+
+    if ( pfl->type != dbfl_type_ref || ! pfl->u.r.field ||
+            dataType > DBR_CTRL_DOUBLE ||
+            dataType % ( LAST_TYPE + 1 ) == DBR_STRING ||
+            pfl->field_type < 0 || pfl->field_type > newDBR_ENUM ||
+            dbDBRnewToDBRold[pfl->field_type] != dataType % ( LAST_TYPE + 1 ) ||
+            dbr_value_size[dataType] != ( unsigned ) pfl->field_size ) {
+        return FALSE;
+    }
+
+    /* CA sends big endian data */
+#if EPICS_BYTE_ORDER != EPICS_ENDIAN_BIG || \
+    EPICS_FLOAT_WORD_ORDER != EPICS_ENDIAN_BIG
+    if ( pfl->field_size > 1 ) {
+        return FALSE;
+    }
+#endif
+
+    /* autosize, or no more than are available (no zero filling) */
+    if ( item_count == 0 ) {
+        item_count = pfl->no_elements;
+    }
+    if ( item_count < 1 || item_count > pfl->no_elements ) {
+        return FALSE;
+    }
+
+    /* small arrays are cheaper to copy, oversized ones get an error reply */
+    dataSize = item_count * pfl->field_size;
+    payloadSize = dbr_size_n ( dataType, item_count );
+    if ( dataSize < MAX_TCP ||
+            CA_MESSAGE_ALIGN ( payloadSize ) + sizeof ( caHdr ) +
+            2 * sizeof ( ca_uint32_t ) > rsrvSizeofLargeBufTCP ) {
+        return FALSE;
+    }
+
+    /* meta-data and the first element, converted in place */
+    if ( dbChannel_get_count ( dbch, dataType, &meta, &one, pfl ) < 0 ||
+            caNetConvert ( dataType, &meta, &meta, TRUE, 1 ) != ECA_NORMAL ) {
+        return FALSE;
+    }
+
+    return cas_send_bs_ref ( pClient, pevext->msg.m_cmmd, dataType,
+        item_count, ECA_NORMAL, pevext->msg.m_available,
+        &meta, dbr_value_offset[dataType],
+        pfl->u.r.field, dataSize, payloadSize ) == ECA_NORMAL;
+}
+
+/*
+ *  read_reply_locked()
+ *
+ *  Encode one read or subscription update, caller holds the send lock
+ */
+static void read_reply_locked ( void *pArg, struct dbChannel *dbch,
                        int eventsRemaining, db_field_log *pfl )
 {
     ca_uint32_t cid;
@@ -498,7 +567,9 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
     ca_uint32_t payload_size;
     dbAddr *paddr=&dbch->addr;
 
-    SEND_LOCK ( pClient );
+    if ( readAccess && pfl && read_reply_ref ( pClient, pevext, dbch, pfl ) ) {
+        return;
+    }
 
     cid = ECA_NORMAL;
 
@@ -520,7 +591,6 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
             RECORD_NAME ( dbch ), pevext->msg.m_dataType, item_count, pevext->msg.m_available, rsrvSizeofLargeBufTCP );
         if ( ! eventsRemaining )
             cas_send_bs_msg ( pClient, FALSE );
-        SEND_UNLOCK ( pClient );
         return;
     }
 
@@ -531,7 +601,6 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
         no_read_access_event ( pClient, pevext );
         if ( ! eventsRemaining )
             cas_send_bs_msg ( pClient, FALSE );
-        SEND_UNLOCK ( pClient );
         return;
     }
 
@@ -600,10 +669,48 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
      */
     if ( ! eventsRemaining )
         cas_send_bs_msg ( pClient, FALSE );
+}
 
+/*
+ *  read_reply()
+ */
+static void read_reply ( void *pArg, struct dbChannel *dbch,
+                       int eventsRemaining, db_field_log *pfl )
+{
+    struct event_ext *pevext = pArg;
+    struct client *pClient = pevext->pciu->client;
+
+    SEND_LOCK ( pClient );
+    read_reply_locked ( pArg, dbch, eventsRemaining, pfl );
     SEND_UNLOCK ( pClient );
+}
 
-    return;
+/*
+ *  read_reply_batch()
+ *
+ *  Encode a batch of subscription updates under one send lock and
+ *  push them out with (at most) one send
+ */
+void read_reply_batch ( void *pArg, dbEventBatchEntry *entries,
+                       unsigned count, int eventsRemaining )
+{
+    struct client *pClient = pArg;
+    unsigned i;
+
+    SEND_LOCK ( pClient );
+    for ( i = 0u; i < count; i++ ) {
+        if ( entries[i].user_sub == read_reply ) {
+            read_reply_locked ( entries[i].user_arg, entries[i].chan,
+                TRUE, entries[i].pfl );
+        }
+        else {
+            ( *entries[i].user_sub ) ( entries[i].user_arg, entries[i].chan,
+                TRUE, entries[i].pfl );
+        }
+    }
+    if ( ! eventsRemaining )
+        cas_send_bs_msg ( pClient, FALSE );
+    SEND_UNLOCK ( pClient );
 }
 
 /*
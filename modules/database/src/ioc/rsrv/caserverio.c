@@ -33,6 +33,89 @@
 #define epicsExportSharedSymbols
 #include "server.h"
 
+/*
+ *  casSendError()
+ *
+ *  Handle a failed TCP send, returns TRUE if the send should be retried.
+ *  Otherwise the client is marked as disconnected and any unsent
+ *  messages are discarded.
+ */
+static int casSendError ( struct client *pclient )
+{
+    int causeWasSocketHangup = 0;
+    int anerrno = SOCKERRNO;
+    char buf[64];
+
+    if ( pclient->disconnect ) {
+        pclient->send.stk = 0u;
+        return FALSE;
+    }
+
+    if ( anerrno == SOCK_EINTR ) {
+        return TRUE;
+    }
+
+    if ( anerrno == SOCK_ENOBUFS ) {
+        errlogPrintf (
+            "CAS: Out of network buffers, retrying send in 15 seconds\n" );
+        epicsThreadSleep ( 15.0 );
+        return TRUE;
+    }
+
+    ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
+
+    if (    
+        anerrno == SOCK_ECONNABORTED ||
+        anerrno == SOCK_ECONNRESET ||
+        anerrno == SOCK_EPIPE ||
+        anerrno == SOCK_ETIMEDOUT ) {
+        causeWasSocketHangup = 1;
+    }
+    else {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString ( 
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "CAS: TCP send to %s failed: %s\n",
+            buf, sockErrBuf);
+    }
+    pclient->disconnect = TRUE;
+    pclient->send.stk = 0u;
+
+    /*
+     * wakeup the receive thread
+     */
+    if ( ! causeWasSocketHangup ) {
+        enum epicsSocketSystemCallInterruptMechanismQueryInfo info  =
+            epicsSocketSystemCallInterruptMechanismQuery ();
+        switch ( info ) {
+        case esscimqi_socketCloseRequired:
+            if ( pclient->sock != INVALID_SOCKET ) {
+                epicsSocketDestroy ( pclient->sock );
+                pclient->sock = INVALID_SOCKET;
+            }
+            break;
+        case esscimqi_socketBothShutdownRequired:
+            {
+                int status = shutdown ( pclient->sock, SHUT_RDWR );
+                if ( status ) {
+                    char sockErrBuf[64];
+                    epicsSocketConvertErrnoToString ( 
+                        sockErrBuf, sizeof ( sockErrBuf ) );
+                    errlogPrintf ("CAS: Socket shutdown error: %s\n",
+                        sockErrBuf );
+                }
+            }
+            break;
+        case esscimqi_socketSigAlarmRequired:
+            epicsSignalRaiseSigAlarm ( pclient->tid );
+            break;
+        default:
+            break;
+        };
+    }
+    return FALSE;
+}
+
 /*
  *  cas_send_bs_msg()
  *
@@ -80,89 +163,138 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
                 pclient->send.stk = bytesLeft;
             }
         }
-        else {
-            int causeWasSocketHangup = 0;
-            int anerrno = SOCKERRNO;
-            char buf[64];
+        else if ( ! casSendError ( pclient ) ) {
+            break;
+        }
+    }
 
-            if ( pclient->disconnect ) {
-                pclient->send.stk = 0u;
-                break;
-            }
+    if ( lock_needed ) {
+        SEND_UNLOCK(pclient);
+    }
 
-            if ( anerrno == SOCK_EINTR ) {
-                continue;
-            }
+    DLOG ( 3, ( "------------------------------\n\n" ) );
 
-            if ( anerrno == SOCK_ENOBUFS ) {
-                errlogPrintf (
-                    "CAS: Out of network buffers, retrying send in 15 seconds\n" );
-                epicsThreadSleep ( 15.0 );
-                continue;
-            }
+    return;
+}
 
-            ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
+/*
+ *  cas_send_bs_ref()
+ *
+ *  Send any messages in the buffer followed by one more message whose
+ *  payload is gathered from pMeta (already in network format) and pData
+ *  by the socket layer, so that large arrays need not be copied into the
+ *  send buffer.  The payload is zero filled up to payloadSize.
+ *
+ *  send lock must be on while in this routine
+ */
+int cas_send_bs_ref (
+    struct client *pclient, ca_uint16_t response, ca_uint16_t dataType,
+    ca_uint32_t nElem, ca_uint32_t cid, ca_uint32_t responseSpecific,
+    const void *pMeta, ca_uint32_t metaSize,
+    const void *pData, ca_uint32_t dataSize, ca_uint32_t payloadSize )
+{
+    static const char zeros[16];
+    ca_uint32_t hdr[ ( sizeof ( caHdr ) + 2 * sizeof ( ca_uint32_t ) ) /
+        sizeof ( ca_uint32_t ) ];
+    caHdr *pMsg = ( caHdr * ) hdr;
+    ca_uint32_t alignedPayloadSize;
+    unsigned hdrSize = sizeof ( caHdr );
+    struct {
+        const char *base;
+        size_t len;
+    } seg[5];
+    unsigned nseg = 0u, first = 0u, i;
+
+    if ( payloadSize > UINT_MAX - sizeof ( caHdr ) - 8u ||
+            metaSize > payloadSize || dataSize > payloadSize - metaSize ) {
+        return ECA_TOLARGE;
+    }
 
-            if (    
-                anerrno == SOCK_ECONNABORTED ||
-                anerrno == SOCK_ECONNRESET ||
-                anerrno == SOCK_EPIPE ||
-                anerrno == SOCK_ETIMEDOUT ) {
-                causeWasSocketHangup = 1;
-            }
-            else {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString ( 
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-                errlogPrintf ( "CAS: TCP send to %s failed: %s\n",
-                    buf, sockErrBuf);
+    alignedPayloadSize = CA_MESSAGE_ALIGN ( payloadSize );
+    if ( alignedPayloadSize - metaSize - dataSize > sizeof ( zeros ) ) {
+        return ECA_INTERNAL;
+    }
+
+    pMsg->m_cmmd = htons ( response );
+    pMsg->m_dataType = htons ( dataType );
+    pMsg->m_cid = htonl ( cid );
+    pMsg->m_available = htonl ( responseSpecific );
+    if ( alignedPayloadSize < 0xffff && nElem < 0xffff ) {
+        pMsg->m_postsize = htons ( ( ca_uint16_t ) alignedPayloadSize );
+        pMsg->m_count = htons ( ( ca_uint16_t ) nElem );
+    }
+    else {
+        ca_uint32_t *pW32 = ( ca_uint32_t * ) ( pMsg + 1 );
+
+        if ( ! CA_V49 ( pclient->minor_version_number ) ) {
+            return ECA_16KARRAYCLIENT;
+        }
+        pMsg->m_postsize = htons ( 0xffff );
+        pMsg->m_count = htons ( 0u );
+        pW32[0] = htonl ( alignedPayloadSize );
+        pW32[1] = htonl ( nElem );
+        hdrSize += 2 * sizeof ( ca_uint32_t );
+    }
+
+    if ( pclient->disconnect ) {
+        pclient->send.stk = 0u;
+        return ECA_NORMAL;
+    }
+
+#   define ADD_SEGMENT(BASE, LEN) \
+    if ( (LEN) > 0u ) { \
+        seg[nseg].base = (const char *) (BASE); \
+        seg[nseg].len = (LEN); \
+        nseg++; \
+    }
+    ADD_SEGMENT ( pclient->send.buf, pclient->send.stk )
+    ADD_SEGMENT ( hdr, hdrSize )
+    ADD_SEGMENT ( pMeta, metaSize )
+    ADD_SEGMENT ( pData, dataSize )
+    ADD_SEGMENT ( zeros, alignedPayloadSize - metaSize - dataSize )
+#   undef ADD_SEGMENT
+
+    while ( first < nseg && ! pclient->disconnect ) {
+        int status;
+#ifdef _WIN32
+        status = send ( pclient->sock, seg[first].base,
+            ( int ) seg[first].len, 0 );
+#else
+        struct iovec iov[5];
+        struct msghdr msg;
+
+        for ( i = first; i < nseg; i++ ) {
+            iov[i - first].iov_base = ( void * ) seg[i].base;
+            iov[i - first].iov_len = seg[i].len;
+        }
+        memset ( &msg, 0, sizeof ( msg ) );
+        msg.msg_iov = iov;
+        msg.msg_iovlen = nseg - first;
+        status = sendmsg ( pclient->sock, &msg, 0 );
+#endif
+        if ( status >= 0 ) {
+            size_t transferSize = ( size_t ) status;
+
+            while ( first < nseg && transferSize >= seg[first].len ) {
+                transferSize -= seg[first].len;
+                first++;
             }
-            pclient->disconnect = TRUE;
-            pclient->send.stk = 0u;
-
-            /*
-             * wakeup the receive thread
-             */
-            if ( ! causeWasSocketHangup ) {
-                enum epicsSocketSystemCallInterruptMechanismQueryInfo info  =
-                    epicsSocketSystemCallInterruptMechanismQuery ();
-                switch ( info ) {
-                case esscimqi_socketCloseRequired:
-                    if ( pclient->sock != INVALID_SOCKET ) {
-                        epicsSocketDestroy ( pclient->sock );
-                        pclient->sock = INVALID_SOCKET;
-                    }
-                    break;
-                case esscimqi_socketBothShutdownRequired:
-                    {
-                        int status = shutdown ( pclient->sock, SHUT_RDWR );
-                        if ( status ) {
-                            char sockErrBuf[64];
-                            epicsSocketConvertErrnoToString ( 
-                                sockErrBuf, sizeof ( sockErrBuf ) );
-                            errlogPrintf ("CAS: Socket shutdown error: %s\n",
-                                sockErrBuf );
-                        }
-                    }
-                    break;
-                case esscimqi_socketSigAlarmRequired:
-                    epicsSignalRaiseSigAlarm ( pclient->tid );
-                    break;
-                default:
-                    break;
-                };
-                break;
+            if ( first < nseg ) {
+                seg[first].base += transferSize;
+                seg[first].len -= transferSize;
             }
         }
+        else if ( ! casSendError ( pclient ) ) {
+            break;
+        }
     }
 
-    if ( lock_needed ) {
-        SEND_UNLOCK(pclient);
+    pclient->send.stk = 0u;
+    if ( first == nseg ) {
+        epicsTimeGetCurrent ( &pclient->time_at_last_send );
     }
 
-    DLOG ( 3, ( "------------------------------\n\n" ) );
-
-    return;
+    return ECA_NORMAL;
 }
 
 /*
@@ -201,26 +333,32 @@ void cas_send_dg_msg ( struct client * pclient )
         sizeDG -= sizeof (caHdr);
     }
 
-    status = sendto ( pclient->sock, pDG, sizeDG, 0,
-       (struct sockaddr *)&pclient->addr, sizeof(pclient->addr) );
-    if ( status >= 0 ) {
-        if ( status >= sizeDG ) {
-            epicsTimeGetCurrent ( &pclient->time_at_last_send );
+    if ( pclient->udpBatch ) {
+        /* sent by cast_server() along with the rest of the batch */
+        casUdpBatchQueue ( pclient, pDG, (unsigned) sizeDG );
+    }
+    else {
+        status = sendto ( pclient->sock, pDG, sizeDG, 0,
+           (struct sockaddr *)&pclient->addr, sizeof(pclient->addr) );
+        if ( status >= 0 ) {
+            if ( status >= sizeDG ) {
+                epicsTimeGetCurrent ( &pclient->time_at_last_send );
+            }
+            else {
+                errlogPrintf ( 
+                    "CAS: System failed to send entire udp frame?\n" );
+            }
         }
         else {
-            errlogPrintf ( 
-                "CAS: System failed to send entire udp frame?\n" );
+            char sockErrBuf[64];
+            char buf[128];
+            epicsSocketConvertErrnoToString ( 
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
+            errlogPrintf( "CAS: UDP send to %s failed: %s\n",
+                buf, sockErrBuf);
         }
     }
-    else {
-        char sockErrBuf[64];
-        char buf[128];
-        epicsSocketConvertErrnoToString ( 
-            sockErrBuf, sizeof ( sockErrBuf ) );
-        ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
-        errlogPrintf( "CAS: UDP send to %s failed: %s\n",
-            buf, sockErrBuf);
-    }
 
     pclient->send.stk = 0u;
 
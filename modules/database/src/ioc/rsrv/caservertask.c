@@ -762,6 +762,8 @@ void rsrv_init (void)
             &rsrv_online_notify_task, NULL);
 
     epicsEventMustWait(beacon_startStopEvent);
+
+    rsrv_name_register_start();
 }
 
 static
@@ -850,6 +852,22 @@ static void log_one_client (struct client *client, unsigned level)
         client->priority,
         n, n == 1 ? "" : "s" );
 
+    if ( client->proto == IPPROTO_UDP ) {
+        casUdpBatchShow ( client );
+    }
+
+    if ( client->proto == IPPROTO_TCP && client->evuser ) {
+        dbEventQueueStats stats;
+
+        if ( db_event_queue_stats ( client->evuser, &stats, 0 ) == DB_EVENT_OK ) {
+            printf ( "\tEvent queue: %u of %u entries used in %u queue%s, "
+                "high water mark %u, %lu overflows\n",
+                stats.used, stats.size, stats.nQueues,
+                stats.nQueues == 1 ? "" : "s",
+                stats.highWaterMark, stats.nOverflow );
+        }
+    }
+
     if ( level >= 3u ) {
         double         send_delay;
         double         recv_delay;
@@ -1504,6 +1522,16 @@ struct client *create_tcp_client (SOCKET sock , const osiSockAddr *peerAddr)
         return NULL;
     }
 
+    if ( rsrvEventBatch > 0 ) {
+        status = db_set_event_batch ( client->evuser, read_reply_batch,
+            client, (unsigned) rsrvEventBatch );
+        if ( status != DB_EVENT_OK ) {
+            errlogPrintf ( "CAS: unable to setup batched event delivery\n" );
+            destroy_tcp_client ( client );
+            return NULL;
+        }
+    }
+
     {
         epicsThreadBooleanStatus    tbs;
 
@@ -36,6 +36,7 @@
 #include <string.h>
 #include <errno.h>
 
+#include "cantProceed.h"
 #include "dbDefs.h"
 #include "envDefs.h"
 #include "epicsMutex.h"
@@ -107,6 +108,276 @@ static void clean_addrq(struct client *client)
 
 }
 
+/*
+ * Datagrams are received and replies sent in batches, with single
+ * recvmmsg() and sendmmsg() calls where available and a loop of
+ * recvfrom()/sendto() otherwise.
+ */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#   define USE_MMSG
+#endif
+
+#if defined(vxWorks) || defined(__rtems__)
+#   define UDP_BATCH 1u     /* receive buffers are large */
+#else
+#   define UDP_BATCH 16u
+#endif
+
+struct rsrv_udp_batch {
+    /* received datagrams */
+    char                *recvBuf[UDP_BATCH];
+    unsigned            recvCnt[UDP_BATCH];
+    struct sockaddr_in  recvAddr[UDP_BATCH];
+    /* replies waiting to be sent */
+    char                sendBuf[UDP_BATCH][MAX_UDP_SEND];
+    unsigned            sendCnt[UDP_BATCH];
+    struct sockaddr_in  sendAddr[UDP_BATCH];
+    unsigned            nSend;
+    /* statistics for casr, written only by the cast_server thread */
+    unsigned long       recvBatches, recvDatagrams, recvMax;
+    unsigned long       sendBatches, sendDatagrams, sendMax;
+    unsigned long       coalesced;
+};
+
+/*
+ * Current batch size, rsrvUdpBatch may be changed at any time
+ */
+static unsigned udpBatchSize ( void )
+{
+    int n = rsrvUdpBatch;
+
+    if ( n < 1 ) return 1u;
+    if ( (unsigned) n > UDP_BATCH ) return UDP_BATCH;
+    return (unsigned) n;
+}
+
+static struct rsrv_udp_batch *udpBatchCreate ( struct client *client )
+{
+    struct rsrv_udp_batch *pb = callocMustSucceed ( 1, sizeof ( *pb ),
+        "cast_server" );
+    unsigned i;
+
+    /* the first slot uses the client's own receive buffer */
+    pb->recvBuf[0] = client->recv.buf;
+    for ( i = 1u; i < UDP_BATCH; i++ ) {
+        pb->recvBuf[i] = mallocMustSucceed ( client->recv.maxstk,
+            "cast_server" );
+    }
+    return pb;
+}
+
+static void udpBatchDestroy ( struct client *client )
+{
+    struct rsrv_udp_batch *pb = client->udpBatch;
+    unsigned i;
+
+    client->udpBatch = NULL;
+    client->recv.buf = pb->recvBuf[0];
+    for ( i = 1u; i < UDP_BATCH; i++ ) {
+        free ( pb->recvBuf[i] );
+    }
+    free ( pb );
+}
+
+/*
+ * Receive at least one datagram, and any more that are already queued
+ * up to the batch size.  Returns the number received or -1 on error.
+ */
+static int udpBatchRecv ( struct client *client, SOCKET sock )
+{
+    struct rsrv_udp_batch *pb = client->udpBatch;
+    unsigned max = udpBatchSize ();
+#ifdef USE_MMSG
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iov[UDP_BATCH];
+    unsigned i;
+    int status;
+
+    memset ( msgs, 0, sizeof ( msgs ) );
+    for ( i = 0u; i < max; i++ ) {
+        iov[i].iov_base = pb->recvBuf[i];
+        iov[i].iov_len = client->recv.maxstk;
+        msgs[i].msg_hdr.msg_name = &pb->recvAddr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof ( pb->recvAddr[i] );
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    status = recvmmsg ( sock, msgs, max, MSG_WAITFORONE, NULL );
+    for ( i = 0u; status > 0 && i < (unsigned) status; i++ ) {
+        pb->recvCnt[i] = msgs[i].msg_len;
+    }
+    return status;
+#else
+    unsigned n = 0u;
+
+    do {
+        osiSocklen_t addrSize = sizeof ( pb->recvAddr[n] );
+        osiSockIoctl_t nchars = 0;
+        int status = recvfrom ( sock, pb->recvBuf[n], client->recv.maxstk,
+            0, (struct sockaddr *) &pb->recvAddr[n], &addrSize );
+
+        if ( status < 0 ) {
+            return n ? (int) n : -1;
+        }
+        pb->recvCnt[n++] = (unsigned) status;
+
+        if ( n == max ||
+                socket_ioctl ( sock, FIONREAD, &nchars ) < 0 ||
+                nchars == 0 ) {
+            break;
+        }
+    } while ( TRUE );
+    return (int) n;
+#endif
+}
+
+/*
+ * Process the datagrams of a batch grouped by sender, keeping their
+ * order otherwise, so that the replies to each sender are coalesced.
+ */
+static void udpBatchOrder ( struct rsrv_udp_batch *pb, unsigned n,
+    unsigned *order )
+{
+    char done[UDP_BATCH];
+    unsigned i, j, k = 0u;
+
+    memset ( done, 0, sizeof ( done ) );
+    for ( i = 0u; i < n; i++ ) {
+        if ( done[i] ) continue;
+        order[k++] = i;
+        for ( j = i + 1u; j < n; j++ ) {
+            if ( !done[j] &&
+                    pb->recvAddr[j].sin_addr.s_addr ==
+                        pb->recvAddr[i].sin_addr.s_addr &&
+                    pb->recvAddr[j].sin_port == pb->recvAddr[i].sin_port ) {
+                done[j] = 1;
+                order[k++] = j;
+            }
+        }
+    }
+}
+
+static void udpSendError ( const struct sockaddr_in *pAddr )
+{
+    char sockErrBuf[64];
+    char buf[128];
+
+    epicsSocketConvertErrnoToString ( sockErrBuf, sizeof ( sockErrBuf ) );
+    ipAddrToDottedIP ( pAddr, buf, sizeof(buf) );
+    errlogPrintf ( "CAS: UDP send to %s failed: %s\n", buf, sockErrBuf );
+}
+
+/*
+ * Send all queued replies
+ */
+static void udpBatchFlush ( struct client *client )
+{
+    struct rsrv_udp_batch *pb = client->udpBatch;
+    unsigned n = pb->nSend;
+    unsigned nOK = 0u;
+    unsigned i;
+#ifdef USE_MMSG
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iov[UDP_BATCH];
+#endif
+
+    if ( n == 0u ) return;
+    pb->nSend = 0u;
+
+#ifdef USE_MMSG
+    memset ( msgs, 0, sizeof ( msgs ) );
+    for ( i = 0u; i < n; i++ ) {
+        iov[i].iov_base = pb->sendBuf[i];
+        iov[i].iov_len = pb->sendCnt[i];
+        msgs[i].msg_hdr.msg_name = &pb->sendAddr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof ( pb->sendAddr[i] );
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    i = 0u;
+    while ( i < n ) {
+        int status = sendmmsg ( client->sock, &msgs[i], n - i, 0 );
+
+        if ( status < 0 ) {
+            if ( SOCKERRNO == SOCK_EINTR ) continue;
+            /* the first remaining datagram failed, skip it */
+            udpSendError ( &pb->sendAddr[i] );
+            i++;
+            continue;
+        }
+        while ( status-- > 0 ) {
+            if ( msgs[i].msg_len < pb->sendCnt[i] ) {
+                errlogPrintf (
+                    "CAS: System failed to send entire udp frame?\n" );
+            }
+            else {
+                nOK++;
+            }
+            i++;
+        }
+    }
+#else
+    for ( i = 0u; i < n; i++ ) {
+        int status = sendto ( client->sock, pb->sendBuf[i], pb->sendCnt[i],
+            0, (struct sockaddr *) &pb->sendAddr[i],
+            sizeof ( pb->sendAddr[i] ) );
+
+        if ( status < 0 ) {
+            udpSendError ( &pb->sendAddr[i] );
+        }
+        else if ( (unsigned) status < pb->sendCnt[i] ) {
+            errlogPrintf (
+                "CAS: System failed to send entire udp frame?\n" );
+        }
+        else {
+            nOK++;
+        }
+    }
+#endif
+
+    if ( nOK ) {
+        epicsTimeGetCurrent ( &client->time_at_last_send );
+    }
+    pb->sendBatches++;
+    pb->sendDatagrams += n;
+    if ( n > pb->sendMax ) pb->sendMax = n;
+}
+
+/*
+ * Queue a finished reply datagram, called by cas_send_dg_msg()
+ */
+void casUdpBatchQueue ( struct client *client, const char *pDG,
+    unsigned sizeDG )
+{
+    struct rsrv_udp_batch *pb = client->udpBatch;
+
+    assert ( sizeDG <= MAX_UDP_SEND );
+    if ( pb->nSend >= udpBatchSize () ) {
+        udpBatchFlush ( client );
+    }
+    memcpy ( pb->sendBuf[pb->nSend], pDG, sizeDG );
+    pb->sendCnt[pb->nSend] = sizeDG;
+    pb->sendAddr[pb->nSend] = client->addr;
+    pb->nSend++;
+}
+
+void casUdpBatchShow ( const struct client *client )
+{
+    const struct rsrv_udp_batch *pb = client->udpBatch;
+
+    if ( !pb ) return;
+    printf ( "\tReceived %lu datagrams in %lu batches (%.1f avg, %lu max)\n",
+        pb->recvDatagrams, pb->recvBatches,
+        pb->recvBatches ? (double) pb->recvDatagrams / pb->recvBatches : 0.0,
+        pb->recvMax );
+    printf ( "\tSent %lu datagrams in %lu batches (%.1f avg, %lu max)\n",
+        pb->sendDatagrams, pb->sendBatches,
+        pb->sendBatches ? (double) pb->sendDatagrams / pb->sendBatches : 0.0,
+        pb->sendMax );
+    printf ( "\t%lu requests answered in a datagram shared with earlier ones\n",
+        pb->coalesced );
+}
+
 /*
  * CAST_SERVER
  *
@@ -119,13 +390,10 @@ void cast_server(void *pParm)
     int                 status;
     int                 count=0;
     int                 mysocket=0;
-    struct sockaddr_in  new_recv_addr;
-    osiSocklen_t        recv_addr_size;
     osiSockIoctl_t      nchars;
     SOCKET              recv_sock, reply_sock;
     struct client      *client;
-
-    recv_addr_size = sizeof(new_recv_addr);
+    struct rsrv_udp_batch *pb;
 
     reply_sock = conf->udp;
 
@@ -150,6 +418,7 @@ void cast_server(void *pParm)
         conf->client = client;
     }
     client->udpRecv = recv_sock;
+    pb = client->udpBatch = udpBatchCreate ( client );
 
     casAttachThreadToClient ( client );
 
@@ -164,13 +433,11 @@ void cast_server(void *pParm)
     epicsEventSignal(casudp_startStopEvent);
 
     while (TRUE) {
-        status = recvfrom (
-            recv_sock,
-            client->recv.buf,
-            client->recv.maxstk,
-            0,
-            (struct sockaddr *)&new_recv_addr, 
-            &recv_addr_size);
+        unsigned order[UDP_BATCH];
+        unsigned ndg = 0u;
+        unsigned i;
+
+        status = udpBatchRecv ( client, recv_sock );
         if (status < 0) {
             if (SOCKERRNO != SOCK_EINTR) {
                 char sockErrBuf[64];
@@ -180,20 +447,30 @@ void cast_server(void *pParm)
                         sockErrBuf);
                 epicsThreadSleep(1.0);
             }
+        }
+        else {
+            ndg = (unsigned) status;
+            pb->recvBatches++;
+            pb->recvDatagrams += ndg;
+            if ( ndg > pb->recvMax ) pb->recvMax = ndg;
+            udpBatchOrder ( pb, ndg, order );
+        }
 
-        } else {
+        for ( i = 0u; i < ndg; i++ ) {
+            unsigned k = order[i];
+            struct sockaddr_in *pAddr = &pb->recvAddr[k];
             size_t idx;
+
             for(idx=0; casIgnoreAddrs[idx]; idx++)
             {
-                if(new_recv_addr.sin_addr.s_addr==casIgnoreAddrs[idx]) {
-                    status = -1; /* ignore */
+                if(pAddr->sin_addr.s_addr==casIgnoreAddrs[idx])
                     break;
-                }
             }
-        }
+            if (casIgnoreAddrs[idx] || casudp_ctl != ctlRun)
+                continue;
 
-        if (status >= 0 && casudp_ctl == ctlRun) {
-            client->recv.cnt = (unsigned) status;
+            client->recv.buf = pb->recvBuf[k];
+            client->recv.cnt = pb->recvCnt[k];
             client->recv.stk = 0ul;
             epicsTimeGetCurrent(&client->time_at_last_recv);
 
@@ -206,18 +483,20 @@ void cast_server(void *pParm)
              * see if the next message is for this same client.
              */
             if (client->send.stk>sizeof(caHdr)) {
-                status = memcmp(&client->addr,
-                    &new_recv_addr, recv_addr_size);
+                status = memcmp(&client->addr, pAddr, sizeof(*pAddr));
                 if(status){     
                     /* 
                      * if the address is different 
                      */
                     cas_send_dg_msg(client);
-                    client->addr = new_recv_addr;
+                    client->addr = *pAddr;
+                }
+                else {
+                    pb->coalesced++;
                 }
             }
             else {
-                client->addr = new_recv_addr;
+                client->addr = *pAddr;
             }
 
             if (CASDEBUG>1) {
@@ -282,10 +561,12 @@ void cast_server(void *pParm)
             cas_send_dg_msg (client);
             clean_addrq (client);
         }
+        udpBatchFlush ( client );
     }
 
     /* ATM never reached, just a placeholder */
 
+    udpBatchDestroy ( client );
     if(!mysocket)
         client->sock = INVALID_SOCKET; /* only one cast_server should destroy the reply socket */
     destroy_client(client);
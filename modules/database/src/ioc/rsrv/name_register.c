@@ -0,0 +1,220 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  register the record names of this server with the name servers
+ *  listed in EPICS_CAS_NAME_SERVERS (see caNameServer)
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "addrList.h"
+#include "cantProceed.h"
+#include "dbDefs.h"
+#include "envDefs.h"
+#include "epicsThread.h"
+#include "errlog.h"
+#include "osiSock.h"
+#include "taskwd.h"
+
+#define epicsExportSharedSymbols
+#include "dbAccessDefs.h"
+#include "dbStaticLib.h"
+#include "server.h"
+
+#define NAME_REGISTER_RETRY_DELAY 5.0 /* sec */
+
+static int nameRegisterSend ( SOCKET sock, const char *pBuf, unsigned nBytes )
+{
+    while ( nBytes ) {
+        int status = send ( sock, pBuf, (int) nBytes, 0 );
+        if ( status <= 0 ) {
+            return -1;
+        }
+        pBuf += status;
+        nBytes -= (unsigned) status;
+    }
+    return 0;
+}
+
+static void nameRegisterHeader ( char *pBuf, unsigned cmmd,
+    unsigned postsize, unsigned dataType, unsigned count,
+    ca_uint32_t cid, ca_uint32_t available )
+{
+    caHdr hdr;
+    hdr.m_cmmd = htons ( (ca_uint16_t) cmmd );
+    hdr.m_postsize = htons ( (ca_uint16_t) postsize );
+    hdr.m_dataType = htons ( (ca_uint16_t) dataType );
+    hdr.m_count = htons ( (ca_uint16_t) count );
+    hdr.m_cid = htonl ( cid );
+    hdr.m_available = htonl ( available );
+    memcpy ( pBuf, &hdr, sizeof ( hdr ) );
+}
+
+/*
+ * send the name of each record and alias, in messages of up to
+ * MAX_TCP bytes
+ */
+static int nameRegisterSendNames ( SOCKET sock, ca_uint32_t serverIP,
+    unsigned *pNameCount )
+{
+    char *pBuf = mallocMustSucceed ( sizeof ( caHdr ) + MAX_TCP,
+        "nameRegisterSendNames" );
+    char *pPayload = pBuf + sizeof ( caHdr );
+    unsigned nBytes = 0u;
+    unsigned nNames = 0u;
+    int status = 0;
+    DBENTRY dbentry;
+    long dbStatus;
+
+    *pNameCount = 0u;
+    dbInitEntry ( pdbbase, &dbentry );
+    for ( dbStatus = dbFirstRecordType ( &dbentry ); !dbStatus && !status;
+            dbStatus = dbNextRecordType ( &dbentry ) ) {
+        for ( dbStatus = dbFirstRecord ( &dbentry ); !dbStatus;
+                dbStatus = dbNextRecord ( &dbentry ) ) {
+            const char *pName = dbGetRecordName ( &dbentry );
+            unsigned len = (unsigned) strlen ( pName ) + 1u;
+            if ( CA_MESSAGE_ALIGN ( nBytes + len ) > MAX_TCP ) {
+                unsigned postsize = CA_MESSAGE_ALIGN ( nBytes );
+                memset ( pPayload + nBytes, '\0', postsize - nBytes );
+                nameRegisterHeader ( pBuf, CA_PROTO_NAME_REGISTER, postsize,
+                    ca_server_port, nNames, serverIP, 0u );
+                status = nameRegisterSend ( sock, pBuf,
+                    sizeof ( caHdr ) + postsize );
+                if ( status ) {
+                    break;
+                }
+                *pNameCount += nNames;
+                nBytes = 0u;
+                nNames = 0u;
+            }
+            memcpy ( pPayload + nBytes, pName, len );
+            nBytes += len;
+            nNames++;
+        }
+    }
+    dbFinishEntry ( &dbentry );
+
+    /* the last message says that the registration is complete */
+    if ( !status ) {
+        unsigned postsize = CA_MESSAGE_ALIGN ( nBytes );
+        memset ( pPayload + nBytes, '\0', postsize - nBytes );
+        nameRegisterHeader ( pBuf, CA_PROTO_NAME_REGISTER, postsize,
+            ca_server_port, nNames, serverIP, 1u );
+        status = nameRegisterSend ( sock, pBuf, sizeof ( caHdr ) + postsize );
+        if ( !status ) {
+            *pNameCount += nNames;
+        }
+    }
+
+    free ( pBuf );
+    return status;
+}
+
+/*
+ *  one thread for each name server, which keeps a connection to it
+ *  open for as long as the server runs
+ */
+static void rsrv_name_register_task ( void *pParm )
+{
+    osiSockAddrNode *pNode = (osiSockAddrNode *) pParm;
+    ca_uint32_t serverIP = 0u;
+    char nameServer[32];
+    int lastError = 0;
+
+    taskwdInsert ( epicsThreadGetIdSelf (), NULL, NULL );
+
+    ipAddrToDottedIP ( &pNode->addr.ia, nameServer, sizeof ( nameServer ) );
+
+    /* the name server uses the circuit's address unless the server
+     * was bound to a single interface
+     */
+    if ( ellCount ( &servers ) == 1 ) {
+        rsrv_iface_config *conf = CONTAINER ( ellFirst ( &servers ),
+            rsrv_iface_config, node );
+        serverIP = ntohl ( conf->tcpAddr.ia.sin_addr.s_addr );
+    }
+
+    while ( TRUE ) {
+        SOCKET sock;
+
+        while ( castcp_ctl != ctlRun ) {
+            epicsThreadSleep ( 0.1 );
+        }
+
+        sock = epicsSocketCreate ( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+        if ( sock == INVALID_SOCKET ) {
+            errlogPrintf ( "CAS: unable to create name server socket\n" );
+            epicsThreadSleep ( NAME_REGISTER_RETRY_DELAY );
+            continue;
+        }
+
+        if ( connect ( sock, &pNode->addr.sa, sizeof ( pNode->addr.ia ) ) < 0 ) {
+            int err = SOCKERRNO;
+            if ( err != lastError ) {
+                char sockErrBuf[64];
+                epicsSocketConvertErrorToString (
+                    sockErrBuf, sizeof ( sockErrBuf ), err );
+                errlogPrintf ( "CAS: name server %s connect error: %s\n",
+                    nameServer, sockErrBuf );
+                lastError = err;
+            }
+        }
+        else {
+            char hdr[sizeof ( caHdr )];
+            unsigned nNames;
+            int intTrue = TRUE;
+
+            lastError = 0;
+            setsockopt ( sock, SOL_SOCKET, SO_KEEPALIVE,
+                (char *) &intTrue, sizeof ( intTrue ) );
+
+            nameRegisterHeader ( hdr, CA_PROTO_VERSION, 0u, 0u,
+                CA_MINOR_PROTOCOL_REVISION, 0u, 0u );
+            if ( !nameRegisterSend ( sock, hdr, sizeof ( hdr ) ) &&
+                    !nameRegisterSendNames ( sock, serverIP, &nNames ) ) {
+                char buf[64];
+
+                errlogPrintf ( "CAS: registered %u names with name server %s\n",
+                    nNames, nameServer );
+                /* the name server forgets the names when this closes */
+                while ( recv ( sock, buf, sizeof ( buf ), 0 ) > 0 ) {
+                }
+            }
+            errlogPrintf ( "CAS: lost connection to name server %s\n",
+                nameServer );
+        }
+        epicsSocketDestroy ( sock );
+        epicsThreadSleep ( NAME_REGISTER_RETRY_DELAY );
+    }
+}
+
+void rsrv_name_register_start ( void )
+{
+    ELLLIST tmpList = ELLLIST_INIT;
+    ELLLIST nameServers = ELLLIST_INIT;
+    osiSockAddrNode *pNode;
+    unsigned short port;
+
+    if ( !envGetConfigParamPtr ( &EPICS_CAS_NAME_SERVERS ) ) {
+        return;
+    }
+
+    /* the same default port as for EPICS_CA_NAME_SERVERS */
+    port = envGetInetPortConfigParam ( &EPICS_CA_SERVER_PORT,
+        (unsigned short) CA_SERVER_PORT );
+    addAddrToChannelAccessAddressList ( &tmpList, &EPICS_CAS_NAME_SERVERS,
+        port, 0 );
+    removeDuplicateAddresses ( &nameServers, &tmpList, 0 );
+
+    while ( ( pNode = (osiSockAddrNode *) ellGet ( &nameServers ) ) ) {
+        epicsThreadMustCreate ( "CAS-names", threadPrios[4],
+            epicsThreadGetStackSize ( epicsThreadStackMedium ),
+            rsrv_name_register_task, pNode );
+    }
+}
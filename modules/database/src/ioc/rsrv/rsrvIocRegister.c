@@ -33,4 +33,6 @@ void rsrvRegistrar(void)
 }
 
 epicsExportAddress(int, CASDEBUG);
+epicsExportAddress(int, rsrvEventBatch);
+epicsExportAddress(int, rsrvUdpBatch);
 epicsExportRegistrar(rsrvRegistrar);
@@ -27,6 +27,7 @@
 #include "asLib.h"
 #include "dbChannel.h"
 #include "dbNotify.h"
+#include "dbEvent.h"
 #define CA_MINOR_PROTOCOL_REVISION 13
 #include "caProto.h"
 #include "ellLib.h"
@@ -101,6 +102,7 @@ typedef struct client {
   unsigned              recvBytesToDrain;
   unsigned              priority;
   char                  disconnect; /* disconnect detected */
+  struct rsrv_udp_batch *udpBatch; /* UDP only, owned by cast_server() */
 } client;
 
 /* Channel state shows which struct client list a
@@ -188,6 +190,8 @@ enum ctl {ctlInit, ctlRun, ctlPause, ctlExit};
 #endif
 
 GLBLTYPE int                CASDEBUG;
+GLBLTYPE int                rsrvEventBatch      GLBLTYPE_INIT(64); /* 0 delivers one at a time */
+GLBLTYPE int                rsrvUdpBatch        GLBLTYPE_INIT(16); /* 1 disables UDP batching */
 GLBLTYPE unsigned short     ca_server_port, ca_udp_port, ca_beacon_port;
 GLBLTYPE ELLLIST            clientQ             GLBLTYPE_INIT(ELLLIST_INIT);
 GLBLTYPE ELLLIST            servers; /* rsrv_iface_config::node, read-only after rsrv_init() */
@@ -231,7 +235,11 @@ void camsgtask (void *client);
 void cas_send_bs_msg ( struct client *pclient, int lock_needed );
 void cas_send_dg_msg ( struct client *pclient );
 void rsrv_online_notify_task (void *);
+void rsrv_name_register_start (void);
 void cast_server (void *);
+void casUdpBatchQueue ( struct client *client, const char *pDG,
+    unsigned sizeDG );
+void casUdpBatchShow ( const struct client *client );
 struct client *create_client ( SOCKET sock, int proto );
 void destroy_client ( struct client * );
 struct client *create_tcp_client ( SOCKET sock, const osiSockAddr* peerAddr );
@@ -239,6 +247,7 @@ void destroy_tcp_client ( struct client * );
 void casAttachThreadToClient ( struct client * );
 int camessage ( struct client *client );
 void rsrv_extra_labor ( void * pArg );
+EVENTBATCHFUNC read_reply_batch;
 int rsrvCheckPut ( const struct channel_in_use *pciu );
 int rsrv_version_reply ( struct client *client );
 void rsrvFreePutNotify ( struct client *pClient,
@@ -262,6 +271,11 @@ int cas_copy_in_header (
 void cas_set_header_cid ( struct client *pClient, ca_uint32_t );
 void cas_set_header_count (struct client *pClient, ca_uint32_t count);
 void cas_commit_msg ( struct client *pClient, ca_uint32_t size );
+int cas_send_bs_ref (
+    struct client *pClient, ca_uint16_t response, ca_uint16_t dataType,
+    ca_uint32_t nElem, ca_uint32_t cid, ca_uint32_t responseSpecific,
+    const void *pMeta, ca_uint32_t metaSize,
+    const void *pData, ca_uint32_t dataSize, ca_uint32_t payloadSize );
 
 #ifdef __cplusplus
 }
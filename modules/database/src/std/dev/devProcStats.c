@@ -0,0 +1,192 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devProcStats.c */
+
+/* Device support reading the processing time statistics of another record,
+ * see dbProcStats.h.  The INP field is "@record statistic" for an ai and
+ * "@record" for a waveform, which gets the histogram.  Reading a record's
+ * statistics enables their collection permanently.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "dbDefs.h"
+#include "dbAccess.h"
+#include "dbProcStats.h"
+#include "epicsString.h"
+#include "recGbl.h"
+#include "devSup.h"
+
+#include "aiRecord.h"
+#include "waveformRecord.h"
+#include "devStatsWf.h"
+#include "epicsExport.h"
+
+static dbProcStats * findStats(dbCommon *prec, const char *parm,
+    char *stat, size_t len)
+{
+    char name[PVNAME_STRINGSZ];
+    DBADDR addr;
+    int n = 0;
+
+    stat[0] = '\0';
+    if (sscanf(parm, "%60s %n", name, &n) < 1) {
+        recGblRecordError(S_db_badField, prec,
+            "devProcStats: No record name in INP");
+        return NULL;
+    }
+    strncpy(stat, parm + n, len - 1);
+    stat[len - 1] = '\0';
+
+    if (dbNameToAddr(name, &addr)) {
+        recGblRecordError(S_db_notFound, prec,
+            "devProcStats: Record not found");
+        return NULL;
+    }
+    return dbProcStatsGet(addr.precord);
+}
+
+/********* ai record **********/
+
+enum aiStat {ai_count, ai_avg, ai_min, ai_max, ai_total, ai_last};
+
+static const char * const aiStats[] = {
+    "count", "avg", "min", "max", "total", "last"
+};
+
+typedef struct aiPvt {
+    dbProcStats *pstats;
+    enum aiStat stat;
+} aiPvt;
+
+static long init_ai(aiRecord *prec)
+{
+    char stat[20];
+    aiPvt *ppvt;
+    int i;
+
+    if (prec->inp.type != INST_IO) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "devAiProcStats::init_ai: Illegal INP field");
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+
+    ppvt = calloc(1, sizeof(aiPvt));
+    if (!ppvt) {
+        prec->pact = TRUE;
+        return S_db_noMemory;
+    }
+    ppvt->pstats = findStats((dbCommon *)prec,
+        prec->inp.value.instio.string, stat, sizeof(stat));
+    ppvt->stat = ai_avg;
+    if (stat[0]) {
+        for (i = 0; i < NELEMENTS(aiStats); i++) {
+            if (!epicsStrCaseCmp(stat, aiStats[i]))
+                break;
+        }
+        if (i == NELEMENTS(aiStats)) {
+            recGblRecordError(S_db_badField, (void *)prec,
+                              "devAiProcStats::init_ai: Bad statistic");
+            ppvt->pstats = NULL;
+        }
+        else
+            ppvt->stat = i;
+    }
+    if (!ppvt->pstats) {
+        free(ppvt);
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    prec->dpvt = ppvt;
+    return 0;
+}
+
+/* Times are returned in microseconds */
+static long read_ai(aiRecord *prec)
+{
+    aiPvt *ppvt = (aiPvt *)prec->dpvt;
+    dbProcStats *pstats;
+
+    if (!ppvt) return -1;
+    pstats = ppvt->pstats;
+
+    switch (ppvt->stat) {
+    case ai_count:
+        prec->val = pstats->count;
+        break;
+    case ai_avg:
+        prec->val = pstats->count ?
+            pstats->total * 1e-3 / pstats->count : 0.0;
+        break;
+    case ai_min:
+        prec->val = pstats->min * 1e-3;
+        break;
+    case ai_max:
+        prec->val = pstats->max * 1e-3;
+        break;
+    case ai_total:
+        prec->val = pstats->total * 1e-3;
+        break;
+    case ai_last:
+        prec->val = pstats->last * 1e-3;
+        break;
+    }
+    prec->udf = FALSE;
+    return 2;
+}
+
+struct {
+    dset common;
+    DEVSUPFUN read_write;
+    DEVSUPFUN special_linconv;
+} devAiProcStats = {
+    {6, NULL, NULL, init_ai, NULL}, read_ai, NULL
+};
+epicsExportAddress(dset, devAiProcStats);
+
+
+/********* waveform record **********/
+
+static long init_wf(waveformRecord *prec)
+{
+    char stat[20];
+    dbProcStats *pstats;
+    long status = devStatsWfInit(prec, "devWfProcStats");
+
+    if (status)
+        return status;
+
+    pstats = findStats((dbCommon *)prec, prec->inp.value.instio.string,
+        stat, sizeof(stat));
+    if (!pstats) {
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    prec->dpvt = pstats;
+    return 0;
+}
+
+static long read_wf(waveformRecord *prec)
+{
+    dbProcStats *pstats = (dbProcStats *)prec->dpvt;
+
+    if (!pstats) return -1;
+
+    devStatsWfStore(prec, pstats->hist, DBPS_NBINS);
+    return 0;
+}
+
+struct {
+    dset common;
+    DEVSUPFUN read_wf;
+} devWfProcStats = {
+    {5, NULL, NULL, init_wf, NULL}, read_wf
+};
+epicsExportAddress(dset, devWfProcStats);
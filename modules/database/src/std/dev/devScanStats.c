@@ -0,0 +1,271 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devScanStats.c */
+
+/* Device support reading the statistics of a periodic scan rate, see
+ * scanPeriodicStatus() in dbScan.h.  The INP field is "@rate statistic"
+ * for an ai, "@rate" for a stringin, which gets the name of the slowest
+ * record in the last pass, and "@rate" for a waveform, which gets the
+ * execution time histogram.  The rate is a menuScan choice such as
+ * "1 second", the statistics cover all threads scanning it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "dbDefs.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "dbStaticLib.h"
+#include "epicsString.h"
+#include "recGbl.h"
+#include "devSup.h"
+
+#include "aiRecord.h"
+#include "stringinRecord.h"
+#include "waveformRecord.h"
+#include "devStatsWf.h"
+#include "epicsExport.h"
+
+/* Return the menuScan choice naming a periodic rate, or NULL */
+static const char * findRate(dbCommon *prec, const char *rate)
+{
+    dbMenu *pmenu = dbFindMenu(pdbbase, "menuScan");
+    int i;
+
+    if (pmenu) {
+        for (i = SCAN_1ST_PERIODIC; i < pmenu->nChoice; i++) {
+            if (!epicsStrCaseCmp(rate, pmenu->papChoiceValue[i]))
+                return pmenu->papChoiceValue[i];
+        }
+    }
+    recGblRecordError(S_db_badField, prec,
+        "devScanStats: No such periodic scan rate");
+    return NULL;
+}
+
+static long readStats(dbCommon *prec, const char *rate,
+    scanPeriodicStats *pstats)
+{
+    if (scanPeriodicStatus(rate, -1, 0, pstats)) {
+        recGblSetSevr(prec, READ_ALARM, INVALID_ALARM);
+        return -1;
+    }
+    return 0;
+}
+
+/********* ai record **********/
+
+enum aiStat {ai_cycles, ai_overruns, ai_skipped, ai_jitter, ai_jitterAvg,
+    ai_jitterMax, ai_exec, ai_execAvg, ai_execMin, ai_execMax, ai_slowest};
+
+static const char * const aiStats[] = {
+    "cycles", "overruns", "skipped", "jitter", "jitterAvg", "jitterMax",
+    "exec", "execAvg", "execMin", "execMax", "slowest"
+};
+
+typedef struct aiPvt {
+    const char *rate;
+    enum aiStat stat;
+} aiPvt;
+
+static long init_ai(aiRecord *prec)
+{
+    char rate[40];
+    const char *parm = prec->inp.value.instio.string;
+    const char *word;
+    aiPvt *ppvt;
+    size_t len;
+    int i;
+
+    if (prec->inp.type != INST_IO) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "devAiScanStats::init_ai: Illegal INP field");
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+
+    ppvt = calloc(1, sizeof(aiPvt));
+    if (!ppvt) {
+        prec->pact = TRUE;
+        return S_db_noMemory;
+    }
+
+    /* The rate may contain spaces, the statistic is the last word */
+    word = strrchr(parm, ' ');
+    word = word ? word + 1 : parm;
+    len = word - parm;
+    ppvt->stat = ai_execAvg;
+    for (i = 0; i < NELEMENTS(aiStats); i++) {
+        if (!epicsStrCaseCmp(word, aiStats[i]))
+            break;
+    }
+    if (i < NELEMENTS(aiStats)) {
+        ppvt->stat = i;
+        while (len && parm[len - 1] == ' ')
+            len--;
+    }
+    else
+        len = strlen(parm);
+    if (len >= sizeof(rate))
+        len = sizeof(rate) - 1;
+    strncpy(rate, parm, len);
+    rate[len] = '\0';
+
+    ppvt->rate = findRate((dbCommon *)prec, rate);
+    if (!ppvt->rate) {
+        free(ppvt);
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    prec->dpvt = ppvt;
+    return 0;
+}
+
+/* Times are returned in milliseconds */
+static long read_ai(aiRecord *prec)
+{
+    aiPvt *ppvt = (aiPvt *)prec->dpvt;
+    scanPeriodicStats stats;
+
+    if (!ppvt) return -1;
+    if (readStats((dbCommon *)prec, ppvt->rate, &stats))
+        return -1;
+
+    switch (ppvt->stat) {
+    case ai_cycles:
+        prec->val = stats.cycles;
+        break;
+    case ai_overruns:
+        prec->val = stats.overruns;
+        break;
+    case ai_skipped:
+        prec->val = stats.skipped;
+        break;
+    case ai_jitter:
+        prec->val = stats.jitterLast * 1e3;
+        break;
+    case ai_jitterAvg:
+        prec->val = stats.jitterAvg * 1e3;
+        break;
+    case ai_jitterMax:
+        prec->val = stats.jitterMax * 1e3;
+        break;
+    case ai_exec:
+        prec->val = stats.execLast * 1e3;
+        break;
+    case ai_execAvg:
+        prec->val = stats.execAvg * 1e3;
+        break;
+    case ai_execMin:
+        prec->val = stats.execMin * 1e3;
+        break;
+    case ai_execMax:
+        prec->val = stats.execMax * 1e3;
+        break;
+    case ai_slowest:
+        prec->val = stats.slowestTime * 1e3;
+        break;
+    }
+    prec->udf = FALSE;
+    return 2;
+}
+
+struct {
+    dset common;
+    DEVSUPFUN read_write;
+    DEVSUPFUN special_linconv;
+} devAiScanStats = {
+    {6, NULL, NULL, init_ai, NULL}, read_ai, NULL
+};
+epicsExportAddress(dset, devAiScanStats);
+
+
+/********* stringin record **********/
+
+static long init_si(stringinRecord *prec)
+{
+    if (prec->inp.type != INST_IO) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "devSiScanStats::init_si: Illegal INP field");
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    prec->dpvt = (void *)findRate((dbCommon *)prec,
+        prec->inp.value.instio.string);
+    if (!prec->dpvt) {
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    return 0;
+}
+
+static long read_si(stringinRecord *prec)
+{
+    scanPeriodicStats stats;
+
+    if (!prec->dpvt) return -1;
+    if (readStats((dbCommon *)prec, prec->dpvt, &stats))
+        return -1;
+
+    strncpy(prec->val, stats.slowest, sizeof(prec->val));
+    prec->val[sizeof(prec->val) - 1] = '\0';
+    prec->udf = FALSE;
+    return 0;
+}
+
+struct {
+    dset common;
+    DEVSUPFUN read_stringin;
+} devSiScanStats = {
+    {5, NULL, NULL, init_si, NULL}, read_si
+};
+epicsExportAddress(dset, devSiScanStats);
+
+
+/********* waveform record **********/
+
+static long init_wf(waveformRecord *prec)
+{
+    long status = devStatsWfInit(prec, "devWfScanStats");
+
+    if (status)
+        return status;
+
+    prec->dpvt = (void *)findRate((dbCommon *)prec,
+        prec->inp.value.instio.string);
+    if (!prec->dpvt) {
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    return 0;
+}
+
+static long read_wf(waveformRecord *prec)
+{
+    scanPeriodicStats stats;
+    epicsUInt32 hist[SCAN_PERIODIC_NBINS];
+    int i;
+
+    if (!prec->dpvt) return -1;
+    if (readStats((dbCommon *)prec, prec->dpvt, &stats))
+        return -1;
+
+    for (i = 0; i < SCAN_PERIODIC_NBINS; i++)
+        hist[i] = stats.execHist[i];
+    devStatsWfStore(prec, hist, SCAN_PERIODIC_NBINS);
+    return 0;
+}
+
+struct {
+    dset common;
+    DEVSUPFUN read_wf;
+} devWfScanStats = {
+    {5, NULL, NULL, init_wf, NULL}, read_wf
+};
+epicsExportAddress(dset, devWfScanStats);
@@ -0,0 +1,60 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devStatsWf.c */
+
+#include "epicsStdio.h"
+
+#include "dbDefs.h"
+#include "dbAccess.h"
+#include "dbEvent.h"
+#include "recGbl.h"
+
+#include "devStatsWf.h"
+
+long devStatsWfInit(waveformRecord *prec, const char *dset)
+{
+    char msg[80];
+
+    if (prec->inp.type != INST_IO) {
+        epicsSnprintf(msg, sizeof(msg), "%s::init_wf: Illegal INP field",
+            dset);
+        recGblRecordError(S_db_badField, (void *)prec, msg);
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    if (prec->ftvl != menuFtypeULONG && prec->ftvl != menuFtypeDOUBLE) {
+        epicsSnprintf(msg, sizeof(msg),
+            "%s::init_wf: FTVL must be ULONG or DOUBLE", dset);
+        recGblRecordError(S_db_badField, (void *)prec, msg);
+        prec->pact = TRUE;
+        return S_db_badField;
+    }
+    return 0;
+}
+
+void devStatsWfStore(waveformRecord *prec, const epicsUInt32 *hist,
+    epicsUInt32 nbins)
+{
+    epicsUInt32 nord = prec->nord;
+    epicsUInt32 i, n = prec->nelm < nbins ? prec->nelm : nbins;
+
+    if (prec->ftvl == menuFtypeULONG) {
+        epicsUInt32 *pbuf = prec->bptr;
+
+        for (i = 0; i < n; i++)
+            pbuf[i] = hist[i];
+    }
+    else {
+        epicsFloat64 *pbuf = prec->bptr;
+
+        for (i = 0; i < n; i++)
+            pbuf[i] = hist[i];
+    }
+    prec->nord = n;
+    prec->udf = FALSE;
+    if (nord != prec->nord)
+        db_post_events(prec, &prec->nord, DBE_VALUE | DBE_LOG);
+}
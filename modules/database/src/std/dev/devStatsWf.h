@@ -0,0 +1,35 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* devStatsWf.h */
+
+/* Helpers shared by the waveform device supports which read a statistics
+ * histogram, devWfProcStats and devWfScanStats.  Not installed.
+ */
+
+#ifndef INC_devStatsWf_H
+#define INC_devStatsWf_H
+
+#include "epicsTypes.h"
+#include "waveformRecord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Check the INP and FTVL fields, dset names the device support in error
+ * messages.  Returns 0 or an S_db_ status with PACT set.
+ */
+long devStatsWfInit(waveformRecord *prec, const char *dset);
+
+/* Copy up to NELM bins into the waveform and set NORD */
+void devStatsWfStore(waveformRecord *prec, const epicsUInt32 *hist,
+    epicsUInt32 nbins);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_devStatsWf_H */
@@ -159,7 +159,13 @@ static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
             dbExtractArrayFromBuf(psrc, pdst, pfl->field_size, pfl->field_type,
                 nTarget, nSource, offset, my->incr);
         }
-        if (pfl->u.r.dtor) pfl->u.r.dtor(pfl);
+        if (pfl->u.r.dtor) {
+            /* Don't let db_delete_field_log() release a shared
+             * snapshot a second time */
+            pfl->u.r.dtor(pfl);
+            pfl->u.r.dtor = NULL;
+            pfl->u.r.field = NULL;
+        }
         if (nTarget) {
             pfl->u.r.dtor = freeArray;
             pfl->u.r.pvt = my->arrayFreeList;
@@ -9,6 +9,7 @@
 /*  Usage
  *      {calc:{expr:"A*B", args:[{...}, ...], units:"mm"}}
  *  First link in 'args' is 'A', second is 'B', and so forth.
+ *  Adding nelm:N makes the inputs and the result arrays of up to N elements.
  */
 
 #include <string.h>
@@ -20,6 +21,7 @@
 #include "dbDefs.h"
 #include "errlog.h"
 #include "epicsAssert.h"
+#include "epicsMath.h"
 #include "epicsString.h"
 #include "epicsTypes.h"
 #include "epicsTime.h"
@@ -45,7 +47,7 @@ typedef struct calc_link {
         ps_init,
         ps_expr, ps_major, ps_minor,
         ps_args, ps_out,
-        ps_prec,
+        ps_prec, ps_nelm,
         ps_units,
         ps_time,
         ps_error
@@ -59,6 +61,9 @@ typedef struct calc_link {
     char *post_expr;
     char *post_major;
     char *post_minor;
+    calcProgram *prog_expr;
+    calcProgram *prog_major;
+    calcProgram *prog_minor;
     char *units;
     short tinp;
     struct link inp[CALCPERFORM_NARGS];
@@ -66,6 +71,15 @@ typedef struct calc_link {
     double arg[CALCPERFORM_NARGS];
     epicsTimeStamp time;
     double val;
+    /* Array mode, only used when nelm is non-zero */
+    epicsUInt32 nelm;
+    double *abuf;
+    calcArrayArg aarg[CALCPERFORM_NARGS];
+    calcArrayArg aval;
+    calcArrayArg aalarm;
+    calcArrayStack *stk_expr;
+    calcArrayStack *stk_major;
+    calcArrayStack *stk_minor;
 } calc_link;
 
 static lset lnkCalc_lset;
@@ -97,6 +111,14 @@ static jlink* lnkCalc_alloc(short dbfType)
     return &clink->jlink;
 }
 
+static void arrayFree(calc_link *clink)
+{
+    calcArrayStackFree(clink->stk_expr);
+    calcArrayStackFree(clink->stk_major);
+    calcArrayStackFree(clink->stk_minor);
+    free(clink->abuf);
+}
+
 static void lnkCalc_free(jlink *pjlink)
 {
     calc_link *clink = CONTAINER(pjlink, struct calc_link, jlink);
@@ -113,6 +135,10 @@ static void lnkCalc_free(jlink *pjlink)
     free(clink->post_expr);
     free(clink->post_major);
     free(clink->post_minor);
+    calcProgramFree(clink->prog_expr);
+    calcProgramFree(clink->prog_major);
+    calcProgramFree(clink->prog_minor);
+    arrayFree(clink);
     free(clink->units);
     free(clink);
 }
@@ -126,6 +152,15 @@ static jlif_result lnkCalc_integer(jlink *pjlink, long long num)
         return jlif_continue;
     }
 
+    if (clink->pstate == ps_nelm) {
+        if (num < 0 || num > 0x7fffffff) {
+            errlogPrintf("lnkCalc: Bad 'nelm' parameter %lld\n", num);
+            return jlif_stop;
+        }
+        clink->nelm = num;
+        return jlif_continue;
+    }
+
     if (clink->pstate != ps_args) {
         errlogPrintf("lnkCalc: Unexpected integer %lld\n", num);
         return jlif_stop;
@@ -223,6 +258,19 @@ static jlif_result lnkCalc_string(jlink *pjlink, const char *val, size_t len)
         return jlif_stop;
     }
 
+    if (clink->pstate == ps_major) {
+        calcProgramFree(clink->prog_major);
+        clink->prog_major = calcCompile(postbuf);
+    }
+    else if (clink->pstate == ps_minor) {
+        calcProgramFree(clink->prog_minor);
+        clink->prog_minor = calcCompile(postbuf);
+    }
+    else {
+        calcProgramFree(clink->prog_expr);
+        clink->prog_expr = calcCompile(postbuf);
+    }
+
     return jlif_continue;
 }
 
@@ -270,6 +318,8 @@ static jlif_result lnkCalc_map_key(jlink *pjlink, const char *key, size_t len)
             clink->pstate = ps_prec;
         else if (!strncmp(key, "time", len))
             clink->pstate = ps_time;
+        else if (!strncmp(key, "nelm", len))
+            clink->pstate = ps_nelm;
         else {
             errlogPrintf("lnkCalc: Unknown key \"%.4s\"\n", key);
             return jlif_stop;
@@ -295,6 +345,60 @@ static jlif_result lnkCalc_map_key(jlink *pjlink, const char *key, size_t len)
     return jlif_continue;
 }
 
+static calcArrayStack * arrayStack(const char *post, epicsUInt32 nelm)
+{
+    calcArrayStack *pstack;
+
+    if (!post)
+        return NULL;
+    pstack = calcArrayStackCreate(post, nelm);
+    if (!pstack)
+        errlogPrintf("lnkCalc: Can't create array stack\n");
+    return pstack;
+}
+
+/* Allocate storage for array mode: the arguments, VAL and an alarm VAL.
+ * Arguments start out as scalars holding any numeric literals.
+ */
+static jlif_result arrayInit(calc_link *clink)
+{
+    epicsUInt32 nelm = clink->nelm;
+    double *pbuf;
+    int i;
+
+    pbuf = calloc((CALCPERFORM_NARGS + 2) * (size_t) nelm, sizeof(double));
+    if (!pbuf) {
+        errlogPrintf("lnkCalc: Out of memory\n");
+        return jlif_stop;
+    }
+    clink->abuf = pbuf;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++, pbuf += nelm) {
+        calcArrayArg *parg = &clink->aarg[i];
+
+        parg->pval = pbuf;
+        parg->pval[0] = clink->arg[i];
+        parg->nelm = 1;
+        parg->size = nelm;
+    }
+    clink->aval.pval = pbuf;
+    clink->aval.nelm = 1;
+    clink->aval.size = nelm;
+    clink->aalarm.pval = pbuf + nelm;
+    clink->aalarm.nelm = 1;
+    clink->aalarm.size = nelm;
+
+    clink->stk_expr = arrayStack(clink->post_expr, nelm);
+    clink->stk_major = arrayStack(clink->post_major, nelm);
+    clink->stk_minor = arrayStack(clink->post_minor, nelm);
+    if ((clink->post_expr && !clink->stk_expr) ||
+        (clink->post_major && !clink->stk_major) ||
+        (clink->post_minor && !clink->stk_minor))
+        return jlif_stop;
+
+    return jlif_continue;
+}
+
 static jlif_result lnkCalc_end_map(jlink *pjlink)
 {
     calc_link *clink = CONTAINER(pjlink, struct calc_link, jlink);
@@ -311,6 +415,8 @@ static jlif_result lnkCalc_end_map(jlink *pjlink)
         errlogPrintf("lnkCalc: No output link ('out' key)\n");
         return jlif_stop;
     }
+    else if (clink->nelm)
+        return arrayInit(clink);
 
     return jlif_continue;
 }
@@ -382,6 +488,10 @@ static void lnkCalc_report(const jlink *pjlink, int level, int indent)
         clink->expr, clink->prec, clink->val,
         clink->units ? clink->units : "");
 
+    if (level > 0 && clink->nelm)
+        printf("%*s  Array of %u/%u elements\n", indent, "",
+            clink->aval.nelm, clink->nelm);
+
     if (level > 0) {
         if (clink->sevr)
             printf("%*s  Alarm: %s, %s\n", indent, "",
@@ -455,7 +565,15 @@ static void lnkCalc_open(struct link *plink)
 
         child->precord = plink->precord;
         dbJLinkInit(child);
-        dbLoadLink(child, DBR_DOUBLE, &clink->arg[i]);
+        if (clink->nelm) {
+            calcArrayArg *parg = &clink->aarg[i];
+            long n = parg->size;
+
+            if (!dbLoadLinkArray(child, DBR_DOUBLE, parg->pval, &n))
+                parg->nelm = n;
+        }
+        else
+            dbLoadLink(child, DBR_DOUBLE, &clink->arg[i]);
     }
 
     if (clink->out.type == JSON_LINK) {
@@ -485,6 +603,10 @@ static void lnkCalc_remove(struct dbLocker *locker, struct link *plink)
     free(clink->post_expr);
     free(clink->post_major);
     free(clink->post_minor);
+    calcProgramFree(clink->prog_expr);
+    calcProgramFree(clink->prog_major);
+    calcProgramFree(clink->prog_minor);
+    arrayFree(clink);
     free(clink->units);
     free(clink);
     plink->value.json.jlink = NULL;
@@ -523,7 +645,10 @@ static int lnkCalc_getDBFtype(const struct link *plink)
 
 static long lnkCalc_getElements(const struct link *plink, long *nelements)
 {
-    *nelements = 1;
+    calc_link *clink = CONTAINER(plink->value.json.jlink,
+        struct calc_link, jlink);
+
+    *nelements = clink->nelm ? clink->nelm : 1;
     return 0;
 }
 
@@ -531,13 +656,13 @@ static long lnkCalc_getElements(const struct link *plink, long *nelements)
 struct lcvt {
     double *pval;
     epicsTimeStamp *ptime;
+    long nReq;
 };
 
 static long readLocked(struct link *pinp, void *vvt)
 {
     struct lcvt *pvt = (struct lcvt *) vvt;
-    long nReq = 1;
-    long status = dbGetLink(pinp, DBR_DOUBLE, pvt->pval, NULL, &nReq);
+    long status = dbGetLink(pinp, DBR_DOUBLE, pvt->pval, NULL, &pvt->nReq);
 
     if (!status && pvt->ptime)
         dbGetTimeStamp(pinp, pvt->ptime);
@@ -545,6 +670,165 @@ static long readLocked(struct link *pinp, void *vvt)
     return status;
 }
 
+/* Use the pre-decoded expression if there is one */
+static long calcEval(const calcProgram *prog, const char *post,
+    double *parg, double *presult)
+{
+    return prog ? calcRun(prog, parg, presult) :
+        calcPerform(parg, presult, post);
+}
+
+/* Array mode: read each non-constant input into its argument array */
+static void arrayFetch(calc_link *clink, dbCommon *prec)
+{
+    int i;
+
+    /* Any link errors will trigger a LINK/INVALID alarm in the child link */
+    for (i = 0; i < clink->nArgs; i++) {
+        struct link *child = &clink->inp[i];
+        calcArrayArg *parg = &clink->aarg[i];
+        long status;
+
+        if (dbLinkIsConstant(child))
+            continue;
+
+        if (i == clink->tinp) {
+            struct lcvt vt = {parg->pval, &clink->time, parg->size};
+
+            status = dbLinkDoLocked(child, readLocked, &vt);
+            if (status == S_db_noLSET)
+                status = readLocked(child, &vt);
+            if (!status)
+                parg->nelm = vt.nReq;
+
+            if (dbLinkIsConstant(&prec->tsel) &&
+                prec->tse == epicsTimeEventDeviceTime) {
+                prec->time = clink->time;
+            }
+        }
+        else {
+            long nReq = parg->size;
+
+            status = dbGetLink(child, DBR_DOUBLE, parg->pval, NULL, &nReq);
+            if (!status)
+                parg->nelm = nReq;
+        }
+    }
+    clink->stat = 0;
+    clink->sevr = 0;
+}
+
+/* Array mode: evaluate an alarm expression on a copy of VAL, in alarm if
+ * any element of the result is non-zero.
+ */
+static long arrayAlarm(calc_link *clink, dbCommon *prec, const char *post,
+    calcArrayStack *pstack, epicsEnum16 sevr)
+{
+    calcArrayArg *palarm = &clink->aalarm;
+    long status;
+    epicsUInt32 i;
+
+    memcpy(palarm->pval, clink->aval.pval,
+        clink->aval.nelm * sizeof(double));
+    palarm->nelm = clink->aval.nelm;
+
+    status = calcArrayPerform(clink->aarg, palarm, post, pstack);
+    if (status)
+        return status;
+
+    for (i = 0; i < palarm->nelm; i++) {
+        if (palarm->pval[i]) {
+            clink->stat = LINK_ALARM;
+            clink->sevr = sevr;
+            recGblSetSevr(prec, clink->stat, clink->sevr);
+            break;
+        }
+    }
+    return 0;
+}
+
+static long arrayAlarms(calc_link *clink, dbCommon *prec)
+{
+    long status = 0;
+
+    if (clink->post_major)
+        status = arrayAlarm(clink, prec, clink->post_major,
+            clink->stk_major, MAJOR_ALARM);
+
+    if (!status && !clink->sevr && clink->post_minor)
+        status = arrayAlarm(clink, prec, clink->post_minor,
+            clink->stk_minor, MINOR_ALARM);
+
+    return status;
+}
+
+static long arrayGetValue(calc_link *clink, dbCommon *prec, short dbrType,
+    void *pbuffer, long *pnRequest)
+{
+    FASTCONVERT conv = dbFastPutConvertRoutine[DBR_DOUBLE][dbrType];
+    long nRequest = pnRequest ? *pnRequest : 1;
+    long status = 0;
+
+    arrayFetch(clink, prec);
+
+    if (clink->post_expr) {
+        char *pdest = pbuffer;
+        int size = dbValueSize(dbrType);
+        long i, n;
+
+        status = calcArrayPerform(clink->aarg, &clink->aval,
+            clink->post_expr, clink->stk_expr);
+        n = status ? 0 : clink->aval.nelm;
+        if (n > nRequest)
+            n = nRequest;
+        for (i = 0; !status && i < n; i++, pdest += size)
+            status = conv(&clink->aval.pval[i], pdest, NULL);
+        clink->val = clink->aval.nelm ? clink->aval.pval[0] : epicsNAN;
+        if (!status && pnRequest)
+            *pnRequest = n;
+    }
+    else if (pnRequest)
+        *pnRequest = 0;
+
+    if (!status)
+        status = arrayAlarms(clink, prec);
+
+    return status;
+}
+
+static long arrayPutValue(calc_link *clink, dbCommon *prec, short dbrType,
+    const void *pbuffer, long nRequest)
+{
+    FASTCONVERT conv = dbFastGetConvertRoutine[dbrType][DBR_DOUBLE];
+    const char *psrc = pbuffer;
+    int size = dbValueSize(dbrType);
+    long status = 0;
+    long i;
+
+    arrayFetch(clink, prec);
+
+    /* Get the values being output as VAL */
+    if (nRequest > (long) clink->aval.size)
+        nRequest = clink->aval.size;
+    for (i = 0; !status && i < nRequest; i++, psrc += size)
+        status = conv(psrc, &clink->aval.pval[i], NULL);
+    clink->aval.nelm = nRequest;
+
+    if (!status && clink->post_expr)
+        status = calcArrayPerform(clink->aarg, &clink->aval,
+            clink->post_expr, clink->stk_expr);
+    clink->val = clink->aval.nelm ? clink->aval.pval[0] : epicsNAN;
+
+    if (!status)
+        status = arrayAlarms(clink, prec);
+
+    if (!status)
+        status = dbPutLink(&clink->out, DBR_DOUBLE, clink->aval.pval,
+            clink->aval.nelm);
+
+    return status;
+}
+
 static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     long *pnRequest)
 {
@@ -555,13 +839,16 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     long status;
     FASTCONVERT conv = dbFastPutConvertRoutine[DBR_DOUBLE][dbrType];
 
+    if (clink->nelm)
+        return arrayGetValue(clink, prec, dbrType, pbuffer, pnRequest);
+
     /* Any link errors will trigger a LINK/INVALID alarm in the child link */
     for (i = 0; i < clink->nArgs; i++) {
         struct link *child = &clink->inp[i];
         long nReq = 1;
 
         if (i == clink->tinp) {
-            struct lcvt vt = {&clink->arg[i], &clink->time};
+            struct lcvt vt = {&clink->arg[i], &clink->time, 1};
 
             status = dbLinkDoLocked(child, readLocked, &vt);
             if (status == S_db_noLSET)
@@ -579,7 +866,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     clink->sevr = 0;
 
     if (clink->post_expr) {
-        status = calcPerform(clink->arg, &clink->val, clink->post_expr);
+        status = calcEval(clink->prog_expr, clink->post_expr, clink->arg,
+            &clink->val);
         if (!status)
             status = conv(&clink->val, pbuffer, NULL);
         if (!status && pnRequest)
@@ -594,7 +882,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if (!status && clink->post_major) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_major);
+        status = calcEval(clink->prog_major, clink->post_major, clink->arg,
+            &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MAJOR_ALARM;
@@ -605,7 +894,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if (!status && !clink->sevr && clink->post_minor) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_minor);
+        status = calcEval(clink->prog_minor, clink->post_minor, clink->arg,
+            &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MINOR_ALARM;
@@ -626,13 +916,16 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     long status;
     FASTCONVERT conv = dbFastGetConvertRoutine[dbrType][DBR_DOUBLE];
 
+    if (clink->nelm)
+        return arrayPutValue(clink, prec, dbrType, pbuffer, nRequest);
+
     /* Any link errors will trigger a LINK/INVALID alarm in the child link */
     for (i = 0; i < clink->nArgs; i++) {
         struct link *child = &clink->inp[i];
         long nReq = 1;
 
         if (i == clink->tinp) {
-            struct lcvt vt = {&clink->arg[i], &clink->time};
+            struct lcvt vt = {&clink->arg[i], &clink->time, 1};
 
             status = dbLinkDoLocked(child, readLocked, &vt);
             if (status == S_db_noLSET)
@@ -653,12 +946,14 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     status = conv(pbuffer, &clink->val, NULL);
 
     if (!status && clink->post_expr)
-        status = calcPerform(clink->arg, &clink->val, clink->post_expr);
+        status = calcEval(clink->prog_expr, clink->post_expr, clink->arg,
+            &clink->val);
 
     if (!status && clink->post_major) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_major);
+        status = calcEval(clink->prog_major, clink->post_major, clink->arg,
+            &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MAJOR_ALARM;
@@ -669,7 +964,8 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     if (!status && !clink->sevr && clink->post_minor) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_minor);
+        status = calcEval(clink->prog_minor, clink->post_minor, clink->arg,
+            &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MINOR_ALARM;
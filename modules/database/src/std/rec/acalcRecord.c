@@ -0,0 +1,363 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Record Support Routines for Array Calculation records */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "errlog.h"
+#include "alarm.h"
+#include "cantProceed.h"
+#include "dbAccess.h"
+#include "dbEvent.h"
+#include "dbFldTypes.h"
+#include "dbLink.h"
+#include "errMdef.h"
+#include "recSup.h"
+#include "recGbl.h"
+#include "special.h"
+
+#define GEN_SIZE_OFFSET
+#include "acalcRecord.h"
+#undef  GEN_SIZE_OFFSET
+#include "epicsExport.h"
+
+/* Create RSET - Record Support Entry Table */
+
+#define report NULL
+#define initialize NULL
+static long init_record(struct dbCommon *prec, int pass);
+static long process(struct dbCommon *prec);
+static long special(DBADDR *paddr, int after);
+#define get_value NULL
+static long cvt_dbaddr(DBADDR *paddr);
+static long get_array_info(DBADDR *paddr, long *no_elements, long *offset);
+static long put_array_info(DBADDR *paddr, long nNew);
+static long get_units(DBADDR *paddr, char *units);
+static long get_precision(const DBADDR *paddr, long *precision);
+#define get_enum_str NULL
+#define get_enum_strs NULL
+#define put_enum_str NULL
+static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble *pgd);
+static long get_control_double(DBADDR *paddr, struct dbr_ctrlDouble *pcd);
+#define get_alarm_double NULL
+
+rset acalcRSET={
+    RSETNUMBER,
+    report,
+    initialize,
+    init_record,
+    process,
+    special,
+    get_value,
+    cvt_dbaddr,
+    get_array_info,
+    put_array_info,
+    get_units,
+    get_precision,
+    get_enum_str,
+    get_enum_strs,
+    put_enum_str,
+    get_graphic_double,
+    get_control_double,
+    get_alarm_double
+};
+epicsExportAddress(rset, acalcRSET);
+
+static void monitor(acalcRecord *prec, epicsUInt32 nord,
+    const epicsUInt32 *pne);
+static long fetch_values(acalcRecord *prec);
+static void compile(acalcRecord *prec);
+
+
+static long init_record(struct dbCommon *pcommon, int pass)
+{
+    struct acalcRecord *prec = (struct acalcRecord *)pcommon;
+    int i;
+
+    if (pass == 0) {
+        if (prec->nelm <= 0)
+            prec->nelm = 1;
+        prec->nord = (prec->nelm == 1);
+        prec->val = callocMustSucceed(prec->nelm, sizeof(double),
+            "acalc: VAL calloc failed");
+        for (i = 0; i < CALCPERFORM_NARGS; i++) {
+            epicsUInt32 *pne = &prec->nea + i;
+
+            (&prec->a)[i] = callocMustSucceed(prec->nelm, sizeof(double),
+                "acalc: input calloc failed");
+            if (*pne > prec->nelm)
+                *pne = prec->nelm;
+        }
+        return 0;
+    }
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        long n = prec->nelm;
+
+        if (dbLoadLinkArray(&prec->inpa + i, DBR_DOUBLE, (&prec->a)[i],
+                &n) == 0)
+            (&prec->nea)[i] = n;
+    }
+    compile(prec);
+    return 0;
+}
+
+static long process(struct dbCommon *pcommon)
+{
+    struct acalcRecord *prec = (struct acalcRecord *)pcommon;
+    epicsUInt32 nord = prec->nord;
+    epicsUInt32 ne[CALCPERFORM_NARGS];
+
+    memcpy(ne, &prec->nea, sizeof(ne));
+    prec->pact = TRUE;
+    if (fetch_values(prec) == 0) {
+        calcArrayArg args[CALCPERFORM_NARGS];
+        calcArrayArg val;
+        int i;
+
+        for (i = 0; i < CALCPERFORM_NARGS; i++) {
+            args[i].pval = (&prec->a)[i];
+            args[i].nelm = (&prec->nea)[i];
+            args[i].size = prec->nelm;
+        }
+        val.pval = prec->val;
+        val.nelm = prec->nord;
+        val.size = prec->nelm;
+
+        if (!prec->rstk ||
+            calcArrayPerform(args, &val, prec->rpcl, prec->rstk)) {
+            recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
+        } else {
+            prec->nord = val.nelm;
+            for (i = 0; i < CALCPERFORM_NARGS; i++)
+                (&prec->nea)[i] = args[i].nelm;
+            prec->udf = FALSE;
+        }
+    }
+
+    recGblGetTimeStamp(prec);
+    /* check event list */
+    monitor(prec, nord, ne);
+    /* process the forward scan link record */
+    recGblFwdLink(prec);
+    prec->pact = FALSE;
+    return 0;
+}
+
+static long special(DBADDR *paddr, int after)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+
+    if (!after) return 0;
+    if (paddr->special == SPC_CALC) {
+        compile(prec);
+        return prec->rstk ? 0 : S_db_badField;
+    }
+    recGblDbaddrError(S_db_badChoice, paddr, "acalc::special - bad special value!");
+    return S_db_badChoice;
+}
+
+#define indexof(field) acalcRecord##field
+
+static long cvt_dbaddr(DBADDR *paddr)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex == indexof(VAL))
+        paddr->pfield = prec->val;
+    else if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        paddr->pfield = (&prec->a)[fieldIndex - indexof(A)];
+    else {
+        errlogPrintf("acalcRecord::cvt_dbaddr called for %s.%s\n",
+            prec->name, paddr->pfldDes->name);
+        return 0;
+    }
+    paddr->no_elements    = prec->nelm;
+    paddr->field_type     = DBF_DOUBLE;
+    paddr->field_size     = sizeof(double);
+    paddr->dbr_field_type = DBF_DOUBLE;
+    return 0;
+}
+
+static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex == indexof(VAL))
+        *no_elements = prec->nord;
+    else if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        *no_elements = (&prec->nea)[fieldIndex - indexof(A)];
+    else {
+        errlogPrintf("acalcRecord::get_array_info called for %s.%s\n",
+            prec->name, paddr->pfldDes->name);
+    }
+    *offset = 0;
+    return 0;
+}
+
+static long put_array_info(DBADDR *paddr, long nNew)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+    epicsUInt32 *pne;
+
+    if (fieldIndex == indexof(VAL))
+        pne = &prec->nord;
+    else if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        pne = &prec->nea + (fieldIndex - indexof(A));
+    else {
+        errlogPrintf("acalcRecord::put_array_info called for %s.%s\n",
+            prec->name, paddr->pfldDes->name);
+        return 0;
+    }
+    if (nNew > prec->nelm)
+        nNew = prec->nelm;
+    if (*pne != nNew) {
+        *pne = nNew;
+        db_post_events(prec, pne, DBE_VALUE | DBE_LOG);
+    }
+    return 0;
+}
+
+static long get_units(DBADDR *paddr, char *units)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))
+        dbGetUnits(&prec->inpa + (fieldIndex - indexof(A)), units,
+            DB_UNITS_SIZE);
+    else if (fieldIndex == indexof(VAL) ||
+             paddr->pfldDes->field_type == DBF_DOUBLE)
+        strncpy(units, prec->egu, DB_UNITS_SIZE);
+    return 0;
+}
+
+static long get_precision(const DBADDR *paddr, long *pprecision)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    *pprecision = prec->prec;
+    if (fieldIndex == indexof(VAL))
+        return 0;
+
+    if (fieldIndex >= indexof(A) && fieldIndex <= indexof(L)) {
+        short precision;
+
+        if (dbGetPrecision(&prec->inpa + (fieldIndex - indexof(A)),
+                &precision) == 0)
+            *pprecision = precision;
+    } else
+        recGblGetPrec(paddr, pprecision);
+    return 0;
+}
+
+static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble *pgd)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex == indexof(VAL) ||
+        (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))) {
+        pgd->lower_disp_limit = prec->lopr;
+        pgd->upper_disp_limit = prec->hopr;
+    } else if (fieldIndex == indexof(NORD) ||
+        (fieldIndex >= indexof(NEA) && fieldIndex <= indexof(NEL))) {
+        pgd->lower_disp_limit = 0;
+        pgd->upper_disp_limit = prec->nelm;
+    } else
+        recGblGetGraphicDouble(paddr, pgd);
+    return 0;
+}
+
+static long get_control_double(DBADDR *paddr, struct dbr_ctrlDouble *pcd)
+{
+    acalcRecord *prec = (acalcRecord *)paddr->precord;
+    int fieldIndex = dbGetFieldIndex(paddr);
+
+    if (fieldIndex == indexof(VAL) ||
+        (fieldIndex >= indexof(A) && fieldIndex <= indexof(L))) {
+        pcd->lower_ctrl_limit = prec->lopr;
+        pcd->upper_ctrl_limit = prec->hopr;
+    } else if (fieldIndex == indexof(NORD) ||
+        (fieldIndex >= indexof(NEA) && fieldIndex <= indexof(NEL))) {
+        pcd->lower_ctrl_limit = 0;
+        pcd->upper_ctrl_limit = prec->nelm;
+    } else
+        recGblGetControlDouble(paddr, pcd);
+    return 0;
+}
+
+/* Convert CALC and replace the work stack */
+static void compile(acalcRecord *prec)
+{
+    short error_number;
+
+    calcArrayStackFree(prec->rstk);
+    prec->rstk = NULL;
+    if (postfix(prec->calc, prec->rpcl, &error_number)) {
+        recGblRecordError(S_db_badField, (void *)prec,
+                          "acalc: Illegal CALC field");
+        errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
+                     prec->name, calcErrorStr(error_number), prec->calc);
+        return;
+    }
+    prec->rstk = calcArrayStackCreate(prec->rpcl, prec->nelm);
+    if (!prec->rstk)
+        errlogPrintf("%s.CALC: Can't create work stack for \"%s\"\n",
+                     prec->name, prec->calc);
+}
+
+static void monitor(acalcRecord *prec, epicsUInt32 nord,
+    const epicsUInt32 *pne)
+{
+    unsigned monitor_mask = recGblResetAlarms(prec) | DBE_VALUE | DBE_LOG;
+    unsigned long stores = 0;
+    int i;
+
+    db_post_events(prec, prec->val, monitor_mask);
+    if (prec->nord != nord)
+        db_post_events(prec, &prec->nord, monitor_mask);
+
+    /* inputs that may have new contents */
+    calcArgUsage(prec->rpcl, NULL, &stores);
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        if (!dbLinkIsConstant(&prec->inpa + i) || (stores & (1 << i))) {
+            db_post_events(prec, (&prec->a)[i], monitor_mask);
+            if ((&prec->nea)[i] != pne[i])
+                db_post_events(prec, &prec->nea + i, monitor_mask);
+        }
+    }
+}
+
+static long fetch_values(acalcRecord *prec)
+{
+    long status = 0;
+    int i;
+
+    for (i = 0; i < CALCPERFORM_NARGS; i++) {
+        struct link *plink = &prec->inpa + i;
+        long nRequest = prec->nelm;
+        long newStatus;
+
+        if (dbLinkIsConstant(plink))
+            continue;
+        newStatus = dbGetLink(plink, DBR_DOUBLE, (&prec->a)[i], 0, &nRequest);
+        if (newStatus == 0)
+            (&prec->nea)[i] = nRequest;
+        else if (status == 0)
+            status = newStatus;
+    }
+    return status;
+}
@@ -212,6 +212,8 @@ static long init_record(struct dbCommon *pcommon, int pass)
         errlogPrintf("%s.OCAL: %s in expression \"%s\"\n",
                      prec->name, calcErrorStr(error_number), prec->ocal);
     }
+    prec->rprg = calcCompile(prec->rpcl);
+    prec->orpg = calcCompile(prec->orpc);
 
     prpvt = prec->rpvt;
     callbackSetCallback(checkLinksCallback, &prpvt->checkLinkCb);
@@ -243,7 +245,8 @@ static long process(struct dbCommon *pcommon)
             checkLinks(prec);
         }
         if (fetch_values(prec) == 0) {
-            if (calcPerform(&prec->a, &prec->val, prec->rpcl)) {
+            if (prec->rprg ? calcRun(prec->rprg, &prec->a, &prec->val) :
+                calcPerform(&prec->a, &prec->val, prec->rpcl)) {
                 recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
             } else {
                 prec->udf = isnan(prec->val);
@@ -327,6 +330,8 @@ static long special(DBADDR *paddr, int after)
     switch(fieldIndex) {
       case(calcoutRecordCALC):
         prec->clcv = postfix(prec->calc, prec->rpcl, &error_number);
+        calcProgramFree(prec->rprg);
+        prec->rprg = calcCompile(prec->rpcl);
         if (prec->clcv){
             recGblRecordError(S_db_badField, (void *)prec,
                       "calcout: special(): Illegal CALC field");
@@ -338,6 +343,8 @@ static long special(DBADDR *paddr, int after)
 
       case(calcoutRecordOCAL):
         prec->oclv = postfix(prec->ocal, prec->orpc, &error_number);
+        calcProgramFree(prec->orpg);
+        prec->orpg = calcCompile(prec->orpc);
         if (prec->dopt == calcoutDOPT_Use_OVAL && prec->oclv){
             recGblRecordError(S_db_badField, (void *)prec,
                     "calcout: special(): Illegal OCAL field");
@@ -612,7 +619,8 @@ static void execOutput(calcoutRecord *prec)
         prec->oval = prec->val;
         break;
     case calcoutDOPT_Use_OVAL:
-        if (calcPerform(&prec->a, &prec->oval, prec->orpc)) {
+        if (prec->orpg ? calcRun(prec->orpg, &prec->a, &prec->oval) :
+            calcPerform(&prec->a, &prec->oval, prec->orpc)) {
             recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
         } else {
             prec->udf = isnan(prec->oval);
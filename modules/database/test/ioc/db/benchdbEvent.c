@@ -0,0 +1,195 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Measure monitor throughput of the event queue with many subscriptions,
+ * delivering events one at a time or in batches.  The consumer mimics
+ * the CA server: it copies each update into a buffer under a lock, and
+ * "sends" the buffer when the queue runs empty or the buffer is full.
+ * Each round posts a burst of updates while the consumer is held up on
+ * that lock, as happens when a client is slow to drain its socket.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "caeventmask.h"
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "dbCommon.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "xRecord.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NSUBS 1000
+#define NPOSTS 3
+#define NROUNDS 500
+#define BUFSIZE 16384
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+typedef struct {
+    epicsMutexId lock;
+    epicsEventId idle;
+    char buf[BUFSIZE];
+    char out[BUFSIZE];
+    size_t used;
+    size_t nEvents;
+    size_t nLocks;
+    size_t nSends;
+} benchPvt;
+
+static void flush(benchPvt *pvt)
+{
+    memcpy(pvt->out, pvt->buf, pvt->used);
+    pvt->used = 0;
+    pvt->nSends++;
+}
+
+static void encode(benchPvt *pvt, dbChannel *chan, db_field_log *pfl)
+{
+    epicsInt32 val;
+
+    if (pvt->used + 16 + sizeof(val) > BUFSIZE)
+        flush(pvt);
+    dbChannelGet(chan, DBR_LONG, &val, NULL, NULL, pfl);
+    memset(pvt->buf + pvt->used, 0, 16);
+    memcpy(pvt->buf + pvt->used + 16, &val, sizeof(val));
+    pvt->used += 16 + sizeof(val);
+    pvt->nEvents++;
+}
+
+static void monitor(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    benchPvt *pvt = user_arg;
+
+    epicsMutexMustLock(pvt->lock);
+    pvt->nLocks++;
+    encode(pvt, chan, pfl);
+    if (!eventsRemaining) {
+        flush(pvt);
+        epicsEventSignal(pvt->idle);
+    }
+    epicsMutexUnlock(pvt->lock);
+}
+
+static void batch(void *arg, dbEventBatchEntry *entries, unsigned count,
+    int eventsRemaining)
+{
+    benchPvt *pvt = arg;
+    unsigned i;
+
+    epicsMutexMustLock(pvt->lock);
+    pvt->nLocks++;
+    for (i = 0; i < count; i++)
+        encode(pvt, entries[i].chan, entries[i].pfl);
+    if (!eventsRemaining) {
+        flush(pvt);
+        epicsEventSignal(pvt->idle);
+    }
+    epicsMutexUnlock(pvt->lock);
+}
+
+static void runBench(benchPvt *pvt, dbChannel *chan, unsigned maxBatch)
+{
+    static dbEventSubscription subs[NSUBS];
+    xRecord *prec = (xRecord *) dbChannelRecord(chan);
+    dbEventQueueStats stats;
+    epicsTimeStamp start, stop;
+    dbEventCtx ctx;
+    double elapsed;
+    int i, round;
+
+    pvt->used = pvt->nEvents = pvt->nLocks = pvt->nSends = 0;
+
+    ctx = db_init_events();
+    if (!ctx)
+        testAbort("Can't create event context");
+    if (maxBatch && db_set_event_batch(ctx, batch, pvt, maxBatch))
+        testAbort("Can't set batch function");
+    if (db_start_events(ctx, "bench", NULL, NULL, epicsThreadPriorityMedium))
+        testAbort("Can't start event task");
+
+    for (i = 0; i < NSUBS; i++) {
+        subs[i] = db_add_event(ctx, chan, monitor, pvt, DBE_VALUE);
+        if (!subs[i])
+            testAbort("db_add_event() failed");
+        db_event_enable(subs[i]);
+    }
+
+    epicsTimeGetCurrent(&start);
+    for (round = 0; round < NROUNDS; round++) {
+        epicsMutexMustLock(pvt->lock);
+        for (i = 1; i <= NPOSTS; i++) {
+            dbScanLock((dbCommon *) prec);
+            prec->val = round * NPOSTS + i;
+            db_post_events(prec, &prec->val, DBE_VALUE);
+            dbScanUnlock((dbCommon *) prec);
+        }
+        epicsMutexUnlock(pvt->lock);
+        do {
+            epicsEventWaitWithTimeout(pvt->idle, 1.0);
+            db_event_queue_stats(ctx, &stats, 0);
+        } while (stats.used);
+    }
+    epicsMutexMustLock(pvt->lock);
+    epicsTimeGetCurrent(&stop);
+    epicsMutexUnlock(pvt->lock);
+    elapsed = epicsTimeDiffInSeconds(&stop, &start);
+
+    testDiag("batch %3u: %lu events in %.3f s, %.2f M events/s, "
+        "%.1f events/lock, %.1f events/send, %lu overflows",
+        maxBatch, (unsigned long) pvt->nEvents, elapsed,
+        pvt->nEvents / elapsed / 1e6,
+        (double) pvt->nEvents / (pvt->nLocks ? pvt->nLocks : 1),
+        (double) pvt->nEvents / (pvt->nSends ? pvt->nSends : 1),
+        stats.nOverflow);
+
+    for (i = 0; i < NSUBS; i++)
+        db_cancel_event(subs[i]);
+    db_close_events(ctx);
+}
+
+MAIN(benchdbEvent)
+{
+    static benchPvt pvt;
+    dbChannel *chan;
+    unsigned maxBatch;
+
+    testPlan(0);
+
+    pvt.lock = epicsMutexMustCreate();
+    pvt.idle = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+    testIocInitOk();
+
+    chan = dbChannelCreate("x.VAL");
+    if (!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel x.VAL");
+
+    testDiag("%d subscriptions, %d rounds of %d posts", NSUBS, NROUNDS,
+        NPOSTS);
+    runBench(&pvt, chan, 0);
+    for (maxBatch = 1; maxBatch <= 256; maxBatch *= 4)
+        runBench(&pvt, chan, maxBatch);
+
+    dbChannelDelete(chan);
+    testIocShutdownOk();
+    testdbCleanup();
+
+    epicsMutexDestroy(pvt.lock);
+    epicsEventDestroy(pvt.idle);
+    return testDone();
+}
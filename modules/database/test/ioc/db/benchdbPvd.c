@@ -0,0 +1,140 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Measure record name lookup throughput of the process variable
+ * directory with several threads searching concurrently.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "dbBase.h"
+#include "dbStaticLib.h"
+#include "dbStaticPvt.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NRECORDS 1000000
+#define NLOOKUPS 2000000
+#define NAMELEN 24
+
+typedef struct {
+    DBBASE *pdbbase;
+    char (*names)[NAMELEN];
+    int hitPercent;
+    epicsEventId done;
+    int threadsRunning;
+    size_t found;
+} benchPvt;
+
+static void lookupTask(void *arg)
+{
+    benchPvt *pvt = (benchPvt *) arg;
+    /* per-thread LCG, so threads don't share a random state */
+    unsigned int seed = (unsigned int) (size_t) epicsThreadGetIdSelf();
+    size_t found = 0;
+    int i;
+
+    for (i = 0; i < NLOOKUPS; i++) {
+        char miss[NAMELEN];
+        const char *name;
+        size_t len;
+
+        seed = seed * 1103515245u + 12345u;
+        name = pvt->names[(seed >> 8) % NRECORDS];
+        if ((int) ((seed >> 16) % 100) >= pvt->hitPercent) {
+            sprintf(miss, "%s:MISS", name);
+            name = miss;
+        }
+        len = strlen(name);
+        if (dbPvdFind(pvt->pdbbase, name, len))
+            found++;
+    }
+    epicsAtomicAddSizeT(&pvt->found, found);
+    if (epicsAtomicDecrIntT(&pvt->threadsRunning) == 0)
+        epicsEventSignal(pvt->done);
+}
+
+static void runBench(benchPvt *pvt, int nthreads, int hitPercent)
+{
+    epicsTimeStamp start, stop;
+    double elapsed;
+    int i;
+
+    pvt->hitPercent = hitPercent;
+    pvt->found = 0;
+    pvt->threadsRunning = nthreads;
+
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < nthreads; i++) {
+        char name[20];
+
+        sprintf(name, "lookup%d", i);
+        epicsThreadMustCreate(name, epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            lookupTask, pvt);
+    }
+    epicsEventMustWait(pvt->done);
+    epicsTimeGetCurrent(&stop);
+    elapsed = epicsTimeDiffInSeconds(&stop, &start);
+
+    testDiag("%2d threads, %3d%% hits: %.3f s, %.2f M lookups/s (%lu found)",
+        nthreads, hitPercent, elapsed,
+        (double) nthreads * NLOOKUPS / elapsed / 1e6,
+        (unsigned long) pvt->found);
+}
+
+MAIN(benchdbPvd)
+{
+    benchPvt pvt;
+    dbRecordNode *nodes;
+    int ncpus = epicsThreadGetCPUs();
+    int nthreads;
+    epicsTimeStamp start, stop;
+    int i;
+
+    testPlan(0);
+
+    memset(&pvt, 0, sizeof(pvt));
+    pvt.done = epicsEventMustCreate(epicsEventEmpty);
+    pvt.names = callocMustSucceed(NRECORDS, NAMELEN, "benchdbPvd");
+    nodes = callocMustSucceed(NRECORDS, sizeof(dbRecordNode), "benchdbPvd");
+    pvt.pdbbase = dbAllocBase();
+
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < NRECORDS; i++) {
+        sprintf(pvt.names[i], "BENCH:%03d:rec%06d", i % 997, i);
+        nodes[i].recordname = pvt.names[i];
+        if (!dbPvdAdd(pvt.pdbbase, NULL, &nodes[i]))
+            testAbort("dbPvdAdd(%s) failed", pvt.names[i]);
+    }
+    epicsTimeGetCurrent(&stop);
+    testDiag("Added %d records in %.3f s", NRECORDS,
+        epicsTimeDiffInSeconds(&stop, &start));
+
+    for (nthreads = 1; nthreads <= 2 * ncpus; nthreads *= 2) {
+        runBench(&pvt, nthreads, 100);
+        runBench(&pvt, nthreads, 10);
+    }
+
+    testDiag("With a negative lookup filter of 16 counters per name");
+    dbPvdFilterSize(16);
+    dbPvdFilterInit(pvt.pdbbase);
+    for (nthreads = 1; nthreads <= 2 * ncpus; nthreads *= 2) {
+        runBench(&pvt, nthreads, 100);
+        runBench(&pvt, nthreads, 10);
+    }
+    dbPvdFilterShow(pvt.pdbbase, 0);
+
+    dbFreeBase(pvt.pdbbase);
+    free(nodes);
+    free(pvt.names);
+    epicsEventDestroy(pvt.done);
+    return testDone();
+}
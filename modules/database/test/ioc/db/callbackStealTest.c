@@ -0,0 +1,106 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Tests for the work-stealing callback thread mode */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "callback.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+/*
+ * All requests below share one user pointer, so they all start out on
+ * the same worker queue.  The first one blocks its worker until the
+ * others have run, which can only happen if another worker steals them.
+ */
+
+#define NCALLBACKS 100
+#define NWORKERS 2
+
+static epicsCallback blocker;
+static epicsCallback cbs[NCALLBACKS];
+static epicsEventId blockerStarted;
+static epicsEventId releaseBlocker;
+static epicsEventId allDone;
+static int counter;
+static int shared;
+
+static void blockCallback(epicsCallback *pCallback)
+{
+    epicsEventSignal(blockerStarted);
+    epicsEventMustWait(releaseBlocker);
+}
+
+static void countCallback(epicsCallback *pCallback)
+{
+    if (epicsAtomicIncrIntT(&counter) == NCALLBACKS)
+        epicsEventSignal(allDone);
+}
+
+MAIN(callbackStealTest)
+{
+    callbackQueueStats stats;
+    int i, prio;
+
+    testPlan(11);
+
+    blockerStarted = epicsEventMustCreate(epicsEventEmpty);
+    releaseBlocker = epicsEventMustCreate(epicsEventEmpty);
+    allDone = epicsEventMustCreate(epicsEventEmpty);
+
+    testOk(callbackWorkStealingThreads(NWORKERS, "Low") == -1,
+        "Priority names need pdbbase");
+    testOk(callbackWorkStealingThreads(NWORKERS, "") == 0,
+        "Configure %d work-stealing threads for all priorities", NWORKERS);
+
+    callbackInit();
+
+    testOk(callbackWorkStealingThreads(NWORKERS, "") == -1,
+        "Configuration rejected after callbackInit()");
+
+    for (prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
+        testDiag("Priority %d", prio);
+        epicsAtomicSetIntT(&counter, 0);
+
+        callbackSetCallback(blockCallback, &blocker);
+        callbackSetPriority(prio, &blocker);
+        callbackSetUser(&shared, &blocker);
+        callbackRequest(&blocker);
+        epicsEventMustWait(blockerStarted);
+
+        for (i = 0; i < NCALLBACKS; i++) {
+            callbackSetCallback(countCallback, &cbs[i]);
+            callbackSetPriority(prio, &cbs[i]);
+            callbackSetUser(&shared, &cbs[i]);
+            callbackRequest(&cbs[i]);
+        }
+
+        testOk(epicsEventWaitWithTimeout(allDone, 10.0) == epicsEventOK,
+            "Requests stolen while their home worker is blocked");
+        testOk(epicsAtomicGetIntT(&counter) == NCALLBACKS,
+            "All %d callbacks ran", NCALLBACKS);
+        epicsEventSignal(releaseBlocker);
+    }
+
+    testOk1(callbackQueueStatus(0, &stats) == 0);
+    testOk(stats.numOverflow[0] + stats.numOverflow[1] +
+        stats.numOverflow[2] == 0, "No queue overflows");
+
+    callbackStop();
+    callbackCleanup();
+
+    epicsEventDestroy(blockerStarted);
+    epicsEventDestroy(releaseBlocker);
+    epicsEventDestroy(allDone);
+
+    return testDone();
+}
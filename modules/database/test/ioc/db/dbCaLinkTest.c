@@ -615,9 +615,88 @@ static void testCAC(void)
     free(buftarg2);
 }
 
+#define NWORKLINKS 8
+
+static void testWorkers(void)
+{
+    DBLINK *plinks[NWORKLINKS];
+    dbCaWorkerStats stats;
+    int i, channels = 0, used = 0, written = 0;
+
+    testDiag("Links shared by several dbCa workers");
+
+    testOk1(dbCaSetThreads(3)==0);
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    for (i = 0; i < NWORKLINKS; i++) {
+        char macros[8];
+
+        sprintf(macros, "N=%d", i);
+        testdbReadDatabase("dbCaLinkTest4.db", NULL, macros);
+    }
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    for (i = 0; i < NWORKLINKS; i++) {
+        char name[16];
+
+        sprintf(name, "source%d", i);
+        plinks[i] = &((xRecord*)testdbRecordPtr(name))->lnk;
+        waitForUpdateN(plinks[i], 1);
+    }
+
+    for (i = 0; dbCaWorkerStatus(i, &stats) == 0; i++) {
+        testDiag("worker %d: %d channels, %lu actions", i,
+            stats.channels, stats.actions);
+        channels += stats.channels;
+        if (stats.channels)
+            used++;
+    }
+    testOp("%d",i,==,3);
+    testOp("%d",channels,==,NWORKLINKS);
+    testOk(used > 1, "Links spread over %d workers", used);
+
+    /* dbCaSync() waits for the puts queued on every worker */
+    for (i = 0; i < NWORKLINKS; i++) {
+        epicsInt32 temp = 100 + i;
+
+        dbScanLock(plinks[i]->precord);
+        dbPutLink(plinks[i], DBR_LONG, &temp, 1);
+        dbScanUnlock(plinks[i]->precord);
+    }
+    dbCaSync();
+    for (i = 0; i < NWORKLINKS; i++) {
+        char name[16];
+        xRecord *ptarg;
+
+        sprintf(name, "target%d", i);
+        ptarg = (xRecord*)testdbRecordPtr(name);
+        dbScanLock((dbCommon*)ptarg);
+        if (ptarg->val == 100 + i)
+            written++;
+        dbScanUnlock((dbCommon*)ptarg);
+    }
+    testOp("%d",written,==,NWORKLINKS);
+
+    testOk1(dbCaSetThreads(1)==-1);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    dbCaSetThreads(1);
+}
+
 MAIN(dbCaLinkTest)
 {
-    testPlan(101);
+    testPlan(107);
     testNativeLink();
     testStringLink();
     testCP();
@@ -627,5 +706,6 @@ MAIN(dbCaLinkTest)
     testArrayLink(10,10);
     testreTargetTypeChange();
     testCAC();
+    testWorkers();
     return testDone();
 }
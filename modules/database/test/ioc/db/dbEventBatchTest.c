@@ -0,0 +1,200 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Tests for batched event delivery */
+
+#include <string.h>
+
+#include "caeventmask.h"
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "dbCommon.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+#include "xRecord.h"
+
+#define NSUBS 10
+#define NPOSTS 5
+#define MAXBATCH 4
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void monitor(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    /* only called through the batch function */
+}
+
+typedef struct {
+    dbEventSubscription subs[NSUBS];
+    epicsInt32 last[NSUBS];
+    epicsEventId started;
+    epicsEventId release;
+    epicsEventId done;
+    unsigned nBatches;
+    unsigned nEvents;
+    unsigned maxCount;
+    int ordered;
+    int foreign;
+    int cancelOn;
+    int canceled;
+} batchPvt;
+
+static void batch(void *arg, dbEventBatchEntry *entries, unsigned count,
+    int eventsRemaining)
+{
+    batchPvt *pvt = arg;
+    unsigned i;
+
+    if (pvt->nBatches++ == 0) {
+        epicsEventSignal(pvt->started);
+        epicsEventMustWait(pvt->release);
+    }
+    if (count > pvt->maxCount)
+        pvt->maxCount = count;
+    if (pvt->canceled)
+        pvt->foreign++;
+
+    for (i = 0; i < count && !pvt->canceled; i++) {
+        size_t n = (epicsInt32 *) entries[i].user_arg - pvt->last;
+        epicsInt32 val;
+
+        if (entries[i].user_sub != monitor ||
+                n >= NSUBS || entries[i].sub != pvt->subs[n]) {
+            pvt->foreign++;
+            continue;
+        }
+        if (dbChannelGet(entries[i].chan, DBR_LONG, &val, NULL, NULL,
+                entries[i].pfl))
+            continue;
+        if (val <= pvt->last[n])
+            pvt->ordered = 0;
+        pvt->last[n] = val;
+        pvt->nEvents++;
+
+        if (val == pvt->cancelOn) {
+            int j;
+
+            /* the rest of this batch must be ignored now */
+            for (j = 0; j < NSUBS; j++)
+                db_cancel_event(pvt->subs[j]);
+            pvt->canceled = 1;
+        }
+    }
+    if (!eventsRemaining)
+        epicsEventSignal(pvt->done);
+}
+
+static void post(xRecord *prec, epicsInt32 val)
+{
+    dbScanLock((dbCommon *) prec);
+    prec->val = val;
+    db_post_events(prec, &prec->val, DBE_VALUE);
+    dbScanUnlock((dbCommon *) prec);
+}
+
+MAIN(dbEventBatchTest)
+{
+    batchPvt pvt;
+    dbChannel *chan;
+    xRecord *prec;
+    dbEventCtx ctx;
+    int i, complete;
+
+    testPlan(10);
+
+    memset(&pvt, 0, sizeof(pvt));
+    pvt.started = epicsEventMustCreate(epicsEventEmpty);
+    pvt.release = epicsEventMustCreate(epicsEventEmpty);
+    pvt.done = epicsEventMustCreate(epicsEventEmpty);
+    pvt.ordered = 1;
+    pvt.cancelOn = -1;
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    testIocInitOk();
+
+    chan = dbChannelCreate("x.VAL");
+    if (!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel x.VAL");
+    prec = (xRecord *) dbChannelRecord(chan);
+
+    ctx = db_init_events();
+    if (!ctx)
+        testAbort("Can't create event context");
+
+    testOk(db_set_event_batch(ctx, batch, &pvt, 0) == DB_EVENT_ERROR,
+        "Batch size 0 rejected");
+    testOk(db_set_event_batch(ctx, batch, &pvt, MAXBATCH) == DB_EVENT_OK,
+        "Batch function set");
+
+    if (db_start_events(ctx, "batch", NULL, NULL, epicsThreadPriorityMedium))
+        testAbort("Can't start event task");
+
+    testOk(db_set_event_batch(ctx, NULL, NULL, 0) == DB_EVENT_ERROR,
+        "Can't change batch function once started");
+
+    for (i = 0; i < NSUBS; i++) {
+        pvt.subs[i] = db_add_event(ctx, chan, monitor, &pvt.last[i],
+            DBE_VALUE);
+        if (!pvt.subs[i])
+            testAbort("db_add_event() failed");
+        db_event_enable(pvt.subs[i]);
+    }
+
+    testDiag("Hold up the first batch while more events are queued");
+    post(prec, 1);
+    epicsEventMustWait(pvt.started);
+    for (i = 2; i <= NPOSTS; i++)
+        post(prec, i);
+    epicsEventSignal(pvt.release);
+
+    for (complete = 0, i = 0; i < 100 && !complete; i++) {
+        int j;
+
+        epicsEventWaitWithTimeout(pvt.done, 0.1);
+        for (complete = 1, j = 0; j < NSUBS; j++)
+            if (pvt.last[j] != NPOSTS)
+                complete = 0;
+    }
+    testOk(complete, "Every subscription saw the last update");
+    testOk(pvt.ordered, "Updates arrive in order");
+    testOk(pvt.foreign == 0, "Entries carry the subscription's arguments");
+    testOk(pvt.maxCount > 1 && pvt.maxCount <= MAXBATCH,
+        "Batches of up to %u events (%u events in %u batches)",
+        pvt.maxCount, pvt.nEvents, pvt.nBatches);
+    testOk(pvt.nBatches < pvt.nEvents, "Fewer batches than events");
+
+    testDiag("Cancel every subscription from within a batch");
+    pvt.cancelOn = NPOSTS + 1;
+    post(prec, NPOSTS + 1);
+    post(prec, NPOSTS + 2);
+    for (i = 0; i < 100 && !pvt.canceled; i++)
+        epicsEventWaitWithTimeout(pvt.done, 0.1);
+    testOk(pvt.canceled, "Subscriptions canceled");
+    post(prec, NPOSTS + 3);
+    epicsThreadSleep(0.1);
+    testOk(pvt.foreign == 0, "Nothing delivered after cancellation");
+
+    db_close_events(ctx);
+    dbChannelDelete(chan);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    epicsEventDestroy(pvt.started);
+    epicsEventDestroy(pvt.release);
+    epicsEventDestroy(pvt.done);
+
+    return testDone();
+}
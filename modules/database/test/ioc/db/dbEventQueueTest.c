@@ -0,0 +1,179 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Tests for the dynamically sized event queues */
+
+#include "caeventmask.h"
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "dbCommon.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NSUBS 200
+#define NPOSTS 20
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static epicsEventId started;
+static epicsEventId release;
+static int delivered;
+
+static void monitor(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    /* hold up the event task on the first update */
+    if (epicsAtomicIncrIntT(&delivered) == 1) {
+        epicsEventSignal(started);
+        epicsEventMustWait(release);
+    }
+}
+
+static void post(dbChannel *chan)
+{
+    dbCommon *prec = dbChannelRecord(chan);
+
+    dbScanLock(prec);
+    db_post_events(prec, dbChannelField(chan), DBE_VALUE);
+    dbScanUnlock(prec);
+}
+
+static void testGrowAndShrink(dbChannel *chan)
+{
+    dbEventSubscription subs[NSUBS];
+    dbEventQueueStats stats;
+    dbEventCtx ctx;
+    int i;
+
+    testDiag("Queue grows with the subscriptions");
+
+    dbEventQueueMin = 8;
+    ctx = db_init_events();
+    if (!ctx || db_start_events(ctx, "queue", NULL, NULL,
+            epicsThreadPriorityMedium))
+        testAbort("Can't start event task");
+
+    db_event_queue_stats(ctx, &stats, 0);
+    testOk(stats.nQueues == 1 && stats.size == 8,
+        "New context has one queue of %u entries", stats.size);
+
+    for (i = 0; i < NSUBS; i++) {
+        subs[i] = db_add_event(ctx, chan, monitor, NULL, DBE_VALUE);
+        if (!subs[i])
+            testAbort("db_add_event() failed");
+        db_event_enable(subs[i]);
+    }
+    db_event_queue_stats(ctx, &stats, 0);
+    testOk(stats.nQueues == 1 && stats.size > 4 * NSUBS,
+        "%d subscriptions share one queue of %u entries", NSUBS, stats.size);
+
+    post(chan);
+    epicsEventMustWait(started);
+    for (i = 0; i < NPOSTS; i++)
+        post(chan);
+
+    db_event_queue_stats(ctx, &stats, 0);
+    testDiag("%u of %u used, high water mark %u, %lu overflows",
+        stats.used, stats.size, stats.highWaterMark, stats.nOverflow);
+    testOk(stats.used > 0 && stats.used <= stats.size,
+        "Undelivered events are counted");
+    testOk(stats.highWaterMark >= stats.used &&
+        stats.highWaterMark <= stats.size, "High water mark");
+    testOk(stats.nOverflow > 0, "Overflows are counted");
+
+    epicsEventSignal(release);
+    for (i = 0; i < 100; i++) {
+        db_event_queue_stats(ctx, &stats, 0);
+        if (stats.used == 0)
+            break;
+        epicsThreadSleep(0.1);
+    }
+    testOk(stats.used == 0, "Queue drained");
+
+    db_event_queue_stats(ctx, &stats, 1);
+    db_event_queue_stats(ctx, &stats, 0);
+    testOk(stats.highWaterMark == 0 && stats.nOverflow == 0,
+        "Statistics reset");
+
+    for (i = 0; i < NSUBS; i++)
+        db_cancel_event(subs[i]);
+    db_event_queue_stats(ctx, &stats, 0);
+    testOk(stats.nQueues == 1 && stats.size <= 16,
+        "Queue shrinks to %u entries when subscriptions are canceled",
+        stats.size);
+
+    db_close_events(ctx);
+}
+
+static void testMaximum(dbChannel *chan)
+{
+    dbEventSubscription subs[NSUBS];
+    dbEventQueueStats stats;
+    dbEventCtx ctx;
+    int i;
+
+    testDiag("Queue size limit");
+
+    dbEventQueueMax = 64;
+    ctx = db_init_events();
+    if (!ctx || db_start_events(ctx, "queue", NULL, NULL,
+            epicsThreadPriorityMedium))
+        testAbort("Can't start event task");
+
+    for (i = 0; i < NSUBS; i++) {
+        subs[i] = db_add_event(ctx, chan, monitor, NULL, DBE_VALUE);
+        if (!subs[i])
+            testAbort("db_add_event() failed");
+    }
+    db_event_queue_stats(ctx, &stats, 0);
+    testOk(stats.nQueues > 1 && stats.size <= 64 * stats.nQueues,
+        "%d subscriptions use %u queues of at most 64 entries",
+        NSUBS, stats.nQueues);
+
+    for (i = 0; i < NSUBS; i++)
+        db_cancel_event(subs[i]);
+    db_close_events(ctx);
+    dbEventQueueMax = 65536;
+}
+
+MAIN(dbEventQueueTest)
+{
+    dbChannel *chan;
+
+    testPlan(9);
+
+    started = epicsEventMustCreate(epicsEventEmpty);
+    release = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    testIocInitOk();
+
+    chan = dbChannelCreate("x.VAL");
+    if (!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel x.VAL");
+
+    testGrowAndShrink(chan);
+    testMaximum(chan);
+
+    dbChannelDelete(chan);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    epicsEventDestroy(started);
+    epicsEventDestroy(release);
+
+    return testDone();
+}
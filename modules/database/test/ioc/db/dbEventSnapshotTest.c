@@ -0,0 +1,203 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Tests for the array snapshots shared by monitors of large arrays */
+
+#include <string.h>
+
+#include "caeventmask.h"
+#include "dbAccessDefs.h"
+#include "dbChannel.h"
+#include "dbCommon.h"
+#include "dbEvent.h"
+#include "db_field_log.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define BIGNELM 8192
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+typedef struct {
+    epicsEventId done;
+    int type;
+    void *field;
+    epicsInt32 first;
+} monPvt;
+
+static void monitor(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    monPvt *mon = (monPvt *) user_arg;
+    long nRequest = 1;
+
+    mon->type = pfl->type;
+    mon->field = pfl->type == dbfl_type_ref ? pfl->u.r.field : NULL;
+    dbScanLock(dbChannelRecord(chan));
+    dbChannelGet(chan, DBR_LONG, &mon->first, NULL, &nRequest, pfl);
+    dbScanUnlock(dbChannelRecord(chan));
+    epicsEventSignal(mon->done);
+}
+
+/* Post one value, and change it again before the event task can read it */
+static void postArray(dbChannel *chan, epicsInt32 posted, epicsInt32 after)
+{
+    dbCommon *prec = dbChannelRecord(chan);
+    epicsInt32 *pdata = (epicsInt32 *) dbChannelField(chan);
+
+    dbScanLock(prec);
+    pdata[0] = posted;
+    db_post_events(prec, pdata, DBE_VALUE);
+    pdata[0] = after;
+    dbScanUnlock(prec);
+}
+
+static dbChannel* openChannel(const char *name)
+{
+    dbChannel *chan = dbChannelCreate(name);
+
+    if (!chan || dbChannelOpen(chan))
+        testAbort("Can't open channel %s", name);
+    return chan;
+}
+
+static void testShareArrayCopy(dbChannel *big1, dbChannel *big2,
+    dbChannel *small)
+{
+    dbChannelSnapshot *psnap = NULL;
+    db_field_log *pfl1 = db_create_read_log(big1);
+    db_field_log *pfl2 = db_create_read_log(big2);
+    db_field_log *pfl3 = db_create_read_log(small);
+
+    testDiag("dbChannelShareArrayCopy()");
+
+    dbScanLock(dbChannelRecord(big1));
+    dbChannelShareArrayCopy(&psnap, pfl1, big1);
+    dbChannelShareArrayCopy(&psnap, pfl2, big2);
+    dbScanUnlock(dbChannelRecord(big1));
+
+    testOk(pfl1->type == dbfl_type_ref && pfl2->type == dbfl_type_ref,
+        "Field logs refer to a copy");
+    testOk(pfl1->u.r.field == pfl2->u.r.field,
+        "Channels to the same field share it");
+    testOk(pfl1->no_elements == BIGNELM, "Copy has %ld elements",
+        pfl1->no_elements);
+    testOk(memcmp(pfl1->u.r.field, dbChannelField(big1),
+        BIGNELM * sizeof(epicsInt32)) == 0, "Copy matches the record");
+
+    dbScanLock(dbChannelRecord(small));
+    dbChannelShareArrayCopy(&psnap, pfl3, small);
+    dbScanUnlock(dbChannelRecord(small));
+
+    testOk(pfl3->type == dbfl_type_ref && pfl3->u.r.field != pfl1->u.r.field,
+        "Another field gets its own copy");
+
+    /* the copies outlive the caller's reference */
+    dbChannelReleaseSnapshot(psnap);
+    testOk1(((epicsInt32 *) pfl1->u.r.field)[0] == 42);
+
+    db_delete_field_log(pfl1);
+    db_delete_field_log(pfl2);
+    db_delete_field_log(pfl3);
+}
+
+MAIN(dbEventSnapshotTest)
+{
+    static epicsInt32 data[BIGNELM];
+    dbChannel *big1, *big2, *small;
+    dbEventSubscription sub1, sub2, sub3;
+    monPvt mon1, mon2, mon3;
+    dbEventCtx ctx;
+    int i;
+
+    testPlan(15);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbEventSnapshotTest.db", NULL, NULL);
+
+    testIocInitOk();
+
+    for (i = 0; i < BIGNELM; i++)
+        data[i] = i;
+    data[0] = 42;
+    testdbPutArrFieldOk("big", DBR_LONG, BIGNELM, data);
+    testdbPutArrFieldOk("small", DBR_LONG, 10, data);
+
+    big1 = openChannel("big");
+    big2 = openChannel("big.VAL");
+    small = openChannel("small");
+
+    testShareArrayCopy(big1, big2, small);
+
+    testDiag("Subscriptions");
+
+    memset(&mon1, 0, sizeof(mon1));
+    memset(&mon2, 0, sizeof(mon2));
+    memset(&mon3, 0, sizeof(mon3));
+    mon1.done = epicsEventMustCreate(epicsEventEmpty);
+    mon2.done = epicsEventMustCreate(epicsEventEmpty);
+    mon3.done = epicsEventMustCreate(epicsEventEmpty);
+
+    ctx = db_init_events();
+    if (!ctx || db_start_events(ctx, "snapshot", NULL, NULL,
+            epicsThreadPriorityMedium))
+        testAbort("Can't start event task");
+
+    sub1 = db_add_event(ctx, big1, monitor, &mon1, DBE_VALUE);
+    sub2 = db_add_event(ctx, big2, monitor, &mon2, DBE_VALUE);
+    sub3 = db_add_event(ctx, small, monitor, &mon3, DBE_VALUE);
+    db_event_enable(sub1);
+    db_event_enable(sub2);
+    db_event_enable(sub3);
+
+    postArray(big1, 1, 2);
+    epicsEventMustWait(mon1.done);
+    epicsEventMustWait(mon2.done);
+    testOk(mon1.type == dbfl_type_ref && mon2.type == dbfl_type_ref,
+        "Large array monitors get a snapshot");
+    testOk(mon1.field == mon2.field, "Snapshot is shared");
+    testOk(mon1.first == 1 && mon2.first == 1,
+        "Snapshot holds the posted value (%d, %d)",
+        (int) mon1.first, (int) mon2.first);
+
+    postArray(small, 3, 4);
+    epicsEventMustWait(mon3.done);
+    testOk(mon3.type == dbfl_type_rec, "Small array monitor reads the record");
+    testOk(mon3.first == 4, "Value read when delivered (%d)", (int) mon3.first);
+
+    dbEventArraySnapshotBytes = 0;
+    postArray(big1, 5, 6);
+    epicsEventMustWait(mon1.done);
+    epicsEventMustWait(mon2.done);
+    testOk(mon1.type == dbfl_type_rec && mon2.type == dbfl_type_rec,
+        "No snapshots when disabled");
+    testOk(mon1.first == 6 && mon2.first == 6,
+        "Values read when delivered (%d, %d)",
+        (int) mon1.first, (int) mon2.first);
+    dbEventArraySnapshotBytes = 16384;
+
+    db_cancel_event(sub1);
+    db_cancel_event(sub2);
+    db_cancel_event(sub3);
+    db_close_events(ctx);
+
+    dbChannelDelete(big1);
+    dbChannelDelete(big2);
+    dbChannelDelete(small);
+    epicsEventDestroy(mon1.done);
+    epicsEventDestroy(mon2.done);
+    epicsEventDestroy(mon3.done);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
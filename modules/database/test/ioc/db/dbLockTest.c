@@ -10,8 +10,10 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "epicsSpin.h"
+#include "epicsEvent.h"
 #include "epicsMutex.h"
 #include "dbCommon.h"
 #include "epicsThread.h"
@@ -147,6 +149,100 @@ static void testSingleLock(void)
     testdbCleanup();
 }
 
+typedef struct {
+    dbCommon *prec;
+    epicsEventId locked;
+} holder;
+
+static void holdLock(void *raw)
+{
+    holder *ph = raw;
+
+    dbScanLock(ph->prec);
+    epicsEventMustTrigger(ph->locked);
+    epicsThreadSleep(0.05);
+    dbScanUnlock(ph->prec);
+}
+
+static void testProfile(void)
+{
+    dbCommon *prec, *precG;
+    lockSetProfile *prof;
+    epicsUInt64 nLock;
+    holder hold;
+
+    testDiag("testing lock set profiling");
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbLockTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = testdbRecordPtr("reca");
+    prof = &prec->lset->plockSet->prof;
+
+    dblspReset();
+    dbScanLock(prec);
+    dbScanUnlock(prec);
+    testOk(prof->nLock==0, "Not profiled by default (%u)", (unsigned)prof->nLock);
+
+    dbLockProfile = 1;
+    dbScanLock(prec);
+    dbScanLock(prec);
+    testOk1(prof->depth==2);
+    dbScanUnlock(prec);
+    dbScanUnlock(prec);
+    testOk1(prof->depth==0);
+    testOk(prof->nLock==2, "nLock==2 (%u)", (unsigned)prof->nLock);
+    testOk(prof->nContended==0, "nContended==0 (%u)", (unsigned)prof->nContended);
+
+    hold.prec = prec;
+    hold.locked = epicsEventMustCreate(epicsEventEmpty);
+    epicsThreadMustCreate("holder", epicsThreadPriorityMedium,
+        epicsThreadGetStackSize(epicsThreadStackSmall), holdLock, &hold);
+    epicsEventMustWait(hold.locked);
+    dbScanLock(prec);
+    dbScanUnlock(prec);
+    epicsEventDestroy(hold.locked);
+
+    testOk(prof->nLock==4, "nLock==4 (%u)", (unsigned)prof->nLock);
+    testOk(prof->nContended==1, "nContended==1 (%u)", (unsigned)prof->nContended);
+    testOk(prof->waitTime>=20000000u, "waitTime %.3f ms", prof->waitTime*1e-6);
+    testOk(prof->maxHold>=20000000u, "maxHold %.3f ms", prof->maxHold*1e-6);
+    testOk(strcmp(prof->maxHolder, "holder")==0, "maxHolder \"%s\"",
+        prof->maxHolder);
+
+    testDiag("Merging lock sets keeps their counters");
+    precG = testdbRecordPtr("recg");
+    dbScanLock(precG);
+    dbScanUnlock(precG);
+    nLock = prof->nLock + precG->lset->plockSet->prof.nLock;
+
+    testdbPutFieldOk("reca.SDIS", DBR_STRING, "recg");
+    testOk1(prec->lset->plockSet==precG->lset->plockSet);
+    prof = &prec->lset->plockSet->prof;
+    testOk(prof->nLock>=nLock, "nLock %u >= %u",
+        (unsigned)prof->nLock, (unsigned)nLock);
+    testOk(prof->nContended>=1, "nContended %u", (unsigned)prof->nContended);
+    testOk(prof->waitTime>=20000000u, "waitTime %.3f ms", prof->waitTime*1e-6);
+    testOk(prof->maxHold>=20000000u, "maxHold %.3f ms", prof->maxHold*1e-6);
+
+    dblsp(3);
+    dblspReset();
+    testOk(prof->nLock==0 && prof->waitTime==0 && prof->maxHold==0,
+        "Counters cleared");
+    dbLockProfile = 0;
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+}
+
 static void testMultiLock(void)
 {
     dbCommon *prec[8];
@@ -416,12 +512,13 @@ static void testLinkNOP(void)
 MAIN(dbLockTest)
 {
 #ifdef LOCKSET_DEBUG
-    testPlan(100);
+    testPlan(117);
 #else
-    testPlan(88);
+    testPlan(105);
 #endif
     testSets();
     testSingleLock();
+    testProfile();
     testMultiLock();
     testLinkBreak();
     testLinkMake();
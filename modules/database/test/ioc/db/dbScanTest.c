@@ -9,17 +9,25 @@
  *  Author: Michael Davidsaver <mdavidsaver@bnl.gov>
  */
 
+#include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include "dbScan.h"
 #include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
 
 #include "dbUnitTest.h"
 #include "testMain.h"
 
 #include "dbAccess.h"
+#include "dbLock.h"
 #include "errlog.h"
 
+#include "xRecord.h"
+
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
 static epicsEventId waiter;
@@ -65,9 +73,227 @@ static void testOnce(void)
     epicsEventDestroy(waiter);
 }
 
+#define NPERIODIC 6
+static const char * const perNames[NPERIODIC] = {
+    "pera", "perb", "perc", "perd", "pere", "perf"
+};
+static epicsMutexId perLock;
+static epicsThreadId perThread[NPERIODIC];
+static unsigned perSeq[NPERIODIC];
+static unsigned perCount;
+
+static void perProcess(xRecord *prec)
+{
+    int i;
+
+    epicsMutexMustLock(perLock);
+    for (i = 0; i < NPERIODIC; i++) {
+        if (strcmp(prec->name, perNames[i]) == 0) {
+            perThread[i] = epicsThreadGetIdSelf();
+            perSeq[i] = ++perCount;
+        }
+    }
+    epicsMutexUnlock(perLock);
+}
+
+static void testPeriodicThreads(void)
+{
+    epicsThreadId worker0, worker1;
+    int i, j, seen0 = 0, seen1 = 0;
+
+    testDiag("check parallel periodic scan threads");
+    perLock = epicsMutexMustCreate();
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbScanTest.db", NULL, NULL);
+
+    testOk1(scanPeriodicThreads(2, "Passive") == -1);
+    testOk1(scanPeriodicThreads(2, "no such rate") == -1);
+    testOk1(scanPeriodicThreads(2, ".1 second") == 0);
+
+    for (i = 0; i < NPERIODIC; i++) {
+        xRecord *prec = (xRecord *)testdbRecordPtr(perNames[i]);
+        prec->clbk = &perProcess;
+    }
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk1(scanPeriodicThreads(1, NULL) == -1);
+
+    worker0 = epicsThreadGetId("scan-0.1-0");
+    worker1 = epicsThreadGetId("scan-0.1-1");
+    testOk(worker0 && worker1, "two workers for '.1 second'");
+
+    epicsThreadSleep(0.5);
+    /* let any scan in progress complete */
+    scanPause();
+    epicsThreadSleep(0.2);
+    epicsMutexMustLock(perLock);
+
+    testOk(dbLockGetLockId(testdbRecordPtr("pera")) ==
+           dbLockGetLockId(testdbRecordPtr("perb")),
+           "pera and perb share a lock set");
+    testOk(perThread[0] && perThread[0] == perThread[1],
+           "pera and perb processed by the same worker");
+    testOk(perSeq[0] < perSeq[1], "pera processed before perb (PHAS)");
+
+    for (i = 0; i < NPERIODIC; i++) {
+        testOk(perThread[i] == worker0 || perThread[i] == worker1,
+               "%s processed by a worker", perNames[i]);
+        seen0 |= perThread[i] == worker0;
+        seen1 |= perThread[i] == worker1;
+    }
+    testOk(seen0 && seen1, "records spread across both workers");
+
+    /* pick two unlinked records scanned by different workers */
+    for (i = 2; i < NPERIODIC && perThread[i] != worker0; i++);
+    for (j = 2; j < NPERIODIC && perThread[j] != worker1; j++);
+    epicsMutexUnlock(perLock);
+
+    if (i == NPERIODIC || j == NPERIODIC) {
+        testSkip(4, "no unlinked records on both workers");
+    }
+    else {
+        char field[40], target[40];
+
+        testDiag("link %s to %s, merging their lock sets", perNames[i],
+            perNames[j]);
+        sprintf(field, "%s.INP", perNames[i]);
+        sprintf(target, "%s NPP", perNames[j]);
+        testdbPutFieldOk(field, DBF_STRING, target);
+        testOk(dbLockGetLockId(testdbRecordPtr(perNames[i])) ==
+               dbLockGetLockId(testdbRecordPtr(perNames[j])),
+               "%s and %s share a lock set", perNames[i], perNames[j]);
+
+        epicsMutexMustLock(perLock);
+        memset(perThread, 0, sizeof(perThread));
+        epicsMutexUnlock(perLock);
+        scanRun();
+        epicsThreadSleep(0.5);
+        scanPause();
+        epicsThreadSleep(0.2);
+
+        epicsMutexMustLock(perLock);
+        testOk(perThread[i] && perThread[j],
+               "%s and %s still processed", perNames[i], perNames[j]);
+        testOk(perThread[i] == perThread[j],
+               "%s and %s processed by the same worker", perNames[i],
+               perNames[j]);
+        epicsMutexUnlock(perLock);
+    }
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+    epicsMutexDestroy(perLock);
+}
+
+#define NDEADLINE 3
+static const char * const dlNames[NDEADLINE] = {
+    "pera", "perg", "slow"
+};
+/* previous and latest start of each record */
+static epicsUInt64 dlTime[NDEADLINE][2];
+
+static void dlProcess(xRecord *prec)
+{
+    epicsUInt64 now = epicsMonotonicGet();
+    int i;
+
+    epicsMutexMustLock(perLock);
+    for (i = 0; i < NDEADLINE; i++) {
+        if (strcmp(prec->name, dlNames[i]) == 0) {
+            dlTime[i][0] = dlTime[i][1];
+            dlTime[i][1] = now;
+        }
+    }
+    epicsMutexUnlock(perLock);
+
+    /* overrun the .2 second list, so it has to skip a deadline */
+    if (strcmp(prec->name, "slow") == 0)
+        epicsThreadSleep(0.3);
+}
+
+/* Distance in seconds of a from the nearest multiple of period from b */
+static double phase(epicsUInt64 a, epicsUInt64 b, double period)
+{
+    double r = fmod(((double) a - (double) b) * 1e-9, period);
+
+    if (r < 0)
+        r += period;
+    if (r > period / 2)
+        r -= period;
+    return fabs(r);
+}
+
+static void testDeadline(void)
+{
+    scanPeriodicStats stats;
+    double spacing;
+    int i;
+
+    testDiag("check deadline scheduling with a common epoch");
+    perLock = epicsMutexMustCreate();
+    dbScanDeadline = 1;
+    dbScanEpoch = 1;
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("dbScanTest.db", NULL, NULL);
+
+    for (i = 0; i < NDEADLINE; i++) {
+        xRecord *prec = (xRecord *)testdbRecordPtr(dlNames[i]);
+        prec->clbk = &dlProcess;
+    }
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    epicsThreadSleep(1.3);
+    scanPause();
+    /* let the slow record finish */
+    epicsThreadSleep(0.4);
+    epicsMutexMustLock(perLock);
+
+    testOk(dlTime[0][0] && dlTime[1][1] && dlTime[2][0],
+           "records processed");
+    testOk(phase(dlTime[1][1], dlTime[0][1], 0.1) < 0.02,
+           "'.5 second' in phase with '.1 second'");
+    testOk(phase(dlTime[2][1], dlTime[0][1], 0.1) < 0.02,
+           "'.2 second' in phase with '.1 second'");
+    spacing = (dlTime[0][1] - dlTime[0][0]) * 1e-9;
+    testOk(fabs(spacing - 0.1) < 0.02, "'.1 second' spacing %.3f", spacing);
+    spacing = (dlTime[2][1] - dlTime[2][0]) * 1e-9;
+    testOk(fabs(spacing - 0.4) < 0.02,
+           "'.2 second' skipped one deadline, spacing %.3f", spacing);
+
+    epicsMutexUnlock(perLock);
+
+    testOk1(scanPeriodicStatus(".2 second", -1, 0, &stats) == 0);
+    testOk(stats.overruns >= 1 && stats.skipped >= stats.overruns,
+           "%lu over-runs, %lu skipped", stats.overruns, stats.skipped);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+    epicsMutexDestroy(perLock);
+    dbScanDeadline = 0;
+    dbScanEpoch = 0;
+}
+
 MAIN(dbScanTest)
 {
-    testPlan(3);
+    testPlan(3 + 13 + NPERIODIC + 7);
     testOnce();
+    testPeriodicThreads();
+    testDeadline();
     return testDone();
 }
@@ -1,5 +1,11 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <cantProceed.h>
+#include <epicsAtomic.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
 #include <errlog.h>
 #include <dbAccess.h>
 #include <dbStaticLib.h>
@@ -183,11 +189,181 @@ static void testDbVerify(const char *record)
     dbFinishEntry(&entry);
 }
 
+#define NPVD 5000
+
+/* Fill a separate directory past several resizes and delete from it */
+static void testPvd(int filterCounters)
+{
+    DBBASE *pbase;
+    dbRecordNode *nodes = callocMustSucceed(NPVD, sizeof(dbRecordNode), "testPvd");
+    char (*names)[20] = callocMustSucceed(NPVD, 20, "testPvd");
+    int i, nadd = 0, nfind = 0, nmiss = 0;
+
+    testDiag("Process variable directory with %d entries, filter %d",
+        NPVD, filterCounters);
+
+    dbPvdFilterSize(filterCounters);
+    pbase = dbAllocBase();
+    dbPvdFilterInit(pbase);
+
+    for (i = 0; i < NPVD; i++) {
+        sprintf(names[i], "pvd:%d", i);
+        nodes[i].recordname = names[i];
+        if (dbPvdAdd(pbase, NULL, &nodes[i]))
+            nadd++;
+    }
+    testOk(nadd == NPVD, "Added %d/%d entries", nadd, NPVD);
+    testOk(!dbPvdAdd(pbase, NULL, &nodes[42]), "Duplicate name rejected");
+
+    for (i = 0; i < NPVD; i += 2)
+        dbPvdDelete(pbase, &nodes[i]);
+
+    for (i = 0; i < NPVD; i++) {
+        PVDENTRY *ppvd = dbPvdFind(pbase, names[i], strlen(names[i]));
+
+        if (i & 1)
+            nfind += ppvd && ppvd->precnode == &nodes[i];
+        else
+            nmiss += !ppvd;
+    }
+    testOk(nfind == NPVD / 2, "Found %d remaining entries", nfind);
+    testOk(nmiss == NPVD / 2, "Missed %d deleted entries", nmiss);
+    testOk1(!dbPvdFind(pbase, "pvd:1", 4));
+
+    nadd = 0;
+    for (i = 0; i < NPVD; i += 2)
+        nadd += !!dbPvdAdd(pbase, NULL, &nodes[i]);
+    nfind = 0;
+    for (i = 0; i < NPVD; i++)
+        nfind += !!dbPvdFind(pbase, names[i], strlen(names[i]));
+    testOk(nadd == NPVD / 2 && nfind == NPVD, "Re-added %d, found %d", nadd, nfind);
+
+    if (filterCounters)
+        dbPvdFilterShow(pbase, 0);
+    dbFreeBase(pbase);
+    dbPvdFilterSize(0);
+    free(nodes);
+    free(names);
+}
+
+#define NPVDSTABLE 1000
+#define NPVDCHURN 1000
+#define NPVDREADERS 4
+#define NPVDROUNDS 20
+
+typedef struct {
+    DBBASE *pbase;
+    PVDENTRY **stable;
+    char (*names)[20];
+    epicsEventId done;
+    int lookups;
+    int found;
+    int errors;
+} pvdReader;
+
+static int pvdStop;
+
+/* Look up stable names, which must always return their entry, and
+ * churning names.  An entry returned for a churning name may already
+ * have been deleted and freed, so it is only counted, never read.
+ */
+static void pvdReaderTask(void *arg)
+{
+    pvdReader *prd = arg;
+    int i = 0;
+
+    while (!epicsAtomicGetIntT(&pvdStop)) {
+        int n = i++ % (NPVDSTABLE + NPVDCHURN);
+        const char *name = prd->names[n];
+        PVDENTRY *ppvd = dbPvdFind(prd->pbase, name, strlen(name));
+
+        if (n < NPVDSTABLE) {
+            if (ppvd != prd->stable[n])
+                prd->errors++;
+        }
+        else if (ppvd)
+            prd->found++;
+        prd->lookups++;
+    }
+    epicsEventMustTrigger(prd->done);
+}
+
+/* Add and delete names while other threads keep looking names up */
+static void testPvdConcurrent(void)
+{
+    DBBASE *pbase = dbAllocBase();
+    int n = NPVDSTABLE + NPVDCHURN;
+    dbRecordNode *nodes = callocMustSucceed(n, sizeof(dbRecordNode),
+        "testPvdConcurrent");
+    char (*names)[20] = callocMustSucceed(n, 20, "testPvdConcurrent");
+    PVDENTRY **stable = callocMustSucceed(NPVDSTABLE, sizeof(PVDENTRY *),
+        "testPvdConcurrent");
+    pvdReader readers[NPVDREADERS];
+    unsigned int retired;
+    int i, round, lookups = 0, found = 0, errors = 0;
+
+    testDiag("Process variable directory with %d readers and a writer",
+        NPVDREADERS);
+
+    for (i = 0; i < n; i++) {
+        sprintf(names[i], "pvd:%d", i);
+        nodes[i].recordname = names[i];
+    }
+    for (i = 0; i < NPVDSTABLE; i++)
+        stable[i] = dbPvdAdd(pbase, NULL, &nodes[i]);
+
+    epicsAtomicSetIntT(&pvdStop, 0);
+    for (i = 0; i < NPVDREADERS; i++) {
+        readers[i].pbase = pbase;
+        readers[i].stable = stable;
+        readers[i].names = names;
+        readers[i].done = epicsEventMustCreate(epicsEventEmpty);
+        readers[i].lookups = readers[i].found = readers[i].errors = 0;
+        epicsThreadMustCreate("pvdReader", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            pvdReaderTask, &readers[i]);
+    }
+
+    for (round = 0; round < NPVDROUNDS; round++) {
+        for (i = NPVDSTABLE; i < n; i++)
+            dbPvdAdd(pbase, NULL, &nodes[i]);
+        for (i = NPVDSTABLE; i < n; i++)
+            dbPvdDelete(pbase, &nodes[i]);
+    }
+
+    epicsAtomicSetIntT(&pvdStop, 1);
+    for (i = 0; i < NPVDREADERS; i++) {
+        epicsEventMustWait(readers[i].done);
+        epicsEventDestroy(readers[i].done);
+        lookups += readers[i].lookups;
+        found += readers[i].found;
+        errors += readers[i].errors;
+    }
+
+    /* with no readers left, one more change frees everything retired */
+    dbPvdAdd(pbase, NULL, &nodes[NPVDSTABLE]);
+    dbPvdDelete(pbase, &nodes[NPVDSTABLE]);
+    retired = dbPvdRetiredCount(pbase);
+
+    testOk(errors == 0, "%d bad results in %d lookups, %d churning names found",
+        errors, lookups, found);
+    testOk(retired == 0, "%u retired blocks left after %d deletes",
+        retired, NPVDROUNDS * NPVDCHURN + 1);
+
+    dbFreeBase(pbase);
+    free(stable);
+    free(nodes);
+    free(names);
+}
+
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
 MAIN(dbStaticTest)
 {
-    testPlan(223);
+    testPlan(237);
+    testPvd(0);
+    testPvd(16);
+    testPvdConcurrent();
     testdbPrepare();
 
     testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
@@ -19,12 +19,17 @@
 int testdbConvert(void);
 int callbackTest(void);
 int callbackParallelTest(void);
+int callbackStealTest(void);
 int dbStateTest(void);
 int dbServerTest(void);
 int dbCaStatsTest(void);
 int dbShutdownTest(void);
 int dbScanTest(void);
+int scanOnceTest(void);
 int scanIoTest(void);
+int dbEventSnapshotTest(void);
+int dbEventQueueTest(void);
+int dbEventBatchTest(void);
 int dbLockTest(void);
 int dbPutLinkTest(void);
 int dbStaticTest(void);
@@ -41,12 +46,17 @@ void epicsRunDbTests(void)
     runTest(testdbConvert);
     runTest(callbackTest);
     runTest(callbackParallelTest);
+    runTest(callbackStealTest);
     runTest(dbStateTest);
     runTest(dbServerTest);
     runTest(dbCaStatsTest);
     runTest(dbShutdownTest);
     runTest(dbScanTest);
+    runTest(scanOnceTest);
     runTest(scanIoTest);
+    runTest(dbEventSnapshotTest);
+    runTest(dbEventQueueTest);
+    runTest(dbEventBatchTest);
     runTest(dbLockTest);
     runTest(dbPutLinkTest);
     runTest(dbStaticTest);
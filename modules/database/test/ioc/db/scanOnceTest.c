@@ -0,0 +1,379 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Stress test of the coalescing scanOnce queue */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dbScan.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "errlog.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NREC 4
+#define NTHREAD 4
+#define NLOOP 20000
+#define CBEVERY 1000
+
+static xRecord *precs[NREC];
+static int reqSeq[NREC];    /* requests made for each record */
+static int seenSeq[NREC];   /* requests made when last processed */
+static epicsThreadId procThread[NREC];
+static int processed;
+static int callbacks;
+
+static void onceProcess(xRecord *prec)
+{
+    int i;
+
+    for (i = 0; i < NREC; i++) {
+        if (prec == precs[i]) {
+            epicsAtomicSetIntT(&seenSeq[i], epicsAtomicGetIntT(&reqSeq[i]));
+            procThread[i] = epicsThreadGetIdSelf();
+        }
+    }
+    epicsAtomicIncrIntT(&processed);
+}
+
+static void onceDone(void *usr, dbCommon *prec)
+{
+    epicsAtomicIncrIntT(&callbacks);
+    epicsEventMustTrigger((epicsEventId)usr);
+}
+
+static epicsEventId gate;
+
+/* Holds up the scanOnce thread until the gate opens */
+static void onceBlock(void *usr, dbCommon *prec)
+{
+    epicsEventMustTrigger((epicsEventId)usr);
+    epicsEventMustWait(gate);
+}
+
+static void startIoc(int coalesce, int size, int threads)
+{
+    int i;
+
+    scanOnceSetCoalesce(coalesce);
+    scanOnceSetQueueSize(size);
+    scanOnceSetThreads(threads);
+
+    testdbPrepare();
+
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("scanOnceTest.db", NULL, NULL);
+
+    for (i = 0; i < NREC; i++) {
+        char name[8];
+
+        sprintf(name, "once%d", i);
+        precs[i] = (xRecord *)testdbRecordPtr(name);
+        precs[i]->clbk = &onceProcess;
+        reqSeq[i] = seenSeq[i] = 0;
+        procThread[i] = NULL;
+    }
+    processed = callbacks = 0;
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+}
+
+static void stopIoc(void)
+{
+    testIocShutdownOk();
+    testdbCleanup();
+    scanOnceSetCoalesce(0);
+    scanOnceSetQueueSize(1000);
+    scanOnceSetThreads(1);
+}
+
+static void testPlain(void)
+{
+    epicsEventId done = epicsEventMustCreate(epicsEventEmpty);
+    scanOnceQueueStats stats;
+    int i;
+
+    testDiag("Without coalescing every request is processed");
+    startIoc(0, 1000, 1);
+
+    for (i = 0; i < 50; i++)
+        scanOnce((dbCommon *)precs[0]);
+    scanOnceCallback((dbCommon *)precs[0], onceDone, done);
+    epicsEventMustWait(done);
+
+    testOk(processed == 51, "processed %d times", processed);
+    testOk1(scanOnceQueueStatus(0, &stats) == 0);
+    testOk(stats.numSuppressed == 0, "no duplicates suppressed (%d)",
+        stats.numSuppressed);
+
+    stopIoc();
+    epicsEventDestroy(done);
+}
+
+typedef struct {
+    epicsEventId wait;
+    epicsEventId done;
+    int nReq;
+    int nCb;
+} worker;
+
+static void requester(void *raw)
+{
+    worker *pw = raw;
+    int i;
+
+    for (i = 0; i < NLOOP; i++) {
+        int r = i % NREC;
+        dbCommon *prec = (dbCommon *)precs[r];
+
+        epicsAtomicIncrIntT(&reqSeq[r]);
+        if (i % CBEVERY == CBEVERY - 1) {
+            /* callbacks must not be lost by merging */
+            if (!scanOnceCallback(prec, onceDone, pw->wait)) {
+                epicsEventMustWait(pw->wait);
+                pw->nCb++;
+            }
+        }
+        else
+            scanOnce(prec);
+        pw->nReq++;
+    }
+    epicsEventMustTrigger(pw->done);
+}
+
+static void testBurst(void)
+{
+    epicsEventId blocked = epicsEventMustCreate(epicsEventEmpty);
+    epicsEventId done = epicsEventMustCreate(epicsEventEmpty);
+    scanOnceQueueStats stats;
+    int i, r;
+
+    testDiag("Coalescing a burst while the scanOnce thread is busy");
+    gate = epicsEventMustCreate(epicsEventEmpty);
+    startIoc(1, 2 * NREC + 2, 1);
+
+    scanOnceCallback((dbCommon *)precs[0], onceBlock, blocked);
+    epicsEventMustWait(blocked);
+
+    for (i = 0; i < 1000; i++) {
+        for (r = 0; r < NREC; r++)
+            scanOnce((dbCommon *)precs[r]);
+    }
+    /* queued behind the merged entry of once1 */
+    testOk1(scanOnceCallback((dbCommon *)precs[1], onceDone, done) == 0);
+    testOk1(scanOnceQueueStatus(0, &stats) == 0);
+    testOk(stats.numUsed == NREC + 1, "%d entries queued", stats.numUsed);
+    testOk(stats.numOverflow == 0, "no overflows (%d)", stats.numOverflow);
+    testOk(stats.numSuppressed == 1000 * NREC - NREC,
+        "%d duplicates suppressed", stats.numSuppressed);
+
+    epicsEventMustTrigger(gate);
+    epicsEventMustWait(done);
+    testOk(processed == 1 + NREC + 1, "processed %d times", processed);
+    testOk(callbacks == 1, "callback called");
+
+    stopIoc();
+    epicsEventDestroy(gate);
+    epicsEventDestroy(blocked);
+    epicsEventDestroy(done);
+}
+
+static void testCoalesce(int nWorkers)
+{
+    worker workers[NTHREAD];
+    scanOnceQueueStats stats;
+    int i, nReq = 0, nCb = 0, caught = 0, suppressed, overflows;
+
+    testDiag("Coalescing %d threads making %d requests each, %d workers",
+        NTHREAD, NLOOP, nWorkers);
+    /* at most one merged entry per record and a callback per thread */
+    startIoc(1, 2 * (NREC + NTHREAD), nWorkers);
+    /* the counters are kept from earlier tests */
+    scanOnceQueueStatus(0, &stats);
+    suppressed = stats.numSuppressed;
+    overflows = stats.numOverflow;
+
+    for (i = 0; i < NTHREAD; i++) {
+        workers[i].wait = epicsEventMustCreate(epicsEventEmpty);
+        workers[i].done = epicsEventMustCreate(epicsEventEmpty);
+        workers[i].nReq = workers[i].nCb = 0;
+        epicsThreadMustCreate("requester", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            requester, &workers[i]);
+    }
+    for (i = 0; i < NTHREAD; i++) {
+        epicsEventMustWait(workers[i].done);
+        nReq += workers[i].nReq;
+        nCb += workers[i].nCb;
+    }
+
+    /* wait for the last requests to be processed */
+    for (i = 0; i < 500 && !caught; i++) {
+        int r;
+
+        caught = 1;
+        for (r = 0; r < NREC; r++)
+            caught &= epicsAtomicGetIntT(&seenSeq[r]) ==
+                epicsAtomicGetIntT(&reqSeq[r]);
+        if (!caught)
+            epicsThreadSleep(0.01);
+    }
+    testOk(caught, "every record processed after its last request");
+    testOk(nCb == NTHREAD * (NLOOP / CBEVERY) && callbacks == nCb,
+        "all %d callbacks called (%d)", nCb, callbacks);
+
+    testOk1(scanOnceQueueStatus(0, &stats) == 0);
+    scanOnceQueueShow(0);
+    suppressed = stats.numSuppressed - suppressed;
+    testOk(stats.numOverflow == overflows, "no overflows (%d)",
+        stats.numOverflow - overflows);
+    testOk(processed == nReq - suppressed,
+        "%d requests, %d suppressed, %d processed", nReq, suppressed,
+        processed);
+
+    stopIoc();
+    for (i = 0; i < NTHREAD; i++) {
+        epicsEventDestroy(workers[i].wait);
+        epicsEventDestroy(workers[i].done);
+    }
+}
+
+#define NORDER 100
+static epicsEventId orderDone;
+static int lastOrder[NREC];
+static int orderErrors;
+static int orderCount;
+
+/* usr is the request's sequence number for its record */
+static void onceOrder(void *usr, dbCommon *prec)
+{
+    int seq = (int)(size_t)usr;
+    int i;
+
+    for (i = 0; i < NREC; i++) {
+        if (prec == (dbCommon *)precs[i]) {
+            if (seq != lastOrder[i] + 1)
+                epicsAtomicIncrIntT(&orderErrors);
+            lastOrder[i] = seq;
+        }
+    }
+    if (epicsAtomicIncrIntT(&orderCount) == NREC * NORDER)
+        epicsEventMustTrigger(orderDone);
+}
+
+/* Queue NORDER requests for every record, return how many completed
+ * out of order */
+static int runOrdered(void)
+{
+    int i;
+
+    orderDone = epicsEventMustCreate(epicsEventEmpty);
+    orderErrors = orderCount = 0;
+    memset(lastOrder, 0, sizeof(lastOrder));
+    for (i = 1; i <= NORDER; i++) {
+        int r;
+
+        for (r = 0; r < NREC; r++)
+            scanOnceCallback((dbCommon *)precs[r], onceOrder,
+                (void *)(size_t)i);
+    }
+    epicsEventMustWait(orderDone);
+    epicsEventDestroy(orderDone);
+    return orderErrors;
+}
+
+static void testWorkers(void)
+{
+    epicsEventId done = epicsEventMustCreate(epicsEventEmpty);
+    scanOnceQueueStats stats, sum;
+    epicsThreadId threads[3];
+    int i, ok = 1;
+
+    testDiag("Three scanOnce workers");
+    startIoc(0, 1000, 3);
+
+    for (i = 0; i < 3; i++) {
+        char name[16];
+
+        sprintf(name, "scanOnce-%d", i);
+        threads[i] = epicsThreadGetId(name);
+        ok &= threads[i] != NULL;
+    }
+    testOk(ok, "worker threads running");
+    testOk1(scanOnceWorkerStatus(3, 0, &stats) == -1);
+
+    for (i = 0; i < NREC; i++) {
+        scanOnceCallback((dbCommon *)precs[i], onceDone, done);
+        epicsEventMustWait(done);
+    }
+    for (i = 0; i < NREC; i++) {
+        unsigned long id = dbLockGetLockId((dbCommon *)precs[i]);
+
+        testOk(procThread[i] == threads[id % 3],
+            "once%d processed by worker %lu", i, id % 3);
+    }
+
+    testOk(runOrdered() == 0, "requests for each record completed in order");
+
+    /* merge the lock sets of two records on different workers */
+    for (i = 1; i < NREC && procThread[i] == procThread[0]; i++);
+    if (i == NREC) {
+        testSkip(4, "all records on one worker");
+    }
+    else {
+        epicsThreadId before0 = procThread[0], beforei = procThread[i];
+        char target[16];
+
+        sprintf(target, "once%d NPP", i);
+        testdbPutFieldOk("once0.INP", DBF_STRING, target);
+        testOk(dbLockGetLockId((dbCommon *)precs[0]) ==
+            dbLockGetLockId((dbCommon *)precs[i]),
+            "once0 and once%d share a lock set", i);
+        testOk(runOrdered() == 0,
+            "requests completed in order after the merge");
+        testOk(procThread[0] == before0 && procThread[i] == beforei,
+            "records keep their worker");
+    }
+
+    memset(&sum, 0, sizeof(sum));
+    for (i = 0; i < 3; i++) {
+        testOk1(scanOnceWorkerStatus(i, 0, &stats) == 0);
+        sum.size += stats.size;
+        sum.maxUsed += stats.maxUsed;
+    }
+    scanOnceQueueShow(0);
+    testOk1(scanOnceQueueStatus(0, &stats) == 0);
+    testOk(stats.size == sum.size && stats.size >= 3 * 1000 &&
+        stats.maxUsed == sum.maxUsed,
+        "queue totals are the sum of the workers'");
+
+    stopIoc();
+    epicsEventDestroy(done);
+}
+
+MAIN(scanOnceTest)
+{
+    testPlan(3 + 7 + 2 * 5 + 2 + NREC + 1 + 4 + 3 + 2);
+    testPlain();
+    testBurst();
+    testCoalesce(1);
+    testWorkers();
+    testCoalesce(3);
+    return testDone();
+}
@@ -37,6 +37,7 @@
 #include "iocInit.h"
 #include "iocsh.h"
 #include "dbChannel.h"
+#include "dbLock.h"
 #include "epicsUnitTest.h"
 #include "dbUnitTest.h"
 #include "testMain.h"
@@ -292,13 +293,56 @@ static void check(short dbr_type) {
     TEST5B(3, -8, -4, "both sides from-end");
 }
 
+/* An empty range releases the shared snapshot the field log refers to,
+ * deleting the log must not release it again.
+ */
+static void testEmptySnapshot(void)
+{
+    dbChannel *pch, *pch2;
+    dbChannelSnapshot *psnap = NULL;
+    db_field_log *pfl, *pfl2;
+    dbAddr valaddr;
+    epicsInt32 ar[10] = {10,11,12,13,14,15,16,17,18,19};
+
+    testHead("Empty range of a shared array snapshot");
+
+    (void) dbNameToAddr("x.VAL", &valaddr);
+    (void) dbPutField(&valaddr, DBR_LONG, ar, 10);
+
+    createAndOpen("x.VAL", "{\"arr\":{\"s\":6,\"e\":2}}", "(empty)", &pch, 1);
+    createAndOpen("x.VAL", "{\"arr\":{}}", "(default)", &pch2, 1);
+
+    pfl = db_create_read_log(pch);
+    pfl2 = db_create_read_log(pch2);
+    dbScanLock(valaddr.precord);
+    dbChannelShareArrayCopy(&psnap, pfl, pch);
+    dbChannelShareArrayCopy(&psnap, pfl2, pch2);
+    dbScanUnlock(valaddr.precord);
+    testOk(pfl->type == dbfl_type_ref && pfl->u.r.field == pfl2->u.r.field,
+           "field logs share the snapshot");
+
+    testOk(dbChannelRunPostChain(pch, pfl) == pfl,
+           "call does not drop or replace field_log");
+    testOk(pfl->no_elements == 0, "no elements left (%ld)", pfl->no_elements);
+    testOk(pfl->u.r.dtor == NULL, "snapshot reference released");
+    db_delete_field_log(pfl);
+    dbChannelReleaseSnapshot(psnap);
+
+    testOk(fl_equals_array(DBR_LONG, pfl2, ar),
+           "other field log still holds the snapshot");
+    db_delete_field_log(pfl2);
+
+    dbChannelDelete(pch);
+    dbChannelDelete(pch2);
+}
+
 MAIN(arrTest)
 {
     dbEventCtx evtctx;
     const chFilterPlugin *plug;
     char arr[] = "arr";
 
-    testPlan(1402);
+    testPlan(1417);
 
     /* Prepare the IOC */
 
@@ -325,6 +369,7 @@ MAIN(arrTest)
     check(DBR_LONG);
     check(DBR_DOUBLE);
     check(DBR_STRING);
+    testEmptySnapshot();
 
     db_close_events(evtctx);
 
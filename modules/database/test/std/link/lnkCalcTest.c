@@ -148,6 +148,82 @@ static void testCalc()
         testOk(prec == 3, "Precision correct (%d)", prec);
     }
 
+    testDiag("testing lnkCalc array mode");
+
+    {
+        epicsFloat64 arr[5] = {0};
+        long nReq = 5;
+        long nelm;
+
+        testPutLongStr("io.INPUT", "{\"calc\":{"
+            "\"expr\":\"A*B+C\","
+            "\"nelm\":4,"
+            "\"args\":[{\"const\":[1,2,3]},10,0.5]"
+            "}}");
+        if (testOk1(pinp->type == JSON_LINK))
+            testDiag("Link was set to '%s'", pinp->value.json.string);
+
+        status = dbGetNelements(pinp, &nelm);
+        testOk(!status && nelm == 4, "dbGetNelements = %ld", nelm);
+
+        status = dbGetLink(pinp, DBF_DOUBLE, arr, NULL, &nReq);
+        testOk(!status, "dbGetLink succeeded (status = %ld)", status);
+        testOk(nReq == 3, "Got 3 elements (%ld)", nReq);
+        testOk(arr[0] == 10.5 && arr[1] == 20.5 && arr[2] == 30.5,
+            "Got [%g, %g, %g]", arr[0], arr[1], arr[2]);
+
+        status = dbGetLink(pinp, DBF_DOUBLE, &f64, NULL, NULL);
+        testOk(!status, "dbGetLink succeeded (status = %ld)", status);
+        testOk(f64 == 10.5, "Scalar read got first element (%g)", f64);
+    }
+
+    {
+        epicsFloat64 arr[3] = {0};
+        long nReq = 3;
+        epicsEnum16 stat, sevr;
+
+        testPutLongStr("io.INPUT", "{\"calc\":{"
+            "\"expr\":\"SUM(A)\","
+            "\"major\":\"A>VAL/2\","
+            "\"nelm\":4,"
+            "\"args\":[{\"const\":[1,2,7]}]"
+            "}}");
+        if (testOk1(pinp->type == JSON_LINK))
+            testDiag("Link was set to '%s'", pinp->value.json.string);
+
+        status = dbGetLink(pinp, DBF_DOUBLE, arr, NULL, &nReq);
+        testOk(!status, "dbGetLink succeeded (status = %ld)", status);
+        testOk(nReq == 1 && arr[0] == 10.0, "Got %ld element(s), %g",
+            nReq, arr[0]);
+        testOk(recGblResetAlarms(pio) & DBE_ALARM, "Record alarm was raised");
+        status = dbGetAlarm(pinp, &stat, &sevr);
+        testOk(!status, "dbGetAlarm succeeded (status = %ld)", status);
+        testOk(sevr == MAJOR_ALARM, "Alarm severity = MAJOR (%d)", sevr);
+    }
+
+    {
+        epicsFloat64 arr[3] = {1, 2, 3};
+        dbStateId out = dbStateFind("out");
+
+        testPutLongStr("io.OUTPUT", "{\"calc\":{"
+            "\"expr\":\"SUM(VAL>A)\","
+            "\"nelm\":3,"
+            "\"out\":{\"state\":\"out\"},"
+            "\"args\":[2]"
+            "}}");
+        if (testOk1(pout->type == JSON_LINK))
+            testDiag("Link was set to '%s'", pout->value.json.string);
+
+        dbStateClear(out);
+        status = dbPutLink(pout, DBF_DOUBLE, arr, 3);
+        testOk(!status, "dbPutLink succeeded (status = %ld)", status);
+        testOk(dbStateGet(out), "output was set");
+
+        status = dbPutLink(pout, DBF_DOUBLE, arr, 2);
+        testOk(!status, "dbPutLink succeeded (status = %ld)", status);
+        testOk(!dbStateGet(out), "output was cleared");
+    }
+
     testIocShutdownOk();
 
     testdbCleanup();
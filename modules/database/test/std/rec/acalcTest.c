@@ -0,0 +1,72 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "dbAccess.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static void testRecord(void)
+{
+    static const double wfa[] = {1, 2, 3, 4, 5};
+    static const double ax2[] = {3, 5, 7, 9, 11};
+    static const double thresh[] = {0, 0, 3, 4, 5};
+    static const double sum[] = {15};
+    static const double in[] = {1, 2, 6};
+    static const double avg[] = {3};
+    static const double dev[] = {-2, -1, 3};
+
+    testDiag("acalc record with array and scalar inputs");
+
+    testdbPutFieldOk("wfa.PROC", DBF_LONG, 1);
+    testdbGetArrFieldEqual("wfa", DBF_DOUBLE, 5, 5, wfa);
+
+    testdbPutFieldOk("ac1.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("ac1.NORD", DBF_LONG, 5);
+    testdbGetFieldEqual("ac1.NEA", DBF_ULONG, 5);
+    testdbGetFieldEqual("ac1.NEB", DBF_ULONG, 1);
+    testdbGetArrFieldEqual("ac1", DBF_DOUBLE, 8, 5, ax2);
+
+    testDiag("Changing CALC");
+
+    testdbPutFieldOk("ac1.CALC", DBF_STRING, "A>2?A:0");
+    testdbPutFieldOk("ac1.PROC", DBF_LONG, 1);
+    testdbGetArrFieldEqual("ac1", DBF_DOUBLE, 8, 5, thresh);
+
+    testdbPutFieldOk("ac1.CALC", DBF_STRING, "SUM(A)");
+    testdbPutFieldOk("ac1.PROC", DBF_LONG, 1);
+    testdbGetFieldEqual("ac1.NORD", DBF_LONG, 1);
+    testdbGetArrFieldEqual("ac1", DBF_DOUBLE, 8, 1, sum);
+
+    testDiag("Putting to an argument array");
+
+    testdbPutArrFieldOk("ac2.A", DBF_DOUBLE, 3, in);
+    testdbGetFieldEqual("ac2.NEA", DBF_ULONG, 3);
+    testdbGetArrFieldEqual("ac2", DBF_DOUBLE, 4, 1, avg);
+    testdbGetArrFieldEqual("ac3", DBF_DOUBLE, 4, 3, dev);
+}
+
+MAIN(acalcTest)
+{
+    testPlan(0);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("acalcTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testRecord();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,319 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Measure end-to-end monitor throughput and latency: records processed
+ * at a fixed rate post events, which RSRV sends over loopback to several
+ * CA client contexts subscribed to every record.  Reports events/sec,
+ * latency percentiles from the record timestamp to the client callback,
+ * and CPU time per event, as TAP diagnostics and as a JSON summary.
+ *
+ *   benchMonitorRate [-n records] [-r Hz] [-m clients] [-t seconds]
+ *                    [-o file.json]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cadef.h"
+#include "caTestLib.h"
+#include "db_access_routines.h"
+#include "dbScan.h"
+#include "dbUnitTest.h"
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "iocInit.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define MAXSAMPLES (1u << 20)
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+typedef struct {
+    struct ca_client_context *ctx;
+    chid *chans;
+    evid *subs;
+    size_t nEvents;
+    int measuring;
+    double *latency;
+    size_t nSamples;
+} benchClient;
+
+typedef struct {
+    int nRecords;
+    double rate;
+    int nClients;
+    double duration;
+    const char *jsonFile;
+} benchConfig;
+
+static void monitor(struct event_handler_args args)
+{
+    benchClient *pclient = args.usr;
+    const struct dbr_time_double *pval = args.dbr;
+    epicsTimeStamp now;
+
+    if (args.status != ECA_NORMAL || !epicsAtomicGetIntT(&pclient->measuring))
+        return;
+
+    epicsTimeGetCurrent(&now);
+    pclient->nEvents++;
+    if (pclient->nSamples < MAXSAMPLES)
+        pclient->latency[pclient->nSamples++] =
+            epicsTimeDiffInSeconds(&now, &pval->stamp);
+}
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(const double *sorted, size_t n, double p)
+{
+    size_t i;
+
+    if (!n)
+        return 0.0;
+    i = (size_t) (p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static int parseArgs(benchConfig *cfg, int argc, char *argv[])
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+
+        if (i + 1 >= argc || opt[0] != '-' || strlen(opt) != 2)
+            return -1;
+        switch (opt[1]) {
+        case 'n': cfg->nRecords = atoi(argv[++i]); break;
+        case 'r': cfg->rate = atof(argv[++i]); break;
+        case 'm': cfg->nClients = atoi(argv[++i]); break;
+        case 't': cfg->duration = atof(argv[++i]); break;
+        case 'o': cfg->jsonFile = argv[++i]; break;
+        default: return -1;
+        }
+    }
+    if (cfg->nRecords <= 0 || cfg->rate <= 0.0 || cfg->nClients <= 0 ||
+            cfg->duration <= 0.0)
+        return -1;
+    return 0;
+}
+
+/* Called before iocInit(), see testCaContextCreate() */
+static int createClient(benchClient *pclient, const benchConfig *cfg)
+{
+    pclient->chans = calloc(cfg->nRecords, sizeof(chid));
+    pclient->subs = calloc(cfg->nRecords, sizeof(evid));
+    pclient->latency = calloc(MAXSAMPLES, sizeof(double));
+    if (!pclient->chans || !pclient->subs || !pclient->latency)
+        return -1;
+
+    pclient->ctx = testCaContextCreate();
+    ca_detach_context();
+    return 0;
+}
+
+static int connectClient(benchClient *pclient, const benchConfig *cfg)
+{
+    int i, status;
+
+    if (!pclient->ctx)
+        return -1;
+    ca_attach_context(pclient->ctx);
+
+    for (i = 0; i < cfg->nRecords; i++) {
+        char name[32];
+
+        sprintf(name, "bench:%d", i);
+        ca_create_channel(name, NULL, NULL, CA_PRIORITY_DEFAULT,
+            &pclient->chans[i]);
+    }
+    status = ca_pend_io(10.0);
+    if (status == ECA_NORMAL && ca_get_ioc_connection_count() != 1u)
+        status = ECA_DISCONN;
+    for (i = 0; status == ECA_NORMAL && i < cfg->nRecords; i++)
+        status = ca_create_subscription(DBR_TIME_DOUBLE, 1,
+            pclient->chans[i], DBE_VALUE, monitor, pclient,
+            &pclient->subs[i]);
+    if (status == ECA_NORMAL)
+        status = ca_flush_io();
+    ca_detach_context();
+    return status == ECA_NORMAL ? 0 : -1;
+}
+
+static void disconnectClient(benchClient *pclient)
+{
+    if (pclient->ctx) {
+        ca_attach_context(pclient->ctx);
+        ca_context_destroy();
+    }
+    free(pclient->chans);
+    free(pclient->subs);
+    free(pclient->latency);
+}
+
+static void writeJson(const benchConfig *cfg, double elapsed, size_t nEvents,
+    size_t nExpected, double cpu, const double *sorted, size_t nSamples)
+{
+    FILE *fp = fopen(cfg->jsonFile, "w");
+
+    if (!fp) {
+        testDiag("Can't write %s", cfg->jsonFile);
+        return;
+    }
+    fprintf(fp, "{\n"
+        "  \"records\": %d,\n"
+        "  \"rate_hz\": %g,\n"
+        "  \"clients\": %d,\n"
+        "  \"duration_s\": %.6f,\n"
+        "  \"events\": %lu,\n"
+        "  \"events_expected\": %lu,\n"
+        "  \"events_per_s\": %.1f,\n"
+        "  \"latency_us\": {\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, "
+            "\"max\": %.1f},\n"
+        "  \"cpu_us_per_event\": %.3f\n"
+        "}\n",
+        cfg->nRecords, cfg->rate, cfg->nClients, elapsed,
+        (unsigned long) nEvents, (unsigned long) nExpected,
+        nEvents / elapsed,
+        percentile(sorted, nSamples, 0.5) * 1e6,
+        percentile(sorted, nSamples, 0.99) * 1e6,
+        percentile(sorted, nSamples, 0.999) * 1e6,
+        nSamples ? sorted[nSamples - 1] * 1e6 : 0.0,
+        nEvents ? cpu / nEvents * 1e6 : 0.0);
+    fclose(fp);
+    testDiag("Summary written to %s", cfg->jsonFile);
+}
+
+MAIN(benchMonitorRate)
+{
+    benchConfig cfg = {100, 100.0, 4, 5.0, "benchMonitorRate.json"};
+    benchClient *clients;
+    EVENTPVT bench;
+    epicsTimeStamp start, next, stop;
+    clock_t cpuStart, cpuStop;
+    size_t nEvents = 0, nSamples = 0, nExpected;
+    double *sorted, elapsed, cpu;
+    int i, ok;
+
+    testPlan(3);
+
+    if (parseArgs(&cfg, argc, argv)) {
+        fprintf(stderr, "usage: %s [-n records] [-r Hz] [-m clients] "
+            "[-t seconds] [-o file.json]\n", argv[0]);
+        return 1;
+    }
+    testDiag("%d records at %g Hz, %d clients, %g s",
+        cfg.nRecords, cfg.rate, cfg.nClients, cfg.duration);
+
+    /* Keep everything on loopback */
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+
+    clients = calloc(cfg.nClients, sizeof(benchClient));
+    if (!clients)
+        testAbort("Out of memory");
+    for (ok = 1, i = 0; i < cfg.nClients; i++)
+        if (createClient(&clients[i], &cfg))
+            ok = 0;
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < cfg.nRecords; i++) {
+        char macros[16];
+
+        sprintf(macros, "N=%d", i);
+        testdbReadDatabase("benchMonitorRate.db", NULL, macros);
+    }
+    if (iocInit())
+        testAbort("iocInit() failed");
+    bench = eventNameToHandle("bench");
+
+    for (i = 0; ok && i < cfg.nClients; i++)
+        if (connectClient(&clients[i], &cfg))
+            ok = 0;
+    testOk(ok, "%d clients subscribed to %d records", cfg.nClients,
+        cfg.nRecords);
+
+    /* let the initial updates go by */
+    epicsThreadSleep(1.0);
+    for (i = 0; i < cfg.nClients; i++)
+        epicsAtomicSetIntT(&clients[i].measuring, 1);
+
+    cpuStart = clock();
+    epicsTimeGetCurrent(&start);
+    next = start;
+    for (;;) {
+        epicsTimeStamp now;
+        double delay;
+
+        postEvent(bench);
+        epicsTimeAddSeconds(&next, 1.0 / cfg.rate);
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &start) >= cfg.duration)
+            break;
+        delay = epicsTimeDiffInSeconds(&next, &now);
+        if (delay > 0.0)
+            epicsThreadSleep(delay);
+    }
+    epicsTimeGetCurrent(&stop);
+    elapsed = epicsTimeDiffInSeconds(&stop, &start);
+
+    /* wait for updates in flight */
+    epicsThreadSleep(0.5);
+    for (i = 0; i < cfg.nClients; i++)
+        epicsAtomicSetIntT(&clients[i].measuring, 0);
+    cpuStop = clock();
+    cpu = (double) (cpuStop - cpuStart) / CLOCKS_PER_SEC;
+
+    for (i = 0; i < cfg.nClients; i++) {
+        nEvents += clients[i].nEvents;
+        nSamples += clients[i].nSamples;
+    }
+    sorted = malloc((nSamples ? nSamples : 1) * sizeof(double));
+    if (!sorted)
+        testAbort("Out of memory");
+    for (nSamples = 0, i = 0; i < cfg.nClients; i++) {
+        memcpy(sorted + nSamples, clients[i].latency,
+            clients[i].nSamples * sizeof(double));
+        nSamples += clients[i].nSamples;
+    }
+    qsort(sorted, nSamples, sizeof(double), cmpDouble);
+
+    nExpected = (size_t) (elapsed * cfg.rate + 0.5) * cfg.nRecords *
+        cfg.nClients;
+    testOk(nEvents > 0, "Received %lu of about %lu updates",
+        (unsigned long) nEvents, (unsigned long) nExpected);
+    testOk(nEvents <= nExpected + (size_t) cfg.nRecords * cfg.nClients,
+        "No more updates than were posted");
+
+    testDiag("%.1f events/s", nEvents / elapsed);
+    testDiag("latency p50 %.1f us, p99 %.1f us, p999 %.1f us",
+        percentile(sorted, nSamples, 0.5) * 1e6,
+        percentile(sorted, nSamples, 0.99) * 1e6,
+        percentile(sorted, nSamples, 0.999) * 1e6);
+    testDiag("CPU %.3f s, %.3f us/event", cpu,
+        nEvents ? cpu / nEvents * 1e6 : 0.0);
+    writeJson(&cfg, elapsed, nEvents, nExpected, cpu, sorted, nSamples);
+
+    for (i = 0; i < cfg.nClients; i++)
+        disconnectClient(&clients[i]);
+    free(clients);
+    free(sorted);
+
+    /* RSRV can't be stopped, so the database is not freed */
+    iocShutdown();
+    return testDone();
+}
@@ -0,0 +1,96 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Measure the cost of per-record processing time statistics: time
+ * dbProcess() of a trivial calc record with the statistics stopped and
+ * started, alternating several rounds and comparing the fastest of each.
+ * The difference is the fixed cost of timing one process() call, the
+ * percentage is that of a record which does almost nothing.
+ *
+ *   benchProcStats [-n passes] [-r rounds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "dbProcStats.h"
+#include "dbUnitTest.h"
+#include "epicsTime.h"
+#include "errlog.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+/* Returns ns per dbProcess() */
+static double timePasses(dbCommon *prec, int nPasses)
+{
+    epicsUInt64 start = epicsMonotonicGet();
+    int i;
+
+    for (i = 0; i < nPasses; i++) {
+        dbScanLock(prec);
+        dbProcess(prec);
+        dbScanUnlock(prec);
+    }
+    return (double)(epicsMonotonicGet() - start) / nPasses;
+}
+
+MAIN(benchProcStats)
+{
+    int nPasses = 1000000, nRounds = 5;
+    double off = 0.0, on = 0.0;
+    dbProcStats *pstats;
+    dbCommon *prec;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            nPasses = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            nRounds = atoi(argv[++i]);
+    }
+    if (nPasses < 1) nPasses = 1;
+    if (nRounds < 1) nRounds = 1;
+
+    testPlan(1);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("procStatsTest.db", NULL, NULL);
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = testdbRecordPtr("plain");
+    timePasses(prec, nPasses / 10 + 1);     /* warm up */
+
+    for (i = 0; i < nRounds; i++) {
+        double t;
+
+        dbProcStatsStop();
+        t = timePasses(prec, nPasses);
+        if (!i || t < off) off = t;
+
+        dbProcStatsStart();
+        t = timePasses(prec, nPasses);
+        if (!i || t < on) on = t;
+    }
+    dbProcStatsStop();
+
+    pstats = dbProcStatsFind(prec);
+    testOk(pstats && pstats->count == (epicsUInt64) nRounds * nPasses,
+        "Timed %d x %d passes", nRounds, nPasses);
+    testDiag("%.1f ns per pass without, %.1f ns with statistics", off, on);
+    testDiag("Timing costs %.1f ns per process(), %.1f%% of this record",
+        on - off, 100.0 * (on - off) / off);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,238 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Run a CA client with EPICS_CA_IO_THREADS set against RSRV over
+ * loopback, so that its circuit is served by the I/O thread pool, and
+ * check that channels connect, monitors and put callbacks complete, and
+ * that the channels reconnect after the server drops the circuit.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "cadef.h"
+#include "caTestLib.h"
+#include "db_access_routines.h"
+#include "dbUnitTest.h"
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "iocInit.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define SERVER_PORT 65531u
+#define NCHAN 4
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static chid chans[NCHAN];
+static evid subs[NCHAN];
+static int nConnected;
+static int nUp;             /* connection up events */
+static int nDown;           /* connection down events */
+static double monValue[NCHAN];
+static int nPutDone;
+static int nPutFailed;
+static epicsEventId changed;
+
+static void connection(struct connection_handler_args args)
+{
+    if (args.op == CA_OP_CONN_UP) {
+        epicsAtomicIncrIntT(&nConnected);
+        epicsAtomicIncrIntT(&nUp);
+    }
+    else {
+        epicsAtomicDecrIntT(&nConnected);
+        epicsAtomicIncrIntT(&nDown);
+    }
+    epicsEventSignal(changed);
+}
+
+static void monitor(struct event_handler_args args)
+{
+    if (args.status == ECA_NORMAL) {
+        size_t i = (size_t) args.usr;
+
+        monValue[i] = *(const double *) args.dbr;
+        epicsEventSignal(changed);
+    }
+}
+
+static void putDone(struct event_handler_args args)
+{
+    if (args.status != ECA_NORMAL)
+        epicsAtomicIncrIntT(&nPutFailed);
+    epicsAtomicIncrIntT(&nPutDone);
+    epicsEventSignal(changed);
+}
+
+static void exception(struct exception_handler_args args)
+{
+    testDiag("CA exception: %s", ca_message(args.stat));
+}
+
+/* Wait up to tmo seconds for *pCount to reach count */
+static int waitCount(int *pCount, int count, double tmo)
+{
+    epicsTimeStamp start, now;
+
+    epicsTimeGetCurrent(&start);
+    while (epicsAtomicGetIntT(pCount) != count) {
+        epicsEventWaitWithTimeout(changed, 0.1);
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &start) > tmo)
+            return 0;
+    }
+    return 1;
+}
+
+/* Wait up to tmo seconds for every monitor to report value */
+static int waitMonitors(double value, double tmo)
+{
+    epicsTimeStamp start, now;
+    unsigned i;
+
+    epicsTimeGetCurrent(&start);
+    for (;;) {
+        for (i = 0u; i < NCHAN; i++) {
+            if (monValue[i] != value + i)
+                break;
+        }
+        if (i == NCHAN)
+            return 1;
+        epicsEventWaitWithTimeout(changed, 0.1);
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &start) > tmo)
+            return 0;
+    }
+}
+
+static void putValues(double value)
+{
+    unsigned i;
+
+    for (i = 0u; i < NCHAN; i++) {
+        double v = value + i;
+
+        ca_put(DBR_DOUBLE, chans[i], &v);
+    }
+    ca_flush_io();
+}
+
+static void testMonitors(double value)
+{
+    int ok;
+
+    putValues(value);
+    ok = waitMonitors(value, 5.0);
+    testOk(ok, "monitors report %g..%g", value, value + NCHAN - 1);
+}
+
+static void testPutCallbacks(double value)
+{
+    unsigned i;
+    int ok, nFailed;
+
+    epicsAtomicSetIntT(&nPutDone, 0);
+    epicsAtomicSetIntT(&nPutFailed, 0);
+    for (i = 0u; i < NCHAN; i++) {
+        double v = value + i;
+
+        ca_array_put_callback(DBR_DOUBLE, 1, chans[i], &v, putDone, NULL);
+    }
+    ca_flush_io();
+    ok = waitCount(&nPutDone, NCHAN, 5.0);
+    nFailed = epicsAtomicGetIntT(&nPutFailed);
+    testOk(ok && nFailed == 0, "%d of %d put callbacks, %d failed",
+        epicsAtomicGetIntT(&nPutDone), NCHAN, nFailed);
+    ok = waitMonitors(value, 5.0);
+    testOk(ok, "monitors follow the put callbacks");
+}
+
+MAIN(caIoThreadsTest)
+{
+    char port[16], name[16];
+    size_t i;
+    int ok;
+
+    testPlan(11);
+
+    sprintf(port, "%u", SERVER_PORT);
+    epicsEnvSet("EPICS_CA_SERVER_PORT", port);
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CA_IO_THREADS", "2");
+
+    changed = epicsEventMustCreate(epicsEventEmpty);
+    testCaContextCreate();
+    ca_add_exception_event(exception, NULL);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("caIoThreadsTest.db", NULL, NULL);
+    if (iocInit())
+        testAbort("iocInit() failed");
+
+    for (i = 0u; i < NCHAN; i++) {
+        sprintf(name, "iot:%u", (unsigned) i);
+        monValue[i] = -1.0;
+        if (ca_create_channel(name, connection, NULL, 0, &chans[i]) !=
+                ECA_NORMAL)
+            testAbort("Can't create channel %s", name);
+    }
+    ca_flush_io();
+    ok = waitCount(&nConnected, NCHAN, 10.0);
+    testOk(ok, "%d of %d channels connected", epicsAtomicGetIntT(&nConnected),
+        NCHAN);
+    if (!ok)
+        testAbort("No connection to the IOC");
+    testOk(ca_get_ioc_connection_count() == 1u &&
+        epicsThreadGetId("CAC-TCP-io-0") && epicsThreadGetId("CAC-TCP-io-1") &&
+        !epicsThreadGetId("CAC-TCP-recv"),
+        "circuit served by the I/O thread pool");
+
+    putValues(0.0);
+    for (i = 0u; i < NCHAN; i++) {
+        ca_create_subscription(DBR_DOUBLE, 1, chans[i], DBE_VALUE, monitor,
+            (void *) i, &subs[i]);
+    }
+    ca_flush_io();
+    ok = waitMonitors(0.0, 5.0);
+    testOk(ok, "initial monitor updates");
+
+    testMonitors(10.0);
+    testPutCallbacks(20.0);
+
+    /* RSRV closes its circuits when it next hears from a paused
+     * client, and doesn't answer searches until it runs again
+     */
+    testDiag("Pausing the IOC");
+    iocPause();
+    putValues(30.0);
+    ok = waitCount(&nDown, NCHAN, 10.0);
+    testOk(ok, "%d of %d channels disconnected", epicsAtomicGetIntT(&nDown),
+        NCHAN);
+
+    testDiag("Resuming the IOC");
+    iocRun();
+    ok = waitCount(&nUp, 2 * NCHAN, 30.0);
+    testOk(ok, "%d of %d channels reconnected", epicsAtomicGetIntT(&nConnected),
+        NCHAN);
+
+    testMonitors(40.0);
+    testPutCallbacks(50.0);
+
+    ca_context_destroy();
+
+    epicsEventDestroy(changed);
+
+    /* RSRV can't be stopped, so the database is not freed */
+    iocShutdown();
+    return testDone();
+}
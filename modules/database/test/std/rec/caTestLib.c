@@ -0,0 +1,23 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "cadef.h"
+#include "epicsUnitTest.h"
+
+#define epicsExportSharedSymbols
+#include "caTestLib.h"
+
+/* Create a preemptive CA client context for the calling thread.
+ *
+ * Call this before iocInit().  iocInit() installs a service that
+ * connects the channels of contexts created later straight to the
+ * records, so they would never use the network or RSRV.
+ */
+struct ca_client_context * testCaContextCreate(void)
+{
+    if (ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+        testAbort("Can't create CA context");
+    return ca_current_context();
+}
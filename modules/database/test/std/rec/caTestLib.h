@@ -0,0 +1,24 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* CA client helpers for tests which run an IOC in the same process */
+
+#ifndef INC_caTestLib_H
+#define INC_caTestLib_H
+
+#include "shareLib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ca_client_context;
+
+epicsShareFunc struct ca_client_context * testCaContextCreate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_caTestLib_H */
@@ -16,6 +16,9 @@ int analogMonitorTest(void);
 int compressTest(void);
 int recMiscTest(void);
 int arrayOpTest(void);
+int acalcTest(void);
+int procStatsTest(void);
+int scanStatsTest(void);
 int asTest(void);
 int linkRetargetLinkTest(void);
 int linkInitTest(void);
@@ -36,6 +39,12 @@ void epicsRunRecordTests(void)
 
     runTest(arrayOpTest);
 
+    runTest(acalcTest);
+
+    runTest(procStatsTest);
+
+    runTest(scanStatsTest);
+
     runTest(asTest);
 
     runTest(linkRetargetLinkTest);
@@ -0,0 +1,304 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Run the CA name server and an IOC which registers with it in this
+ * process, and resolve names through the name server over loopback:
+ * registered names are found, DOREPLY searches for other names are
+ * answered with CA_PROTO_NOT_FOUND, CA clients connect using only
+ * EPICS_CA_NAME_SERVERS, and the names of an IOC are forgotten when
+ * its registration circuit closes.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "cadef.h"
+#include "caTestLib.h"
+#include "caProto.h"
+#include "db_access_routines.h"
+#include "dbUnitTest.h"
+#include "envDefs.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "iocInit.h"
+#include "osiSock.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define IOC_PORT 65532u
+#define FAKE_PORT 12345u
+#define MINOR_VERSION 13u
+#define TIMEOUT 5.0
+
+extern "C" void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+/* in libca */
+extern "C" void caNameServerThread(void *pListenSock);
+
+static void putHeader(char *pBuf, unsigned cmmd, unsigned postsize,
+    unsigned dataType, unsigned count, ca_uint32_t cid, ca_uint32_t available)
+{
+    caHdr hdr;
+
+    hdr.m_cmmd = htons((ca_uint16_t) cmmd);
+    hdr.m_postsize = htons((ca_uint16_t) postsize);
+    hdr.m_dataType = htons((ca_uint16_t) dataType);
+    hdr.m_count = htons((ca_uint16_t) count);
+    hdr.m_cid = htonl(cid);
+    hdr.m_available = htonl(available);
+    memcpy(pBuf, &hdr, sizeof(hdr));
+}
+
+static void sendAll(SOCKET sock, const char *pBuf, unsigned nBytes)
+{
+    while (nBytes) {
+        int status = send(sock, pBuf, (int) nBytes, 0);
+
+        if (status <= 0)
+            testAbort("send() to the name server failed");
+        pBuf += status;
+        nBytes -= (unsigned) status;
+    }
+}
+
+static bool recvAll(SOCKET sock, char *pBuf, unsigned nBytes)
+{
+    while (nBytes) {
+        fd_set fds;
+        struct timeval tmo = {(long) TIMEOUT, 0};
+        int status;
+
+        FD_ZERO(&fds);
+        FD_SET(sock, &fds);
+        if (select((int) sock + 1, &fds, NULL, NULL, &tmo) <= 0)
+            return false;
+        status = recv(sock, pBuf, (int) nBytes, 0);
+        if (status <= 0)
+            return false;
+        pBuf += status;
+        nBytes -= (unsigned) status;
+    }
+    return true;
+}
+
+static SOCKET connectTo(const osiSockAddr &addr)
+{
+    SOCKET sock = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    char buf[sizeof(caHdr)];
+
+    if (sock == INVALID_SOCKET)
+        testAbort("Can't create TCP socket");
+    if (connect(sock, &addr.sa, sizeof(addr.ia)) < 0)
+        testAbort("Can't connect to the name server");
+    putHeader(buf, CA_PROTO_VERSION, 0u, 0u, MINOR_VERSION, 0u, 0u);
+    sendAll(sock, buf, sizeof(buf));
+    return sock;
+}
+
+/* Search for a name, followed by an echo request so that no reply is
+ * known when the echo comes back first.  Returns the command of the
+ * reply, or CA_PROTO_ECHO if there was none.
+ */
+static unsigned search(SOCKET sock, const char *pName, unsigned reply,
+    ca_uint32_t cid, caHdr *pReply)
+{
+    char buf[2 * sizeof(caHdr) + 64];
+    unsigned postsize = CA_MESSAGE_ALIGN(strlen(pName) + 1u);
+    unsigned cmmd = CA_PROTO_ECHO;
+
+    memset(pReply, 0, sizeof(*pReply));
+    memset(buf, 0, sizeof(buf));
+    putHeader(buf, CA_PROTO_SEARCH, postsize, reply, MINOR_VERSION,
+        cid, cid);
+    strcpy(buf + sizeof(caHdr), pName);
+    putHeader(buf + sizeof(caHdr) + postsize, CA_PROTO_ECHO,
+        0u, 0u, 0u, 0u, 0u);
+    sendAll(sock, buf, 2u * sizeof(caHdr) + postsize);
+
+    for (;;) {
+        caHdr hdr;
+        char payload[64];
+        unsigned size;
+
+        if (!recvAll(sock, (char *) &hdr, sizeof(hdr)))
+            testAbort("No reply from the name server");
+        size = ntohs(hdr.m_postsize);
+        if (size > sizeof(payload) || !recvAll(sock, payload, size))
+            testAbort("Bad reply from the name server");
+        switch (ntohs(hdr.m_cmmd)) {
+        case CA_PROTO_SEARCH:
+        case CA_PROTO_NOT_FOUND:
+            cmmd = ntohs(hdr.m_cmmd);
+            pReply->m_dataType = ntohs(hdr.m_dataType);
+            pReply->m_cid = ntohl(hdr.m_cid);
+            pReply->m_available = ntohl(hdr.m_available);
+            break;
+        case CA_PROTO_ECHO:
+            return cmmd;
+        }
+    }
+}
+
+/* Repeat a search until the reply is the expected one */
+static unsigned searchUntil(SOCKET sock, const char *pName, unsigned expect,
+    caHdr *pReply)
+{
+    epicsTimeStamp start, now;
+    unsigned cmmd;
+
+    epicsTimeGetCurrent(&start);
+    do {
+        cmmd = search(sock, pName, DOREPLY, 1u, pReply);
+        if (cmmd == expect)
+            break;
+        epicsThreadSleep(0.05);
+        epicsTimeGetCurrent(&now);
+    } while (epicsTimeDiffInSeconds(&now, &start) < TIMEOUT);
+    return cmmd;
+}
+
+static void testSearch(SOCKET sock)
+{
+    caHdr reply;
+    unsigned cmmd;
+
+    testDiag("Searching the name server");
+
+    cmmd = search(sock, "ns:ai", DONTREPLY, 7u, &reply);
+    testOk(cmmd == CA_PROTO_SEARCH && reply.m_dataType == IOC_PORT && reply.m_available == 7u &&
+        reply.m_cid == INADDR_LOOPBACK,
+        "ns:ai found at port %u, address %08x, for cid %u",
+        reply.m_dataType, (unsigned) reply.m_cid,
+        (unsigned) reply.m_available);
+    testOk(search(sock, "ns:calc.VAL", DONTREPLY, 8u, &reply) ==
+        CA_PROTO_SEARCH && reply.m_available == 8u,
+        "ns:calc.VAL found");
+    testOk(search(sock, "ns:calc.{\"ts\":{}}", DONTREPLY, 9u, &reply) ==
+        CA_PROTO_SEARCH && reply.m_available == 9u,
+        "ns:calc with a filter found");
+
+    testOk(search(sock, "ns:none", DOREPLY, 10u, &reply) ==
+        CA_PROTO_NOT_FOUND && reply.m_dataType == DOREPLY &&
+        reply.m_cid == 10u && reply.m_available == 10u,
+        "DOREPLY search for ns:none is answered not found");
+    testOk(search(sock, "ns:none", DONTREPLY, 11u, &reply) == CA_PROTO_ECHO,
+        "DONTREPLY search for ns:none isn't answered");
+}
+
+static void testClient(void)
+{
+    unsigned nCircuits = ca_get_ioc_connection_count();
+    chid chan;
+    double val = 42.0;
+
+    testDiag("Connecting a CA client through the name server");
+
+    testOk(ca_create_channel("ns:ai", NULL, NULL, 0, &chan) == ECA_NORMAL &&
+        ca_pend_io(TIMEOUT) == ECA_NORMAL &&
+        ca_state(chan) == cs_conn &&
+        ca_get_ioc_connection_count() == nCircuits + 1u,
+        "ns:ai connected over a circuit to the IOC");
+    testOk(ca_put(DBR_DOUBLE, chan, &val) == ECA_NORMAL &&
+        ca_flush_io() == ECA_NORMAL, "ns:ai written");
+    val = 0.0;
+    testOk(ca_get(DBR_DOUBLE, chan, &val) == ECA_NORMAL &&
+        ca_pend_io(TIMEOUT) == ECA_NORMAL && val == 42.0,
+        "ns:ai read back");
+    ca_clear_channel(chan);
+    ca_context_destroy();
+}
+
+static void testCircuitClose(const osiSockAddr &nsAddr, SOCKET sock)
+{
+    static const char names[] = "fake:a\0fake:b";
+    char buf[sizeof(caHdr) + 16];
+    SOCKET fake = connectTo(nsAddr);
+    caHdr reply;
+    unsigned cmmd;
+
+    testDiag("Names of an IOC are removed when its circuit closes");
+
+    memset(buf, 0, sizeof(buf));
+    putHeader(buf, CA_PROTO_NAME_REGISTER, 16u, FAKE_PORT, 2u, 0u, 1u);
+    memcpy(buf + sizeof(caHdr), names, sizeof(names));
+    sendAll(fake, buf, sizeof(buf));
+
+    cmmd = searchUntil(sock, "fake:a", CA_PROTO_SEARCH, &reply);
+    testOk(cmmd == CA_PROTO_SEARCH && reply.m_dataType == FAKE_PORT,
+        "fake:a registered at port %u", reply.m_dataType);
+    testOk(search(sock, "fake:b", DOREPLY, 2u, &reply) == CA_PROTO_SEARCH,
+        "fake:b registered");
+
+    epicsSocketDestroy(fake);
+
+    testOk(searchUntil(sock, "fake:a", CA_PROTO_NOT_FOUND, &reply) ==
+        CA_PROTO_NOT_FOUND, "fake:a removed");
+    testOk(search(sock, "fake:b", DOREPLY, 2u, &reply) == CA_PROTO_NOT_FOUND,
+        "fake:b removed");
+    testOk(search(sock, "ns:ai", DOREPLY, 3u, &reply) == CA_PROTO_SEARCH &&
+        reply.m_dataType == IOC_PORT, "ns:ai is still registered");
+}
+
+MAIN(nameServerTest)
+{
+    SOCKET listenSock, sock;
+    osiSockAddr nsAddr;
+    osiSocklen_t addrSize = sizeof(nsAddr);
+    caHdr reply;
+    char buf[64];
+
+    testPlan(13);
+
+    osiSockAttach();
+
+    /* the name server, at a free port */
+    listenSock = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSock == INVALID_SOCKET)
+        testAbort("Can't create TCP socket");
+    memset(&nsAddr, 0, sizeof(nsAddr));
+    nsAddr.ia.sin_family = AF_INET;
+    nsAddr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenSock, &nsAddr.sa, sizeof(nsAddr.ia)) < 0 ||
+            listen(listenSock, 10) < 0 ||
+            getsockname(listenSock, &nsAddr.sa, &addrSize) < 0)
+        testAbort("Can't listen for name server circuits");
+    epicsThreadMustCreate("caNameServer", epicsThreadPriorityMedium,
+        epicsThreadGetStackSize(epicsThreadStackMedium),
+        caNameServerThread, &listenSock);
+
+    /* the IOC and clients know only about the name server */
+    sprintf(buf, "127.0.0.1:%u", (unsigned) ntohs(nsAddr.ia.sin_port));
+    epicsEnvSet("EPICS_CAS_NAME_SERVERS", buf);
+    epicsEnvSet("EPICS_CA_NAME_SERVERS", buf);
+    sprintf(buf, "%u", IOC_PORT);
+    epicsEnvSet("EPICS_CA_SERVER_PORT", buf);
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "");
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+
+    testCaContextCreate();
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("nameServerTest.db", NULL, NULL);
+    if (iocInit())
+        testAbort("iocInit() failed");
+
+    sock = connectTo(nsAddr);
+    if (searchUntil(sock, "ns:ai", CA_PROTO_SEARCH, &reply) !=
+            CA_PROTO_SEARCH)
+        testAbort("The IOC didn't register with the name server");
+
+    testSearch(sock);
+    testClient();
+    testCircuitClose(nsAddr, sock);
+
+    epicsSocketDestroy(sock);
+
+    /* RSRV and the name server can't be stopped, so the database is
+     * not freed */
+    iocShutdown();
+    return testDone();
+}
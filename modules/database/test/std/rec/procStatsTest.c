@@ -0,0 +1,114 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include "dbAccess.h"
+#include "dbProcStats.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static dbProcStats * statsOf(const char *name)
+{
+    return dbProcStatsFind(testdbRecordPtr(name));
+}
+
+static void process(const char *name, int n)
+{
+    while (n--)
+        testdbPutFieldOk(name, DBF_LONG, 0);
+}
+
+static void testTagged(void)
+{
+    dbProcStats *pstats = statsOf("tagged");
+    epicsUInt32 hist[DBPS_NBINS];
+    epicsUInt64 sum = 0;
+    long nReq = DBPS_NBINS;
+    DBADDR addr;
+    int i;
+
+    testDiag("Record with a procStats info tag");
+
+    if (!testOk(pstats && pstats->enabled, "Enabled at iocInit")) {
+        testSkip(8, "No statistics");
+        return;
+    }
+    process("tagged.PROC", 3);
+    testOk(pstats->count == 3, "count == 3 (%u)", (unsigned) pstats->count);
+    testOk(pstats->min <= pstats->max && pstats->max <= pstats->total,
+        "min <= max <= total");
+
+    testdbPutFieldOk("tagged:count.PROC", DBF_LONG, 0);
+    testdbGetFieldEqual("tagged:count", DBF_DOUBLE, 3.0);
+
+    testdbPutFieldOk("tagged:hist.PROC", DBF_LONG, 0);
+    if (dbNameToAddr("tagged:hist", &addr) ||
+        dbGetField(&addr, DBR_ULONG, hist, NULL, &nReq, NULL))
+        testAbort("Can't read tagged:hist");
+    for (i = 0; i < nReq; i++)
+        sum += hist[i];
+    testOk(nReq == DBPS_NBINS && sum == 3,
+        "Histogram holds 3 entries (%ld bins, %u)", nReq, (unsigned) sum);
+
+    dbProcStatsStop();
+    process("tagged.PROC", 1);
+    testOk(pstats->count == 4, "Still timed when stopped (%u)",
+        (unsigned) pstats->count);
+}
+
+static void testStartStop(void)
+{
+    dbProcStats *pstats;
+
+    testDiag("Starting and stopping");
+
+    testOk1(statsOf("plain") == NULL);
+    process("plain.PROC", 2);
+
+    testOk1(dbProcStatsStart() == 0);
+    pstats = statsOf("plain");
+    if (!testOk(pstats && pstats->enabled, "Enabled by dbProcStatsStart")) {
+        testSkip(4, "No statistics");
+        return;
+    }
+    testOk1(pstats->count == 0);
+    process("plain.PROC", 2);
+    testOk(pstats->count == 2, "count == 2 (%u)", (unsigned) pstats->count);
+
+    dbProcStatsReport(5, 1);
+
+    dbProcStatsStop();
+    process("plain.PROC", 1);
+    testOk(pstats->count == 2, "Not timed when stopped (%u)",
+        (unsigned) pstats->count);
+
+    dbProcStatsReset();
+    testOk(pstats->count == 0 && pstats->total == 0 && pstats->hist[0] == 0,
+        "Counters cleared");
+}
+
+MAIN(procStatsTest)
+{
+    testPlan(0);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("procStatsTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testTagged();
+    testStartStop();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
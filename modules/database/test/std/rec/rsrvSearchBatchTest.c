@@ -0,0 +1,188 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Send bursts of UDP search requests to RSRV over loopback from two
+ * sockets, and check that every reply arrives at the right socket in the
+ * order the requests were sent, with UDP batching on and off.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "caProto.h"
+#include "dbAccess.h"
+#include "dbUnitTest.h"
+#include "envDefs.h"
+#include "iocInit.h"
+#include "iocsh.h"
+#include "osiSock.h"
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define SERVER_PORT 65533u
+#define NSOCK 2
+#define NREQ 40         /* datagrams per socket and burst */
+#define NREC 4
+#define MINOR_VERSION 13u
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+typedef struct {
+    SOCKET sock;
+    unsigned nReply;
+    unsigned nOrder;    /* replies received out of order */
+    unsigned nOther;    /* replies not for this socket */
+} searchClient;
+
+static void sendSearch(searchClient *pc, const struct sockaddr_in *pAddr,
+    ca_uint32_t cid)
+{
+    char buf[2 * sizeof(caHdr) + 16];
+    caHdr *pVer = (caHdr *) buf;
+    caHdr *pSearch = pVer + 1;
+    char *pName = (char *) (pSearch + 1);
+
+    memset(buf, 0, sizeof(buf));
+    pVer->m_cmmd = htons(CA_PROTO_VERSION);
+    pVer->m_count = htons(MINOR_VERSION);
+    pVer->m_cid = htonl(cid);
+    sprintf(pName, "batch:%u", (unsigned) (cid % NREC));
+    pSearch->m_cmmd = htons(CA_PROTO_SEARCH);
+    pSearch->m_postsize = htons(16);
+    pSearch->m_dataType = htons(DONTREPLY);
+    pSearch->m_count = htons(MINOR_VERSION);
+    pSearch->m_cid = htonl(cid);
+    pSearch->m_available = htonl(cid);
+
+    if (sendto(pc->sock, buf, sizeof(buf), 0,
+            (const struct sockaddr *) pAddr, sizeof(*pAddr)) != sizeof(buf))
+        testAbort("sendto() failed");
+}
+
+/* Count the search replies in a datagram, checking their order */
+static void readReplies(searchClient *pc, unsigned base)
+{
+    char buf[MAX_UDP_RECV];
+    int n = recv(pc->sock, buf, sizeof(buf), 0);
+    unsigned pos = 0u;
+
+    while (n > 0 && pos + sizeof(caHdr) <= (unsigned) n) {
+        caHdr hdr;
+
+        memcpy(&hdr, buf + pos, sizeof(hdr));
+        pos += sizeof(hdr) + ntohs(hdr.m_postsize);
+        if (ntohs(hdr.m_cmmd) != CA_PROTO_SEARCH)
+            continue;
+        if (ntohl(hdr.m_available) / NREQ != base / NREQ)
+            pc->nOther++;
+        else if (ntohl(hdr.m_available) != base + pc->nReply++)
+            pc->nOrder++;
+    }
+}
+
+static void testBurst(searchClient *clients,
+    const struct sockaddr_in *pAddr, unsigned round)
+{
+    epicsTimeStamp start, now;
+    unsigned i, j, nReply = 0u;
+
+    for (j = 0u; j < NSOCK; j++) {
+        clients[j].nReply = clients[j].nOrder = clients[j].nOther = 0u;
+    }
+
+    /* interleave the senders, so that batches hold several of each */
+    for (i = 0u; i < NREQ; i++) {
+        for (j = 0u; j < NSOCK; j++) {
+            sendSearch(&clients[j], pAddr, (round * NSOCK + j) * NREQ + i);
+        }
+    }
+
+    epicsTimeGetCurrent(&start);
+    do {
+        fd_set fds;
+        struct timeval tmo = {0, 100000};
+        SOCKET maxSock = 0;
+
+        FD_ZERO(&fds);
+        for (j = 0u; j < NSOCK; j++) {
+            FD_SET(clients[j].sock, &fds);
+            if (clients[j].sock > maxSock)
+                maxSock = clients[j].sock;
+        }
+        if (select((int) maxSock + 1, &fds, NULL, NULL, &tmo) > 0) {
+            for (j = 0u; j < NSOCK; j++) {
+                if (FD_ISSET(clients[j].sock, &fds))
+                    readReplies(&clients[j], (round * NSOCK + j) * NREQ);
+            }
+        }
+        for (nReply = 0u, j = 0u; j < NSOCK; j++) {
+            nReply += clients[j].nReply;
+        }
+        epicsTimeGetCurrent(&now);
+    } while (nReply < NSOCK * NREQ &&
+        epicsTimeDiffInSeconds(&now, &start) < 5.0);
+
+    for (j = 0u; j < NSOCK; j++) {
+        testOk(clients[j].nReply == NREQ && clients[j].nOrder == 0u &&
+            clients[j].nOther == 0u,
+            "socket %u: %u of %u replies, %u out of order, %u misdirected",
+            j, clients[j].nReply, NREQ, clients[j].nOrder,
+            clients[j].nOther);
+    }
+}
+
+MAIN(rsrvSearchBatchTest)
+{
+    static const int sizes[] = {16, 4, 1};
+    searchClient clients[NSOCK];
+    struct sockaddr_in addr;
+    const iocshVarDef *pvar;
+    char port[16];
+    unsigned i, j;
+
+    testPlan(NSOCK * 2 * (sizeof(sizes) / sizeof(sizes[0])));
+
+    sprintf(port, "%u", SERVER_PORT);
+    epicsEnvSet("EPICS_CA_SERVER_PORT", port);
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("rsrvSearchBatchTest.db", NULL, NULL);
+    if (iocInit())
+        testAbort("iocInit() failed");
+
+    pvar = iocshFindVariable("rsrvUdpBatch");
+    if (!pvar)
+        testAbort("rsrvUdpBatch not registered");
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(SERVER_PORT);
+
+    for (j = 0u; j < NSOCK; j++) {
+        clients[j].sock = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+        if (clients[j].sock == INVALID_SOCKET)
+            testAbort("Can't create UDP socket");
+    }
+
+    for (i = 0u; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        *(int *) pvar->pval = sizes[i];
+        testDiag("rsrvUdpBatch = %d", sizes[i]);
+        testBurst(clients, &addr, 2u * i);
+        testBurst(clients, &addr, 2u * i + 1u);
+    }
+
+    for (j = 0u; j < NSOCK; j++) {
+        epicsSocketDestroy(clients[j].sock);
+    }
+
+    /* RSRV can't be stopped, so the database is not freed */
+    iocShutdown();
+    return testDone();
+}
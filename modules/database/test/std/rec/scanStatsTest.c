@@ -0,0 +1,114 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "dbUnitTest.h"
+#include "epicsThread.h"
+#include "errlog.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static const char rate[] = ".1 second";
+
+static void testStatus(void)
+{
+    scanPeriodicStats stats;
+    unsigned long sum = 0;
+    int i;
+
+    testDiag("scanPeriodicStatus()");
+
+    testOk1(scanPeriodicStatus("no such rate", -1, 0, &stats) == -1);
+    testOk1(scanPeriodicStatus(rate, 1, 0, &stats) == -1);
+    testOk1(scanPeriodicStatus(rate, -1, 0, NULL) == -2);
+
+    if (!testOk1(scanPeriodicStatus(rate, -1, 0, &stats) == 0)) {
+        testSkip(6, "No statistics");
+        return;
+    }
+    testOk(stats.period == 0.1 && stats.nWorkers == 1,
+        "period %g, %d worker", stats.period, stats.nWorkers);
+    testOk(stats.cycles >= 2, "cycles >= 2 (%lu)", stats.cycles);
+    testOk(stats.execMin <= stats.execAvg && stats.execAvg <= stats.execMax,
+        "execMin <= execAvg <= execMax");
+    testOk(stats.jitterAvg <= stats.jitterMax, "jitterAvg <= jitterMax");
+    testOk(strcmp(stats.slowest, "tick") == 0 &&
+        stats.slowestTime <= stats.execLast,
+        "Slowest record '%s'", stats.slowest);
+    for (i = 0; i < SCAN_PERIODIC_NBINS; i++)
+        sum += stats.execHist[i];
+    testOk(sum == stats.cycles, "Histogram holds %lu entries (%lu)",
+        stats.cycles, sum);
+
+    scanppl(0.1);
+}
+
+static void testDevice(void)
+{
+    epicsUInt32 hist[SCAN_PERIODIC_NBINS];
+    long nReq = SCAN_PERIODIC_NBINS;
+    epicsFloat64 cycles;
+    DBADDR addr;
+
+    testDiag("Scan Stats device support");
+
+    testdbPutFieldOk("scan:cycles.PROC", DBF_LONG, 0);
+    testdbPutFieldOk("scan:slowest.PROC", DBF_LONG, 0);
+    testdbPutFieldOk("scan:hist.PROC", DBF_LONG, 0);
+
+    if (dbNameToAddr("scan:cycles", &addr) ||
+        dbGetField(&addr, DBR_DOUBLE, &cycles, NULL, NULL, NULL))
+        testAbort("Can't read scan:cycles");
+    testOk(cycles >= 2, "scan:cycles >= 2 (%g)", cycles);
+    testdbGetFieldEqual("scan:cycles.SEVR", DBF_LONG, 0);
+    testdbGetFieldEqual("scan:slowest", DBF_STRING, "tick");
+
+    if (dbNameToAddr("scan:hist", &addr) ||
+        dbGetField(&addr, DBR_ULONG, hist, NULL, &nReq, NULL))
+        testAbort("Can't read scan:hist");
+    testOk(nReq == SCAN_PERIODIC_NBINS, "%ld bins", nReq);
+}
+
+static void testReset(void)
+{
+    scanPeriodicStats stats;
+
+    testDiag("Reset");
+
+    testOk1(scanPeriodicStatus(rate, -1, 1, NULL) == -2);
+    testOk1(scanPeriodicStatus(rate, 0, 0, &stats) == 0);
+    testOk(stats.cycles <= 1 && stats.overruns == 0,
+        "Counters cleared (%lu cycles)", stats.cycles);
+}
+
+MAIN(scanStatsTest)
+{
+    testPlan(20);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("scanStatsTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    /* Let the list be scanned a few times */
+    epicsThreadSleep(0.55);
+
+    testStatus();
+    testDevice();
+    testReset();
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,746 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* calcArray.c
+ *
+ * Evaluates a postfix expression from postfix() on arrays of doubles.
+ * Each stack entry holds a whole array, and every operator is applied to
+ * all of its elements in one simple loop before moving on to the next
+ * operator, so the cost of decoding the expression is paid once per
+ * evaluation rather than once per element, and the loops are left in a
+ * form the compiler can vectorize.
+ *
+ * Operands with exactly one element are scalars and get combined with
+ * every element of the other operand.  Two arrays of different lengths
+ * give a result as long as the shorter one.  The var-arg functions MIN,
+ * MAX, SUM, AVG, FINITE and ISNAN work element-wise when given several
+ * arguments, but given a single argument they reduce all of its elements
+ * to a scalar.  A ?: with a scalar condition takes just one branch like
+ * calcPerform(); with an array condition both branches get evaluated and
+ * their results are merged element by element.  Scalar operations use the
+ * same C expressions as calcPerform(), so an expression on scalars gives
+ * the same result as calcPerform() does.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define epicsExportSharedSymbols
+#include "dbDefs.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "errlog.h"
+#include "postfix.h"
+#include "postfixPvt.h"
+
+#ifndef PI
+#define PI 3.14159265358979323
+#endif
+
+typedef struct stackEntry {
+    const double *p;    /* the elements, in buf or in an argument */
+    double *buf;        /* storage belonging to this entry */
+    epicsUInt32 n;      /* number of elements, 1 for a scalar */
+} stackEntry;
+
+struct calcArrayStack {
+    epicsUInt32 size;   /* capacity of each entry */
+    int depth;          /* number of entries */
+    double *pdata;      /* storage for all the entries */
+    stackEntry *ptop;   /* while evaluating */
+    calcArrayArg *parg;
+    calcArrayArg *pval;
+    stackEntry entry[1];    /* zero'th entry not used */
+};
+
+/* What evaluate() was called to do */
+enum {
+    EVAL_EXPR,  /* the whole expression */
+    EVAL_THEN,  /* the true branch of a ?:, up to its COND_ELSE */
+    EVAL_ELSE   /* the false branch of a ?: */
+};
+
+/* Length of the result of an operation on two operands */
+static epicsUInt32 combine(epicsUInt32 n1, epicsUInt32 n2)
+{
+    if (n1 == 1)
+        return n2;
+    if (n2 == 1)
+        return n1;
+    return n1 < n2 ? n1 : n2;
+}
+
+/* Maximum stack depth the expression can need.  Conditions and true
+ * branch results are counted as staying on the stack until the end of
+ * their ?:, which they do when the condition is an array.
+ */
+static int stackDepth(const char *pinst)
+{
+    int depth = 0, max = 0;
+    int op;
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        switch (op) {
+        case LITERAL_DOUBLE:
+            pinst += sizeof(double);
+            depth++;
+            break;
+
+        case LITERAL_INT:
+            pinst += sizeof(epicsInt32);
+            depth++;
+            break;
+
+        case FETCH_VAL:
+        case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+        case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+        case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+        case CONST_PI:
+        case CONST_D2R:
+        case CONST_R2D:
+        case RANDOM:
+            depth++;
+            break;
+
+        case STORE_A: case STORE_B: case STORE_C: case STORE_D:
+        case STORE_E: case STORE_F: case STORE_G: case STORE_H:
+        case STORE_I: case STORE_J: case STORE_K: case STORE_L:
+        case ADD: case SUB: case MULT: case DIV: case MODULO: case POWER:
+        case ATAN2:
+        case REL_OR: case REL_AND:
+        case BIT_OR: case BIT_AND: case BIT_EXCL_OR:
+        case RIGHT_SHIFT: case LEFT_SHIFT:
+        case NOT_EQ: case LESS_THAN: case LESS_OR_EQ:
+        case EQUAL: case GR_OR_EQ: case GR_THAN:
+            depth--;
+            break;
+
+        case MAX: case MIN: case SUM: case AVG:
+        case FINITE: case ISNAN:
+            depth -= *pinst++ - 1;
+            break;
+
+        case COND_IF:
+        case COND_ELSE:
+            break;
+
+        case COND_END:
+            depth -= 2;
+            break;
+
+        case UNARY_NEG:
+        case ABS_VAL: case EXP: case LOG_10: case LOG_E: case SQU_RT:
+        case ACOS: case ASIN: case ATAN: case COS: case COSH:
+        case SIN: case SINH: case TAN: case TANH:
+        case CEIL: case FLOOR: case ISINF: case NINT:
+        case REL_NOT: case BIT_NOT:
+            break;
+
+        default:
+            return -1;
+        }
+        if (depth < 0)
+            return -1;
+        if (depth > max)
+            max = depth;
+    }
+    return max;
+}
+
+epicsShareFunc calcArrayStack *
+    calcArrayStackCreate(const char *pinst, epicsUInt32 size)
+{
+    calcArrayStack *ps;
+    int depth, i;
+
+    if (!pinst)
+        return NULL;
+    depth = stackDepth(pinst);
+    if (depth <= 0)
+        return NULL;
+    if (size < 1)
+        size = 1;
+
+    ps = malloc(sizeof(calcArrayStack) + depth * sizeof(stackEntry));
+    if (!ps)
+        return NULL;
+    ps->pdata = malloc((size_t) depth * size * sizeof(double));
+    if (!ps->pdata) {
+        free(ps);
+        return NULL;
+    }
+    ps->size = size;
+    ps->depth = depth;
+    for (i = 1; i <= depth; i++) {
+        ps->entry[i].buf = ps->pdata + (size_t) (i - 1) * size;
+        ps->entry[i].p = ps->entry[i].buf;
+        ps->entry[i].n = 0;
+    }
+    return ps;
+}
+
+epicsShareFunc void
+    calcArrayStackFree(calcArrayStack *ps)
+{
+    if (ps) {
+        free(ps->pdata);
+        free(ps);
+    }
+}
+
+/* Skip over the true branch of a ?: and its COND_ELSE,
+ * the way calcPerform()'s cond_search() does.
+ */
+static int skipThen(const char **ppinst)
+{
+    const char *pinst = *ppinst;
+    int nested = 0;
+    int op;
+
+    while ((op = *pinst++) != END_EXPRESSION) {
+        switch (op) {
+        case LITERAL_DOUBLE:
+            pinst += sizeof(double);
+            break;
+        case LITERAL_INT:
+            pinst += sizeof(epicsInt32);
+            break;
+        case MAX: case MIN: case SUM: case AVG:
+        case FINITE: case ISNAN:
+            pinst++;
+            break;
+        case COND_IF:
+            nested++;
+            break;
+        case COND_ELSE:
+            if (nested-- == 0) {
+                *ppinst = pinst;
+                return 0;
+            }
+            break;
+        }
+    }
+    return -1;
+}
+
+/* Skip over the false branch of a ?:.  That ends at its own COND_END,
+ * which is consumed, or at the COND_ELSE of an outer ?: or the end of
+ * the expression, since postfix() puts the COND_ENDs of nested ?:
+ * operators together after the last of their branches.
+ */
+static void skipElse(const char **ppinst)
+{
+    const char *pinst = *ppinst;
+    int needElse = 0;   /* nested ?: still to see their COND_ELSE */
+    int needEnd = 0;    /* nested ?: still to see their COND_END */
+    int op;
+
+    while ((op = *pinst) != END_EXPRESSION) {
+        if (op == COND_ELSE) {
+            if (!needElse)
+                break;
+            needElse--;
+            needEnd++;
+        }
+        else if (op == COND_END) {
+            if (!needEnd) {
+                pinst++;
+                break;
+            }
+            needEnd--;
+        }
+        pinst++;
+        switch (op) {
+        case LITERAL_DOUBLE:
+            pinst += sizeof(double);
+            break;
+        case LITERAL_INT:
+            pinst += sizeof(epicsInt32);
+            break;
+        case MAX: case MIN: case SUM: case AVG:
+        case FINITE: case ISNAN:
+            pinst++;
+            break;
+        case COND_IF:
+            needElse++;
+            break;
+        }
+    }
+    *ppinst = pinst;
+}
+
+static stackEntry * push(calcArrayStack *ps)
+{
+    if (ps->ptop == &ps->entry[ps->depth]) {
+        errlogPrintf("calcArrayPerform: Stack overflow\n");
+        return NULL;
+    }
+    return ++ps->ptop;
+}
+
+static stackEntry * pushScalar(calcArrayStack *ps, double value)
+{
+    stackEntry *x = push(ps);
+
+    if (x) {
+        x->buf[0] = value;
+        x->p = x->buf;
+        x->n = 1;
+    }
+    return x;
+}
+
+static stackEntry * pushArray(calcArrayStack *ps, const calcArrayArg *parg)
+{
+    stackEntry *x = push(ps);
+
+    if (x) {
+        x->p = parg->pval;
+        x->n = parg->nelm < ps->size ? parg->nelm : ps->size;
+    }
+    return x;
+}
+
+/* Copy entries that refer to pdata into their own storage */
+static void detach(calcArrayStack *ps, const double *pdata)
+{
+    stackEntry *x;
+
+    for (x = &ps->entry[1]; x <= ps->ptop; x++) {
+        if (x->p == pdata) {
+            memcpy(x->buf, x->p, x->n * sizeof(double));
+            x->p = x->buf;
+        }
+    }
+}
+
+/* Element loops.  Within expr, 'a' is an element of the operand below
+ * the top of the stack (or of the only operand) and 'b' an element of
+ * the top operand.  The result goes into the storage of the lower entry.
+ */
+#define UNARY(expr) \
+    do { \
+        const double *pa = x->p; \
+        double *pr = x->buf; \
+        epicsUInt32 i, n = x->n; \
+        for (i = 0; i < n; i++) { \
+            double a = pa[i]; \
+            pr[i] = (expr); \
+        } \
+        x->p = pr; \
+    } while (0)
+
+#define BINARY(expr) \
+    do { \
+        const double *pa = x->p, *pb = y->p; \
+        double *pr = x->buf; \
+        epicsUInt32 i, n = combine(x->n, y->n); \
+        if (y->n == 1) { \
+            double b = pb[0]; \
+            for (i = 0; i < n; i++) { \
+                double a = pa[i]; \
+                pr[i] = (expr); \
+            } \
+        } else if (x->n == 1) { \
+            double a = pa[0]; \
+            for (i = 0; i < n; i++) { \
+                double b = pb[i]; \
+                pr[i] = (expr); \
+            } \
+        } else { \
+            for (i = 0; i < n; i++) { \
+                double a = pa[i], b = pb[i]; \
+                pr[i] = (expr); \
+            } \
+        } \
+        x->p = pr; \
+        x->n = n; \
+        ps->ptop--; \
+    } while (0)
+
+/* Reduce the top entry to a scalar */
+static void reduce(stackEntry *x, int op)
+{
+    const double *pa = x->p;
+    epicsUInt32 i, n = x->n;
+    double r;
+
+    switch (op) {
+    case MAX:
+        r = n ? pa[0] : epicsNAN;
+        for (i = 1; i < n; i++)
+            if (r < pa[i] || isnan(pa[i]))
+                r = pa[i];
+        break;
+
+    case MIN:
+        r = n ? pa[0] : epicsNAN;
+        for (i = 1; i < n; i++)
+            if (r > pa[i] || isnan(pa[i]))
+                r = pa[i];
+        break;
+
+    case SUM:
+    case AVG: {
+        /* Independent partial sums, so the loop can be vectorized */
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+        for (i = 0; i + 4 <= n; i += 4) {
+            s0 += pa[i];
+            s1 += pa[i + 1];
+            s2 += pa[i + 2];
+            s3 += pa[i + 3];
+        }
+        for (; i < n; i++)
+            s0 += pa[i];
+        r = (s0 + s1) + (s2 + s3);
+        if (op == AVG)
+            r /= n;
+        break;
+    }
+
+    case FINITE: {
+        int all = 1;
+
+        for (i = 0; i < n; i++)
+            all &= finite(pa[i]) != 0;
+        r = all;
+        break;
+    }
+
+    case ISNAN: {
+        int any = 0;
+
+        for (i = 0; i < n; i++)
+            any |= isnan(pa[i]) != 0;
+        r = any;
+        break;
+    }
+
+    default:
+        r = epicsNAN;
+    }
+    x->buf[0] = r;
+    x->p = x->buf;
+    x->n = 1;
+}
+
+/* Combine the results of both branches of a ?: with an array condition,
+ * which are on the stack above the condition.
+ */
+static void merge(calcArrayStack *ps)
+{
+    stackEntry *c = ps->ptop - 2;
+    stackEntry *t = ps->ptop - 1;
+    stackEntry *e = ps->ptop;
+    const double *pc = c->p, *pt = t->p, *pe = e->p;
+    double *pr = c->buf;
+    epicsUInt32 i, n = combine(combine(c->n, t->n), e->n);
+
+    if (c->n != 1 && t->n != 1 && e->n != 1) {
+        for (i = 0; i < n; i++)
+            pr[i] = pc[i] != 0.0 ? pt[i] : pe[i];
+    }
+    else {
+        epicsUInt32 sc = c->n != 1, st = t->n != 1, se = e->n != 1;
+
+        for (i = 0; i < n; i++)
+            pr[i] = pc[i * sc] != 0.0 ? pt[i * st] : pe[i * se];
+    }
+    c->p = pr;
+    c->n = n;
+    ps->ptop = c;
+}
+
+static int evaluate(calcArrayStack *ps, const char **ppinst, int mode)
+{
+    const char *pinst = *ppinst;
+    stackEntry *x, *y;
+    int op, nargs;
+
+    for (;;) {
+        op = *pinst++;
+        x = ps->ptop;
+        y = x;
+        switch (op) {
+        /* The operators that work on two operands find the one
+         * below the top in x and the top one in y.
+         */
+        case ADD: case SUB: case MULT: case DIV: case MODULO: case POWER:
+        case ATAN2:
+        case REL_OR: case REL_AND:
+        case BIT_OR: case BIT_AND: case BIT_EXCL_OR:
+        case RIGHT_SHIFT: case LEFT_SHIFT:
+        case NOT_EQ: case LESS_THAN: case LESS_OR_EQ:
+        case EQUAL: case GR_OR_EQ: case GR_THAN:
+            if (x - ps->entry < 2)
+                return -1;
+            x--;
+            break;
+
+        case UNARY_NEG:
+        case ABS_VAL: case EXP: case LOG_10: case LOG_E: case SQU_RT:
+        case ACOS: case ASIN: case ATAN: case COS: case COSH:
+        case SIN: case SINH: case TAN: case TANH:
+        case CEIL: case FLOOR: case ISINF: case NINT:
+        case REL_NOT: case BIT_NOT:
+        case STORE_A: case STORE_B: case STORE_C: case STORE_D:
+        case STORE_E: case STORE_F: case STORE_G: case STORE_H:
+        case STORE_I: case STORE_J: case STORE_K: case STORE_L:
+        case COND_IF:
+            if (x == ps->entry)
+                return -1;
+            break;
+        }
+
+        switch (op) {
+        case END_EXPRESSION:
+            if (mode == EVAL_THEN)
+                return -1;
+            *ppinst = pinst - 1;
+            return 0;
+
+        case LITERAL_DOUBLE: {
+            double lit;
+
+            memcpy(&lit, pinst, sizeof(double));
+            pinst += sizeof(double);
+            if (!pushScalar(ps, lit))
+                return -1;
+            break;
+        }
+
+        case LITERAL_INT: {
+            epicsInt32 lit;
+
+            memcpy(&lit, pinst, sizeof(epicsInt32));
+            pinst += sizeof(epicsInt32);
+            if (!pushScalar(ps, lit))
+                return -1;
+            break;
+        }
+
+        case FETCH_VAL:
+            if (!pushArray(ps, ps->pval))
+                return -1;
+            break;
+
+        case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+        case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+        case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+            if (!pushArray(ps, &ps->parg[op - FETCH_A]))
+                return -1;
+            break;
+
+        case STORE_A: case STORE_B: case STORE_C: case STORE_D:
+        case STORE_E: case STORE_F: case STORE_G: case STORE_H:
+        case STORE_I: case STORE_J: case STORE_K: case STORE_L: {
+            calcArrayArg *parg = &ps->parg[op - STORE_A];
+            epicsUInt32 n = x->n < parg->size ? x->n : parg->size;
+
+            ps->ptop--;
+            detach(ps, parg->pval);
+            if (x->p != parg->pval)
+                memcpy(parg->pval, x->p, n * sizeof(double));
+            parg->nelm = n;
+            break;
+        }
+
+        case CONST_PI:
+            if (!pushScalar(ps, PI))
+                return -1;
+            break;
+
+        case CONST_D2R:
+            if (!pushScalar(ps, PI/180.))
+                return -1;
+            break;
+
+        case CONST_R2D:
+            if (!pushScalar(ps, 180./PI))
+                return -1;
+            break;
+
+        case RANDOM:
+            if (!pushScalar(ps, epicsCalcRandomPvt()))
+                return -1;
+            break;
+
+        case UNARY_NEG:     UNARY(-a);                      break;
+        case ADD:           BINARY(a + b);                  break;
+        case SUB:           BINARY(a - b);                  break;
+        case MULT:          BINARY(a * b);                  break;
+        case DIV:           BINARY(a / b);                  break;
+        case MODULO:
+            BINARY((epicsInt32) b ?
+                (double) ((epicsInt32) a % (epicsInt32) b) : epicsNAN);
+            break;
+        case POWER:         BINARY(pow(a, b));              break;
+
+        case ABS_VAL:       UNARY(fabs(a));                 break;
+        case EXP:           UNARY(exp(a));                  break;
+        case LOG_10:        UNARY(log10(a));                break;
+        case LOG_E:         UNARY(log(a));                  break;
+        case SQU_RT:        UNARY(sqrt(a));                 break;
+
+        case ACOS:          UNARY(acos(a));                 break;
+        case ASIN:          UNARY(asin(a));                 break;
+        case ATAN:          UNARY(atan(a));                 break;
+        case ATAN2:         BINARY(atan2(b, a));            break;
+        case COS:           UNARY(cos(a));                  break;
+        case COSH:          UNARY(cosh(a));                 break;
+        case SIN:           UNARY(sin(a));                  break;
+        case SINH:          UNARY(sinh(a));                 break;
+        case TAN:           UNARY(tan(a));                  break;
+        case TANH:          UNARY(tanh(a));                 break;
+
+        case CEIL:          UNARY(ceil(a));                 break;
+        case FLOOR:         UNARY(floor(a));                break;
+        case ISINF:         UNARY(isinf(a));                break;
+        case NINT:
+            UNARY((epicsInt32) (a >= 0 ? a + 0.5 : a - 0.5));
+            break;
+
+        case REL_OR:        BINARY(a || b);                 break;
+        case REL_AND:       BINARY(a && b);                 break;
+        case REL_NOT:       UNARY(!a);                      break;
+
+        /* Bitwise operators cast the same way calcPerform() does */
+        case BIT_OR:
+            BINARY((epicsInt32) ((epicsUInt32) a | (epicsUInt32) b));
+            break;
+        case BIT_AND:
+            BINARY((epicsInt32) ((epicsUInt32) a & (epicsUInt32) b));
+            break;
+        case BIT_EXCL_OR:
+            BINARY((epicsInt32) ((epicsUInt32) a ^ (epicsUInt32) b));
+            break;
+        case BIT_NOT:
+            UNARY((epicsInt32) ~(epicsUInt32) a);
+            break;
+        case RIGHT_SHIFT:
+            BINARY(((epicsInt32) (epicsUInt32) a) >> ((epicsUInt32) b & 31));
+            break;
+        case LEFT_SHIFT:
+            BINARY(((epicsInt32) (epicsUInt32) a) << ((epicsUInt32) b & 31));
+            break;
+
+        case NOT_EQ:        BINARY(a != b);                 break;
+        case LESS_THAN:     BINARY(a < b);                  break;
+        case LESS_OR_EQ:    BINARY(a <= b);                 break;
+        case EQUAL:         BINARY(a == b);                 break;
+        case GR_OR_EQ:      BINARY(a >= b);                 break;
+        case GR_THAN:       BINARY(a > b);                  break;
+
+        case MAX: case MIN: case SUM: case AVG:
+        case FINITE: case ISNAN:
+            nargs = *pinst++;
+            if (nargs < 1 || ps->ptop - ps->entry < nargs)
+                return -1;
+            if (nargs == 1) {
+                reduce(ps->ptop, op);
+                break;
+            }
+            /* Element-wise, folding down from the top like calcPerform() */
+            if (op == FINITE) {
+                x = ps->ptop;
+                UNARY(finite(a) != 0);
+            }
+            else if (op == ISNAN) {
+                x = ps->ptop;
+                UNARY(isnan(a) != 0);
+            }
+            while (--nargs) {
+                y = ps->ptop;
+                x = y - 1;
+                switch (op) {
+                case MAX:   BINARY(a < b || isnan(b) ? b : a);  break;
+                case MIN:   BINARY(a > b || isnan(b) ? b : a);  break;
+                case SUM:
+                case AVG:   BINARY(a + b);                      break;
+                case FINITE:BINARY(finite(a) && b);             break;
+                case ISNAN: BINARY(isnan(a) || b);              break;
+                }
+            }
+            if (op == AVG) {
+                double count = pinst[-1];
+
+                x = ps->ptop;
+                UNARY(a / count);
+            }
+            break;
+
+        case COND_IF:
+            if (x->n == 1) {
+                double cond = x->p[0];
+
+                ps->ptop--;
+                if (cond != 0.0) {
+                    if (evaluate(ps, &pinst, EVAL_THEN))
+                        return -1;
+                    skipElse(&pinst);
+                }
+                else {
+                    if (skipThen(&pinst) ||
+                        evaluate(ps, &pinst, EVAL_ELSE))
+                        return -1;
+                }
+            }
+            else {
+                if (evaluate(ps, &pinst, EVAL_THEN) ||
+                    ps->ptop != x + 1 ||
+                    evaluate(ps, &pinst, EVAL_ELSE) ||
+                    ps->ptop != x + 2)
+                    return -1;
+                merge(ps);
+            }
+            break;
+
+        case COND_ELSE:
+            if (mode == EVAL_EXPR)
+                return -1;
+            /* The true branch consumes its COND_ELSE, but a false
+             * branch stops at the one belonging to an outer ?:
+             */
+            *ppinst = mode == EVAL_THEN ? pinst : pinst - 1;
+            return 0;
+
+        case COND_END:
+            if (mode == EVAL_ELSE) {
+                *ppinst = pinst;
+                return 0;
+            }
+            break;
+
+        default:
+            errlogPrintf("calcArrayPerform: Bad Opcode %d at %p\n",
+                op, pinst-1);
+            return -1;
+        }
+    }
+}
+
+epicsShareFunc long
+    calcArrayPerform(calcArrayArg *parg, calcArrayArg *pval,
+        const char *pinst, calcArrayStack *ps)
+{
+    stackEntry *x;
+    epicsUInt32 n;
+
+    ps->ptop = ps->entry;
+    ps->parg = parg;
+    ps->pval = pval;
+    if (evaluate(ps, &pinst, EVAL_EXPR))
+        return -1;
+
+    /* The stack should now have one item on it, the expression value */
+    x = ps->ptop;
+    if (x != &ps->entry[1])
+        return -1;
+    n = x->n < pval->size ? x->n : pval->size;
+    if (x->p != pval->pval)
+        memcpy(pval->pval, x->p, n * sizeof(double));
+    pval->nelm = n;
+    return 0;
+}
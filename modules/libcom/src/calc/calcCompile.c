@@ -0,0 +1,860 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* calcCompile.c
+ *
+ * Translates the postfix byte stream produced by postfix() into an array
+ * of fixed-size instructions that calcRun() can execute without decoding
+ * anything.  While doing so it
+ *  - resolves literals and constants into the instructions that use them,
+ *  - folds operations whose operands are all constant,
+ *  - drops the untaken branch of a ?: with a constant condition,
+ *  - fuses an operand fetch into the following binary operator, STORE or
+ *    conditional so it doesn't go through the stack, and
+ *  - resolves the conditionals into direct jumps.
+ * Every value is computed with the same C expressions that calcPerform()
+ * uses (constants are folded by calling calcPerform() itself), so results
+ * are bit-identical, except that C leaves open which NaN an operation on
+ * two NaNs returns.  The top of the stack is held in a local variable
+ * while evaluating, so most instructions never touch the stack array.
+ * The stack depth is checked once here, so calcRun() doesn't need to check
+ * it.  Anything unexpected makes calcCompile() return NULL and the caller
+ * keeps using calcPerform().
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define epicsExportSharedSymbols
+#include "dbDefs.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "epicsStdio.h"
+#include "errlog.h"
+#include "postfix.h"
+#include "postfixPvt.h"
+
+/* Instructions that don't appear in the postfix stream */
+enum {
+    CALC_PUSH = NOT_GENERATED + 1,
+    CALC_NOPS
+};
+
+/* Where an instruction gets its operand 'top' from */
+enum {
+    SRC_NONE,   /* no operand, or works on the stack in place */
+    SRC_POP,    /* pop it off the stack */
+    SRC_CONST,  /* the value field */
+    SRC_ARG,    /* parg[arg] */
+    SRC_VAL     /* *presult */
+};
+
+typedef struct calcInst {
+    unsigned char op;       /* rpn_opcode or CALC_PUSH */
+    unsigned char src;      /* SRC_* */
+    unsigned char arg;      /* argument index for SRC_ARG */
+    unsigned char aux;      /* STORE_A target index, or var-arg count */
+    unsigned short jump;    /* target of COND_IF and COND_ELSE */
+    unsigned short disp;    /* what calcRun() switches on, see OPERAND() */
+    double value;           /* operand for SRC_CONST */
+} calcInst;
+
+struct calcProgram {
+    unsigned count;
+    calcInst code[1];
+};
+
+/* Evaluate a short postfix sequence with calcPerform() */
+static int perform(const char *pinst, double *presult)
+{
+    double args[CALCPERFORM_NARGS];
+
+    memset(args, 0, sizeof(args));
+    *presult = 0.0;
+    return calcPerform(args, presult, pinst) != 0;
+}
+
+static int isBinary(int op)
+{
+    switch (op) {
+    case ADD: case SUB: case MULT: case DIV: case MODULO: case POWER:
+    case ATAN2:
+    case REL_OR: case REL_AND:
+    case BIT_OR: case BIT_AND: case BIT_EXCL_OR:
+    case RIGHT_SHIFT: case LEFT_SHIFT:
+    case NOT_EQ: case LESS_THAN: case LESS_OR_EQ:
+    case EQUAL: case GR_OR_EQ: case GR_THAN:
+        return 1;
+    }
+    return 0;
+}
+
+static int isUnary(int op)
+{
+    switch (op) {
+    case UNARY_NEG:
+    case ABS_VAL: case EXP: case LOG_10: case LOG_E: case SQU_RT:
+    case ACOS: case ASIN: case ATAN: case COS: case COSH:
+    case SIN: case SINH: case TAN: case TANH:
+    case CEIL: case FLOOR: case ISINF: case NINT:
+    case REL_NOT: case BIT_NOT:
+        return 1;
+    }
+    return 0;
+}
+
+static int isVarArg(int op)
+{
+    return op == MAX || op == MIN || op == SUM || op == AVG ||
+        op == FINITE || op == ISNAN;
+}
+
+/* Compiler state */
+typedef struct {
+    calcInst *out;
+    unsigned n;         /* instructions emitted */
+    unsigned barrier;   /* instructions below this are jump targets or
+                         * precede one, so they can't be merged */
+} compiler;
+
+static int isConstPush(const compiler *pc, unsigned i)
+{
+    return i >= pc->barrier && i < pc->n &&
+        pc->out[i].op == CALC_PUSH && pc->out[i].src == SRC_CONST;
+}
+
+static calcInst * emit(compiler *pc, int op, int src)
+{
+    calcInst *pi = &pc->out[pc->n++];
+
+    memset(pi, 0, sizeof(*pi));
+    pi->op = op;
+    pi->src = src;
+    return pi;
+}
+
+/* Replace the last nconst constant pushes and the operator op with a
+ * push of the result.
+ */
+static int fold(compiler *pc, int op, int nargs, int nconst)
+{
+    char buf[(1 + sizeof(double)) * CALCPERFORM_STACK + 3];
+    char *pbuf = buf;
+    unsigned i;
+    double value;
+
+    for (i = pc->n - nconst; i < pc->n; i++) {
+        *pbuf++ = LITERAL_DOUBLE;
+        memcpy(pbuf, &pc->out[i].value, sizeof(double));
+        pbuf += sizeof(double);
+    }
+    *pbuf++ = op;
+    if (isVarArg(op))
+        *pbuf++ = nargs;
+    *pbuf = END_EXPRESSION;
+    if (perform(buf, &value))
+        return -1;
+    pc->n -= nconst;
+    emit(pc, CALC_PUSH, SRC_CONST)->value = value;
+    return 0;
+}
+
+/* If the last instruction is a push that can be merged into a following
+ * consumer, turn it into that consumer and return it.
+ */
+static calcInst * fuse(compiler *pc, int op)
+{
+    calcInst *pi;
+
+    if (pc->n == 0 || pc->n - 1 < pc->barrier)
+        return NULL;
+    pi = &pc->out[pc->n - 1];
+    if (pi->op != CALC_PUSH)
+        return NULL;
+    pi->op = op;
+    return pi;
+}
+
+/* A decoded postfix element */
+typedef struct {
+    int op;
+    int nargs;          /* var-arg count */
+    double value;       /* literal value */
+    unsigned target;    /* element that COND_IF or COND_ELSE continues at */
+} element;
+
+/* Find the element after the operator that cond_search() in
+ * calcPerform.c would jump to from element i.  Note that postfix()
+ * puts all the COND_ENDs of nested conditionals at the end.
+ */
+static int findTarget(element *pel, unsigned nel, unsigned i, int match)
+{
+    int count = 1;
+
+    for (i++; i < nel; i++) {
+        if (pel[i].op == match && --count == 0) {
+            return i + 1;
+        }
+        if (pel[i].op == COND_IF)
+            count++;
+    }
+    return -1;
+}
+
+/* Check the stack depth along every path */
+static int checkDepth(const calcInst *code, unsigned count)
+{
+    int *depth = malloc(count * sizeof(int));
+    unsigned i;
+    int ok = 0;
+
+    if (!depth)
+        return -1;
+    for (i = 0; i < count; i++)
+        depth[i] = -1;
+    depth[0] = 0;
+
+    for (i = 0; i < count; i++) {
+        const calcInst *pi = &code[i];
+        int d = depth[i];
+        int need = 0, after;
+
+        if (d < 0)
+            goto done;
+        if (pi->src == SRC_POP) {
+            if (--d < 0)
+                goto done;
+        }
+        if (pi->op == CALC_PUSH || pi->op == RANDOM) {
+            after = d + 1;
+        } else if (isBinary(pi->op) || isUnary(pi->op)) {
+            need = 1;
+            after = d;
+        } else if (isVarArg(pi->op)) {
+            need = pi->aux;
+            after = d - pi->aux + 1;
+        } else {
+            after = d;
+        }
+        if (d < need || after > CALCPERFORM_STACK)
+            goto done;
+
+        if (pi->op == END_EXPRESSION) {
+            ok = (i == count - 1 && d == 1);
+            goto done;
+        }
+        if (pi->op == COND_IF || pi->op == COND_ELSE) {
+            if (pi->jump <= i || pi->jump >= count ||
+                (depth[pi->jump] >= 0 && depth[pi->jump] != after))
+                goto done;
+            depth[pi->jump] = after;
+            if (pi->op == COND_ELSE)
+                continue;
+        }
+        if (depth[i + 1] >= 0 && depth[i + 1] != after)
+            goto done;
+        depth[i + 1] = after;
+    }
+done:
+    free(depth);
+    return ok ? 0 : -1;
+}
+
+/* Decode the postfix stream into elements */
+static element * decode(const char *pinst, unsigned *pnel)
+{
+    element *pel;
+    unsigned nel = 1;
+    const char *p;
+    int op;
+
+    /* Count the elements, including END_EXPRESSION */
+    for (p = pinst; (op = *p++) != END_EXPRESSION; nel++) {
+        if (op == LITERAL_DOUBLE)
+            p += sizeof(double);
+        else if (op == LITERAL_INT)
+            p += sizeof(epicsInt32);
+        else if (isVarArg(op))
+            p++;
+    }
+    if (nel > USHRT_MAX)
+        return NULL;
+    pel = calloc(nel, sizeof(element));
+    if (!pel)
+        return NULL;
+
+    for (nel = 0; ; nel++) {
+        element *pe = &pel[nel];
+        epicsInt32 itop;
+
+        pe->op = op = *pinst++;
+        switch (op) {
+        case LITERAL_DOUBLE:
+            memcpy(&pe->value, pinst, sizeof(double));
+            pinst += sizeof(double);
+            break;
+        case LITERAL_INT:
+            memcpy(&itop, pinst, sizeof(epicsInt32));
+            pe->value = itop;
+            pinst += sizeof(epicsInt32);
+            break;
+        case MIN:
+        case MAX:
+        case SUM:
+        case AVG:
+        case FINITE:
+        case ISNAN:
+            pe->nargs = *pinst++;
+            break;
+        }
+        if (op == END_EXPRESSION)
+            break;
+    }
+    *pnel = nel + 1;
+    return pel;
+}
+
+epicsShareFunc calcProgram *
+    calcCompile(const char *pinst)
+{
+    element *pel;
+    unsigned nel;
+    unsigned *nref;     /* live jumps to each element */
+    unsigned *map;      /* instruction index of each element */
+    calcInst *code = NULL;
+    calcProgram *pprog = NULL;
+    compiler c;
+    int dead = 0;
+    unsigned e, i;
+
+    if (!pinst)
+        return NULL;
+    pel = decode(pinst, &nel);
+    if (!pel)
+        return NULL;
+    nref = calloc(nel, sizeof(unsigned));
+    map = calloc(nel, sizeof(unsigned));
+    code = malloc(nel * sizeof(calcInst));
+    if (!nref || !map || !code)
+        goto done;
+
+    for (e = 0; e < nel; e++) {
+        int op = pel[e].op;
+
+        if (op == COND_IF || op == COND_ELSE) {
+            int target = findTarget(pel, nel, e,
+                op == COND_IF ? COND_ELSE : COND_END);
+
+            if (target < 0)
+                goto done;
+            pel[e].target = target;
+        }
+    }
+
+    c.out = code;
+    c.n = c.barrier = 0;
+
+    for (e = 0; e < nel; e++) {
+        element *pe = &pel[e];
+        int op = pe->op;
+        calcInst *pi;
+        double value;
+        char elem[2];
+
+        if (nref[e]) {
+            /* Jumps land here */
+            if (c.n && code[c.n - 1].op == COND_ELSE &&
+                code[c.n - 1].jump == e) {
+                /* to the next instruction, so it can go */
+                c.n--;
+                nref[e]--;
+                if (c.barrier > c.n)
+                    c.barrier = c.n;
+            }
+            if (nref[e])
+                c.barrier = c.n;
+            dead = 0;
+        }
+        else if (dead)
+            continue;
+        map[e] = c.n;
+
+        switch (op) {
+        case END_EXPRESSION:
+            emit(&c, END_EXPRESSION, SRC_NONE);
+            break;
+
+        case LITERAL_DOUBLE:
+        case LITERAL_INT:
+            emit(&c, CALC_PUSH, SRC_CONST)->value = pe->value;
+            break;
+
+        case CONST_PI:
+        case CONST_D2R:
+        case CONST_R2D:
+            elem[0] = op;
+            elem[1] = END_EXPRESSION;
+            if (perform(elem, &value))
+                goto done;
+            emit(&c, CALC_PUSH, SRC_CONST)->value = value;
+            break;
+
+        case FETCH_VAL:
+            emit(&c, CALC_PUSH, SRC_VAL);
+            break;
+
+        case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+        case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+        case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+            emit(&c, CALC_PUSH, SRC_ARG)->arg = op - FETCH_A;
+            break;
+
+        case STORE_A: case STORE_B: case STORE_C: case STORE_D:
+        case STORE_E: case STORE_F: case STORE_G: case STORE_H:
+        case STORE_I: case STORE_J: case STORE_K: case STORE_L:
+            pi = fuse(&c, STORE_A);
+            if (!pi)
+                pi = emit(&c, STORE_A, SRC_POP);
+            pi->aux = op - STORE_A;
+            break;
+
+        case RANDOM:
+            emit(&c, RANDOM, SRC_NONE);
+            break;
+
+        case MAX:
+        case MIN:
+        case SUM:
+        case AVG:
+        case FINITE:
+        case ISNAN:
+            if (pe->nargs < 1 || pe->nargs > CALCPERFORM_STACK)
+                goto done;
+            for (i = 1; i <= pe->nargs && isConstPush(&c, c.n - i); i++);
+            if (i > pe->nargs) {
+                if (fold(&c, op, pe->nargs, pe->nargs))
+                    goto done;
+            }
+            else
+                emit(&c, op, SRC_NONE)->aux = pe->nargs;
+            break;
+
+        case COND_IF:
+            if (isConstPush(&c, c.n - 1)) {
+                /* Constant condition */
+                if (code[--c.n].value != 0.0)
+                    break;
+                pi = emit(&c, COND_ELSE, SRC_NONE);
+                dead = 1;
+            }
+            else {
+                pi = fuse(&c, COND_IF);
+                if (!pi)
+                    pi = emit(&c, COND_IF, SRC_POP);
+            }
+            pi->jump = pe->target;
+            nref[pe->target]++;
+            break;
+
+        case COND_ELSE:
+            emit(&c, COND_ELSE, SRC_NONE)->jump = pe->target;
+            nref[pe->target]++;
+            dead = 1;
+            break;
+
+        case COND_END:
+            break;
+
+        default:
+            if (isBinary(op)) {
+                if (isConstPush(&c, c.n - 1) && isConstPush(&c, c.n - 2)) {
+                    if (fold(&c, op, 2, 2))
+                        goto done;
+                }
+                else if (!fuse(&c, op))
+                    emit(&c, op, SRC_POP);
+            }
+            else if (isUnary(op)) {
+                if (isConstPush(&c, c.n - 1)) {
+                    if (fold(&c, op, 1, 1))
+                        goto done;
+                }
+                else
+                    emit(&c, op, SRC_NONE);
+            }
+            else
+                goto done;
+        }
+    }
+
+    /* Jumps were recorded as element numbers */
+    for (i = 0; i < c.n; i++) {
+        if (code[i].op == COND_IF || code[i].op == COND_ELSE)
+            code[i].jump = map[code[i].jump];
+        code[i].disp = code[i].op;
+        if (code[i].src > SRC_POP)
+            code[i].disp += (code[i].src - SRC_POP) * CALC_NOPS;
+    }
+    if (checkDepth(code, c.n))
+        goto done;
+
+    pprog = malloc(sizeof(calcProgram) + (c.n - 1) * sizeof(calcInst));
+    if (pprog) {
+        pprog->count = c.n;
+        memcpy(pprog->code, code, c.n * sizeof(calcInst));
+    }
+done:
+    free(pel);
+    free(nref);
+    free(map);
+    free(code);
+    return pprog;
+}
+
+epicsShareFunc void
+    calcProgramFree(calcProgram *pprog)
+{
+    free(pprog);
+}
+
+/* Turn off global optimization for 64-bit MSVC builds */
+#if defined(_WIN32) && defined(_M_X64) && !defined(_MINGW)
+#  pragma optimize("g", off)
+#endif
+
+/* Case labels for an instruction that takes its operand from any source.
+ * The cases just fetch the operand into top, then share the code that
+ * follows.  Popping the operand leaves the value below it in acc.  The
+ * case values are kept dense so the switch compiles to a single table.
+ */
+#define OPERAND(op) \
+    case op:                top = acc; acc = *ptop--; goto op##_; \
+    case op + CALC_NOPS:    top = pinst->value;       goto op##_; \
+    case op + CALC_NOPS*2:  top = parg[pinst->arg];   goto op##_; \
+    case op + CALC_NOPS*3:  top = *presult;           op##_
+
+/* calcRun
+ *
+ * Evaluate a compiled expression, exactly as calcPerform() would
+ */
+epicsShareFunc long
+    calcRun(const calcProgram *pprog, double *parg, double *presult)
+{
+    /* The top of the stack is kept in acc, the rest of it in stack[2] up;
+     * the first push saves the undefined acc in stack[1].
+     */
+    double stack[CALCPERFORM_STACK+2];
+    double *ptop = stack;               /* stack pointer */
+    double acc = 0.0;                   /* top of stack */
+    double top = 0.0;                   /* the instruction's operand */
+    epicsInt32 itop;
+    epicsUInt32 utop;
+    int nargs;
+    const calcInst *pinst;
+
+    for (pinst = pprog->code; ; pinst++) {
+        switch (pinst->disp) {
+        case END_EXPRESSION:
+            /* calcCompile() checked that there's one item on the stack */
+            *presult = acc;
+            return 0;
+
+        OPERAND(CALC_PUSH):
+            *++ptop = acc;
+            acc = top;
+            break;
+
+        OPERAND(STORE_A):
+            parg[pinst->aux] = top;
+            break;
+
+        OPERAND(COND_IF):
+            if (top == 0.0)
+                pinst = pprog->code + pinst->jump - 1;
+            break;
+
+        case COND_ELSE:
+            pinst = pprog->code + pinst->jump - 1;
+            break;
+
+        case RANDOM:
+            *++ptop = acc;
+            acc = epicsCalcRandomPvt();
+            break;
+
+        case UNARY_NEG:
+            acc = - acc;
+            break;
+
+        OPERAND(ADD):
+            acc += top;
+            break;
+
+        OPERAND(SUB):
+            acc -= top;
+            break;
+
+        OPERAND(MULT):
+            acc *= top;
+            break;
+
+        OPERAND(DIV):
+            acc /= top;
+            break;
+
+        OPERAND(MODULO):
+            itop = (epicsInt32) top;
+            if (itop)
+                acc = (epicsInt32) acc % itop;
+            else
+                acc = epicsNAN;
+            break;
+
+        OPERAND(POWER):
+            acc = pow(acc, top);
+            break;
+
+        case ABS_VAL:
+            acc = fabs(acc);
+            break;
+
+        case EXP:
+            acc = exp(acc);
+            break;
+
+        case LOG_10:
+            acc = log10(acc);
+            break;
+
+        case LOG_E:
+            acc = log(acc);
+            break;
+
+        case MAX:
+            nargs = pinst->aux;
+            while (--nargs) {
+                top = acc;
+                acc = *ptop--;
+                if (acc < top || isnan(top))
+                    acc = top;
+            }
+            break;
+
+        case MIN:
+            nargs = pinst->aux;
+            while (--nargs) {
+                top = acc;
+                acc = *ptop--;
+                if (acc > top || isnan(top))
+                    acc = top;
+            }
+            break;
+
+        case SUM:
+            nargs = pinst->aux;
+            while (--nargs) {
+                top = acc;
+                acc = *ptop-- + top;
+            }
+            break;
+
+        case AVG:
+            nargs = pinst->aux;
+            top = nargs;
+            while (--nargs)
+                acc += *ptop--;
+            acc /= top;
+            break;
+
+        case SQU_RT:
+            acc = sqrt(acc);
+            break;
+
+        case ACOS:
+            acc = acos(acc);
+            break;
+
+        case ASIN:
+            acc = asin(acc);
+            break;
+
+        case ATAN:
+            acc = atan(acc);
+            break;
+
+        OPERAND(ATAN2):
+            acc = atan2(top, acc);  /* Args backwards, as calcPerform */
+            break;
+
+        case COS:
+            acc = cos(acc);
+            break;
+
+        case SIN:
+            acc = sin(acc);
+            break;
+
+        case TAN:
+            acc = tan(acc);
+            break;
+
+        case COSH:
+            acc = cosh(acc);
+            break;
+
+        case SINH:
+            acc = sinh(acc);
+            break;
+
+        case TANH:
+            acc = tanh(acc);
+            break;
+
+        case CEIL:
+            acc = ceil(acc);
+            break;
+
+        case FLOOR:
+            acc = floor(acc);
+            break;
+
+        case FINITE:
+            nargs = pinst->aux;
+            top = finite(acc);
+            while (--nargs) {
+                acc = *ptop--;
+                top = top && finite(acc);
+            }
+            acc = top;
+            break;
+
+        case ISINF:
+            acc = isinf(acc);
+            break;
+
+        case ISNAN:
+            nargs = pinst->aux;
+            top = isnan(acc);
+            while (--nargs) {
+                acc = *ptop--;
+                top = top || isnan(acc);
+            }
+            acc = top;
+            break;
+
+        case NINT:
+            top = acc;
+            acc = (epicsInt32) (top >= 0 ? top + 0.5 : top - 0.5);
+            break;
+
+        OPERAND(REL_OR):
+            acc = acc || top;
+            break;
+
+        OPERAND(REL_AND):
+            acc = acc && top;
+            break;
+
+        case REL_NOT:
+            acc = ! acc;
+            break;
+
+        /* See calcPerform() for the casts in the bitwise operations */
+
+        OPERAND(BIT_OR):
+            utop = top;
+            acc = (epicsInt32) ((epicsUInt32) acc | utop);
+            break;
+
+        OPERAND(BIT_AND):
+            utop = top;
+            acc = (epicsInt32) ((epicsUInt32) acc & utop);
+            break;
+
+        OPERAND(BIT_EXCL_OR):
+            utop = top;
+            acc = (epicsInt32) ((epicsUInt32) acc ^ utop);
+            break;
+
+        case BIT_NOT:
+            utop = acc;
+            acc = (epicsInt32) ~utop;
+            break;
+
+        OPERAND(RIGHT_SHIFT):
+            utop = top;
+            acc = ((epicsInt32) (epicsUInt32) acc) >> (utop & 31);
+            break;
+
+        OPERAND(LEFT_SHIFT):
+            utop = top;
+            acc = ((epicsInt32) (epicsUInt32) acc) << (utop & 31);
+            break;
+
+        OPERAND(NOT_EQ):
+            acc = acc != top;
+            break;
+
+        OPERAND(LESS_THAN):
+            acc = acc < top;
+            break;
+
+        OPERAND(LESS_OR_EQ):
+            acc = acc <= top;
+            break;
+
+        OPERAND(EQUAL):
+            acc = acc == top;
+            break;
+
+        OPERAND(GR_OR_EQ):
+            acc = acc >= top;
+            break;
+
+        OPERAND(GR_THAN):
+            acc = acc > top;
+            break;
+
+        default:
+            errlogPrintf("calcRun: Bad Opcode %d\n", pinst->op);
+            return -1;
+        }
+    }
+}
+#if defined(_WIN32) && defined(_M_X64) && !defined(_MINGW)
+#  pragma optimize("", on)
+#endif
+
+epicsShareFunc void
+    calcProgramDump(const calcProgram *pprog)
+{
+    static const char *srcName[] = {"", "pop", "const", "arg", "VAL"};
+    unsigned i;
+
+    for (i = 0; i < pprog->count; i++) {
+        const calcInst *pi = &pprog->code[i];
+
+        switch (pi->op) {
+        case CALC_PUSH:      printf("%4u: PUSH  ", i); break;
+        case STORE_A:        printf("%4u: STORE ", i); break;
+        case COND_IF:        printf("%4u: JZ    ", i); break;
+        case COND_ELSE:      printf("%4u: JMP   ", i); break;
+        case END_EXPRESSION: printf("%4u: END   ", i); break;
+        default:             printf("%4u: op %2d ", i, pi->op);
+        }
+        printf("%-5s", srcName[pi->src]);
+        if (pi->src == SRC_CONST)
+            printf(" %g", pi->value);
+        else if (pi->src == SRC_ARG)
+            printf(" %c", 'A' + pi->arg);
+        if (pi->op == STORE_A)
+            printf(" => %c", 'A' + pi->aux);
+        if (pi->op == COND_IF || pi->op == COND_ELSE)
+            printf(" -> %u", pi->jump);
+        if (isVarArg(pi->op))
+            printf(" (%d args)", pi->aux);
+        printf("\n");
+    }
+}
@@ -25,7 +25,6 @@
 #include "postfix.h"
 #include "postfixPvt.h"
 
-static double calcRandom(void);
 static int cond_search(const char **ppinst, int match);
 
 #ifndef PI
@@ -187,6 +186,24 @@ epicsShareFunc long
 	    }
 	    break;
 
+	case SUM:
+	    nargs = *pinst++;
+	    while (--nargs) {
+		top = *ptop--;
+		*ptop += top;
+	    }
+	    break;
+
+	case AVG:
+	    nargs = *pinst++;
+	    top = nargs;
+	    while (--nargs) {
+		*(ptop - 1) += *ptop;
+		ptop--;
+	    }
+	    *ptop /= top;
+	    break;
+
 	case SQU_RT:
 	    *ptop = sqrt(*ptop);
 	    break;
@@ -270,7 +287,7 @@ epicsShareFunc long
 	    break;
 
 	case RANDOM:
-	    *++ptop = calcRandom();
+	    *++ptop = epicsCalcRandomPvt();
 	    break;
 
 	case REL_OR:
@@ -404,6 +421,8 @@ calcArgUsage(const char *pinst, unsigned long *pinputs, unsigned long *pstores)
 	    break;
 	case MIN:
 	case MAX:
+	case SUM:
+	case AVG:
 	case FINITE:
 	case ISNAN:
 	    pinst++;
@@ -459,7 +478,7 @@ static unsigned short seed = 0xa3bf;
 static unsigned short multy = 191 * 8 + 5;  /* 191 % 8 == 5 */
 static unsigned short addy = 0x3141;
 
-static double calcRandom(void)
+double epicsCalcRandomPvt(void)
 {
     seed = (seed * multy) + addy;
 
@@ -491,6 +510,8 @@ static int cond_search(const char **ppinst, int match)
 	    break;
 	case MIN:
 	case MAX:
+	case SUM:
+	case AVG:
 	case FINITE:
 	case ISNAN:
 	    pinst++;
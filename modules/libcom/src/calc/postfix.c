@@ -88,6 +88,7 @@ static const ELEMENT operands[] = {
 {"ASIN",	7, 8,	0,	UNARY_OPERATOR,	ASIN},
 {"ATAN",	7, 8,	0,	UNARY_OPERATOR,	ATAN},
 {"ATAN2",	7, 8,	-1,	UNARY_OPERATOR,	ATAN2},
+{"AVG",		7, 8,	0,	VARARG_OPERATOR,AVG},
 {"B",		0, 0,	1,	OPERAND,	FETCH_B},
 {"C",		0, 0,	1,	OPERAND,	FETCH_C},
 {"CEIL",	7, 8,	0,	UNARY_OPERATOR,	CEIL},
@@ -124,6 +125,7 @@ static const ELEMENT operands[] = {
 {"SINH",	7, 8,	0,	UNARY_OPERATOR,	SINH},
 {"SQR",		7, 8,	0,	UNARY_OPERATOR,	SQU_RT},
 {"SQRT",	7, 8,	0,	UNARY_OPERATOR,	SQU_RT},
+{"SUM",		7, 8,	0,	VARARG_OPERATOR,SUM},
 {"TAN",		7, 8,	0,	UNARY_OPERATOR,	TAN},
 {"TANH",	7, 8,	0,	UNARY_OPERATOR,	TANH},
 {"VAL",		0, 0,	1,	OPERAND,	FETCH_VAL},
@@ -550,6 +552,8 @@ epicsShareFunc void
 	"LOG_E",
 	"MAX",
 	"MIN",
+	"SUM",
+	"AVG",
 	"SQU_RT",
     /* Trigonometric */
 	"ACOS",
@@ -613,6 +617,8 @@ epicsShareFunc void
 	    break;
 	case MIN:
 	case MAX:
+	case SUM:
+	case AVG:
 	case FINITE:
 	case ISNAN:
 	    printf("\t%s, %d arg(s)\n", opcodes[(int) op], *++pinst);
@@ -15,6 +15,7 @@
 #define INCpostfixh
 
 #include "shareLib.h"
+#include "epicsTypes.h"
 
 #define CALCPERFORM_NARGS 12
 #define CALCPERFORM_STACK 80
@@ -82,6 +83,50 @@ epicsShareFunc const char *
 epicsShareFunc void
     calcExprDump(const char *pinst);
 
+/* Pre-decoded form of a postfix expression, which calcRun() evaluates
+ * faster than calcPerform() with bit-identical results.  calcCompile()
+ * returns NULL for an expression it can't handle, in which case the
+ * caller should keep using calcPerform() on the postfix buffer.
+ */
+typedef struct calcProgram calcProgram;
+
+epicsShareFunc calcProgram *
+    calcCompile(const char *ppostfix);
+
+epicsShareFunc long
+    calcRun(const calcProgram *pprog, double *parg, double *presult);
+
+epicsShareFunc void
+    calcProgramFree(calcProgram *pprog);
+
+epicsShareFunc void
+    calcProgramDump(const calcProgram *pprog);
+
+/* Evaluation of a postfix expression on arrays, applying the operators to
+ * each element in turn; an argument with one element is used as a scalar.
+ * calcArrayPerform() evaluates the expression on CALCPERFORM_NARGS
+ * arguments, reading VAL from and putting the result into *pval.  It needs
+ * a work stack from calcArrayStackCreate() for the same expression, which
+ * sets the maximum number of elements it works on.
+ */
+typedef struct calcArrayArg {
+    double *pval;           /* the elements */
+    epicsUInt32 nelm;       /* number of elements in use */
+    epicsUInt32 size;       /* number of elements pval has room for */
+} calcArrayArg;
+
+typedef struct calcArrayStack calcArrayStack;
+
+epicsShareFunc calcArrayStack *
+    calcArrayStackCreate(const char *ppostfix, epicsUInt32 size);
+
+epicsShareFunc void
+    calcArrayStackFree(calcArrayStack *pstack);
+
+epicsShareFunc long
+    calcArrayPerform(calcArrayArg *parg, calcArrayArg *pval,
+        const char *ppostfix, calcArrayStack *pstack);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,8 +16,8 @@
  *     be contiguous.
  *  2. The LITERAL opcodes are followed by a binary representation of their
  *     values, but these are not aligned properly.
- *  3. The var-arg functions MIN, MAX, FINITE and ISNAN are followed by
- *     a byte giving the number of arguments to process.
+ *  3. The var-arg functions MIN, MAX, SUM, AVG, FINITE and ISNAN are
+ *     followed by a byte giving the number of arguments to process.
  *  4. You can't use strlen() on an RPN buffer since the literal values
  *     can contain zero bytes.
  */
@@ -55,6 +55,8 @@ typedef enum {
 	LOG_E,
 	MAX,
 	MIN,
+	SUM,
+	AVG,
 	SQU_RT,
     /* Trigonometric */
 	ACOS,
@@ -101,4 +103,8 @@ typedef enum {
 	NOT_GENERATED
 } rpn_opcode;
 
+/* Private to libCom, shared by calcPerform() and calcRun() so they draw
+ * the same sequence */
+double epicsCalcRandomPvt(void);
+
 #endif /* INCpostfixPvth */
@@ -50,10 +50,15 @@ epicsShareExtern const ENV_PARAM EPICS_CA_SERVER_PORT;
 epicsShareExtern const ENV_PARAM EPICS_CA_MAX_ARRAY_BYTES;
 epicsShareExtern const ENV_PARAM EPICS_CA_AUTO_ARRAY_BYTES;
 epicsShareExtern const ENV_PARAM EPICS_CA_MAX_SEARCH_PERIOD;
+epicsShareExtern const ENV_PARAM EPICS_CA_MAX_SEARCH_RATE;
+epicsShareExtern const ENV_PARAM EPICS_CA_NAME_CACHE;
 epicsShareExtern const ENV_PARAM EPICS_CA_NAME_SERVERS;
 epicsShareExtern const ENV_PARAM EPICS_CA_MCAST_TTL;
+epicsShareExtern const ENV_PARAM EPICS_CA_IO_THREADS;
+epicsShareExtern const ENV_PARAM EPICS_CA_ZERO_COPY_SEND;
 epicsShareExtern const ENV_PARAM EPICS_CAS_INTF_ADDR_LIST;
 epicsShareExtern const ENV_PARAM EPICS_CAS_IGNORE_ADDR_LIST;
+epicsShareExtern const ENV_PARAM EPICS_CAS_NAME_SERVERS;
 epicsShareExtern const ENV_PARAM EPICS_CAS_AUTO_BEACON_ADDR_LIST;
 epicsShareExtern const ENV_PARAM EPICS_CAS_BEACON_ADDR_LIST;
 epicsShareExtern const ENV_PARAM EPICS_CAS_SERVER_PORT;
@@ -65,6 +70,7 @@ epicsShareExtern const ENV_PARAM EPICS_BUILD_OS_CLASS;
 epicsShareExtern const ENV_PARAM EPICS_BUILD_TARGET_ARCH;
 epicsShareExtern const ENV_PARAM EPICS_TZ;
 epicsShareExtern const ENV_PARAM EPICS_TS_NTP_INET;
+epicsShareExtern const ENV_PARAM EPICS_FDMGR_POLLER;
 epicsShareExtern const ENV_PARAM EPICS_IOC_IGNORE_SERVERS;
 epicsShareExtern const ENV_PARAM EPICS_IOC_LOG_PORT;
 epicsShareExtern const ENV_PARAM EPICS_IOC_LOG_INET;
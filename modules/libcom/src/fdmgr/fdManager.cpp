@@ -20,11 +20,22 @@
 //
 
 #include <algorithm>
+#include <limits.h>
+#include <string.h>
+
+#if defined(__linux__)
+#   include <errno.h>
+#   include <unistd.h>
+#   include <sys/epoll.h>
+#   define FDMGR_EPOLL
+#endif
 
 #define instantiateRecourceLib
 #define epicsExportSharedSymbols
 #include "epicsAssert.h"
 #include "epicsThread.h"
+#include "envDefs.h"
+#include "epicsString.h"
 #include "fdManager.h"
 #include "locationException.h"
 
@@ -35,24 +46,325 @@ epicsShareDef fdManager fileDescriptorManager;
 const unsigned mSecPerSec = 1000u;
 const unsigned uSecPerSec = 1000u * mSecPerSec;
 
+//
+// fdPoller
+//
+// waits for activity on the pending registrations of a fdManager
+// and moves those which are ready to its active list
+//
+class fdPoller {
+public:
+    virtual ~fdPoller () {}
+    virtual const char * name () const = 0;
+    virtual bool fdInRange ( SOCKET fd ) const = 0;
+    virtual void installReg ( fdManager & mgr, fdReg & reg ) = 0;
+    virtual void removeReg ( fdManager & mgr, fdReg & reg ) = 0;
+    // returns the number of registrations activated, or -1
+    virtual int poll ( fdManager & mgr, double delay ) = 0;
+    static fdPoller * create ( fdPollerType type );
+protected:
+    static tsDLList < fdReg > & pendingList ( fdManager & mgr )
+    {
+        return mgr.regList;
+    }
+    static bool activate ( fdManager & mgr, fdReg * pReg, bool first );
+};
+
+//
+// fdPoller::activate ()
+//
+bool fdPoller::activate ( fdManager & mgr, fdReg * pReg, bool first )
+{
+    if ( ! pReg || pReg->state != fdReg::pending ) {
+        return false;
+    }
+    mgr.regList.remove ( *pReg );
+    if ( first ) {
+        mgr.activeList.push ( *pReg );
+    }
+    else {
+        mgr.activeList.add ( *pReg );
+    }
+    pReg->state = fdReg::active;
+    return true;
+}
+
+//
+// fdSelectPoller
+//
+// rebuilds fd_sets from the pending list and calls select() on every
+// iteration, limited to FD_SETSIZE
+//
+class fdSelectPoller : public fdPoller {
+public:
+    fdSelectPoller ();
+    ~fdSelectPoller ();
+    const char * name () const { return "select"; }
+    bool fdInRange ( SOCKET fd ) const { return FD_IN_FDSET ( fd ); }
+    void installReg ( fdManager & mgr, fdReg & reg );
+    void removeReg ( fdManager & mgr, fdReg & reg );
+    int poll ( fdManager & mgr, double delay );
+private:
+    fd_set * fdSetsPtr;
+    SOCKET maxFD;
+};
+
+fdSelectPoller::fdSelectPoller () :
+    fdSetsPtr ( new fd_set [fdrNEnums] ), maxFD ( 0 )
+{
+    for ( size_t i = 0u; i < fdrNEnums; i++ ) {
+        FD_ZERO ( &fdSetsPtr[i] ); 
+    }
+}
+
+fdSelectPoller::~fdSelectPoller ()
+{
+    delete [] this->fdSetsPtr;
+}
+
+void fdSelectPoller::installReg ( fdManager &, fdReg & reg )
+{
+    this->maxFD = max ( this->maxFD, reg.getFD()+1 );
+}
+
+void fdSelectPoller::removeReg ( fdManager &, fdReg & reg )
+{
+    FD_CLR(reg.getFD(), &this->fdSetsPtr[reg.getType()]);
+}
+
+int fdSelectPoller::poll ( fdManager & mgr, double delay )
+{
+    tsDLList < fdReg > & regList = pendingList ( mgr );
+    tsDLIter < fdReg > iter = regList.firstIter ();
+    while ( iter.valid () ) {
+        FD_SET(iter->getFD(), &this->fdSetsPtr[iter->getType()]); 
+        ++iter;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = static_cast<time_t> ( delay );
+    tv.tv_usec = static_cast<long> ( (delay-tv.tv_sec) * uSecPerSec );
+
+    fd_set * pReadSet = & this->fdSetsPtr[fdrRead];
+    fd_set * pWriteSet = & this->fdSetsPtr[fdrWrite];
+    fd_set * pExceptSet = & this->fdSetsPtr[fdrException];
+    int status = select (this->maxFD, pReadSet, pWriteSet, pExceptSet, &tv);
+
+    if ( status > 0 ) {
+        int nActive = 0;
+
+        //
+        // Look for activity
+        //
+        iter=regList.firstIter ();
+        while ( iter.valid () && status > 0 ) {
+            tsDLIter < fdReg > tmp = iter;
+            tmp++;
+            if (FD_ISSET(iter->getFD(), &this->fdSetsPtr[iter->getType()])) {
+                FD_CLR(iter->getFD(), &this->fdSetsPtr[iter->getType()]);
+                activate ( mgr, iter.pointer (), false );
+                nActive++;
+                status--;
+            }
+            iter = tmp;
+        }
+        return nActive;
+    }
+    else if ( status < 0 ) {
+        int errnoCpy = SOCKERRNO;
+        
+        // dont depend on flags being properly set if 
+        // an error is retuned from select
+        for ( size_t i = 0u; i < fdrNEnums; i++ ) {
+            FD_ZERO ( &fdSetsPtr[i] );
+        }
+
+        //
+        // print a message if its an unexpected error
+        //
+        if ( errnoCpy != SOCK_EINTR ) {
+            char sockErrBuf[64];
+            epicsSocketConvertErrnoToString ( 
+                sockErrBuf, sizeof ( sockErrBuf ) );
+            fprintf ( stderr, 
+            "fdManager: select failed because \"%s\"\n",
+                sockErrBuf );
+        }
+        return -1;
+    }
+    return 0;
+}
+
+#ifdef FDMGR_EPOLL
+
+//
+// fdEpollPoller
+//
+// keeps one epoll registration per file descriptor whose event mask
+// is the union of the fdReg types installed for it, so a wakeup costs
+// in proportion to the number of ready descriptors only
+//
+class fdEpollPoller : public fdPoller {
+public:
+    fdEpollPoller ( int epfd );
+    ~fdEpollPoller ();
+    const char * name () const { return "epoll"; }
+    bool fdInRange ( SOCKET fd ) const { return fd >= 0; }
+    void installReg ( fdManager & mgr, fdReg & reg );
+    void removeReg ( fdManager & mgr, fdReg & reg );
+    int poll ( fdManager & mgr, double delay );
+private:
+    enum { maxEvents = 256 };
+    struct epoll_event events[maxEvents];
+    int epfd;
+    void update ( fdManager & mgr, SOCKET fd );
+};
+
+fdEpollPoller::fdEpollPoller ( int epfdIn ) :
+    epfd ( epfdIn )
+{
+}
+
+fdEpollPoller::~fdEpollPoller ()
+{
+    close ( this->epfd );
+}
+
+void fdEpollPoller::update ( fdManager & mgr, SOCKET fd )
+{
+    struct epoll_event ev;
+
+    memset ( &ev, 0, sizeof ( ev ) );
+    if ( mgr.lookUpFD ( fd, fdrRead ) ) {
+        ev.events |= EPOLLIN;
+    }
+    if ( mgr.lookUpFD ( fd, fdrWrite ) ) {
+        ev.events |= EPOLLOUT;
+    }
+    if ( mgr.lookUpFD ( fd, fdrException ) ) {
+        ev.events |= EPOLLPRI;
+    }
+    ev.data.fd = fd;
+
+    int status;
+    if ( ev.events ) {
+        status = epoll_ctl ( this->epfd, EPOLL_CTL_MOD, fd, &ev );
+        if ( status < 0 && errno == ENOENT ) {
+            status = epoll_ctl ( this->epfd, EPOLL_CTL_ADD, fd, &ev );
+        }
+    }
+    else {
+        status = epoll_ctl ( this->epfd, EPOLL_CTL_DEL, fd, &ev );
+        // the fd may already be closed, which also removes it
+        if ( status < 0 && ( errno == EBADF || errno == ENOENT ) ) {
+            status = 0;
+        }
+    }
+    if ( status < 0 ) {
+        fprintf ( stderr, "fdManager: epoll_ctl(fd=%d) failed because "
+            "\"%s\"\n", int ( fd ), strerror ( errno ) );
+    }
+}
+
+void fdEpollPoller::installReg ( fdManager & mgr, fdReg & reg )
+{
+    this->update ( mgr, reg.getFD () );
+}
+
+void fdEpollPoller::removeReg ( fdManager & mgr, fdReg & reg )
+{
+    this->update ( mgr, reg.getFD () );
+}
+
+int fdEpollPoller::poll ( fdManager & mgr, double delay )
+{
+    // round up so that a timer due in less than a millisecond
+    // doesn't turn this into a busy loop
+    int timeout = INT_MAX;
+    if ( delay * mSecPerSec < INT_MAX ) {
+        timeout = static_cast < int > ( delay * mSecPerSec );
+        if ( timeout < delay * mSecPerSec ) {
+            timeout++;
+        }
+    }
+
+    int status = epoll_wait ( this->epfd, this->events, maxEvents, timeout );
+    if ( status < 0 ) {
+        if ( errno != EINTR ) {
+            fprintf ( stderr, "fdManager: epoll_wait failed because "
+                "\"%s\"\n", strerror ( errno ) );
+        }
+        return -1;
+    }
+
+    int nActive = 0;
+    for ( int i = 0; i < status; i++ ) {
+        const SOCKET fd = this->events[i].data.fd;
+        const unsigned ev = this->events[i].events;
+
+        // select() reports errors and hangups as readable and writable.
+        // Writes go first, see fdManager::installReg().
+        if ( ev & ( EPOLLOUT | EPOLLERR | EPOLLHUP ) ) {
+            nActive += activate ( mgr, mgr.lookUpFD ( fd, fdrWrite ), true );
+        }
+        if ( ev & ( EPOLLIN | EPOLLERR | EPOLLHUP ) ) {
+            nActive += activate ( mgr, mgr.lookUpFD ( fd, fdrRead ), false );
+        }
+        if ( ev & EPOLLPRI ) {
+            nActive += activate ( mgr,
+                mgr.lookUpFD ( fd, fdrException ), false );
+        }
+    }
+    return nActive;
+}
+
+#endif // FDMGR_EPOLL
+
+//
+// fdPoller::create ()
+//
+fdPoller * fdPoller::create ( fdPollerType type )
+{
+    if ( type == fdpDefault ) {
+        const char * pName = envGetConfigParamPtr ( & EPICS_FDMGR_POLLER );
+
+        type = fdpEpoll;
+        if ( pName && epicsStrCaseCmp ( pName, "select" ) == 0 ) {
+            type = fdpSelect;
+        }
+        else if ( pName && epicsStrCaseCmp ( pName, "epoll" ) != 0 ) {
+            fprintf ( stderr, "fdManager: unknown EPICS_FDMGR_POLLER "
+                "\"%s\" ignored\n", pName );
+        }
+    }
+#ifdef FDMGR_EPOLL
+    if ( type == fdpEpoll ) {
+        int epfd = epoll_create1 ( EPOLL_CLOEXEC );
+        if ( epfd >= 0 ) {
+            return new fdEpollPoller ( epfd );
+        }
+        fprintf ( stderr, "fdManager: epoll_create1 failed because "
+            "\"%s\", using select\n", strerror ( errno ) );
+    }
+#endif
+    return new fdSelectPoller ();
+}
+
 //
 // fdManager::fdManager()
 //
 // hopefully its a reasonable guess that select() and epicsThreadSleep()
 // will have the same sleep quantum 
 //
-epicsShareFunc fdManager::fdManager () : 
-    sleepQuantum ( epicsThreadSleepQuantum () ), 
-        fdSetsPtr ( new fd_set [fdrNEnums] ),
-        pTimerQueue ( 0 ), maxFD ( 0 ), processInProg ( false ), 
+epicsShareFunc fdManager::fdManager ( fdPollerType pollerType ) : 
+    sleepQuantum ( epicsThreadSleepQuantum () ), pPoller ( 0 ),
+        pTimerQueue ( 0 ), processInProg ( false ), 
         pCBReg ( 0 )
 {
     int status = osiSockAttach ();
     assert (status);
 
-    for ( size_t i = 0u; i < fdrNEnums; i++ ) {
-        FD_ZERO ( &fdSetsPtr[i] ); 
-    }
+    this->pPoller = fdPoller::create ( pollerType );
 }
 
 //
@@ -71,10 +383,18 @@ epicsShareFunc fdManager::~fdManager()
         pReg->destroy();
     }
     delete this->pTimerQueue;
-    delete [] this->fdSetsPtr;
+    delete this->pPoller;
     osiSockRelease();
 }
 
+//
+// fdManager::pollerName()
+//
+epicsShareFunc const char * fdManager::pollerName () const
+{
+    return this->pPoller->name ();
+}
+
 //
 // fdManager::process()
 //
@@ -103,45 +423,12 @@ epicsShareFunc void fdManager::process (double delay)
         minDelay = delay;
     }
 
-    bool ioPending = false;
-    tsDLIter < fdReg > iter = this->regList.firstIter ();
-    while ( iter.valid () ) {
-        FD_SET(iter->getFD(), &this->fdSetsPtr[iter->getType()]); 
-        ioPending = true;
-        ++iter;
-    }
-
-    if ( ioPending ) {
-        struct timeval tv;
-        tv.tv_sec = static_cast<time_t> ( minDelay );
-        tv.tv_usec = static_cast<long> ( (minDelay-tv.tv_sec) * uSecPerSec );
-
-        fd_set * pReadSet = & this->fdSetsPtr[fdrRead];
-        fd_set * pWriteSet = & this->fdSetsPtr[fdrWrite];
-        fd_set * pExceptSet = & this->fdSetsPtr[fdrException];
-        int status = select (this->maxFD, pReadSet, pWriteSet, pExceptSet, &tv);
+    if ( this->regList.count () > 0u ) {
+        int status = this->pPoller->poll ( *this, minDelay );
 
         this->pTimerQueue->process(epicsTime::getMonotonic());
 
         if ( status > 0 ) {
-
-            //
-            // Look for activity
-            //
-            iter=this->regList.firstIter ();
-            while ( iter.valid () && status > 0 ) {
-                tsDLIter < fdReg > tmp = iter;
-                tmp++;
-                if (FD_ISSET(iter->getFD(), &this->fdSetsPtr[iter->getType()])) {
-                    FD_CLR(iter->getFD(), &this->fdSetsPtr[iter->getType()]);
-                    this->regList.remove(*iter);
-                    this->activeList.add(*iter);
-                    iter->state = fdReg::active;
-                    status--;
-                }
-                iter = tmp;
-            }
-
             //
             // I am careful to prevent problems if they access the
             // above list while in a "callBack()" routine
@@ -175,27 +462,6 @@ epicsShareFunc void fdManager::process (double delay)
                 }
             }
         }
-        else if ( status < 0 ) {
-            int errnoCpy = SOCKERRNO;
-            
-            // dont depend on flags being properly set if 
-            // an error is retuned from select
-            for ( size_t i = 0u; i < fdrNEnums; i++ ) {
-                FD_ZERO ( &fdSetsPtr[i] );
-            }
-
-            //
-            // print a message if its an unexpected error
-            //
-            if ( errnoCpy != SOCK_EINTR ) {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString ( 
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-                fprintf ( stderr, 
-                "fdManager: select failed because \"%s\"\n",
-                    sockErrBuf );
-            }
-        }
     }
     else {
         /*
@@ -258,7 +524,6 @@ void fdRegId::show ( unsigned level ) const
 //
 void fdManager::installReg (fdReg &reg)
 {
-    this->maxFD = max ( this->maxFD, reg.getFD()+1 );
     // Most applications will find that its important to push here to 
     // the front of the list so that transient writes get executed
     // first allowing incoming read protocol to find that outgoing
@@ -270,6 +535,7 @@ void fdManager::installReg (fdReg &reg)
     if ( status != 0 ) {
         throwWithLocation ( fdInterestSubscriptionAlreadyExits () );
     }
+    this->pPoller->installReg ( *this, reg );
 }
 
 //
@@ -311,7 +577,7 @@ void fdManager::removeReg (fdReg &regIn)
     }
     regIn.state = fdReg::limbo;
 
-    FD_CLR(regIn.getFD(), &this->fdSetsPtr[regIn.getType()]);
+    this->pPoller->removeReg ( *this, regIn );
 }
 
 //
@@ -348,9 +614,9 @@ fdReg::fdReg (const SOCKET fdIn, const fdRegType typIn,
     fdRegId (fdIn,typIn), state (limbo), 
     onceOnly (onceOnlyIn), manager (managerIn)
 { 
-    if (!FD_IN_FDSET(fdIn)) {
-        fprintf (stderr, "%s: fd > FD_SETSIZE ignored\n", 
-            __FILE__);
+    if (!this->manager.pPoller->fdInRange(fdIn)) {
+        fprintf (stderr, "%s: fd %d out of range for the %s poller, ignored\n",
+            __FILE__, (int) fdIn, this->manager.pollerName ());
         return;
     }
     this->manager.installReg (*this);
@@ -28,6 +28,14 @@
 
 enum fdRegType {fdrRead, fdrWrite, fdrException, fdrNEnums};
 
+//
+// fdPollerType
+//
+// how a fdManager waits for file descriptor activity, fdpDefault
+// is taken from EPICS_FDMGR_POLLER, otherwise the best available
+//
+enum fdPollerType {fdpDefault, fdpSelect, fdpEpoll};
+
 //
 // fdRegId
 //
@@ -77,10 +85,13 @@ public:
     //
     class fdInterestSubscriptionAlreadyExits {};
 
-    epicsShareFunc fdManager ();
+    epicsShareFunc fdManager ( fdPollerType pollerType = fdpDefault );
     epicsShareFunc virtual ~fdManager ();
     epicsShareFunc void process ( double delay ); // delay parameter is in seconds
 
+    // name of the poller in use ("select" or "epoll")
+    epicsShareFunc const char * pollerName () const;
+
     // returns NULL if the fd is unknown
     epicsShareFunc class fdReg *lookUpFD (const SOCKET fd, const fdRegType type);
 
@@ -91,9 +102,8 @@ private:
     tsDLList < fdReg > activeList;
     resTable < fdReg, fdRegId > fdTbl;
     const double sleepQuantum;
-    fd_set * fdSetsPtr;
+    class fdPoller * pPoller;
     epicsTimerQueuePassive * pTimerQueue;
-    SOCKET maxFD;
     bool processInProg;
     //
     // Set to fdreg when in call back
@@ -108,6 +118,7 @@ private:
     fdManager ( const fdManager & );
     fdManager & operator = ( const fdManager & );
     friend class fdReg;
+    friend class fdPoller;
 };
 
 //
@@ -123,6 +134,7 @@ epicsShareExtern fdManager fileDescriptorManager;
 class epicsShareClass fdReg :
     public fdRegId, public tsDLNode<fdReg>, public tsSLNode<fdReg> {
     friend class fdManager;
+    friend class fdPoller;
 
 public:
 
@@ -0,0 +1,223 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Bounded lock-free multi-producer/multi-consumer ring of pointers.
+ *
+ * Each slot carries a sequence number which tells producers and
+ * consumers whether it is free for the current lap of the ring.
+ * A thread claims a position by compare-and-swap of the shared
+ * enqueue or dequeue counter, then fills or empties the slot and
+ * publishes the result by advancing the slot sequence number.
+ * (D. Vyukov's bounded MPMC queue.)
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define epicsExportSharedSymbols
+#include "epicsAtomic.h"
+#include "epicsRingMPMC.h"
+
+/* Keep the producer and consumer counters in separate cache lines */
+#define CACHE_LINE 64
+
+/* The sequence number is read with a plain load followed by a read
+ * barrier (acquire), and written after a write barrier (release).
+ * The counters are only modified by compare-and-swap.
+ */
+typedef struct ringSlot {
+    volatile size_t seq;
+    void * volatile value;
+} ringSlot;
+
+struct epicsRingMPMC {
+    volatile size_t enqueuePos;
+    char pad1[CACHE_LINE - sizeof(size_t)];
+    volatile size_t dequeuePos;
+    char pad2[CACHE_LINE - sizeof(size_t)];
+    size_t mask;
+    volatile int highWaterMark;
+    ringSlot *slots;
+};
+
+epicsRingMPMCId epicsRingMPMCCreate(int size)
+{
+    epicsRingMPMCId ring;
+    size_t nslots = 2;
+    size_t i;
+
+    if (size < 1)
+        return NULL;
+    while (nslots < (size_t)size)
+        nslots <<= 1;
+
+    ring = calloc(1, sizeof(*ring));
+    if (!ring)
+        return NULL;
+    ring->slots = calloc(nslots, sizeof(ringSlot));
+    if (!ring->slots) {
+        free(ring);
+        return NULL;
+    }
+    for (i = 0; i < nslots; i++)
+        ring->slots[i].seq = i;
+    ring->mask = nslots - 1;
+    return ring;
+}
+
+void epicsRingMPMCDelete(epicsRingMPMCId ring)
+{
+    if (!ring)
+        return;
+    free(ring->slots);
+    free(ring);
+}
+
+static int usedCount(epicsRingMPMCId ring)
+{
+    /* read the consumer counter first so that head - tail can't go
+     * negative, but may briefly exceed the capacity.
+     */
+    size_t tail = ring->dequeuePos;
+    size_t head;
+    size_t used;
+
+    epicsAtomicReadMemoryBarrier();
+    head = ring->enqueuePos;
+    used = head - tail;
+
+    if (used > ring->mask + 1)
+        used = ring->mask + 1;
+    return (int)used;
+}
+
+int epicsRingMPMCPush(epicsRingMPMCId ring, void *p)
+{
+    size_t pos = ring->enqueuePos;
+    ringSlot *slot;
+    size_t used;
+
+    for (;;) {
+        size_t seq;
+        ptrdiff_t dif;
+
+        slot = &ring->slots[pos & ring->mask];
+        seq = slot->seq;
+        epicsAtomicReadMemoryBarrier();
+        dif = (ptrdiff_t)(seq - pos);
+
+        if (dif == 0) {
+            size_t prev = epicsAtomicCmpAndSwapSizeT(
+                (size_t *)&ring->enqueuePos, pos, pos + 1);
+
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (dif < 0) {
+            return 0; /* full */
+        }
+        else {
+            pos = ring->enqueuePos;
+        }
+    }
+
+    slot->value = p;
+    epicsAtomicWriteMemoryBarrier();
+    slot->seq = pos + 1;
+
+    /* The high-water mark is rarely exceeded, so only read it
+     * in the common case.
+     */
+    used = pos + 1 - ring->dequeuePos;
+    if (used <= ring->mask + 1) {
+        int hwm;
+
+        while ((int)used > (hwm = ring->highWaterMark)) {
+            if (epicsAtomicCmpAndSwapIntT((int *)&ring->highWaterMark,
+                    hwm, (int)used) == hwm)
+                break;
+        }
+    }
+    return 1;
+}
+
+void* epicsRingMPMCPop(epicsRingMPMCId ring)
+{
+    size_t pos = ring->dequeuePos;
+    ringSlot *slot;
+    void *p;
+
+    for (;;) {
+        size_t seq;
+        ptrdiff_t dif;
+
+        slot = &ring->slots[pos & ring->mask];
+        seq = slot->seq;
+        epicsAtomicReadMemoryBarrier();
+        dif = (ptrdiff_t)(seq - (pos + 1));
+
+        if (dif == 0) {
+            size_t prev = epicsAtomicCmpAndSwapSizeT(
+                (size_t *)&ring->dequeuePos, pos, pos + 1);
+
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (dif < 0) {
+            return NULL; /* empty */
+        }
+        else {
+            pos = ring->dequeuePos;
+        }
+    }
+
+    p = slot->value;
+    /* The load of value must complete before a producer can see the
+     * slot free and overwrite it, a write barrier alone only orders
+     * stores.
+     */
+    epicsAtomicReadMemoryBarrier();
+    epicsAtomicWriteMemoryBarrier();
+    slot->seq = pos + ring->mask + 1;
+    return p;
+}
+
+int epicsRingMPMCGetFree(epicsRingMPMCId ring)
+{
+    return (int)(ring->mask + 1) - usedCount(ring);
+}
+
+int epicsRingMPMCGetUsed(epicsRingMPMCId ring)
+{
+    return usedCount(ring);
+}
+
+int epicsRingMPMCGetSize(epicsRingMPMCId ring)
+{
+    return (int)(ring->mask + 1);
+}
+
+int epicsRingMPMCIsEmpty(epicsRingMPMCId ring)
+{
+    return usedCount(ring) == 0;
+}
+
+int epicsRingMPMCIsFull(epicsRingMPMCId ring)
+{
+    return usedCount(ring) == (int)(ring->mask + 1);
+}
+
+int epicsRingMPMCGetHighWaterMark(epicsRingMPMCId ring)
+{
+    return ring->highWaterMark;
+}
+
+void epicsRingMPMCResetHighWaterMark(epicsRingMPMCId ring)
+{
+    epicsAtomicSetIntT((int *)&ring->highWaterMark, usedCount(ring));
+}
@@ -0,0 +1,51 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Bounded lock-free multi-producer/multi-consumer ring of pointers.
+ */
+
+#ifndef INCepicsRingMPMCh
+#define INCepicsRingMPMCh
+
+/* NOTES
+ *   Any number of threads may push and pop concurrently without locking.
+ *   Push may also be called from interrupt context on targets where the
+ *   epicsAtomic compare-and-swap operations are lock-free.
+ *
+ *   The requested size is rounded up to the next power of two; use
+ *   epicsRingMPMCGetSize() to find the actual capacity.
+ *
+ *   The used count and high-water mark are approximate while other
+ *   threads are pushing or popping.
+ */
+
+#include "shareLib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct epicsRingMPMC *epicsRingMPMCId;
+
+epicsShareFunc epicsRingMPMCId epicsRingMPMCCreate(int size);
+epicsShareFunc void epicsRingMPMCDelete(epicsRingMPMCId id);
+/*epicsRingMPMCPush returns (0,1) if p (was not, was) put on ring*/
+epicsShareFunc int   epicsRingMPMCPush(epicsRingMPMCId id, void *p);
+/*epicsRingMPMCPop returns 0 if ring is empty*/
+epicsShareFunc void* epicsRingMPMCPop(epicsRingMPMCId id);
+epicsShareFunc int  epicsRingMPMCGetFree(epicsRingMPMCId id);
+epicsShareFunc int  epicsRingMPMCGetUsed(epicsRingMPMCId id);
+epicsShareFunc int  epicsRingMPMCGetSize(epicsRingMPMCId id);
+epicsShareFunc int  epicsRingMPMCIsEmpty(epicsRingMPMCId id);
+epicsShareFunc int  epicsRingMPMCIsFull(epicsRingMPMCId id);
+epicsShareFunc int  epicsRingMPMCGetHighWaterMark(epicsRingMPMCId id);
+epicsShareFunc void epicsRingMPMCResetHighWaterMark(epicsRingMPMCId id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCepicsRingMPMCh */
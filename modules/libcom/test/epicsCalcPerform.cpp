@@ -0,0 +1,103 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* epicsCalcPerform.cpp */
+
+/* Compare the time calcPerform() and calcRun() take to evaluate some
+ * expressions typical of calc and calcout records.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "epicsTime.h"
+#include "postfix.h"
+#include "testMain.h"
+
+static const unsigned nEval = 1000000u;
+
+static const char * const exprs[] = {
+    "A+B",
+    "A*B+C",
+    "(A+B)/2",
+    "A>B?A:B",
+    "ABS(A-B)<C?1:0",
+    "A*SIN(B*D2R)+C*COS(B*D2R)",
+    "(A-B)*0.5+(C-D)*0.25+E*1e-3",
+    "A<0?0:A>10?10:A",
+    "MAX(A,B,C,D)-MIN(A,B,C,D)",
+    "A&&B||C&&!D",
+    "(A>>4)&0xff|(B<<8)",
+    "C:=A+B;D:=A-B;C*D",
+    "VAL+(A-VAL)*0.1",
+    "A+1+2*PI*R2D/360-1",
+    "0?A:B+C*D/E-F",
+    "(A+B+C+D+E+F+G+H+I+J+K+L)/12",
+};
+
+/* Time per evaluation in ns, including setting up the arguments */
+static double timeIt(const char *rpn, const calcProgram *prog, double &result)
+{
+    double args[CALCPERFORM_NARGS];
+    double val = 0.0;
+    epicsTime begin = epicsTime::getCurrent ();
+
+    for (unsigned i = 0u; i < nEval; i++) {
+        for (int j = 0; j < CALCPERFORM_NARGS; j++) {
+            args[j] = j + (i & 7);
+        }
+        if (prog) {
+            calcRun(prog, args, &val);
+        } else {
+            calcPerform(args, &val, rpn);
+        }
+    }
+    result = val;
+    return (epicsTime::getCurrent () - begin) / nEval * 1e9;
+}
+
+MAIN(epicsCalcPerform)
+{
+    char rpn[MAX_POSTFIX_SIZE];
+    double totPerform = 0.0, totRun = 0.0;
+    int failed = 0;
+
+    printf("%u evaluations of each expression\n", nEval);
+    printf("%-32s %10s %10s %8s\n", "expression", "calcPerform", "calcRun",
+        "speedup");
+
+    for (unsigned i = 0u; i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        double perfResult, runResult;
+        calcProgram *prog;
+        short err;
+
+        if (postfix(exprs[i], rpn, &err)) {
+            printf("%s: %s\n", exprs[i], calcErrorStr(err));
+            failed = 1;
+            continue;
+        }
+        prog = calcCompile(rpn);
+        if (!prog) {
+            printf("%s: calcCompile() failed\n", exprs[i]);
+            failed = 1;
+            continue;
+        }
+
+        double tPerform = timeIt(rpn, 0, perfResult);
+        double tRun = timeIt(rpn, prog, runResult);
+
+        bool same = !memcmp(&perfResult, &runResult, sizeof(double));
+
+        printf("%-32s %8.1f ns %8.1f ns %7.2fx%s\n", exprs[i],
+            tPerform, tRun, tPerform / tRun, same ? "" : "  RESULTS DIFFER");
+        if (!same)
+            failed = 1;
+        totPerform += tPerform;
+        totRun += tRun;
+        calcProgramFree(prog);
+    }
+    printf("%-32s %8.1f ns %8.1f ns %7.2fx\n", "total",
+        totPerform, totRun, totPerform / totRun);
+    return failed;
+}
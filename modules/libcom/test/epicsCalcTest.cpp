@@ -6,9 +6,11 @@
 \*************************************************************************/
 //	Author: Andrew Johnson
 
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "dbDefs.h"
 #include "epicsUnitTest.h"
 #include "epicsTypes.h"
 #include "epicsMath.h"
@@ -18,6 +20,99 @@
 
 /* Infrastructure for running tests */
 
+static const double testArgVals[CALCPERFORM_NARGS] = {
+    1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
+};
+
+/* C doesn't say which NaN an operation on NaNs returns, and compilers
+ * may swap the operands of commutative operations, so any two NaNs match.
+ */
+static bool sameBits(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0 || (isnan(a) && isnan(b));
+}
+
+/* Check that calcRun() on the compiled expression gives exactly the same
+ * result and stored arguments as calcPerform() did.
+ */
+bool compiledSame(const char *expr, const char *rpn, const double *inArgs,
+    double inResult, const double *perfArgs, long perfStatus,
+    double perfResult) {
+    double args[CALCPERFORM_NARGS];
+    calcProgram *prog = calcCompile(rpn);
+    double result;
+    long status;
+    bool same = true;
+
+    if (!prog) {
+        testDiag("calcCompile: can't compile '%s'", expr);
+        return false;
+    }
+    memcpy(args, inArgs, sizeof(args));
+    result = inResult;
+    status = calcRun(prog, args, &result);
+    if (status != perfStatus || (!status && !sameBits(result, perfResult))) {
+        testDiag("calcRun: '%s' returned %ld, %.17g; calcPerform %ld, %.17g",
+                 expr, status, result, perfStatus, perfResult);
+        same = false;
+    }
+    for (int i = 0; i < CALCPERFORM_NARGS; i++) {
+        if (!sameBits(args[i], perfArgs[i])) {
+            testDiag("calcRun: '%s' stored %.17g in arg %c, calcPerform %.17g",
+                     expr, args[i], 'A' + i, perfArgs[i]);
+            same = false;
+        }
+    }
+    if (!same)
+        calcProgramDump(prog);
+    calcProgramFree(prog);
+    return same;
+}
+
+/* Check that calcArrayPerform() on scalar arguments gives exactly the same
+ * result and stored arguments as calcPerform() did.
+ */
+bool arraySame(const char *expr, const char *rpn, const double *inArgs,
+    double inResult, const double *perfArgs, long perfStatus,
+    double perfResult) {
+    double args[CALCPERFORM_NARGS];
+    calcArrayArg arg[CALCPERFORM_NARGS];
+    calcArrayArg val;
+    calcArrayStack *pstack = calcArrayStackCreate(rpn, 1);
+    double result = inResult;
+    long status;
+    bool same = true;
+
+    if (!pstack) {
+        testDiag("calcArrayStackCreate: failed for '%s'", expr);
+        return false;
+    }
+    for (int i = 0; i < CALCPERFORM_NARGS; i++) {
+        args[i] = inArgs[i];
+        arg[i].pval = &args[i];
+        arg[i].nelm = arg[i].size = 1;
+    }
+    val.pval = &result;
+    val.nelm = val.size = 1;
+    status = calcArrayPerform(arg, &val, rpn, pstack);
+    if (!status != !perfStatus ||
+        (!status && (val.nelm != 1 || !sameBits(result, perfResult)))) {
+        testDiag("calcArrayPerform: '%s' returned %ld, %.17g; "
+                 "calcPerform %ld, %.17g",
+                 expr, status, result, perfStatus, perfResult);
+        same = false;
+    }
+    for (int i = 0; i < CALCPERFORM_NARGS; i++) {
+        if (!sameBits(args[i], perfArgs[i])) {
+            testDiag("calcArrayPerform: '%s' stored %.17g in arg %c, "
+                     "calcPerform %.17g",
+                     expr, args[i], 'A' + i, perfArgs[i]);
+            same = false;
+        }
+    }
+    calcArrayStackFree(pstack);
+    return same;
+}
+
 double doCalc(const char *expr) {
     /* Evaluate expression, return result */
     double args[CALCPERFORM_NARGS] = {
@@ -46,6 +141,7 @@ double doCalc(const char *expr) {
 void testCalc(const char *expr, double expected) {
     /* Evaluate expression, test against expected result */
     bool pass = false;
+    bool same = false;
     double args[CALCPERFORM_NARGS] = {
         1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
     };
@@ -61,10 +157,18 @@ void testCalc(const char *expr, double expected) {
 
     if (postfix(expr, rpn, &err)) {
         testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
-    } else
-        if (calcPerform(args, &result, rpn) && finite(result)) {
+    } else {
+        double inResult = result;
+        long status = calcPerform(args, &result, rpn);
+
+        if (status && finite(result)) {
             testDiag("calcPerform: error evaluating '%s'", expr);
         }
+        same = compiledSame(expr, rpn, testArgVals, inResult, args, status,
+                            result) &&
+               arraySame(expr, rpn, testArgVals, inResult, args, status,
+                         result);
+    }
 
     if (finite(expected) && finite(result)) {
         pass = fabs(expected - result) < 1e-8;
@@ -73,6 +177,7 @@ void testCalc(const char *expr, double expected) {
     } else {
         pass = (result == expected);
     }
+    pass = pass && same;
     if (!testOk(pass, "%s", expr)) {
         testDiag("Expected result is %g, actually got %g", expected, result);
         calcExprDump(rpn);
@@ -83,6 +188,7 @@ void testCalc(const char *expr, double expected) {
 void testUInt32Calc(const char *expr, epicsUInt32 expected) {
     /* Evaluate expression, test against expected result */
     bool pass = false;
+    bool same = false;
     double args[CALCPERFORM_NARGS] = {
         1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
     };
@@ -99,13 +205,21 @@ void testUInt32Calc(const char *expr, epicsUInt32 expected) {
 
     if (postfix(expr, rpn, &err)) {
         testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
-    } else
-        if (calcPerform(args, &result, rpn) && finite(result)) {
+    } else {
+        double inResult = result;
+        long status = calcPerform(args, &result, rpn);
+
+        if (status && finite(result)) {
             testDiag("calcPerform: error evaluating '%s'", expr);
         }
+        same = compiledSame(expr, rpn, testArgVals, inResult, args, status,
+                            result) &&
+               arraySame(expr, rpn, testArgVals, inResult, args, status,
+                         result);
+    }
 
     uresult = (epicsUInt32) result;
-    pass = (uresult == expected);
+    pass = (uresult == expected) && same;
     if (!testOk(pass, "%s", expr)) {
         testDiag("Expected result is 0x%x (%u), actually got 0x%x (%u)",
                  expected, expected, uresult, uresult);
@@ -114,6 +228,114 @@ void testUInt32Calc(const char *expr, epicsUInt32 expected) {
     free(rpn);
 }
 
+void testRun(const char *expr) {
+    /* Compare calcRun() with calcPerform() over a range of inputs */
+    static const double vals[] = {
+        0.0, -0.0, 1.0, -1.0, 0.5, -2.5, 3.0, 1e300, -1e-300, 2147483648.0,
+        -2863311530.0, epicsINF, -epicsINF, epicsNAN
+    };
+    const int nvals = sizeof(vals) / sizeof(vals[0]);
+    char *rpn = (char*)malloc(INFIX_TO_POSTFIX_SIZE(strlen(expr)+1));
+    short err;
+    bool pass = true;
+
+    if(!rpn) {
+        testFail("postfix: %s no memory", expr);
+        return;
+    }
+
+    if (postfix(expr, rpn, &err)) {
+        testFail("postfix: %s in expression '%s'", calcErrorStr(err), expr);
+        free(rpn);
+        return;
+    }
+    for (int n = 0; n < nvals * nvals && pass; n++) {
+        double inArgs[CALCPERFORM_NARGS], args[CALCPERFORM_NARGS];
+        double val = vals[(n + 5) % nvals], result = val;
+        long status;
+
+        /* Every pair of values for A and B, others vary with them */
+        for (int i = 0; i < CALCPERFORM_NARGS; i++)
+            inArgs[i] = vals[(i & 1 ? n / nvals : n % nvals) * (i + 1) % nvals];
+        memcpy(args, inArgs, sizeof(args));
+        status = calcPerform(args, &result, rpn);
+        pass = compiledSame(expr, rpn, inArgs, val, args, status, result) &&
+               arraySame(expr, rpn, inArgs, val, args, status, result);
+    }
+    testOk(pass, "calcRun matches calcPerform for '%s'", expr);
+    free(rpn);
+}
+
+void testArrayCalc(const char *expr, int nexpected, ...) {
+    /* Evaluate expression on arrays, test against the expected elements.
+     * A and B have 5 elements, D has 4, F is empty, the others are scalars.
+     */
+    static const double inA[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    static const double inB[] = {10.0, 20.0, 30.0, 40.0, 50.0};
+    static const double inD[] = {-1.0, 0.0, epicsNAN, 1.0};
+    const epicsUInt32 size = 8;
+    double store[CALCPERFORM_NARGS][8], result[8];
+    calcArrayArg arg[CALCPERFORM_NARGS];
+    calcArrayArg val;
+    calcArrayStack *pstack = NULL;
+    char *rpn = (char*)malloc(INFIX_TO_POSTFIX_SIZE(strlen(expr)+1));
+    short err;
+    bool pass = false;
+    va_list ap;
+
+    if(!rpn) {
+        testFail("postfix: %s no memory", expr);
+        return;
+    }
+
+    for (int i = 0; i < CALCPERFORM_NARGS; i++) {
+        arg[i].pval = store[i];
+        arg[i].size = size;
+        arg[i].nelm = 1;
+        store[i][0] = testArgVals[i];
+    }
+    memcpy(store[0], inA, sizeof(inA));
+    arg[0].nelm = NELEMENTS(inA);
+    memcpy(store[1], inB, sizeof(inB));
+    arg[1].nelm = NELEMENTS(inB);
+    memcpy(store[3], inD, sizeof(inD));
+    arg[3].nelm = NELEMENTS(inD);
+    arg[5].nelm = 0;
+    result[0] = 100.0;
+    val.pval = result;
+    val.size = size;
+    val.nelm = 1;
+
+    if (postfix(expr, rpn, &err)) {
+        testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
+    } else if (!(pstack = calcArrayStackCreate(rpn, size))) {
+        testDiag("calcArrayStackCreate: failed for '%s'", expr);
+    } else if (calcArrayPerform(arg, &val, rpn, pstack)) {
+        testDiag("calcArrayPerform: error evaluating '%s'", expr);
+    } else {
+        pass = (int) val.nelm == nexpected;
+        if (!pass)
+            testDiag("Expected %d elements, actually got %u",
+                     nexpected, val.nelm);
+    }
+
+    va_start(ap, nexpected);
+    for (int i = 0; pass && i < nexpected; i++) {
+        double expected = va_arg(ap, double);
+
+        if (isnan(expected) ? !isnan(result[i]) : result[i] != expected) {
+            testDiag("Expected element %d to be %g, actually got %g",
+                     i, expected, result[i]);
+            pass = false;
+        }
+    }
+    va_end(ap);
+
+    testOk(pass, "Array %s", expr);
+    calcArrayStackFree(pstack);
+    free(rpn);
+}
+
 void testArgs(const char *expr, unsigned long einp, unsigned long eout) {
     char *rpn = (char*)malloc(INFIX_TO_POSTFIX_SIZE(strlen(expr)+1));
     short err = 0;
@@ -297,7 +519,7 @@ MAIN(epicsCalcTest)
     const double a=1.0, b=2.0, c=3.0, d=4.0, e=5.0, f=6.0,
 		 g=7.0, h=8.0, i=9.0, j=10.0, k=11.0, l=12.0;
     
-    testPlan(613);
+    testPlan(705);
 
     /* LITERAL_OPERAND elements */
     testExpr(0);
@@ -921,6 +1143,103 @@ MAIN(epicsCalcTest)
     testArgs("12.1;A:=0;B:=A;C:=B;D:=C", 0, A_A|A_B|A_C|A_D);
     testArgs("13.1;B:=A;A:=B;C:=D;D:=C", A_A|A_D, A_A|A_B|A_C|A_D);
     
+    // calcRun() must give the same results as calcPerform()
+    testRun("A+B");
+    testRun("A-B*C");
+    testRun("A/B+VAL");
+    testRun("A%B");
+    testRun("A**B");
+    testRun("ATAN2(A,B)");
+    testRun("A AND B");
+    testRun("A OR B");
+    testRun("A XOR B");
+    testRun("A>>B");
+    testRun("A<<B");
+    testRun("A&&B||!C");
+    testRun("A<B");
+    testRun("A<=B");
+    testRun("A=B");
+    testRun("A#B");
+    testRun("A>=B");
+    testRun("A>B");
+    testRun("-A+ABS(B)");
+    testRun("NINT(A)+CEIL(B)+FLOOR(C)");
+    testRun("SQR(A)+EXP(B)+LN(C)+LOG(D)");
+    testRun("SIN(A)+COS(B)+TAN(C)+ASIN(D)+ACOS(E)+ATAN(F)");
+    testRun("SINH(A)+COSH(B)+TANH(C)");
+    testRun("MAX(A,B,C)");
+    testRun("MIN(A,B,C,D)");
+    testRun("MAX(A,1,NaN)");
+    testRun("FINITE(A,B)");
+    testRun("ISNAN(A,B)");
+    testRun("ISINF(A)");
+    testRun("~A");
+    testRun("A?B:C");
+    testRun("A?B?C:D:E");
+    testRun("A?B:C?D:E");
+    testRun("(A?B:C)+D");
+    testRun("A+(B?C:D)");
+    testRun("A?1:VAL");
+    testRun("1?A:B");
+    testRun("0?A:B+C");
+    testRun("1+2?A:B");
+    testRun("A?(1?B:C):(0?D:E)");
+    testRun("B:=A;A:=1;B+A");
+    testRun("C:=A?B:3;C*2");
+    testRun("E:=1+2*PI;E+A");
+    testRun("A+1+2*3-D2R*R2D");
+    testRun("(A<B?A:B)-MIN(A,B)");
+    testRun("C:=A?B:C;D?E:C");
+    testRun("MAX(A+1,B?C:D,1+2)");
+    testRun("SUM(A,B,C)");
+    testRun("AVG(A,B)");
+
+    testCalc("SUM(-2)", -2);
+    testCalc("SUM(1,2,3)", 6);
+    testCalc("SUM(1,Inf)", Inf);
+    testCalc("SUM(1,NaN,2)", NaN);
+    testCalc("AVG(5)", 5);
+    testCalc("AVG(1,2,3,4)", 2.5);
+    testCalc("AVG(a,b,c)", 2);
+    testCalc("AVG(1,-Inf)", -Inf);
+
+    // Array evaluation
+    testArrayCalc("A*C", 5, 3.0, 6.0, 9.0, 12.0, 15.0);
+    testArrayCalc("C-A", 5, 2.0, 1.0, 0.0, -1.0, -2.0);
+    testArrayCalc("A+B", 5, 11.0, 22.0, 33.0, 44.0, 55.0);
+    testArrayCalc("A+D", 4, 0.0, 2.0, NaN, 5.0);
+    testArrayCalc("-A", 5, -1.0, -2.0, -3.0, -4.0, -5.0);
+    testArrayCalc("A%2", 5, 1.0, 0.0, 1.0, 0.0, 1.0);
+    testArrayCalc("A>2&&A<5", 5, 0.0, 0.0, 1.0, 1.0, 0.0);
+    testArrayCalc("1", 1, 1.0);
+    testArrayCalc("SUM(A)", 1, 15.0);
+    testArrayCalc("SUM(A*B)", 1, 550.0);
+    testArrayCalc("AVG(B)", 1, 30.0);
+    testArrayCalc("MAX(A)", 1, 5.0);
+    testArrayCalc("MIN(B)", 1, 10.0);
+    testArrayCalc("MAX(D)", 1, NaN);
+    testArrayCalc("SUM(D)", 1, NaN);
+    testArrayCalc("SUM(F)", 1, 0.0);
+    testArrayCalc("FINITE(A)", 1, 1.0);
+    testArrayCalc("FINITE(D)", 1, 0.0);
+    testArrayCalc("ISNAN(D)", 1, 1.0);
+    testArrayCalc("MAX(A,3)", 5, 3.0, 3.0, 3.0, 4.0, 5.0);
+    testArrayCalc("MIN(A,B,C)", 5, 1.0, 2.0, 3.0, 3.0, 3.0);
+    testArrayCalc("SUM(A,B,1)", 5, 12.0, 23.0, 34.0, 45.0, 56.0);
+    testArrayCalc("AVG(A,B)", 5, 5.5, 11.0, 16.5, 22.0, 27.5);
+    testArrayCalc("ISNAN(A,D)", 4, 0.0, 0.0, 1.0, 0.0);
+    testArrayCalc("AVG(A)+MAX(B)", 1, 53.0);
+    testArrayCalc("A-AVG(A)", 5, -2.0, -1.0, 0.0, 1.0, 2.0);
+    testArrayCalc("A>2?A:0", 5, 0.0, 0.0, 3.0, 4.0, 5.0);
+    testArrayCalc("C>1?A:B", 5, 1.0, 2.0, 3.0, 4.0, 5.0);
+    testArrayCalc("C<1?A:B", 5, 10.0, 20.0, 30.0, 40.0, 50.0);
+    testArrayCalc("A>3?B:C<1?A:D", 4, -1.0, 0.0, NaN, 40.0);
+    testArrayCalc("A>3?A<5?B:0:C", 5, 3.0, 3.0, 3.0, 40.0, 0.0);
+    testArrayCalc("VAL+A", 5, 101.0, 102.0, 103.0, 104.0, 105.0);
+    testArrayCalc("F+1", 0);
+    testArrayCalc("E:=A*2;SUM(E)", 1, 30.0);
+    testArrayCalc("A:=B;B:=C;A+B", 5, 13.0, 23.0, 33.0, 43.0, 53.0);
+
     // Malformed expressions
     testBadExpr("0x0.1", CALC_ERR_SYNTAX);
     testBadExpr("1*", CALC_ERR_INCOMPLETE);
@@ -53,8 +53,10 @@ int ipAddrToAsciiTest(void);
 int macDefExpandTest(void);
 int macLibTest(void);
 int osiSockTest(void);
+int fdManagerTest(void);
 int ringBytesTest(void);
 int ringPointerTest(void);
+int ringMPMCTest(void);
 int taskwdTest(void);
 
 void epicsRunLibComTests(void)
@@ -108,8 +110,10 @@ void epicsRunLibComTests(void)
     runTest(macDefExpandTest);
     runTest(macLibTest);
     runTest(osiSockTest);
+    runTest(fdManagerTest);
     runTest(ringBytesTest);
     runTest(ringPointerTest);
+    runTest(ringMPMCTest);
     runTest(taskwdTest);
 
     /*
@@ -0,0 +1,128 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* fdManagerPerform.cpp */
+
+/* Measure the cost of dispatching one ready socket in fdManager::process()
+ * when many more sockets are registered but idle, for each poller.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "osiSock.h"
+#include "epicsTime.h"
+#include "fdManager.h"
+#include "testMain.h"
+
+static const unsigned nDispatch = 20000u;
+static const unsigned maxIdle = 10000u;
+
+class benchReg : public fdReg {
+public:
+    benchReg ( SOCKET fd, fdManager & mgr ) :
+        fdReg ( fd, fdrRead, false, mgr ), count ( 0u ) {}
+    unsigned count;
+private:
+    void callBack ()
+    {
+        char buf[16];
+        recv ( this->getFD (), buf, sizeof ( buf ), 0 );
+        this->count++;
+    }
+};
+
+static SOCKET udpSocket ( osiSockAddr & addr )
+{
+    SOCKET sock = epicsSocketCreate ( AF_INET, SOCK_DGRAM, 0 );
+    if ( sock == INVALID_SOCKET ) {
+        return sock;
+    }
+    memset ( &addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+    osiSocklen_t len = sizeof ( addr.ia );
+    if ( bind ( sock, &addr.sa, sizeof ( addr.ia ) ) ||
+            getsockname ( sock, &addr.sa, &len ) ) {
+        epicsSocketDestroy ( sock );
+        return INVALID_SOCKET;
+    }
+    return sock;
+}
+
+static void benchPoller ( fdPollerType type, SOCKET active,
+    const osiSockAddr & addr, SOCKET sender, const SOCKET * idle,
+    unsigned nIdle )
+{
+    fdManager mgr ( type );
+
+    // the idle ones first, so that select() has to scan them all
+    unsigned nReg = 0u;
+    for ( unsigned i = 0u; i < nIdle; i++ ) {
+        if ( type == fdpSelect && ! FD_IN_FDSET ( idle[i] ) ) {
+            break;
+        }
+        new benchReg ( idle[i], mgr );
+        nReg++;
+    }
+    benchReg * pActive = new benchReg ( active, mgr );
+
+    epicsTime begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < nDispatch; i++ ) {
+        sendto ( sender, "x", 1, 0, &addr.sa, sizeof ( addr.ia ) );
+        unsigned count = pActive->count;
+        while ( pActive->count == count ) {
+            mgr.process ( 1.0 );
+        }
+    }
+    double elapsed = epicsTime::getCurrent () - begin;
+
+    printf ( "%-6s %5u idle: %8.2f us per dispatch%s\n",
+        mgr.pollerName (), nReg, elapsed / nDispatch * 1e6,
+        nReg < nIdle ? " (FD_SETSIZE limit)" : "" );
+
+    // the fdManager destroys the registrations
+}
+
+MAIN(fdManagerPerform)
+{
+    static SOCKET idle[maxIdle];
+    unsigned nSockets = 0u;
+    osiSockAddr addr, peer;
+
+    osiSockAttach ();
+
+    SOCKET active = udpSocket ( addr );
+    SOCKET sender = udpSocket ( peer );
+    if ( active == INVALID_SOCKET || sender == INVALID_SOCKET ) {
+        printf ( "Can't create sockets\n" );
+        return 1;
+    }
+
+    while ( nSockets < maxIdle ) {
+        osiSockAddr idleAddr;
+        SOCKET sock = udpSocket ( idleAddr );
+        if ( sock == INVALID_SOCKET ) {
+            break;
+        }
+        idle[nSockets++] = sock;
+    }
+    printf ( "%u idle sockets created, %u dispatches each\n",
+        nSockets, nDispatch );
+
+    for ( unsigned nIdle = 10u; nIdle <= nSockets; nIdle *= 10u ) {
+        benchPoller ( fdpSelect, active, addr, sender, idle, nIdle );
+#if defined(__linux__)
+        benchPoller ( fdpEpoll, active, addr, sender, idle, nIdle );
+#endif
+    }
+
+    for ( unsigned i = 0u; i < nSockets; i++ ) {
+        epicsSocketDestroy ( idle[i] );
+    }
+    epicsSocketDestroy ( active );
+    epicsSocketDestroy ( sender );
+    osiSockRelease ();
+    return 0;
+}
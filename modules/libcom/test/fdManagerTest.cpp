@@ -0,0 +1,128 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* Tests for fdManager with each of its pollers */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "osiSock.h"
+#include "fdManager.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+namespace {
+
+SOCKET udpSocket ( osiSockAddr & addr )
+{
+    SOCKET sock = epicsSocketCreate ( AF_INET, SOCK_DGRAM, 0 );
+    if ( sock == INVALID_SOCKET )
+        testAbort ( "epicsSocketCreate failed" );
+
+    memset ( &addr, 0, sizeof ( addr ) );
+    addr.ia.sin_family = AF_INET;
+    addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+    addr.ia.sin_port = 0;
+    osiSocklen_t len = sizeof ( addr.ia );
+    if ( bind ( sock, &addr.sa, sizeof ( addr.ia ) ) ||
+            getsockname ( sock, &addr.sa, &len ) )
+        testAbort ( "Can't bind UDP socket" );
+    return sock;
+}
+
+class testReg : public fdReg {
+public:
+    testReg ( SOCKET fd, fdRegType type, bool onceOnly, fdManager & mgr,
+        bool deleteSelf = false ) :
+        fdReg ( fd, type, onceOnly, mgr ), count ( 0 ),
+        deleteSelf ( deleteSelf ), pDestroyed ( 0 ) {}
+    ~testReg () { if ( pDestroyed ) *pDestroyed = true; }
+    unsigned count;
+    bool deleteSelf;
+    bool * pDestroyed;
+private:
+    void callBack ()
+    {
+        this->count++;
+        if ( this->getType () == fdrRead ) {
+            char buf[16];
+            recv ( this->getFD (), buf, sizeof ( buf ), 0 );
+        }
+        if ( this->deleteSelf )
+            delete this;
+    }
+};
+
+void testPoller ( fdPollerType type, const char * name )
+{
+    fdManager mgr ( type );
+    osiSockAddr addr, peer;
+    SOCKET sock, other;
+
+    testDiag ( "%s poller", name );
+    testOk ( strcmp ( mgr.pollerName (), name ) == 0,
+        "fdManager uses %s", mgr.pollerName () );
+
+    sock = udpSocket ( addr );
+    other = udpSocket ( peer );
+
+    testReg * pRead = new testReg ( sock, fdrRead, false, mgr );
+    testOk ( mgr.lookUpFD ( sock, fdrRead ) == pRead, "lookUpFD() finds it" );
+    testOk1 ( mgr.lookUpFD ( sock, fdrWrite ) == 0 );
+
+    mgr.process ( 0.05 );
+    testOk ( pRead->count == 0, "No callback while idle" );
+
+    sendto ( other, "x", 1, 0, &addr.sa, sizeof ( addr.ia ) );
+    sendto ( other, "y", 1, 0, &addr.sa, sizeof ( addr.ia ) );
+    for ( int i = 0; i < 10 && pRead->count < 2; i++ )
+        mgr.process ( 0.1 );
+    testOk ( pRead->count == 2, "Read callback per datagram (%u)",
+        pRead->count );
+
+    bool destroyed = false;
+    testReg * pWrite = new testReg ( sock, fdrWrite, true, mgr );
+    pWrite->pDestroyed = &destroyed;
+    mgr.process ( 0.1 );
+    testOk ( destroyed, "onceOnly write registration destroyed after "
+        "its callback" );
+    testOk1 ( mgr.lookUpFD ( sock, fdrWrite ) == 0 );
+
+    mgr.process ( 0.05 );
+    testOk ( pRead->count == 2, "Read interest unaffected" );
+
+    delete pRead;
+    destroyed = false;
+    pRead = new testReg ( sock, fdrRead, false, mgr, true );
+    pRead->pDestroyed = &destroyed;
+    sendto ( other, "z", 1, 0, &addr.sa, sizeof ( addr.ia ) );
+    for ( int i = 0; i < 10 && ! destroyed; i++ )
+        mgr.process ( 0.1 );
+    testOk ( destroyed && mgr.lookUpFD ( sock, fdrRead ) == 0,
+        "Registration deleted from its own callback" );
+
+    epicsSocketDestroy ( sock );
+    epicsSocketDestroy ( other );
+}
+
+} // namespace
+
+MAIN(fdManagerTest)
+{
+    testPlan(18);
+
+    osiSockAttach ();
+
+    testPoller ( fdpSelect, "select" );
+
+#if defined(__linux__)
+    testPoller ( fdpEpoll, "epoll" );
+#else
+    testSkip ( 9, "epoll not available" );
+#endif
+
+    osiSockRelease ();
+    return testDone();
+}
@@ -0,0 +1,157 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* ringMPMCPerform.cpp */
+
+/* Compare the throughput of epicsRingMPMC with a locked epicsRingPointer
+ * for several numbers of producer and consumer threads.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsAtomic.h"
+#include "epicsTime.h"
+#include "epicsRingPointer.h"
+#include "epicsRingMPMC.h"
+#include "testMain.h"
+
+static const unsigned itemsPerProducer = 100000u;
+static const int ringSize = 2048;
+/* Block briefly (rather than yield) when the ring is full or empty
+ * so that threads with real-time priorities can't starve each other.
+ */
+static const double backoff = 1e-4;
+
+struct ringOps {
+    const char *name;
+    void * (*create) ( int size );
+    void ( *destroy ) ( void *ring );
+    int ( *push ) ( void *ring, void *p );
+    void * ( *pop ) ( void *ring );
+};
+
+static void * lockedCreate ( int size )
+    { return epicsRingPointerLockedCreate ( size ); }
+static void lockedDestroy ( void *ring )
+    { epicsRingPointerDelete ( ring ); }
+static int lockedPush ( void *ring, void *p )
+    { return epicsRingPointerPush ( ring, p ); }
+static void * lockedPop ( void *ring )
+    { return epicsRingPointerPop ( ring ); }
+
+static void * mpmcCreate ( int size )
+    { return epicsRingMPMCCreate ( size ); }
+static void mpmcDestroy ( void *ring )
+    { epicsRingMPMCDelete ( static_cast < epicsRingMPMCId > ( ring ) ); }
+static int mpmcPush ( void *ring, void *p )
+    { return epicsRingMPMCPush ( static_cast < epicsRingMPMCId > ( ring ), p ); }
+static void * mpmcPop ( void *ring )
+    { return epicsRingMPMCPop ( static_cast < epicsRingMPMCId > ( ring ) ); }
+
+static const ringOps rings[] = {
+    { "epicsRingPointerLocked", lockedCreate, lockedDestroy, lockedPush, lockedPop },
+    { "epicsRingMPMC", mpmcCreate, mpmcDestroy, mpmcPush, mpmcPop },
+};
+
+struct benchPvt {
+    const ringOps *ops;
+    void *ring;
+    epicsEventId done;
+    int producersRunning;
+    int threadsRunning;
+    size_t consumed;
+    size_t fullSpins;
+};
+
+extern "C" void benchProducer ( void *arg )
+{
+    benchPvt *pvt = static_cast < benchPvt * > ( arg );
+    size_t spins = 0u;
+    for ( unsigned i = 1u; i <= itemsPerProducer; i++ ) {
+        while ( ! pvt->ops->push ( pvt->ring, &pvt->consumed ) ) {
+            spins++;
+            epicsThreadSleep ( backoff );
+        }
+    }
+    epicsAtomicAddSizeT ( &pvt->fullSpins, spins );
+    epicsAtomicDecrIntT ( &pvt->producersRunning );
+    epicsAtomicDecrIntT ( &pvt->threadsRunning );
+    epicsEventMustTrigger ( pvt->done );
+}
+
+extern "C" void benchConsumer ( void *arg )
+{
+    benchPvt *pvt = static_cast < benchPvt * > ( arg );
+    size_t consumed = 0u;
+    while ( true ) {
+        if ( pvt->ops->pop ( pvt->ring ) ) {
+            consumed++;
+        }
+        else if ( ! epicsAtomicGetIntT ( &pvt->producersRunning ) ) {
+            if ( ! pvt->ops->pop ( pvt->ring ) )
+                break;
+            consumed++;
+        }
+        else {
+            epicsThreadSleep ( backoff );
+        }
+    }
+    epicsAtomicAddSizeT ( &pvt->consumed, consumed );
+    epicsAtomicDecrIntT ( &pvt->threadsRunning );
+    epicsEventMustTrigger ( pvt->done );
+}
+
+static void benchRing ( const ringOps & ops, int nProducers, int nConsumers )
+{
+    benchPvt pvt;
+    pvt.ops = &ops;
+    pvt.ring = ops.create ( ringSize );
+    pvt.done = epicsEventMustCreate ( epicsEventEmpty );
+    pvt.producersRunning = nProducers;
+    pvt.threadsRunning = nProducers + nConsumers;
+    pvt.consumed = 0u;
+    pvt.fullSpins = 0u;
+
+    epicsTime begin = epicsTime::getMonotonic ();
+    for ( int i = 0; i < nConsumers; i++ ) {
+        epicsThreadMustCreate ( "consumer", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize ( epicsThreadStackSmall ),
+            benchConsumer, &pvt );
+    }
+    for ( int i = 0; i < nProducers; i++ ) {
+        epicsThreadMustCreate ( "producer", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize ( epicsThreadStackSmall ),
+            benchProducer, &pvt );
+    }
+    while ( epicsAtomicGetIntT ( &pvt.threadsRunning ) ) {
+        epicsEventMustWait ( pvt.done );
+    }
+    epicsTime end = epicsTime::getMonotonic ();
+
+    double delay = end - begin;
+    printf ( "%-24s %2d x %-2d %10.0f items/sec (%lu full spins)\n",
+        ops.name, nProducers, nConsumers,
+        pvt.consumed / delay, static_cast < unsigned long > ( pvt.fullSpins ) );
+
+    epicsEventDestroy ( pvt.done );
+    ops.destroy ( pvt.ring );
+}
+
+MAIN(ringMPMCPerform)
+{
+    static const int config[][2] = {
+        { 1, 1 }, { 2, 2 }, { 4, 1 }, { 1, 4 }, { 4, 4 }, { 8, 8 }
+    };
+    printf ( "%u items per producer, ring size %d, %d CPUs\n",
+        itemsPerProducer, ringSize, epicsThreadGetCPUs () );
+    for ( unsigned c = 0u; c < sizeof ( config ) / sizeof ( config[0] ); c++ ) {
+        for ( unsigned r = 0u; r < sizeof ( rings ) / sizeof ( rings[0] ); r++ ) {
+            benchRing ( rings[r], config[c][0], config[c][1] );
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* ringMPMCTest.c */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsAtomic.h"
+#include "epicsRingMPMC.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NPRODUCERS 4
+#define NCONSUMERS 4
+#define NITEMS 10000
+
+/* Block rather than spin when the ring is full or empty, so that
+ * threads with real-time priorities can't starve each other.
+ */
+#define BACKOFF 0.001
+
+static void *int2ptr(size_t i)
+{
+    char *zero = 0;
+    return zero+i;
+}
+
+static size_t ptr2int(void *p)
+{
+    char *zero = 0, *p2 = p;
+    return p2-zero;
+}
+
+static void testSingle(void)
+{
+    epicsRingMPMCId ring = epicsRingMPMCCreate(100);
+    int size, i;
+
+    testDiag("Testing operations w/o threading");
+
+    testOk1(epicsRingMPMCCreate(0)==NULL);
+    if (!ring)
+        testAbort("epicsRingMPMCCreate failed");
+
+    size = epicsRingMPMCGetSize(ring);
+    testOk(size==128, "size %d rounded up to 128", size);
+    testOk1(epicsRingMPMCIsEmpty(ring));
+    testOk1(!epicsRingMPMCIsFull(ring));
+    testOk1(epicsRingMPMCGetFree(ring)==size);
+    testOk1(epicsRingMPMCGetUsed(ring)==0);
+    testOk1(epicsRingMPMCGetHighWaterMark(ring)==0);
+    testOk1(epicsRingMPMCPop(ring)==NULL);
+
+    testOk1(epicsRingMPMCPush(ring, int2ptr(1))==1);
+    testOk1(!epicsRingMPMCIsEmpty(ring));
+    testOk1(epicsRingMPMCGetUsed(ring)==1);
+    testOk1(epicsRingMPMCGetHighWaterMark(ring)==1);
+
+    testDiag("Fill it up");
+    for (i=2; i<2*size; i++) {
+        if (!epicsRingMPMCPush(ring, int2ptr(i)))
+            break;
+    }
+    testOk(i==size+1, "%d == %d", i, size+1);
+    testOk1(epicsRingMPMCIsFull(ring));
+    testOk1(epicsRingMPMCGetFree(ring)==0);
+    testOk1(epicsRingMPMCGetHighWaterMark(ring)==size);
+
+    testDiag("Drain it out");
+    for (i=1; i<2*size; i++) {
+        void *addr = epicsRingMPMCPop(ring);
+        if (addr==NULL || ptr2int(addr)!=i)
+            break;
+    }
+    testOk(i==size+1, "%d == %d", i, size+1);
+    testOk1(epicsRingMPMCIsEmpty(ring));
+    testOk1(epicsRingMPMCGetHighWaterMark(ring)==size);
+    epicsRingMPMCResetHighWaterMark(ring);
+    testOk1(epicsRingMPMCGetHighWaterMark(ring)==0);
+
+    testDiag("Wrap around several times");
+    for (i=1; i<10*size; i++) {
+        if (!epicsRingMPMCPush(ring, int2ptr(i)) ||
+            ptr2int(epicsRingMPMCPop(ring))!=i)
+            break;
+    }
+    testOk(i==10*size, "%d == %d", i, 10*size);
+
+    epicsRingMPMCDelete(ring);
+}
+
+typedef struct {
+    epicsRingMPMCId ring;
+    epicsEventId done;
+    int id;
+    size_t consumed;
+    size_t sum;
+    size_t last[NPRODUCERS];
+    int ordered;
+    int *producersRunning;
+} threadPvt;
+
+/* Values are (item << 8 | producer), item counting from 1 */
+static void producer(void *raw)
+{
+    threadPvt *pvt = raw;
+    size_t i;
+
+    for (i=1; i<=NITEMS; i++) {
+        void *p = int2ptr(i<<8 | pvt->id);
+        while (!epicsRingMPMCPush(pvt->ring, p))
+            epicsThreadSleep(BACKOFF);
+    }
+    epicsAtomicDecrIntT(pvt->producersRunning);
+    epicsEventMustTrigger(pvt->done);
+}
+
+static void consumer(void *raw)
+{
+    threadPvt *pvt = raw;
+
+    pvt->ordered = 1;
+    for (;;) {
+        void *p = epicsRingMPMCPop(pvt->ring);
+
+        if (p) {
+            size_t v = ptr2int(p), item = v>>8;
+            int src = v & 0xff;
+
+            if (src >= NPRODUCERS || item <= pvt->last[src])
+                pvt->ordered = 0;
+            else
+                pvt->last[src] = item;
+            pvt->consumed++;
+            pvt->sum += item;
+        }
+        else if (!epicsAtomicGetIntT(pvt->producersRunning) &&
+                 epicsRingMPMCIsEmpty(pvt->ring)) {
+            break;
+        }
+        else {
+            epicsThreadSleep(BACKOFF);
+        }
+    }
+    epicsEventMustTrigger(pvt->done);
+}
+
+static void testMulti(void)
+{
+    threadPvt prod[NPRODUCERS], cons[NCONSUMERS];
+    epicsRingMPMCId ring = epicsRingMPMCCreate(64);
+    int producersRunning = NPRODUCERS;
+    size_t consumed = 0, sum = 0;
+    int ordered = 1;
+    int i;
+
+    testDiag("%d producers, %d consumers, %d items each",
+        NPRODUCERS, NCONSUMERS, NITEMS);
+
+    memset(prod, 0, sizeof(prod));
+    memset(cons, 0, sizeof(cons));
+    for (i=0; i<NCONSUMERS; i++) {
+        cons[i].ring = ring;
+        cons[i].done = epicsEventMustCreate(epicsEventEmpty);
+        cons[i].producersRunning = &producersRunning;
+        epicsThreadMustCreate("consumer", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            &consumer, &cons[i]);
+    }
+    for (i=0; i<NPRODUCERS; i++) {
+        prod[i].ring = ring;
+        prod[i].id = i;
+        prod[i].done = epicsEventMustCreate(epicsEventEmpty);
+        prod[i].producersRunning = &producersRunning;
+        epicsThreadMustCreate("producer", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            &producer, &prod[i]);
+    }
+
+    for (i=0; i<NPRODUCERS; i++) {
+        epicsEventMustWait(prod[i].done);
+        epicsEventDestroy(prod[i].done);
+    }
+    for (i=0; i<NCONSUMERS; i++) {
+        epicsEventMustWait(cons[i].done);
+        epicsEventDestroy(cons[i].done);
+        consumed += cons[i].consumed;
+        sum += cons[i].sum;
+        ordered &= cons[i].ordered;
+    }
+
+    testOk(consumed==(size_t)NPRODUCERS*NITEMS, "consumed %lu of %lu",
+        (unsigned long)consumed, (unsigned long)NPRODUCERS*NITEMS);
+    testOk(sum==(size_t)NPRODUCERS*NITEMS*(NITEMS+1)/2,
+        "no items lost or duplicated");
+    testOk(ordered, "items from each producer consumed in order");
+    testOk1(epicsRingMPMCIsEmpty(ring));
+
+    epicsRingMPMCDelete(ring);
+}
+
+MAIN(ringMPMCTest)
+{
+    testPlan(25);
+    testSingle();
+    testMulti();
+    return testDone();
+}